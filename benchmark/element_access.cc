@@ -0,0 +1,160 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Generic element loops written against MatrixBase, whose element access is
+// resolved at compile time, against the same loops through a virtual data()
+// (how MatrixBase used to work) and through the type-erased AnyMatrix.
+//
+// usage: element_access [n]   (n x n matrices, default 1000)
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "slab/matrix.h"
+
+using namespace slab;
+
+namespace {
+
+// The former MatrixBase: every element access calls a virtual data().
+template <typename T, std::size_t N>
+class VirtualBase {
+ public:
+  explicit VirtualBase(const MatrixSlice<N> &d) : desc_(d) {}
+  virtual ~VirtualBase() = default;
+  virtual T *data() = 0;
+
+  std::size_t n_rows() const { return desc_.extents[0]; }
+  std::size_t n_cols() const { return desc_.extents[1]; }
+
+  template <typename... Args>
+  T &operator()(Args... args) {
+    return *(data() + desc_(args...));
+  }
+
+ private:
+  MatrixSlice<N> desc_;
+};
+
+template <typename T, std::size_t N>
+class VirtualMatrix : public VirtualBase<T, N> {
+ public:
+  explicit VirtualMatrix(Matrix<T, N> &m)
+      : VirtualBase<T, N>(m.descriptor()), m_(m) {}
+  T *data() override { return m_.data(); }
+
+ private:
+  Matrix<T, N> &m_;
+};
+
+// y(i, j) = 2 * x(i, j) + y(i, j)
+template <typename M>
+double axpy_2d(M &x, M &y) {
+  for (std::size_t i = 0; i != x.n_rows(); ++i)
+    for (std::size_t j = 0; j != x.n_cols(); ++j) y(i, j) += 2 * x(i, j);
+  return y(0, 0);
+}
+
+template <typename M>
+double sum_2d(M &m) {
+  double res = 0;
+  for (std::size_t i = 0; i != m.n_rows(); ++i)
+    for (std::size_t j = 0; j != m.n_cols(); ++j) res += m(i, j);
+  return res;
+}
+
+// Called through volatile pointers, so that the compiler can neither inline
+// them into main() nor devirtualize the calls from the known dynamic type.
+double axpy_static(mat &x, mat &y) { return axpy_2d(x, y); }
+double axpy_virtual(VirtualBase<double, 2> &x, VirtualBase<double, 2> &y) {
+  return axpy_2d(x, y);
+}
+double axpy_erased(AnyMatrix<double, 2> x, AnyMatrix<double, 2> y) {
+  return axpy_2d(x, y);
+}
+double axpy_erased_ref(AnyMatrix<double, 2> x, AnyMatrix<double, 2> y) {
+  MatrixRef<double, 2> xr = x.ref(), yr = y.ref();
+  return axpy_2d(xr, yr);
+}
+
+double sum_static(mat &m) { return sum_2d(m); }
+double sum_virtual(VirtualBase<double, 2> &m) { return sum_2d(m); }
+double sum_erased(AnyMatrix<double, 2> m) { return sum_2d(m); }
+
+template <typename F>
+double best_seconds(F f, double &sink) {
+  double best = 1e30;
+  for (int rep = 0; rep != 5; ++rep) {
+    const auto t0 = std::chrono::steady_clock::now();
+    sink += f();
+    const auto t1 = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+  }
+  return best;
+}
+
+void report(const char *name, double seconds, double base, std::size_t n) {
+  std::printf("%-28s %8.3f ns/element %7.2fx\n", name, seconds * 1e9 / n,
+              seconds / base);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+  mat a(n, n);
+  for (std::size_t i = 0; i != a.size(); ++i) a.data()[i] = double(i % 7);
+  mat b = a;
+
+  double sink = 0;
+  const std::size_t elems = n * n;
+  std::printf("generic element loops, %zu x %zu\n", n, n);
+
+  double (*volatile f_static)(mat &, mat &) = axpy_static;
+  double (*volatile f_virtual)(VirtualBase<double, 2> &,
+                               VirtualBase<double, 2> &) = axpy_virtual;
+  double (*volatile f_erased)(AnyMatrix<double, 2>, AnyMatrix<double, 2>) =
+      axpy_erased;
+  double (*volatile f_erased_ref)(AnyMatrix<double, 2>,
+                                  AnyMatrix<double, 2>) = axpy_erased_ref;
+  VirtualMatrix<double, 2> va(a), vb(b);
+
+  const double a_static = best_seconds([&] { return f_static(a, b); }, sink);
+  const double a_virtual =
+      best_seconds([&] { return f_virtual(va, vb); }, sink);
+  const double a_erased = best_seconds([&] { return f_erased(a, b); }, sink);
+  const double a_erased_ref =
+      best_seconds([&] { return f_erased_ref(a, b); }, sink);
+  report("y += 2x, MatrixBase", a_static, a_static, elems);
+  report("y += 2x, virtual data()", a_virtual, a_static, elems);
+  report("y += 2x, AnyMatrix", a_erased, a_static, elems);
+  report("y += 2x, AnyMatrix::ref()", a_erased_ref, a_static, elems);
+
+  double (*volatile g_static)(mat &) = sum_static;
+  double (*volatile g_virtual)(VirtualBase<double, 2> &) = sum_virtual;
+  double (*volatile g_erased)(AnyMatrix<double, 2>) = sum_erased;
+
+  const double s_static = best_seconds([&] { return g_static(a); }, sink);
+  const double s_virtual = best_seconds([&] { return g_virtual(va); }, sink);
+  const double s_erased = best_seconds([&] { return g_erased(a); }, sink);
+  report("sum, MatrixBase", s_static, s_static, elems);
+  report("sum, virtual data()", s_virtual, s_static, elems);
+  report("sum, AnyMatrix", s_erased, s_static, elems);
+
+  std::printf("(checksum %g)\n", sink);
+  return 0;
+}
@@ -0,0 +1,83 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// kron() against the block-by-block evaluation it replaced, for an m x m
+// matrix times a p x p one, and kron_add().
+//
+// usage: kron [m [p]]   (default 100 and 40)
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "slab/matrix.h"
+
+using namespace slab;
+
+namespace {
+
+// a temporary a(i, j) * b per block, copied into a strided view
+mat blockwise_kron(const mat &a, const mat &b) {
+  const std::size_t p = b.n_rows(), q = b.n_cols();
+  mat res(uninitialized, a.n_rows() * p, a.n_cols() * q);
+  for (std::size_t j = 0; j != a.n_cols(); ++j)
+    for (std::size_t i = 0; i != a.n_rows(); ++i)
+      res(slice{i * p, p}, slice{j * q, q}) = a(i, j) * b;
+  return res;
+}
+
+template <typename F>
+double best_seconds(F f) {
+  double best = 1e30;
+  for (int rep = 0; rep != 3; ++rep) {
+    const auto t0 = std::chrono::steady_clock::now();
+    f();
+    const auto t1 = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+  }
+  return best;
+}
+
+void report(const char *name, double seconds, std::size_t n) {
+  // bytes written
+  std::printf("%-28s %8.2f ms %8.2f GB/s\n", name, seconds * 1e3,
+              double(n) * sizeof(double) / seconds * 1e-9);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const std::size_t m = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+  const std::size_t p = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 40;
+  mat a(m, m), b(p, p);
+  for (std::size_t i = 0; i != a.size(); ++i) a.data()[i] = double(i % 7);
+  for (std::size_t i = 0; i != b.size(); ++i) b.data()[i] = double(i % 5);
+
+  std::printf("kron of %zu x %zu and %zu x %zu doubles, %zu threads\n", m, m,
+              p, p, num_threads());
+  mat c, d;
+  report("block by block", best_seconds([&] { c = blockwise_kron(a, b); }),
+         m * m * p * p);
+  report("kron()", best_seconds([&] { d = kron(a, b); }), m * m * p * p);
+  report("kron_into()", best_seconds([&] { kron_into(a, b, d); }),
+         m * m * p * p);
+  report("kron_add()", best_seconds([&] { kron_add(a, b, d); }),
+         m * m * p * p);
+  report("kron() of views",
+         best_seconds([&] { d = kron(a.cols(0, m / 2), b.t()); }),
+         m * (m / 2 + 1) * p * p);
+  return c.size() == m * m * p * p ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Element-wise operators on float vectors that fit in cache, with the SIMD
+// kernels of each instruction set the CPU supports (see simd_kernels.h).
+// Large vectors are bound by memory bandwidth, whatever the instructions.
+//
+// usage: simd_kernels [n]   (default 4096)
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "slab/matrix.h"
+
+using namespace slab;
+
+namespace {
+
+template <typename F>
+double best_seconds(F f) {
+  double best = 1e30;
+  for (int rep = 0; rep != 5; ++rep) {
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i != 1000; ++i) f();
+    const auto t1 = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+  }
+  return best / 1000;
+}
+
+void report(const char *name, double seconds, std::size_t n) {
+  std::printf("  %-18s %8.3f us %8.2f Gelem/s\n", name, seconds * 1e6,
+              n / seconds * 1e-9);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096;
+  Matrix<float, 1> a(n), b(n), c(n);
+  Matrix<int, 1> k(n);
+  for (std::size_t i = 0; i != n; ++i) {
+    a(i) = 1.0f + i % 17;
+    b(i) = 2.0f - i % 5;
+    k(i) = int(i % 31);
+  }
+
+  float sink = 0;
+  std::printf("element-wise operators on %zu floats\n", n);
+  for (int l = 0; l <= int(simd_max_level()); ++l) {
+    set_simd_level(SimdLevel(l));
+    std::printf("%s\n", simd_level_name(simd_level()));
+    report("c = a + b", best_seconds([&] { c = a + b; }), n);
+    report("c = a / 3", best_seconds([&] { c = a / 3.0f; }), n);
+    report("c *= b", best_seconds([&] { c *= b; }), n);
+    report("c = 0.5", best_seconds([&] { c = 0.5f; }), n);
+    report("a == a", best_seconds([&] { sink += a == a; }), n);
+    report("float from int", best_seconds([&] {
+             sink += Matrix<float, 1>(k)(0);
+           }), n);
+    sink += c(0);
+  }
+
+  std::printf("(checksum %g)\n", sink);
+  return 0;
+}
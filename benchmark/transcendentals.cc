@@ -0,0 +1,116 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// The element-wise functions of vmath.h against copying the matrix and
+// calling the std:: function per element, as exp() and the others did.
+//
+// usage: transcendentals [n]   (n doubles and n floats, default 10^6)
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "slab/matrix.h"
+
+using namespace slab;
+
+namespace {
+
+template <typename F>
+double best_seconds(F f, double &sink) {
+  double best = 1e30;
+  for (int rep = 0; rep != 5; ++rep) {
+    const auto t0 = std::chrono::steady_clock::now();
+    sink += f();
+    const auto t1 = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+  }
+  return best;
+}
+
+void report(const char *name, double scalar, double vector, std::size_t n) {
+  std::printf("%-8s %8.2f ns/element %8.2f ns/element %7.2fx\n", name,
+              scalar * 1e9 / n, vector * 1e9 / n, scalar / vector);
+}
+
+// one function, through std:: and through slab::
+template <typename T, typename S, typename V>
+void compare(const char *name, const Matrix<T, 1> &x, S s, V v,
+             double &sink) {
+  const double scalar = best_seconds([&] {
+    Matrix<T, 1> res = x;
+    res.apply([&](T &a) { a = s(a); });
+    return double(res(res.size() / 2));
+  }, sink);
+  Matrix<T, 1> out(x.size());
+  const double vector = best_seconds([&] {
+    v(x, out);
+    return double(out(out.size() / 2));
+  }, sink);
+  report(name, scalar, vector, x.size());
+}
+
+template <typename T>
+void run(std::size_t n, double &sink) {
+  Matrix<T, 1> x(n), y(n);
+  for (std::size_t i = 0; i != n; ++i) {
+    x(i) = T(-20.0 + 40.0 * double(i) / double(n));  // [-20, 20)
+    y(i) = T(1e-3 + 100.0 * double(i) / double(n));  // (0, 100]
+  }
+
+  std::printf("%s, std:: copy-and-apply vs slab::*_into, %zu threads\n",
+              sizeof(T) == 8 ? "double" : "float", num_threads());
+  compare("exp", x, [](T a) { return std::exp(a); },
+          [](const Matrix<T, 1> &a, Matrix<T, 1> &b) { exp_into(a, b); },
+          sink);
+  compare("expm1", x, [](T a) { return std::expm1(a); },
+          [](const Matrix<T, 1> &a, Matrix<T, 1> &b) { expm1_into(a, b); },
+          sink);
+  compare("log", y, [](T a) { return std::log(a); },
+          [](const Matrix<T, 1> &a, Matrix<T, 1> &b) { log_into(a, b); },
+          sink);
+  compare("log1p", y, [](T a) { return std::log1p(a); },
+          [](const Matrix<T, 1> &a, Matrix<T, 1> &b) { log1p_into(a, b); },
+          sink);
+  compare("sin", x, [](T a) { return std::sin(a); },
+          [](const Matrix<T, 1> &a, Matrix<T, 1> &b) { sin_into(a, b); },
+          sink);
+  compare("cos", x, [](T a) { return std::cos(a); },
+          [](const Matrix<T, 1> &a, Matrix<T, 1> &b) { cos_into(a, b); },
+          sink);
+  compare("tan", x, [](T a) { return std::tan(a); },
+          [](const Matrix<T, 1> &a, Matrix<T, 1> &b) { tan_into(a, b); },
+          sink);
+  compare("tanh", x, [](T a) { return std::tanh(a); },
+          [](const Matrix<T, 1> &a, Matrix<T, 1> &b) { tanh_into(a, b); },
+          sink);
+  compare("sqrt", y, [](T a) { return std::sqrt(a); },
+          [](const Matrix<T, 1> &a, Matrix<T, 1> &b) { sqrt_into(a, b); },
+          sink);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const std::size_t n =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  double sink = 0;
+  run<double>(n, sink);
+  run<float>(n, sink);
+  std::printf("(checksum %g)\n", sink);
+  return 0;
+}
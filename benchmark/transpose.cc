@@ -0,0 +1,80 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// transpose() against the row-to-column copy it replaced, and the in-place
+// transposes, on m x n matrices of doubles.
+//
+// usage: transpose [m [n]]   (default 4096 x 4096)
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "slab/matrix.h"
+
+using namespace slab;
+
+namespace {
+
+mat rowwise_transpose(const mat &a) {
+  mat res(uninitialized, a.n_cols(), a.n_rows());
+  for (std::size_t i = 0; i < a.n_rows(); ++i) res.col(i) = a.row(i);
+  return res;
+}
+
+template <typename F>
+double best_seconds(F f) {
+  double best = 1e30;
+  for (int rep = 0; rep != 3; ++rep) {
+    const auto t0 = std::chrono::steady_clock::now();
+    f();
+    const auto t1 = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+  }
+  return best;
+}
+
+void report(const char *name, double seconds, std::size_t n) {
+  // bytes read and written
+  std::printf("%-28s %8.2f ms %8.2f GB/s\n", name, seconds * 1e3,
+              2.0 * n * sizeof(double) / seconds * 1e-9);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const std::size_t m = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096;
+  const std::size_t n = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : m;
+  mat a(m, n);
+  for (std::size_t i = 0; i != a.size(); ++i) a.data()[i] = double(i);
+
+  std::printf("transpose of %zu x %zu doubles, %zu threads\n", m, n,
+              num_threads());
+  mat b;
+  report("row to column copy",
+         best_seconds([&] { b = rowwise_transpose(a); }), a.size());
+  report("transpose()", best_seconds([&] { b = transpose(a); }), a.size());
+
+  const std::size_t nt = num_threads();
+  set_num_threads(1);
+  report("transpose(), 1 thread", best_seconds([&] { b = transpose(a); }),
+         a.size());
+  set_num_threads(nt);
+
+  report("inplace_trans()", best_seconds([&] { a.inplace_trans(); }),
+         a.size());
+  return b.size() == a.size() ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Copies and updates through MatrixRef views of an n x n matrix of doubles:
+// the row walks of traverse.h against the element-by-element
+// MatrixRefIterator loops they replaced.
+//
+// usage: view_traversal [n]   (default 2000)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "slab/matrix.h"
+
+using namespace slab;
+
+namespace {
+
+template <typename F>
+double best_seconds(F f) {
+  double best = 1e30;
+  for (int rep = 0; rep != 5; ++rep) {
+    const auto t0 = std::chrono::steady_clock::now();
+    f();
+    const auto t1 = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+  }
+  return best;
+}
+
+void report(const char *name, double seconds, std::size_t n) {
+  std::printf("%-34s %8.2f ms %8.2f GB/s\n", name, seconds * 1e3,
+              n * sizeof(double) / seconds * 1e-9);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+  const std::size_t h = n / 2;
+  mat a(n, n), b(n, n);
+  for (std::size_t i = 0; i != a.size(); ++i) a.data()[i] = 1.0 / (1 + i % 9);
+
+  std::printf("views of %zu x %zu doubles\n", n, n);
+  auto src = a.submat(0, 0, n - 1, h - 1);
+  auto dst = b.submat(0, h, n - 1, 2 * h - 1);
+  report("submat copy, iterators", best_seconds([&] {
+           std::copy(src.begin(), src.end(), dst.begin());
+         }), src.size());
+  report("submat copy, row walk", best_seconds([&] { dst = src; }),
+         src.size());
+  report("submat +=, iterators", best_seconds([&] {
+           auto j = src.begin();
+           for (auto i = dst.begin(); i != dst.end(); ++i, ++j) *i += *j;
+         }), src.size());
+  report("submat +=, row walk", best_seconds([&] { dst += src; }),
+         src.size());
+  report("mat(submat), iterators", best_seconds([&] {
+           mat c(uninitialized, n, h);
+           std::copy(src.begin(), src.end(), c.begin());
+         }), src.size());
+  report("mat(submat), row walk", best_seconds([&] { mat c = src; }),
+         src.size());
+
+  auto col = a.col(1);
+  auto dcol = b.col(3);
+  report("column copy, iterators", best_seconds([&] {
+           for (int r = 0; r != 100; ++r)
+             std::copy(col.begin(), col.end(), dcol.begin());
+         }), col.size() * 100);
+  report("column copy, row walk", best_seconds([&] {
+           for (int r = 0; r != 100; ++r) dcol = col;
+         }), col.size() * 100);
+
+  std::printf("(checksum %g)\n", sum(vectorise_view(b)));
+  return 0;
+}
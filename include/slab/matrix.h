@@ -23,14 +23,26 @@
 #include "slab/matrix/error.h"
 #include "slab/matrix/slice.h"
 
+#include "slab/matrix/allocator.h"
+#include "slab/matrix/arena.h"
+#include "slab/matrix/instrument.h"
+#include "slab/matrix/mkl_allocator.h"
+#include "slab/matrix/numa.h"
+#include "slab/matrix/parallel.h"
+
 #include "slab/matrix/matrix.h"
 #include "slab/matrix/matrix_ops.h"
+#include "slab/matrix/view_range.h"
+#include "slab/matrix/any_matrix.h"
 #include "slab/matrix/packed_matrix.h"
+#include "slab/matrix/fixed_matrix.h"
+#include "slab/matrix/mapped_matrix.h"
 
 #include "slab/matrix/matrix_fns.h"
 #include "slab/matrix/type_alias.h"
 
 #include "slab/matrix/blas_interface.h"
 #include "slab/matrix/lapack_interface.h"
+#include "slab/matrix/kron_matrix.h"
 
 #endif  // SLAB_MATRIX_H_
@@ -0,0 +1,235 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file allocator.h
+/// @brief Allocators for the element storage of Matrix
+
+#ifndef SLAB_MATRIX_ALLOCATOR_H_
+#define SLAB_MATRIX_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdlib>
+
+#include <memory>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>  // madvise
+#endif
+
+namespace slab {
+namespace matrix_impl {
+
+// Allocates `bytes` bytes aligned to `alignment`, which must be a power of two
+// and a multiple of sizeof(void *).
+inline void *aligned_malloc(std::size_t bytes, std::size_t alignment) {
+#if defined(_WIN32)
+  return _aligned_malloc(bytes, alignment);
+#else
+  void *p = nullptr;
+  if (posix_memalign(&p, alignment, bytes)) return nullptr;
+  return p;
+#endif
+}
+
+inline void aligned_free(void *p) {
+#if defined(_WIN32)
+  _aligned_free(p);
+#else
+  free(p);
+#endif
+}
+
+template <typename T>
+inline T *allocate_aligned(std::size_t n, std::size_t alignment) {
+  if (n == 0) return nullptr;
+  if (n > static_cast<std::size_t>(-1) / sizeof(T)) throw std::bad_alloc();
+
+  void *p = aligned_malloc(n * sizeof(T), alignment);
+  if (!p) throw std::bad_alloc();
+
+  return static_cast<T *>(p);
+}
+
+}  // namespace matrix_impl
+
+//! AlignedAllocator<T, Alignment> returns storage aligned to Alignment bytes.
+/*!
+ * \tparam T value type.
+ * \tparam Alignment alignment in bytes, 64 (one cache line / one AVX-512
+ * register) by default.
+ *
+ * Matrix<double, 2, AlignedAllocator<double>> keeps SIMD loads and the
+ * packing routines of BLAS on their aligned fast paths.
+ */
+template <typename T, std::size_t Alignment = 64>
+struct AlignedAllocator {
+  static_assert(Alignment >= sizeof(void *) &&
+                    (Alignment & (Alignment - 1)) == 0,
+                "AlignedAllocator: alignment must be a power of two");
+
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = AlignedAllocator<U, Alignment>;
+  };
+
+  AlignedAllocator() noexcept {}
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+
+  T *allocate(std::size_t n) const {
+    return matrix_impl::allocate_aligned<T>(n, Alignment);
+  }
+  void deallocate(T *p, std::size_t) const noexcept {
+    matrix_impl::aligned_free(p);
+  }
+};
+
+template <typename T, typename U, std::size_t Alignment>
+inline bool operator==(const AlignedAllocator<T, Alignment> &,
+                       const AlignedAllocator<U, Alignment> &) noexcept {
+  return true;
+}
+
+template <typename T, typename U, std::size_t Alignment>
+inline bool operator!=(const AlignedAllocator<T, Alignment> &,
+                       const AlignedAllocator<U, Alignment> &) noexcept {
+  return false;
+}
+
+//! HugePageAllocator<T> backs large matrices with transparent huge pages.
+/*!
+ * \tparam T value type.
+ *
+ * Requests of at least one huge page (2 MiB) are aligned to a huge page
+ * boundary and advised with MADV_HUGEPAGE, which cuts TLB misses on large
+ * BLAS/LAPACK operands. Smaller requests, and platforms without transparent
+ * huge pages, fall back to 64-byte aligned storage.
+ */
+template <typename T>
+struct HugePageAllocator {
+  static constexpr std::size_t huge_page_size = std::size_t(2) << 20;
+  static constexpr std::size_t min_alignment = 64;
+
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = HugePageAllocator<U>;
+  };
+
+  HugePageAllocator() noexcept {}
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U> &) noexcept {}
+
+  T *allocate(std::size_t n) const {
+    if (n == 0) return nullptr;
+    if (n > static_cast<std::size_t>(-1) / sizeof(T)) throw std::bad_alloc();
+
+    const std::size_t bytes = n * sizeof(T);
+    if (bytes < huge_page_size)
+      return matrix_impl::allocate_aligned<T>(n, min_alignment);
+
+    // round up to whole huge pages so that the advice covers every page
+    const std::size_t len =
+        (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+    void *p = matrix_impl::aligned_malloc(len, huge_page_size);
+    if (!p) throw std::bad_alloc();
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    madvise(p, len, MADV_HUGEPAGE);  // only a hint, failure is harmless
+#endif
+    return static_cast<T *>(p);
+  }
+  void deallocate(T *p, std::size_t) const noexcept {
+    matrix_impl::aligned_free(p);
+  }
+};
+
+template <typename T>
+constexpr std::size_t HugePageAllocator<T>::huge_page_size;
+
+template <typename T>
+constexpr std::size_t HugePageAllocator<T>::min_alignment;
+
+template <typename T, typename U>
+inline bool operator==(const HugePageAllocator<T> &,
+                       const HugePageAllocator<U> &) noexcept {
+  return true;
+}
+
+template <typename T, typename U>
+inline bool operator!=(const HugePageAllocator<T> &,
+                       const HugePageAllocator<U> &) noexcept {
+  return false;
+}
+
+//! CowAllocator<T, A> selects copy-on-write storage for Matrix.
+/*!
+ * \tparam T value type.
+ * \tparam A allocator of the elements, std::allocator<T> by default.
+ *
+ * Copies of a Matrix<T, N, CowAllocator<T>> share a reference-counted buffer,
+ * which is cloned on the first mutable access (non-const data(), operator(),
+ * row()/col()/slicing, iterators, assignment). Matrices that are passed
+ * around by value and only read are never duplicated.
+ *
+ * Pointers, iterators and MatrixRefs taken from a non-const matrix are bound
+ * to its buffer at that moment: take them after the last copy is made, or
+ * writes through them show up in the copies as well.
+ *
+ * \code
+ * CowMatrix<double, 2> x = load_design();
+ * CowMatrix<double, 2> y = x;  // shares the buffer of x
+ * y(0, 0) = 1;                 // y clones the buffer, x is unchanged
+ * \endcode
+ */
+template <typename T, typename A = std::allocator<T>>
+struct CowAllocator : A {
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = CowAllocator<
+        U, typename std::allocator_traits<A>::template rebind_alloc<U>>;
+  };
+
+  CowAllocator() = default;
+  template <typename U, typename B>
+  CowAllocator(const CowAllocator<U, B> &x) noexcept
+      : A(static_cast<const B &>(x)) {}
+};
+
+template <typename T, typename U, typename A, typename B>
+inline bool operator==(const CowAllocator<T, A> &x,
+                       const CowAllocator<U, B> &y) noexcept {
+  return static_cast<const A &>(x) == static_cast<const B &>(y);
+}
+
+template <typename T, typename U, typename A, typename B>
+inline bool operator!=(const CowAllocator<T, A> &x,
+                       const CowAllocator<U, B> &y) noexcept {
+  return !(x == y);
+}
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_ALLOCATOR_H_
@@ -0,0 +1,144 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file any_matrix.h
+/// @brief AnyMatrix, a type-erased handle to a Matrix or MatrixRef
+
+#ifndef SLAB_MATRIX_ANY_MATRIX_H_
+#define SLAB_MATRIX_ANY_MATRIX_H_
+
+#include <cassert>
+#include <cstddef>
+
+#include <type_traits>
+
+#include "slab/matrix/matrix_base.h"
+#include "slab/matrix/matrix_ref.h"
+#include "slab/matrix/matrix_slice.h"
+#include "slab/matrix/traits.h"
+
+namespace slab {
+
+//! AnyMatrix<T, N> refers to any Matrix or MatrixRef of order N.
+/*!
+ * MatrixBase resolves data() and size() at compile time, so a function
+ * taking "any matrix" is a template. AnyMatrix is the opt-in alternative for
+ * code that needs one non-template type at run time, e.g. a virtual
+ * function or a container of matrices of different allocators: it reaches
+ * the matrix through a table of function pointers, as a virtual base would.
+ *
+ * \code
+ * double trace(AnyMatrix<const double, 2> a);  // not a template
+ * trace(m);                                    // Matrix<double, 2, A>
+ * trace(m.submat(0, 0, 2, 2));                 // MatrixRef<double, 2>
+ * \endcode
+ *
+ * AnyMatrix<const T, N> gives read-only access. Like MatrixRef, it does not
+ * own the matrix and must not outlive it; unlike MatrixRef, it follows the
+ * matrix when it is resized or reallocated. Element loops should take the
+ * MatrixRef from ref() once rather than call operator() per element.
+ */
+template <typename T, std::size_t N>
+class AnyMatrix {
+ public:
+  static constexpr std::size_t order_ = N;
+  using value_type = T;
+
+  //! refer to a Matrix or MatrixRef
+  template <typename U, typename D,
+            typename = Enable_if<Convertible<U *, T *>()>>
+  AnyMatrix(MatrixBase<U, N, D> &m)
+      : obj_(&m.derived()), ops_(&ops_for<D>()) {}
+
+  //! refer to a const Matrix or MatrixRef (AnyMatrix<const T, N> only)
+  template <typename U, typename D,
+            typename = Enable_if<Convertible<const U *, T *>()>>
+  AnyMatrix(const MatrixBase<U, N, D> &m)
+      : obj_(const_cast<D *>(&m.derived())), ops_(&ops_for<D>()) {}
+
+  //! number of dimensions
+  static constexpr std::size_t order() { return order_; }
+  //! #elements in the nth dimension
+  std::size_t extent(std::size_t n) const {
+    assert(n < order_);
+    return descriptor().extents[n];
+  }
+  std::size_t n_rows() const { return extent(0); }
+  std::size_t n_cols() const { return extent(1); }
+  //! total number of elements
+  std::size_t size() const { return ops_->size(obj_); }
+  //! the slice defining subscripting
+  const MatrixSlice<N> &descriptor() const { return ops_->descriptor(obj_); }
+
+  //! "flat" element access
+  T *data() const { return ops_->data(obj_); }
+
+  //! m(i,j,k) subscripting with integers
+  template <typename... Args>
+  Enable_if<matrix_impl::Requesting_element<Args...>(), T &> operator()(
+      Args... args) const {
+    const MatrixSlice<N> &d = descriptor();
+    assert(matrix_impl::check_bounds(d, args...));
+    return *(data() + d(args...));
+  }
+
+  //! the current elements as a view
+  MatrixRef<T, N> ref() const { return {descriptor(), data()}; }
+
+ private:
+  struct Ops {
+    T *(*data)(void *);
+    std::size_t (*size)(const void *);
+    const MatrixSlice<N> &(*descriptor)(const void *);
+  };
+
+  // D as it is accessed: through its const members for AnyMatrix<const T>,
+  // so that a copy-on-write matrix is not copied by reading it
+  template <typename D>
+  using Access =
+      typename std::conditional<std::is_const<T>::value, const D, D>::type;
+
+  template <typename D>
+  static T *data_of(void *p) {
+    return static_cast<Access<D> *>(p)->data();
+  }
+
+  template <typename D>
+  static std::size_t size_of(const void *p) {
+    return static_cast<const D *>(p)->size();
+  }
+
+  template <typename D>
+  static const MatrixSlice<N> &descriptor_of(const void *p) {
+    return static_cast<const D *>(p)->descriptor();
+  }
+
+  template <typename D>
+  static const Ops &ops_for() {
+    static const Ops ops{&data_of<D>, &size_of<D>, &descriptor_of<D>};
+    return ops;
+  }
+
+  void *obj_;
+  const Ops *ops_;
+};
+
+template <typename T, std::size_t N>
+constexpr std::size_t AnyMatrix<T, N>::order_;
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_ANY_MATRIX_H_
@@ -0,0 +1,212 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file arena.h
+/// @brief A thread-local scoped arena for Matrix temporaries
+
+#ifndef SLAB_MATRIX_ARENA_H_
+#define SLAB_MATRIX_ARENA_H_
+
+#include <cstddef>
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+#include "slab/matrix/allocator.h"
+
+namespace slab {
+
+//! Usage statistics of the arena of the calling thread.
+struct ArenaStats {
+  std::size_t bytes_in_use;     // bytes handed out and not yet rewound
+  std::size_t high_water_mark;  // peak of bytes_in_use
+  std::size_t capacity;         // bytes reserved from the system
+  std::size_t num_allocations;  // allocations served so far
+  std::size_t num_blocks;       // blocks reserved from the system
+};
+
+namespace matrix_impl {
+
+// A bump allocator made of a list of blocks. Individual deallocations are
+// no-ops; memory is given back in bulk by rewinding to a mark.
+class Arena {
+ public:
+  static constexpr std::size_t alignment = 64;
+  static constexpr std::size_t default_block_size = std::size_t(1) << 20;
+
+  struct Mark {
+    std::size_t block;
+    std::size_t offset;
+    std::size_t used;
+  };
+
+  Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+  ~Arena() { release(); }
+
+  bool active() const { return depth_ != 0; }
+
+  Mark enter(std::size_t block_size) {
+    ++depth_;
+    if (block_size > block_size_) block_size_ = block_size;
+    return Mark{block_, offset_, used_};
+  }
+
+  // O(1): blocks are kept for the next scope.
+  void leave(const Mark &m) {
+    --depth_;
+    block_ = m.block;
+    offset_ = m.offset;
+    used_ = m.used;
+  }
+
+  void *allocate(std::size_t bytes) {
+    // never hand out a zero-size slot, which could sit past the block end
+    bytes = (std::max<std::size_t>(bytes, 1) + alignment - 1) / alignment *
+            alignment;
+
+    while (block_ < blocks_.size()) {
+      if (offset_ + bytes <= blocks_[block_].size) {
+        void *p = blocks_[block_].base + offset_;
+        bump(bytes);
+        return p;
+      }
+      used_ += blocks_[block_].size - offset_;  // the tail is skipped
+      ++block_;
+      offset_ = 0;
+    }
+
+    std::size_t size = std::max(bytes, block_size_);
+    if (!blocks_.empty()) size = std::max(size, 2 * blocks_.back().size);
+    char *base = static_cast<char *>(aligned_malloc(size, alignment));
+    if (!base) throw std::bad_alloc();
+    blocks_.push_back(Block{base, size});
+    capacity_ += size;
+
+    block_ = blocks_.size() - 1;
+    offset_ = 0;
+    bump(bytes);
+    return base;
+  }
+
+  bool owns(const void *p) const {
+    const char *c = static_cast<const char *>(p);
+    for (const Block &b : blocks_)
+      if (c >= b.base && c < b.base + b.size) return true;
+    return false;
+  }
+
+  bool empty() const { return blocks_.empty(); }
+
+  // Frees every block; only valid outside of any scope.
+  void release() {
+    for (const Block &b : blocks_) aligned_free(b.base);
+    blocks_.clear();
+    block_ = offset_ = used_ = capacity_ = 0;
+  }
+
+  ArenaStats stats() const {
+    return ArenaStats{used_, high_water_, capacity_, num_allocations_,
+                      blocks_.size()};
+  }
+
+  void reset_high_water_mark() { high_water_ = used_; }
+
+ private:
+  struct Block {
+    char *base;
+    std::size_t size;
+  };
+
+  void bump(std::size_t bytes) {
+    offset_ += bytes;
+    used_ += bytes;
+    high_water_ = std::max(high_water_, used_);
+    ++num_allocations_;
+  }
+
+  std::vector<Block> blocks_;
+  std::size_t block_ = 0;   // index of the block being filled
+  std::size_t offset_ = 0;  // first free byte in that block
+  std::size_t used_ = 0;
+  std::size_t capacity_ = 0;
+  std::size_t high_water_ = 0;
+  std::size_t num_allocations_ = 0;
+  std::size_t depth_ = 0;  // number of live ArenaScope objects
+  std::size_t block_size_ = default_block_size;
+};
+
+inline Arena &thread_arena() {
+  static thread_local Arena arena;
+  return arena;
+}
+
+}  // namespace matrix_impl
+
+//! ArenaScope redirects Matrix allocations on the calling thread to an arena.
+/*!
+ * While an ArenaScope is alive, every Matrix storage allocation made by the
+ * constructing thread (including the temporaries created by the arithmetic
+ * operators) is carved out of a thread-local bump arena instead of the heap.
+ * When the scope ends, everything allocated inside it is released at once in
+ * O(1); the arena blocks are kept and reused by the next scope.
+ *
+ * Scopes nest. A Matrix allocated inside a scope must be destroyed before
+ * the scope ends and must not be handed to another thread. In particular,
+ * do not move-assign it to a Matrix that outlives the scope (`res = a + b;`);
+ * copy the values instead (`res(slice{0}, slice{0}) = a + b;` or `res += t`).
+ *
+ * \code
+ * mat res(n, n);
+ * for (int it = 0; it != iters; ++it) {
+ *   ArenaScope scope;
+ *   mat tmp = a + b * c - d;  // no malloc/free
+ *   res += tmp;
+ * }
+ * \endcode
+ */
+class ArenaScope {
+ public:
+  //! Enter a scope. block_size is the minimum size of newly reserved blocks.
+  explicit ArenaScope(
+      std::size_t block_size = matrix_impl::Arena::default_block_size)
+      : mark_(matrix_impl::thread_arena().enter(block_size)) {}
+  ~ArenaScope() { matrix_impl::thread_arena().leave(mark_); }
+
+  ArenaScope(const ArenaScope &) = delete;
+  ArenaScope &operator=(const ArenaScope &) = delete;
+
+  //! statistics of the arena of the calling thread
+  static ArenaStats stats() { return matrix_impl::thread_arena().stats(); }
+  //! restart peak tracking from the current usage
+  static void reset_high_water_mark() {
+    matrix_impl::thread_arena().reset_high_water_mark();
+  }
+  //! give the blocks of the calling thread back to the system
+  static void release() {
+    if (!matrix_impl::thread_arena().active())
+      matrix_impl::thread_arena().release();
+  }
+
+ private:
+  matrix_impl::Arena::Mark mark_;
+};
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_ARENA_H_
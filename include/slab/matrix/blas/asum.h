@@ -42,8 +42,8 @@ namespace slab {
 /// @return Contains the sum of magnitudes of real and imaginary parts
 ///         of all elements of the vector.
 ///
-template <typename T>
-inline T blas_asum(const Matrix<T, 1> &x) {
+template <typename T, typename DX>
+inline T blas_asum(const MatrixBase<T, 1, DX> &x) {
   const int n = x.size();
   const int incx = x.descriptor().strides[0];
 
@@ -42,9 +42,9 @@ namespace slab {
 /// @param y Vector with type vec/fvec/cx_vec/cx_fvec.
 /// @return Void.
 ///
-template <typename T>
-inline void blas_axpy(const T &a, const MatrixBase<T, 1> &x,
-                      MatrixBase<T, 1> &y) {
+template <typename T, typename DX, typename DY>
+inline void blas_axpy(const T &a, const MatrixBase<T, 1, DX> &x,
+                      MatrixBase<T, 1, DY> &y) {
   assert(x.size() == y.size());
 
   const int n = x.size();
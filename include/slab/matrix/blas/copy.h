@@ -40,10 +40,10 @@ namespace slab {
 /// @param y Vector with type vec/fvec/cx_vec/cx_fvec.
 /// @return Void.
 ///
-template <typename T>
-inline void blas_copy(const Matrix<T, 1> &x, Matrix<T, 1> &y) {
+template <typename T, typename DX>
+inline void blas_copy(const MatrixBase<T, 1, DX> &x, Matrix<T, 1> &y) {
   y.clear();
-  y = Matrix<T, 1>(x.size());
+  y = Matrix<T, 1>(uninitialized, x.size());
 
   const int incx = x.descriptor().strides[0];
   const int incy = y.descriptor().strides[0];
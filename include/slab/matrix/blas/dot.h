@@ -42,8 +42,9 @@ namespace slab {
 /// @param y Vector with type vec/fvec/cx_vec/cx_fvec.
 /// @return The result of the dot product of \f$x\f$ and \f$y\f$.
 ///
-template <typename T>
-inline T blas_dot(const Matrix<T, 1> &x, const Matrix<T, 1> &y) {
+template <typename T, typename DX, typename DY>
+inline T blas_dot(const MatrixBase<T, 1, DX> &x,
+                  const MatrixBase<T, 1, DY> &y) {
   assert(x.size() == y.size());
 
   const int n = x.size();
@@ -42,9 +42,9 @@ namespace slab {
 /// unconjugated y.
 /// @return Void.
 ///
-template <typename T>
-inline void blas_dotc_sub(const Matrix<T, 1> &x, const Matrix<T, 1> &y,
-                          Matrix<T, 1> &dotc) {
+template <typename T, typename DX, typename DY>
+inline void blas_dotc_sub(const MatrixBase<T, 1, DX> &x,
+                          const MatrixBase<T, 1, DY> &y, Matrix<T, 1> &dotc) {
   assert(x.size() == y.size());
 
   const int n = x.size();
@@ -41,9 +41,9 @@ namespace slab {
 /// @param dotu Contains the result of the dot product of x and y.
 /// @return Void.
 ///
-template <typename T>
-inline void blas_dotu_sub(const Matrix<T, 1> &x, const Matrix<T, 1> &y,
-                          Matrix<T, 1> &dotu) {
+template <typename T, typename DX, typename DY>
+inline void blas_dotu_sub(const MatrixBase<T, 1, DX> &x,
+                          const MatrixBase<T, 1, DY> &y, Matrix<T, 1> &dotu) {
   assert(x.size() == y.size());
 
   const int n = x.size();
@@ -28,57 +28,34 @@ namespace slab {
 /// @addtogroup blas_level3 BLAS Level 3
 /// @{
 
-template <typename T, typename T1, typename T2>
+/// Transposed views, e.g. `a.t()`, are not copied: they reach BLAS as the
+/// opposite transpose flag.
+template <typename T, typename T1, typename T2, typename TA, typename TB,
+          typename DA, typename DB, typename DC>
 inline void blas_gemm(const CBLAS_TRANSPOSE transa,
                       const CBLAS_TRANSPOSE transb, const T1 &alpha,
-                      const MatrixBase<T, 2> &a, const MatrixBase<T, 2> &b,
-                      const T2 &beta, MatrixBase<T, 2> &c) {
+                      const MatrixBase<TA, 2, DA> &a,
+                      const MatrixBase<TB, 2, DB> &b, const T2 &beta,
+                      MatrixBase<T, 2, DC> &c) {
   static_assert(Convertible<T1, T>(),
                 "blas_gemm(): incompatible element type for alpha");
   static_assert(Convertible<T2, T>(),
                 "blas_gemm(): incompatible element type for beta");
+  static_assert(Same<Remove_const<TA>, T>() && Same<Remove_const<TB>, T>(),
+                "blas_gemm(): mismatched element types");
+  if (!matrix_impl::Blas_type<T>())
+    err_quit("blas_gemm(): unsupported element type.");
 
-  const int m = c.n_rows();
-  const int n = c.n_cols();
-  int k = a.n_cols();
-
-  if (transa != CblasNoTrans) k = a.n_rows();
-
-  const int lda = a.n_cols();
-  const int ldb = b.n_cols();
-  const int ldc = c.n_cols();
+  const auto op_a = matrix_impl::gemm_arg(a).op(transa);
+  const auto op_b = matrix_impl::gemm_arg(b).op(transb);
+  assert(op_a.rows() == c.n_rows() && op_b.cols() == c.n_cols());
 
-  if (is_double<T>::value) {
-    cblas_dgemm(CblasRowMajor, transa, transb, m, n, k, (const double)alpha,
-                (const double *)(a.data() + a.descriptor().start), lda,
-                (const double *)(b.data() + b.descriptor().start), ldb,
-                (const double)beta, (double *)(c.data() + c.descriptor().start),
-                ldc);
-  } else if (is_float<T>::value) {
-    cblas_sgemm(CblasRowMajor, transa, transb, m, n, k, (const float)alpha,
-                (const float *)(a.data() + a.descriptor().start), lda,
-                (const float *)(b.data() + b.descriptor().start), ldb,
-                (const float)beta, (float *)(c.data() + c.descriptor().start),
-                ldc);
-  } else if (is_complex_double<T>::value) {
-    cblas_zgemm(
-        CblasRowMajor, transa, transb, m, n, k,
-        reinterpret_cast<const double *>(&alpha),
-        reinterpret_cast<const double *>(a.data() + a.descriptor().start), lda,
-        reinterpret_cast<const double *>(b.data() + b.descriptor().start), ldb,
-        reinterpret_cast<const double *>(&beta),
-        reinterpret_cast<double *>(c.data() + c.descriptor().start), ldc);
-  } else if (is_complex_float<T>::value) {
-    cblas_cgemm(
-        CblasRowMajor, transa, transb, m, n, k,
-        reinterpret_cast<const float *>(&alpha),
-        reinterpret_cast<const float *>(a.data() + a.descriptor().start), lda,
-        reinterpret_cast<const float *>(b.data() + b.descriptor().start), ldb,
-        reinterpret_cast<const float *>(&beta),
-        reinterpret_cast<float *>(c.data() + c.descriptor().start), ldc);
-  } else {
-    err_quit("blas_gemm(): unsupported element type.");
-  }
+  const MatrixSlice<2> &cd = c.descriptor();
+  assert(c.n_cols() <= 1 || cd.strides[1] == 1);
+  const std::size_t ldc =
+      c.n_rows() > 1 ? cd.strides[0] : std::max<std::size_t>(c.n_cols(), 1);
+  matrix_impl::gemm_into(T(alpha), op_a, op_b, T(beta), c.data() + cd.start,
+                         ldc);
 }
 
 /// @}
@@ -28,47 +28,26 @@ namespace slab {
 /// @addtogroup blas_level2 BLAS Level 2
 /// @{
 
-template <typename T>
+/// Transposed views, e.g. `a.t()`, are not copied: they reach BLAS as the
+/// opposite transpose flag.
+template <typename T, typename TA, typename TX, typename DA, typename DX,
+          typename DY>
 inline void blas_gemv(const CBLAS_TRANSPOSE trans, const T &alpha,
-                      const MatrixBase<T, 2> &a, const MatrixBase<T, 1> &x,
-                      const T &beta, MatrixBase<T, 1> &y) {
-  const int m = y.n_rows();
-  const int n = x.n_rows();
-
-  const int lda = a.n_cols();
+                      const MatrixBase<TA, 2, DA> &a,
+                      const MatrixBase<TX, 1, DX> &x, const T &beta,
+                      MatrixBase<T, 1, DY> &y) {
+  static_assert(Same<Remove_const<TA>, T>() && Same<Remove_const<TX>, T>(),
+                "blas_gemv(): mismatched element types");
+  if (!matrix_impl::Blas_type<T>())
+    err_quit("blas_gemv(): unsupported element type.");
 
-  const int incx = x.descriptor().strides[0];
-  const int incy = y.descriptor().strides[0];
+  const auto op_a = matrix_impl::gemm_arg(a).op(trans);
+  assert(op_a.rows() == y.n_rows() && op_a.cols() == x.n_rows());
 
-  if (is_double<T>::value) {
-    cblas_dgemv(CblasRowMajor, trans, m, n, (const double)alpha,
-                (const double *)(a.data() + a.descriptor().start), lda,
-                (const double *)(x.data() + x.descriptor().start), incx,
-                (const double)beta, (double *)(y.data() + y.descriptor().start),
-                incy);
-  } else if (is_float<T>::value) {
-    cblas_sgemv(CblasRowMajor, trans, m, n, (const float)alpha,
-                (const float *)(a.data() + a.descriptor().start), lda,
-                (const float *)(x.data() + x.descriptor().start), incx,
-                (const float)beta, (float *)(y.data() + y.descriptor().start),
-                incy);
-  } else if (is_complex_double<T>::value) {
-    cblas_zgemv(
-        CblasRowMajor, trans, m, n, reinterpret_cast<const double *>(&alpha),
-        reinterpret_cast<const double *>(a.data() + a.descriptor().start), lda,
-        reinterpret_cast<const double *>(x.data() + x.descriptor().start), incx,
-        reinterpret_cast<const double *>(&beta),
-        reinterpret_cast<double *>(y.data() + y.descriptor().start), incy);
-  } else if (is_complex_float<T>::value) {
-    cblas_cgemv(
-        CblasRowMajor, trans, m, n, reinterpret_cast<const float *>(&alpha),
-        reinterpret_cast<const float *>(a.data() + a.descriptor().start), lda,
-        reinterpret_cast<const float *>(x.data() + x.descriptor().start), incx,
-        reinterpret_cast<const float *>(&beta),
-        reinterpret_cast<float *>(y.data() + y.descriptor().start), incy);
-  } else {
-    err_quit("blas_gemv(): unsupported element type.");
-  }
+  const MatrixSlice<1> &xd = x.descriptor();
+  const MatrixSlice<1> &yd = y.descriptor();
+  matrix_impl::gemv_into(alpha, op_a, x.data() + xd.start, xd.strides[0], beta,
+                         y.data() + yd.start, yd.strides[0]);
 }
 
 /// @}
@@ -40,8 +40,8 @@ namespace slab {
 /// @param x Vector with type vec/fvec/cx_vec/cx_fvec.
 /// @return The Euclidean norm of the vector x.
 ///
-template <typename T>
-inline double blas_nrm2(const Matrix<T, 1> &x) {
+template <typename T, typename DX>
+inline double blas_nrm2(const MatrixBase<T, 1, DX> &x) {
   double res = 0.0;
 
   const int n = x.size();
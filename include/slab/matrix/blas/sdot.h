@@ -39,8 +39,9 @@ namespace slab {
 /// @param sy Vector with type fvec.
 /// @return The result of the dot product of sx and sy (with sb added).
 ///
-inline float blas_sdsdot(const float sb, const Matrix<float, 1> &sx,
-                         const Matrix<float, 1> &sy) {
+template <typename DX, typename DY>
+inline float blas_sdsdot(const float sb, const MatrixBase<float, 1, DX> &sx,
+                         const MatrixBase<float, 1, DY> &sy) {
   assert(sx.size() == sy.size());
 
   const int n = sx.size();
@@ -64,8 +65,9 @@ inline float blas_sdsdot(const float sb, const Matrix<float, 1> &sx,
 /// @param sy Vector with type fvec
 /// @return The result of the dot product of sx and sy
 ///
-inline double blas_dsdot(const Matrix<float, 1> &sx,
-                         const Matrix<float, 1> &sy) {
+template <typename DX, typename DY>
+inline double blas_dsdot(const MatrixBase<float, 1, DX> &sx,
+                         const MatrixBase<float, 1, DY> &sy) {
   assert(sx.size() == sy.size());
 
   const int n = sx.size();
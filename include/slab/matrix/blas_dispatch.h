@@ -0,0 +1,333 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file blas_dispatch.h
+/// @brief Routing of element-wise arithmetic to BLAS Level 1 kernels
+///
+/// Also the typed wrappers of the Level 2 and 3 kernels matmul() uses.
+///
+/// The scalar and compound operators of Matrix and MatrixRef, and the
+/// expressions `y = a * x`, `y += a * x`, `y = x + z` and `y = x - z`, are
+/// computed with cblas_?copy, cblas_?axpy and cblas_?scal when the element
+/// type is float, double, std::complex<float> or std::complex<double> and
+/// the destination has at least blas_threshold() elements. The BLAS kernels
+/// are vectorized and, in OpenBLAS and MKL, threaded; below the threshold
+/// the call overhead outweighs that and the native loops are used.
+///
+/// A matrix is handed to BLAS as one vector when it is contiguous or
+/// one-dimensional (e.g. a strided row or column), otherwise as one vector
+/// per row along its last dimension.
+
+#ifndef SLAB_MATRIX_BLAS_DISPATCH_H_
+#define SLAB_MATRIX_BLAS_DISPATCH_H_
+
+#include <cstddef>
+#include <cstdlib>
+
+#include <atomic>
+#include <complex>
+#include <limits>
+
+#ifdef USE_MKL
+#include "mkl.h"
+#else
+extern "C" {
+#include "cblas.h"
+}
+#endif
+
+#include "slab/matrix/matrix_slice.h"
+#include "slab/matrix/traits.h"
+
+namespace slab {
+
+namespace matrix_impl {
+
+inline std::atomic<std::size_t> &blas_threshold_setting() {
+  static std::atomic<std::size_t> n{0};  // 0: not decided yet
+  return n;
+}
+
+}  // namespace matrix_impl
+
+//! fewest elements for which element-wise arithmetic is routed to BLAS
+/*!
+ * Defaults to the SLAB_BLAS_THRESHOLD environment variable or, when it is
+ * not set, to 32768.
+ */
+inline std::size_t blas_threshold() {
+  std::size_t n = matrix_impl::blas_threshold_setting().load();
+  if (n == 0) {
+    const char *env = std::getenv("SLAB_BLAS_THRESHOLD");
+    if (env) n = std::strtoul(env, nullptr, 10);
+    if (n == 0) n = std::size_t(1) << 15;
+    matrix_impl::blas_threshold_setting().store(n);
+  }
+  return n;
+}
+
+//! set the fewest elements for which element-wise arithmetic uses BLAS
+inline void set_blas_threshold(std::size_t n) {
+  matrix_impl::blas_threshold_setting().store(n ? n : 1);
+}
+
+namespace matrix_impl {
+
+// Whether T is an element type of the BLAS.
+template <typename T>
+constexpr bool Blas_type() {
+  return is_double<T>::value || is_float<T>::value ||
+         is_complex_double<T>::value || is_complex_float<T>::value;
+}
+
+// Rows shorter than this are not worth a BLAS call each.
+constexpr std::size_t blas_min_row = 64;
+
+// y := x
+inline void l1_copy(int n, const float *x, int incx, float *y, int incy) {
+  cblas_scopy(n, x, incx, y, incy);
+}
+inline void l1_copy(int n, const double *x, int incx, double *y, int incy) {
+  cblas_dcopy(n, x, incx, y, incy);
+}
+inline void l1_copy(int n, const std::complex<float> *x, int incx,
+                    std::complex<float> *y, int incy) {
+  cblas_ccopy(n, reinterpret_cast<const float *>(x), incx,
+              reinterpret_cast<float *>(y), incy);
+}
+inline void l1_copy(int n, const std::complex<double> *x, int incx,
+                    std::complex<double> *y, int incy) {
+  cblas_zcopy(n, reinterpret_cast<const double *>(x), incx,
+              reinterpret_cast<double *>(y), incy);
+}
+
+// y := a * x + y
+inline void l1_axpy(int n, float a, const float *x, int incx, float *y,
+                    int incy) {
+  cblas_saxpy(n, a, x, incx, y, incy);
+}
+inline void l1_axpy(int n, double a, const double *x, int incx, double *y,
+                    int incy) {
+  cblas_daxpy(n, a, x, incx, y, incy);
+}
+inline void l1_axpy(int n, std::complex<float> a, const std::complex<float> *x,
+                    int incx, std::complex<float> *y, int incy) {
+  cblas_caxpy(n, reinterpret_cast<const float *>(&a),
+              reinterpret_cast<const float *>(x), incx,
+              reinterpret_cast<float *>(y), incy);
+}
+inline void l1_axpy(int n, std::complex<double> a,
+                    const std::complex<double> *x, int incx,
+                    std::complex<double> *y, int incy) {
+  cblas_zaxpy(n, reinterpret_cast<const double *>(&a),
+              reinterpret_cast<const double *>(x), incx,
+              reinterpret_cast<double *>(y), incy);
+}
+
+// x := a * x
+inline void l1_scal(int n, float a, float *x, int incx) {
+  cblas_sscal(n, a, x, incx);
+}
+inline void l1_scal(int n, double a, double *x, int incx) {
+  cblas_dscal(n, a, x, incx);
+}
+inline void l1_scal(int n, std::complex<float> a, std::complex<float> *x,
+                    int incx) {
+  cblas_cscal(n, reinterpret_cast<const float *>(&a),
+              reinterpret_cast<float *>(x), incx);
+}
+inline void l1_scal(int n, std::complex<double> a, std::complex<double> *x,
+                    int incx) {
+  cblas_zscal(n, reinterpret_cast<const double *>(&a),
+              reinterpret_cast<double *>(x), incx);
+}
+
+// y := alpha * op(a) * x + beta * y, row-major a of m rows and n columns
+inline void l2_gemv(CBLAS_TRANSPOSE trans, int m, int n, float alpha,
+                    const float *a, int lda, const float *x, int incx,
+                    float beta, float *y, int incy) {
+  cblas_sgemv(CblasRowMajor, trans, m, n, alpha, a, lda, x, incx, beta, y,
+              incy);
+}
+inline void l2_gemv(CBLAS_TRANSPOSE trans, int m, int n, double alpha,
+                    const double *a, int lda, const double *x, int incx,
+                    double beta, double *y, int incy) {
+  cblas_dgemv(CblasRowMajor, trans, m, n, alpha, a, lda, x, incx, beta, y,
+              incy);
+}
+inline void l2_gemv(CBLAS_TRANSPOSE trans, int m, int n,
+                    std::complex<float> alpha, const std::complex<float> *a,
+                    int lda, const std::complex<float> *x, int incx,
+                    std::complex<float> beta, std::complex<float> *y,
+                    int incy) {
+  cblas_cgemv(CblasRowMajor, trans, m, n,
+              reinterpret_cast<const float *>(&alpha),
+              reinterpret_cast<const float *>(a), lda,
+              reinterpret_cast<const float *>(x), incx,
+              reinterpret_cast<const float *>(&beta),
+              reinterpret_cast<float *>(y), incy);
+}
+inline void l2_gemv(CBLAS_TRANSPOSE trans, int m, int n,
+                    std::complex<double> alpha, const std::complex<double> *a,
+                    int lda, const std::complex<double> *x, int incx,
+                    std::complex<double> beta, std::complex<double> *y,
+                    int incy) {
+  cblas_zgemv(CblasRowMajor, trans, m, n,
+              reinterpret_cast<const double *>(&alpha),
+              reinterpret_cast<const double *>(a), lda,
+              reinterpret_cast<const double *>(x), incx,
+              reinterpret_cast<const double *>(&beta),
+              reinterpret_cast<double *>(y), incy);
+}
+
+// c := alpha * op(a) * op(b) + beta * c, row-major c of m rows and n columns
+inline void l3_gemm(CBLAS_TRANSPOSE transa, CBLAS_TRANSPOSE transb, int m,
+                    int n, int k, float alpha, const float *a, int lda,
+                    const float *b, int ldb, float beta, float *c, int ldc) {
+  cblas_sgemm(CblasRowMajor, transa, transb, m, n, k, alpha, a, lda, b, ldb,
+              beta, c, ldc);
+}
+inline void l3_gemm(CBLAS_TRANSPOSE transa, CBLAS_TRANSPOSE transb, int m,
+                    int n, int k, double alpha, const double *a, int lda,
+                    const double *b, int ldb, double beta, double *c,
+                    int ldc) {
+  cblas_dgemm(CblasRowMajor, transa, transb, m, n, k, alpha, a, lda, b, ldb,
+              beta, c, ldc);
+}
+inline void l3_gemm(CBLAS_TRANSPOSE transa, CBLAS_TRANSPOSE transb, int m,
+                    int n, int k, std::complex<float> alpha,
+                    const std::complex<float> *a, int lda,
+                    const std::complex<float> *b, int ldb,
+                    std::complex<float> beta, std::complex<float> *c,
+                    int ldc) {
+  cblas_cgemm(CblasRowMajor, transa, transb, m, n, k,
+              reinterpret_cast<const float *>(&alpha),
+              reinterpret_cast<const float *>(a), lda,
+              reinterpret_cast<const float *>(b), ldb,
+              reinterpret_cast<const float *>(&beta),
+              reinterpret_cast<float *>(c), ldc);
+}
+inline void l3_gemm(CBLAS_TRANSPOSE transa, CBLAS_TRANSPOSE transb, int m,
+                    int n, int k, std::complex<double> alpha,
+                    const std::complex<double> *a, int lda,
+                    const std::complex<double> *b, int ldb,
+                    std::complex<double> beta, std::complex<double> *c,
+                    int ldc) {
+  cblas_zgemm(CblasRowMajor, transa, transb, m, n, k,
+              reinterpret_cast<const double *>(&alpha),
+              reinterpret_cast<const double *>(a), lda,
+              reinterpret_cast<const double *>(b), ldb,
+              reinterpret_cast<const double *>(&beta),
+              reinterpret_cast<double *>(c), ldc);
+}
+
+// Whether an operation reading (xd, x) and writing (yd, y), of the same
+// extents, is worth routing to BLAS: yd has at least blas_threshold()
+// elements and, unless both slices are contiguous or one-dimensional, rows
+// long enough for one BLAS call each.
+template <std::size_t N>
+bool blas_routable(const MatrixSlice<N> &xd, const MatrixSlice<N> &yd) {
+  const std::size_t n = yd.size;
+  if (n < blas_threshold() ||
+      n > std::size_t(std::numeric_limits<int>::max()))
+    return false;
+  return N == 1 || yd.extents[N - 1] >= blas_min_row ||
+         (is_contiguous(xd) && is_contiguous(yd));
+}
+
+// Calls f(n, xoff, incx, yoff, incy) for each of the vectors BLAS sees when
+// traversing the routable slices xd and yd in step.
+template <std::size_t N, typename F>
+void blas_vectors(const MatrixSlice<N> &xd, const MatrixSlice<N> &yd, F f) {
+  if (is_contiguous(xd) && is_contiguous(yd)) {
+    f(int(yd.size), xd.start, 1, yd.start, 1);
+    return;
+  }
+
+  const std::size_t cols = yd.extents[N - 1];
+  const int incx = int(xd.strides[N - 1]);
+  const int incy = int(yd.strides[N - 1]);
+  for (std::size_t r = 0; r != yd.size / cols; ++r)
+    f(int(cols), row_offset(xd, r), incx, row_offset(yd, r), incy);
+}
+
+// The element-wise kernels below return false, doing nothing, when the
+// operation is not routed to BLAS: the element type is not a BLAS type, the
+// slices are not routable, or the source overlaps the destination shifted.
+// The caller then runs its own loop. A zero scale factor is not routed
+// either: BLAS takes it as a shortcut, setting y to 0 in scal and leaving
+// it as is in axpy, where 0 * NaN and 0 * Inf must give NaN.
+
+// (yd, y) := a * (yd, y)
+template <typename T, std::size_t N>
+Enable_if<Blas_type<T>(), bool> dispatch_scal(const T &a, T *y,
+                                              const MatrixSlice<N> &yd) {
+  if (a == T{0} || !blas_routable(yd, yd)) return false;
+  blas_vectors(yd, yd, [&](int n, std::size_t, int, std::size_t yoff,
+                           int incy) { l1_scal(n, a, y + yoff, incy); });
+  return true;
+}
+
+// (yd, y) := (xd, x)
+template <typename T, std::size_t N>
+Enable_if<Blas_type<T>(), bool> dispatch_copy(const T *x,
+                                              const MatrixSlice<N> &xd, T *y,
+                                              const MatrixSlice<N> &yd) {
+  if (!blas_routable(xd, yd) || shifted_overlap(x, xd, y, yd)) return false;
+  if (same_view(x, xd, y, yd)) return true;
+  blas_vectors(xd, yd, [&](int n, std::size_t xoff, int incx,
+                           std::size_t yoff, int incy) {
+    l1_copy(n, x + xoff, incx, y + yoff, incy);
+  });
+  return true;
+}
+
+// (yd, y) := a * (xd, x) + (yd, y)
+template <typename T, std::size_t N>
+Enable_if<Blas_type<T>(), bool> dispatch_axpy(const T &a, const T *x,
+                                              const MatrixSlice<N> &xd, T *y,
+                                              const MatrixSlice<N> &yd) {
+  if (a == T{0} || !blas_routable(xd, yd) || shifted_overlap(x, xd, y, yd))
+    return false;
+  blas_vectors(xd, yd, [&](int n, std::size_t xoff, int incx,
+                           std::size_t yoff, int incy) {
+    l1_axpy(n, a, x + xoff, incx, y + yoff, incy);
+  });
+  return true;
+}
+
+template <typename T, typename U, std::size_t N>
+bool dispatch_scal(const U &, T *, const MatrixSlice<N> &) {
+  return false;
+}
+
+template <typename T, typename U, std::size_t N>
+bool dispatch_copy(const U *, const MatrixSlice<N> &, T *,
+                   const MatrixSlice<N> &) {
+  return false;
+}
+
+template <typename T, typename U, typename V, std::size_t N>
+bool dispatch_axpy(const V &, const U *, const MatrixSlice<N> &, T *,
+                   const MatrixSlice<N> &) {
+  return false;
+}
+
+}  // namespace matrix_impl
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_BLAS_DISPATCH_H_
@@ -36,6 +36,7 @@ extern "C" {
 #include "slab/matrix/error.h"
 #include "slab/matrix/matrix.h"
 #include "slab/matrix/matrix_base.h"
+#include "slab/matrix/matrix_ops.h"
 #include "slab/matrix/traits.h"
 
 // BLAS Level 1 Routines and Functions
@@ -191,8 +192,8 @@ inline std::size_t blas_iamax(const Matrix<T, 1> &x) {
 /// @addtogroup blas_level2 BLAS Level 2
 /// @{
 
-template <typename T, typename TRI>
-inline void blas_spr(const T &alpha, const MatrixBase<T, 1> &x,
+template <typename T, typename TRI, typename DX>
+inline void blas_spr(const T &alpha, const MatrixBase<T, 1, DX> &x,
                      SymmetricMatrix<T, TRI> &ap) {
   assert(x.size() == ap.n_rows());
 
@@ -215,9 +216,10 @@ inline void blas_spr(const T &alpha, const MatrixBase<T, 1> &x,
   }
 }
 
-template <typename T, typename TRI>
-inline void blas_spr2(const T &alpha, const MatrixBase<T, 1> &x,
-                      const MatrixBase<T, 1> &y, SymmetricMatrix<T, TRI> &ap) {
+template <typename T, typename TRI, typename DX, typename DY>
+inline void blas_spr2(const T &alpha, const MatrixBase<T, 1, DX> &x,
+                      const MatrixBase<T, 1, DY> &y,
+                      SymmetricMatrix<T, TRI> &ap) {
   assert(x.size() == y.size());
   assert(x.size() == ap.n_rows());
 
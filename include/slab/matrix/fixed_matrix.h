@@ -0,0 +1,596 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file fixed_matrix.h
+/// @brief Matrices with compile-time extents
+
+#ifndef SLAB_MATRIX_FIXED_MATRIX_H_
+#define SLAB_MATRIX_FIXED_MATRIX_H_
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+
+#include <algorithm>
+#include <array>
+#include <complex>
+#include <initializer_list>
+#include <iostream>
+
+#include "slab/matrix/error.h"
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/matrix_ref.h"
+
+namespace slab {
+
+//! FixedMatrix<T,R,C> is an R x C matrix with compile-time extents.
+/*!
+ * \tparam T value type.
+ * \tparam R number of rows.
+ * \tparam C number of columns.
+ *
+ * The elements are stored row-major inside the object, there is no
+ * descriptor and every loop has a constant trip count, so the compiler
+ * fully unrolls and vectorizes the small kernels (matmul, transpose,
+ * inverse, chol, solve) below. Element-wise operators follow Matrix:
+ * `a * b` multiplies element by element, matmul() is the matrix product.
+ *
+ * A FixedMatrix converts to Matrix<T, 2>, can be built from any
+ * MatrixBase<T, 2, D> (Matrix or MatrixRef) and exposes itself as a
+ * MatrixRef<T, 2> through ref().
+ */
+template <typename T, std::size_t R, std::size_t C>
+class FixedMatrix {
+  static_assert(R > 0 && C > 0, "FixedMatrix: extents must be positive");
+
+ public:
+  //! @cond Doxygen_Suppress
+  using value_type = T;
+  using iterator = T *;
+  using const_iterator = const T *;
+
+  static constexpr std::size_t rows = R;
+  static constexpr std::size_t cols = C;
+
+  FixedMatrix() : elems_() {}  // all elements are zero
+  FixedMatrix(FixedMatrix &&) = default;
+  FixedMatrix &operator=(FixedMatrix &&) = default;
+  FixedMatrix(const FixedMatrix &) = default;
+  FixedMatrix &operator=(const FixedMatrix &) = default;
+  ~FixedMatrix() = default;
+  //! @endcond
+
+  //! leave the elements uninitialized
+  explicit FixedMatrix(uninitialized_tag) {}
+
+  //! initialize from list, e.g. {{1, 2}, {3, 4}}
+  FixedMatrix(std::initializer_list<std::initializer_list<T>> init);
+
+  //! construct from Matrix or MatrixRef
+  template <typename D>
+  explicit FixedMatrix(const MatrixBase<T, 2, D> &x) {
+    *this = x;
+  }
+  //! assign from Matrix or MatrixRef
+  template <typename D>
+  FixedMatrix &operator=(const MatrixBase<T, 2, D> &x);
+
+  //! set every element to val
+  FixedMatrix &operator=(const T &val) {
+    std::fill(begin(), end(), val);
+    return *this;
+  }
+
+  //! convert to Matrix
+  template <typename A>
+  operator Matrix<T, 2, A>() const {
+    Matrix<T, 2, A> res(uninitialized, R, C);
+    std::copy(begin(), end(), res.begin());
+    return res;
+  }
+
+  //! view as MatrixRef
+  ///@{
+  MatrixRef<T, 2> ref() { return {MatrixSlice<2>(R, C), data()}; }
+  MatrixRef<const T, 2> ref() const {
+    return {MatrixSlice<2>(R, C), data()};
+  }
+  ///@}
+
+  static constexpr std::size_t n_rows() { return R; }
+  static constexpr std::size_t n_cols() { return C; }
+  //! total number of elements
+  static constexpr std::size_t size() { return R * C; }
+
+  //! m(i,j) subscripting
+  ///@{
+  T &operator()(std::size_t i, std::size_t j) {
+    assert(i < R && j < C);
+    return elems_[i * C + j];
+  }
+  const T &operator()(std::size_t i, std::size_t j) const {
+    assert(i < R && j < C);
+    return elems_[i * C + j];
+  }
+  ///@}
+
+  //! m(i) "flat" subscripting, convenient for R x 1 and 1 x C vectors
+  ///@{
+  T &operator()(std::size_t i) {
+    assert(i < R * C);
+    return elems_[i];
+  }
+  const T &operator()(std::size_t i) const {
+    assert(i < R * C);
+    return elems_[i];
+  }
+  ///@}
+
+  //! "flat" element access
+  ///@{
+  T *data() { return elems_.data(); }
+  const T *data() const { return elems_.data(); }
+  ///@}
+
+  //! element iterators
+  ///@{
+  iterator begin() { return data(); }
+  const_iterator begin() const { return data(); }
+  iterator end() { return data() + R * C; }
+  const_iterator end() const { return data() + R * C; }
+  ///@}
+
+  //! @cond Doxygen_Suppress
+  FixedMatrix &operator+=(const T &val);
+  FixedMatrix &operator-=(const T &val);
+  FixedMatrix &operator*=(const T &val);
+  FixedMatrix &operator/=(const T &val);
+
+  FixedMatrix &operator+=(const FixedMatrix &x);
+  FixedMatrix &operator-=(const FixedMatrix &x);
+  FixedMatrix &operator*=(const FixedMatrix &x);
+  FixedMatrix &operator/=(const FixedMatrix &x);
+  //! @endcond
+
+ private:
+  std::array<T, R * C> elems_;
+};
+
+template <typename T, std::size_t R, std::size_t C>
+constexpr std::size_t FixedMatrix<T, R, C>::rows;
+
+template <typename T, std::size_t R, std::size_t C>
+constexpr std::size_t FixedMatrix<T, R, C>::cols;
+
+template <typename T, std::size_t R, std::size_t C>
+FixedMatrix<T, R, C>::FixedMatrix(
+    std::initializer_list<std::initializer_list<T>> init)
+    : elems_() {
+  assert(init.size() == R);
+
+  std::size_t i = 0;
+  for (const auto &row : init) {
+    assert(row.size() == C);
+    std::copy(row.begin(), row.end(), elems_.begin() + i * C);
+    ++i;
+  }
+}
+
+template <typename T, std::size_t R, std::size_t C>
+template <typename D>
+FixedMatrix<T, R, C> &FixedMatrix<T, R, C>::operator=(
+    const MatrixBase<T, 2, D> &x) {
+  assert(x.n_rows() == R && x.n_cols() == C);
+
+  for (std::size_t i = 0; i != R; ++i)
+    for (std::size_t j = 0; j != C; ++j) (*this)(i, j) = x(i, j);
+
+  return *this;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+FixedMatrix<T, R, C> &FixedMatrix<T, R, C>::operator+=(const T &val) {
+  for (std::size_t i = 0; i != R * C; ++i) elems_[i] += val;
+  return *this;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+FixedMatrix<T, R, C> &FixedMatrix<T, R, C>::operator-=(const T &val) {
+  for (std::size_t i = 0; i != R * C; ++i) elems_[i] -= val;
+  return *this;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+FixedMatrix<T, R, C> &FixedMatrix<T, R, C>::operator*=(const T &val) {
+  for (std::size_t i = 0; i != R * C; ++i) elems_[i] *= val;
+  return *this;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+FixedMatrix<T, R, C> &FixedMatrix<T, R, C>::operator/=(const T &val) {
+  for (std::size_t i = 0; i != R * C; ++i) elems_[i] /= val;
+  return *this;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+FixedMatrix<T, R, C> &FixedMatrix<T, R, C>::operator+=(const FixedMatrix &x) {
+  for (std::size_t i = 0; i != R * C; ++i) elems_[i] += x.elems_[i];
+  return *this;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+FixedMatrix<T, R, C> &FixedMatrix<T, R, C>::operator-=(const FixedMatrix &x) {
+  for (std::size_t i = 0; i != R * C; ++i) elems_[i] -= x.elems_[i];
+  return *this;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+FixedMatrix<T, R, C> &FixedMatrix<T, R, C>::operator*=(const FixedMatrix &x) {
+  for (std::size_t i = 0; i != R * C; ++i) elems_[i] *= x.elems_[i];
+  return *this;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+FixedMatrix<T, R, C> &FixedMatrix<T, R, C>::operator/=(const FixedMatrix &x) {
+  for (std::size_t i = 0; i != R * C; ++i) elems_[i] /= x.elems_[i];
+  return *this;
+}
+
+// -----------------------------------------------------------------------------
+// Arithmetic operators
+// -----------------------------------------------------------------------------
+
+template <typename T, std::size_t R, std::size_t C>
+inline bool operator==(const FixedMatrix<T, R, C> &a,
+                       const FixedMatrix<T, R, C> &b) {
+  return std::equal(a.begin(), a.end(), b.begin());
+}
+
+template <typename T, std::size_t R, std::size_t C>
+inline bool operator!=(const FixedMatrix<T, R, C> &a,
+                       const FixedMatrix<T, R, C> &b) {
+  return !(a == b);
+}
+
+template <typename T, std::size_t R, std::size_t C>
+inline FixedMatrix<T, R, C> operator-(const FixedMatrix<T, R, C> &x) {
+  FixedMatrix<T, R, C> res(uninitialized);
+  for (std::size_t i = 0; i != R * C; ++i) res(i) = -x(i);
+  return res;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+inline FixedMatrix<T, R, C> operator+(FixedMatrix<T, R, C> a,
+                                      const FixedMatrix<T, R, C> &b) {
+  return a += b;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+inline FixedMatrix<T, R, C> operator-(FixedMatrix<T, R, C> a,
+                                      const FixedMatrix<T, R, C> &b) {
+  return a -= b;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+inline FixedMatrix<T, R, C> operator*(FixedMatrix<T, R, C> a,
+                                      const FixedMatrix<T, R, C> &b) {
+  return a *= b;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+inline FixedMatrix<T, R, C> operator/(FixedMatrix<T, R, C> a,
+                                      const FixedMatrix<T, R, C> &b) {
+  return a /= b;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+inline FixedMatrix<T, R, C> operator+(FixedMatrix<T, R, C> x, const T &val) {
+  return x += val;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+inline FixedMatrix<T, R, C> operator+(const T &val, FixedMatrix<T, R, C> x) {
+  return x += val;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+inline FixedMatrix<T, R, C> operator-(FixedMatrix<T, R, C> x, const T &val) {
+  return x -= val;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+inline FixedMatrix<T, R, C> operator*(FixedMatrix<T, R, C> x, const T &val) {
+  return x *= val;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+inline FixedMatrix<T, R, C> operator*(const T &val, FixedMatrix<T, R, C> x) {
+  return x *= val;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+inline FixedMatrix<T, R, C> operator/(FixedMatrix<T, R, C> x, const T &val) {
+  return x /= val;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+std::ostream &operator<<(std::ostream &os, const FixedMatrix<T, R, C> &m) {
+  os << '{';
+  for (std::size_t i = 0; i != R; ++i) {
+    os << '{';
+    for (std::size_t j = 0; j != C; ++j) {
+      os << m(i, j);
+      if (j + 1 != C) os << ',';
+    }
+    os << '}';
+    if (i + 1 != R) os << ',';
+  }
+  return os << '}';
+}
+
+// -----------------------------------------------------------------------------
+// Kernels
+// -----------------------------------------------------------------------------
+
+namespace matrix_impl {
+
+template <typename T>
+inline T conj_elem(const T &x) {
+  return x;
+}
+
+template <typename T>
+inline std::complex<T> conj_elem(const std::complex<T> &x) {
+  return std::conj(x);
+}
+
+}  // namespace matrix_impl
+
+//! matrix product of two fixed-size matrices
+template <typename T, std::size_t R, std::size_t K, std::size_t C>
+inline FixedMatrix<T, R, C> matmul(const FixedMatrix<T, R, K> &a,
+                                   const FixedMatrix<T, K, C> &b) {
+  FixedMatrix<T, R, C> res;
+  // i-k-j order: the innermost loop runs along rows of b and res
+  for (std::size_t i = 0; i != R; ++i) {
+    for (std::size_t k = 0; k != K; ++k) {
+      const T aik = a(i, k);
+      for (std::size_t j = 0; j != C; ++j) res(i, j) += aik * b(k, j);
+    }
+  }
+  return res;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+inline FixedMatrix<T, C, R> transpose(const FixedMatrix<T, R, C> &a) {
+  FixedMatrix<T, C, R> res(uninitialized);
+  for (std::size_t i = 0; i != R; ++i)
+    for (std::size_t j = 0; j != C; ++j) res(j, i) = a(i, j);
+  return res;
+}
+
+//! determinant, in closed form up to 4x4 and by LU decomposition beyond
+///@{
+template <typename T>
+inline T det(const FixedMatrix<T, 1, 1> &a) {
+  return a(0);
+}
+
+template <typename T>
+inline T det(const FixedMatrix<T, 2, 2> &a) {
+  return a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0);
+}
+
+template <typename T>
+inline T det(const FixedMatrix<T, 3, 3> &a) {
+  return a(0, 0) * (a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1)) -
+         a(0, 1) * (a(1, 0) * a(2, 2) - a(1, 2) * a(2, 0)) +
+         a(0, 2) * (a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0));
+}
+
+template <typename T>
+inline T det(const FixedMatrix<T, 4, 4> &a) {
+  // Laplace expansion by complementary 2x2 minors of rows 0-1 and 2-3
+  const T s0 = a(0, 0) * a(1, 1) - a(1, 0) * a(0, 1);
+  const T s1 = a(0, 0) * a(1, 2) - a(1, 0) * a(0, 2);
+  const T s2 = a(0, 0) * a(1, 3) - a(1, 0) * a(0, 3);
+  const T s3 = a(0, 1) * a(1, 2) - a(1, 1) * a(0, 2);
+  const T s4 = a(0, 1) * a(1, 3) - a(1, 1) * a(0, 3);
+  const T s5 = a(0, 2) * a(1, 3) - a(1, 2) * a(0, 3);
+
+  const T c5 = a(2, 2) * a(3, 3) - a(3, 2) * a(2, 3);
+  const T c4 = a(2, 1) * a(3, 3) - a(3, 1) * a(2, 3);
+  const T c3 = a(2, 1) * a(3, 2) - a(3, 1) * a(2, 2);
+  const T c2 = a(2, 0) * a(3, 3) - a(3, 0) * a(2, 3);
+  const T c1 = a(2, 0) * a(3, 2) - a(3, 0) * a(2, 2);
+  const T c0 = a(2, 0) * a(3, 1) - a(3, 0) * a(2, 1);
+
+  return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+}
+
+template <typename T, std::size_t N>
+inline T det(FixedMatrix<T, N, N> a) {
+  T res = T{1};
+  for (std::size_t k = 0; k != N; ++k) {
+    std::size_t p = k;
+    for (std::size_t i = k + 1; i != N; ++i)
+      if (std::abs(a(i, k)) > std::abs(a(p, k))) p = i;
+    if (a(p, k) == T{0}) return T{0};
+    if (p != k) {
+      for (std::size_t j = 0; j != N; ++j) std::swap(a(k, j), a(p, j));
+      res = -res;
+    }
+    res *= a(k, k);
+    for (std::size_t i = k + 1; i != N; ++i) {
+      const T l = a(i, k) / a(k, k);
+      for (std::size_t j = k + 1; j != N; ++j) a(i, j) -= l * a(k, j);
+    }
+  }
+  return res;
+}
+///@}
+
+//! solve a * x = b by LU decomposition with partial pivoting
+template <typename T, std::size_t N, std::size_t C>
+inline FixedMatrix<T, N, C> solve(FixedMatrix<T, N, N> a,
+                                  FixedMatrix<T, N, C> b) {
+  for (std::size_t k = 0; k != N; ++k) {
+    std::size_t p = k;
+    for (std::size_t i = k + 1; i != N; ++i)
+      if (std::abs(a(i, k)) > std::abs(a(p, k))) p = i;
+    if (p != k) {
+      for (std::size_t j = k; j != N; ++j) std::swap(a(k, j), a(p, j));
+      for (std::size_t j = 0; j != C; ++j) std::swap(b(k, j), b(p, j));
+    }
+    for (std::size_t i = k + 1; i != N; ++i) {
+      const T l = a(i, k) / a(k, k);
+      for (std::size_t j = k + 1; j != N; ++j) a(i, j) -= l * a(k, j);
+      for (std::size_t j = 0; j != C; ++j) b(i, j) -= l * b(k, j);
+    }
+  }
+
+  // back substitution
+  for (std::size_t k = N; k-- != 0;) {
+    for (std::size_t i = k + 1; i != N; ++i) {
+      const T u = a(k, i);
+      for (std::size_t j = 0; j != C; ++j) b(k, j) -= u * b(i, j);
+    }
+    for (std::size_t j = 0; j != C; ++j) b(k, j) /= a(k, k);
+  }
+
+  return b;
+}
+
+//! inverse, in closed form up to 4x4 and by LU decomposition beyond
+///@{
+template <typename T>
+inline FixedMatrix<T, 1, 1> inverse(const FixedMatrix<T, 1, 1> &a) {
+  FixedMatrix<T, 1, 1> res(uninitialized);
+  res(0) = T{1} / a(0);
+  return res;
+}
+
+template <typename T>
+inline FixedMatrix<T, 2, 2> inverse(const FixedMatrix<T, 2, 2> &a) {
+  const T inv_det = T{1} / det(a);
+
+  FixedMatrix<T, 2, 2> res(uninitialized);
+  res(0, 0) = a(1, 1) * inv_det;
+  res(0, 1) = -a(0, 1) * inv_det;
+  res(1, 0) = -a(1, 0) * inv_det;
+  res(1, 1) = a(0, 0) * inv_det;
+  return res;
+}
+
+template <typename T>
+inline FixedMatrix<T, 3, 3> inverse(const FixedMatrix<T, 3, 3> &a) {
+  FixedMatrix<T, 3, 3> res(uninitialized);  // the adjugate first
+  res(0, 0) = a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1);
+  res(0, 1) = a(0, 2) * a(2, 1) - a(0, 1) * a(2, 2);
+  res(0, 2) = a(0, 1) * a(1, 2) - a(0, 2) * a(1, 1);
+  res(1, 0) = a(1, 2) * a(2, 0) - a(1, 0) * a(2, 2);
+  res(1, 1) = a(0, 0) * a(2, 2) - a(0, 2) * a(2, 0);
+  res(1, 2) = a(0, 2) * a(1, 0) - a(0, 0) * a(1, 2);
+  res(2, 0) = a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0);
+  res(2, 1) = a(0, 1) * a(2, 0) - a(0, 0) * a(2, 1);
+  res(2, 2) = a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0);
+
+  const T d = a(0, 0) * res(0, 0) + a(0, 1) * res(1, 0) + a(0, 2) * res(2, 0);
+  return res *= T{1} / d;
+}
+
+template <typename T>
+inline FixedMatrix<T, 4, 4> inverse(const FixedMatrix<T, 4, 4> &a) {
+  // the 2x2 minors of det(), reused for the cofactors
+  const T s0 = a(0, 0) * a(1, 1) - a(1, 0) * a(0, 1);
+  const T s1 = a(0, 0) * a(1, 2) - a(1, 0) * a(0, 2);
+  const T s2 = a(0, 0) * a(1, 3) - a(1, 0) * a(0, 3);
+  const T s3 = a(0, 1) * a(1, 2) - a(1, 1) * a(0, 2);
+  const T s4 = a(0, 1) * a(1, 3) - a(1, 1) * a(0, 3);
+  const T s5 = a(0, 2) * a(1, 3) - a(1, 2) * a(0, 3);
+
+  const T c5 = a(2, 2) * a(3, 3) - a(3, 2) * a(2, 3);
+  const T c4 = a(2, 1) * a(3, 3) - a(3, 1) * a(2, 3);
+  const T c3 = a(2, 1) * a(3, 2) - a(3, 1) * a(2, 2);
+  const T c2 = a(2, 0) * a(3, 3) - a(3, 0) * a(2, 3);
+  const T c1 = a(2, 0) * a(3, 2) - a(3, 0) * a(2, 2);
+  const T c0 = a(2, 0) * a(3, 1) - a(3, 0) * a(2, 1);
+
+  const T inv_det =
+      T{1} / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+  FixedMatrix<T, 4, 4> res(uninitialized);
+  res(0, 0) = (a(1, 1) * c5 - a(1, 2) * c4 + a(1, 3) * c3) * inv_det;
+  res(0, 1) = (-a(0, 1) * c5 + a(0, 2) * c4 - a(0, 3) * c3) * inv_det;
+  res(0, 2) = (a(3, 1) * s5 - a(3, 2) * s4 + a(3, 3) * s3) * inv_det;
+  res(0, 3) = (-a(2, 1) * s5 + a(2, 2) * s4 - a(2, 3) * s3) * inv_det;
+
+  res(1, 0) = (-a(1, 0) * c5 + a(1, 2) * c2 - a(1, 3) * c1) * inv_det;
+  res(1, 1) = (a(0, 0) * c5 - a(0, 2) * c2 + a(0, 3) * c1) * inv_det;
+  res(1, 2) = (-a(3, 0) * s5 + a(3, 2) * s2 - a(3, 3) * s1) * inv_det;
+  res(1, 3) = (a(2, 0) * s5 - a(2, 2) * s2 + a(2, 3) * s1) * inv_det;
+
+  res(2, 0) = (a(1, 0) * c4 - a(1, 1) * c2 + a(1, 3) * c0) * inv_det;
+  res(2, 1) = (-a(0, 0) * c4 + a(0, 1) * c2 - a(0, 3) * c0) * inv_det;
+  res(2, 2) = (a(3, 0) * s4 - a(3, 1) * s2 + a(3, 3) * s0) * inv_det;
+  res(2, 3) = (-a(2, 0) * s4 + a(2, 1) * s2 - a(2, 3) * s0) * inv_det;
+
+  res(3, 0) = (-a(1, 0) * c3 + a(1, 1) * c1 - a(1, 2) * c0) * inv_det;
+  res(3, 1) = (a(0, 0) * c3 - a(0, 1) * c1 + a(0, 2) * c0) * inv_det;
+  res(3, 2) = (-a(3, 0) * s3 + a(3, 1) * s1 - a(3, 2) * s0) * inv_det;
+  res(3, 3) = (a(2, 0) * s3 - a(2, 1) * s1 + a(2, 2) * s0) * inv_det;
+  return res;
+}
+
+template <typename T, std::size_t N>
+inline FixedMatrix<T, N, N> inverse(const FixedMatrix<T, N, N> &a) {
+  FixedMatrix<T, N, N> id;
+  for (std::size_t i = 0; i != N; ++i) id(i, i) = T{1};
+  return solve(a, id);
+}
+///@}
+
+//! inverse of a, as solve(a) does for Matrix
+template <typename T, std::size_t N>
+inline FixedMatrix<T, N, N> solve(const FixedMatrix<T, N, N> &a) {
+  return inverse(a);
+}
+
+//! upper triangular R with a = R^H * R, as chol() does for Matrix
+template <typename T, std::size_t N>
+inline FixedMatrix<T, N, N> chol(const FixedMatrix<T, N, N> &a) {
+  FixedMatrix<T, N, N> res;
+  for (std::size_t j = 0; j != N; ++j) {
+    T d = a(j, j);
+    for (std::size_t k = 0; k != j; ++k)
+      d -= matrix_impl::conj_elem(res(k, j)) * res(k, j);
+    if (!(std::real(d) > 0)) err_quit("chol(): unsuccessful");
+
+    const T rjj = T(std::sqrt(std::real(d)));
+    res(j, j) = rjj;
+    for (std::size_t i = j + 1; i != N; ++i) {
+      T s = a(j, i);
+      for (std::size_t k = 0; k != j; ++k)
+        s -= matrix_impl::conj_elem(res(k, j)) * res(k, i);
+      res(j, i) = s / rjj;
+    }
+  }
+  return res;
+}
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_FIXED_MATRIX_H_
@@ -24,14 +24,18 @@ namespace slab {
 
 template <typename T>
 inline Matrix<T, 2> chol(const Matrix<T, 2> &x) {
+  SLAB_MATRIX_SCOPE("chol");
   assert(x.n_rows() == x.n_cols());
 
   Matrix<T, 2> x_copy(x);
   int info = lapack_potrf(x_copy);
   if (info) err_quit("chol(): unsuccessful");
 
-  Matrix<T, 2> res = zeros<Matrix<T, 2>>(x.n_rows(), x.n_cols());
+  Matrix<T, 2> res(uninitialized, x.n_rows(), x.n_cols());
   for (std::size_t i = 0; i != x.n_rows(); ++i) {
+    for (std::size_t j = 0; j != i; ++j) {
+      res(i, j) = T{0};
+    }
     for (std::size_t j = i; j != x.n_cols(); ++j) {
       res(i, j) = x_copy(i, j);
     }
@@ -24,6 +24,7 @@ namespace slab {
 
 template <typename T>
 inline Matrix<T, 2> diagmat(const Matrix<T, 1> &x) {
+  SLAB_MATRIX_SCOPE("diagmat");
   Matrix<T, 2> res(x.size(), x.size());
   res.diag() = x;
 
@@ -24,8 +24,11 @@ namespace slab {
 
 template <typename M, typename... Args>
 Enable_if<Matrix_type<M>(), M> eye(std::size_t i, std::size_t j) {
+  SLAB_MATRIX_SCOPE("eye");
   assert(M::order() == 2);
-  M res(i, j);
+  M res(uninitialized, i, j);
+  matrix_impl::first_touch_fill(res.data(), res.descriptor(),
+                                typename M::value_type(0));
   res.diag() = 1;
 
   return res;
@@ -24,13 +24,14 @@ namespace slab {
 
 template <typename T>
 inline Matrix<T, 2> inverse(const Matrix<T, 2> &a) {
+  SLAB_MATRIX_SCOPE("inverse");
   assert(a.n_rows() == a.n_cols());
 
   int info;
   const int m = a.n_rows();
   const int n = a.n_cols();
   const int lda = a.n_cols();
-  Matrix<int, 1> ipiv(n);
+  Matrix<int, 1> ipiv(uninitialized, n);
 
   Matrix<T, 2> res = a;
   if (is_double<T>::value) {
@@ -74,7 +75,7 @@ inline bool inv(Matrix<double, 2> &b, const Matrix<double, 2> &a) {
   int ldb = b.n_cols();
 
   Matrix<double, 2> a_copy = a;
-  Matrix<int, 1> ipiv(n);
+  Matrix<int, 1> ipiv(uninitialized, n);
 
   int info = LAPACKE_dgesv(LAPACK_ROW_MAJOR, n, nrhs, (double *)a_copy.data(),
                            lda, ipiv.data(), (double *)b.data(), ldb);
@@ -25,7 +25,7 @@ namespace slab {
 // join_vecs()
 template <typename T>
 inline Matrix<T, 1> join_vecs(const Matrix<T, 1> &a, const Matrix<T, 1> &b) {
-  Matrix<T, 1> res(a.n_rows() + b.n_rows());
+  Matrix<T, 1> res(uninitialized, a.n_rows() + b.n_rows());
   res(slice{0, a.n_rows()}) = a;
   res(slice{a.n_rows(), b.n_rows()}) = b;
 
@@ -35,7 +35,7 @@ inline Matrix<T, 1> join_vecs(const Matrix<T, 1> &a, const Matrix<T, 1> &b) {
 template <typename T>
 inline Matrix<T, 1> join_vecs(const MatrixRef<T, 1> &a,
                               const MatrixRef<T, 1> &b) {
-  Matrix<T, 1> res(a.n_rows() + b.n_rows());
+  Matrix<T, 1> res(uninitialized, a.n_rows() + b.n_rows());
   res(slice{0, a.n_rows()}) = a;
   res(slice{a.n_rows(), b.n_rows()}) = b;
 
@@ -44,7 +44,7 @@ inline Matrix<T, 1> join_vecs(const MatrixRef<T, 1> &a,
 
 template <typename T>
 inline Matrix<T, 1> join_vecs(const Matrix<T, 1> &a, const MatrixRef<T, 1> &b) {
-  Matrix<T, 1> res(a.n_rows() + b.n_rows());
+  Matrix<T, 1> res(uninitialized, a.n_rows() + b.n_rows());
   res(slice{0, a.n_rows()}) = a;
   res(slice{a.n_rows(), b.n_rows()}) = b;
 
@@ -53,7 +53,7 @@ inline Matrix<T, 1> join_vecs(const Matrix<T, 1> &a, const MatrixRef<T, 1> &b) {
 
 template <typename T>
 inline Matrix<T, 1> join_vecs(const MatrixRef<T, 1> &a, const Matrix<T, 1> &b) {
-  Matrix<T, 1> res(a.n_rows() + b.n_rows());
+  Matrix<T, 1> res(uninitialized, a.n_rows() + b.n_rows());
   res(slice{0, a.n_rows()}) = a;
   res(slice{a.n_rows(), b.n_rows()}) = b;
 
@@ -74,6 +74,7 @@ inline Matrix<T, 1> join_vecs(const MatrixRef<T, 1> &x, Args... args) {
 
 template <typename T>
 inline Matrix<T, 2> join_rows(const Matrix<T, 2> &a, const Matrix<T, 2> &b) {
+  SLAB_MATRIX_SCOPE("join_rows");
   Matrix<T, 2> res;
   if (a.empty() && b.empty())
     return res;
@@ -84,7 +85,7 @@ inline Matrix<T, 2> join_rows(const Matrix<T, 2> &a, const Matrix<T, 2> &b) {
   else if (a.n_rows() != b.n_rows())
     err_quit("joint_rows(): inconsistent number of rows");
 
-  res = slab::zeros<Matrix<T, 2>>(a.n_rows(), a.n_cols() + b.n_cols());
+  res = Matrix<T, 2>(uninitialized, a.n_rows(), a.n_cols() + b.n_cols());
   res(slice{0, a.n_rows()}, slice{0, a.n_cols()}) = a;
   res(slice{0, a.n_rows()}, slice{a.n_cols(), b.n_cols()}) = b;
 
@@ -94,9 +95,10 @@ inline Matrix<T, 2> join_rows(const Matrix<T, 2> &a, const Matrix<T, 2> &b) {
 template <typename T>
 inline Matrix<T, 2> join_rows(const MatrixRef<T, 2> &a,
                               const MatrixRef<T, 2> &b) {
+  SLAB_MATRIX_SCOPE("join_rows");
   assert(a.n_rows() == b.n_rows());
 
-  Matrix<T, 2> res(a.n_rows(), a.n_cols() + b.n_cols());
+  Matrix<T, 2> res(uninitialized, a.n_rows(), a.n_cols() + b.n_cols());
   res(slice{0, a.n_rows()}, slice{0, a.n_cols()}) = a;
   res(slice{0, a.n_rows()}, slice{a.n_cols(), b.n_cols()}) = b;
 
@@ -105,9 +107,10 @@ inline Matrix<T, 2> join_rows(const MatrixRef<T, 2> &a,
 
 template <typename T>
 inline Matrix<T, 2> join_rows(const Matrix<T, 2> &a, const MatrixRef<T, 2> &b) {
+  SLAB_MATRIX_SCOPE("join_rows");
   assert(a.n_rows() == b.n_rows());
 
-  Matrix<T, 2> res(a.n_rows(), a.n_cols() + b.n_cols());
+  Matrix<T, 2> res(uninitialized, a.n_rows(), a.n_cols() + b.n_cols());
   res(slice{0, a.n_rows()}, slice{0, a.n_cols()}) = a;
   res(slice{0, a.n_rows()}, slice{a.n_cols(), b.n_cols()}) = b;
 
@@ -116,9 +119,10 @@ inline Matrix<T, 2> join_rows(const Matrix<T, 2> &a, const MatrixRef<T, 2> &b) {
 
 template <typename T>
 inline Matrix<T, 2> join_rows(const MatrixRef<T, 2> &a, const Matrix<T, 2> &b) {
+  SLAB_MATRIX_SCOPE("join_rows");
   assert(a.n_rows() == b.n_rows());
 
-  Matrix<T, 2> res(a.n_rows(), a.n_cols() + b.n_cols());
+  Matrix<T, 2> res(uninitialized, a.n_rows(), a.n_cols() + b.n_cols());
   res(slice{0, a.n_rows()}, slice{0, a.n_cols()}) = a;
   res(slice{0, a.n_rows()}, slice{a.n_cols(), b.n_cols()}) = b;
 
@@ -129,6 +133,7 @@ inline Matrix<T, 2> join_rows(const MatrixRef<T, 2> &a, const Matrix<T, 2> &b) {
 
 template <typename T>
 inline Matrix<T, 2> join_cols(const Matrix<T, 2> &a, const Matrix<T, 2> &b) {
+  SLAB_MATRIX_SCOPE("join_cols");
   Matrix<T, 2> res;
   if (a.empty() && b.empty())
     return res;
@@ -139,7 +144,7 @@ inline Matrix<T, 2> join_cols(const Matrix<T, 2> &a, const Matrix<T, 2> &b) {
   else if (a.n_cols() != b.n_cols())
     err_quit("joint_rows(): inconsistent number of columns");
 
-  res = slab::zeros<Matrix<T, 2>>(a.n_rows() + b.n_rows(), a.n_cols());
+  res = Matrix<T, 2>(uninitialized, a.n_rows() + b.n_rows(), a.n_cols());
   res(slice{0, a.n_rows()}, slice{0, a.n_cols()}) = a;
   res(slice{a.n_rows(), b.n_rows()}, slice{0, a.n_cols()}) = b;
 
@@ -149,9 +154,10 @@ inline Matrix<T, 2> join_cols(const Matrix<T, 2> &a, const Matrix<T, 2> &b) {
 template <typename T>
 inline Matrix<T, 2> join_cols(const MatrixRef<T, 2> &a,
                               const MatrixRef<T, 2> &b) {
+  SLAB_MATRIX_SCOPE("join_cols");
   assert(a.n_cols() == b.n_cols());
 
-  Matrix<T, 2> res(a.n_rows() + b.n_rows(), a.n_cols());
+  Matrix<T, 2> res(uninitialized, a.n_rows() + b.n_rows(), a.n_cols());
   res(slice{0, a.n_rows()}, slice{0, a.n_cols()}) = a;
   res(slice{a.n_rows(), b.n_rows()}, slice{0, a.n_cols()}) = b;
 
@@ -160,9 +166,10 @@ inline Matrix<T, 2> join_cols(const MatrixRef<T, 2> &a,
 
 template <typename T>
 inline Matrix<T, 2> join_cols(const Matrix<T, 2> &a, const MatrixRef<T, 2> &b) {
+  SLAB_MATRIX_SCOPE("join_cols");
   assert(a.n_cols() == b.n_cols());
 
-  Matrix<T, 2> res(a.n_rows() + b.n_rows(), a.n_cols());
+  Matrix<T, 2> res(uninitialized, a.n_rows() + b.n_rows(), a.n_cols());
   res(slice{0, a.n_rows()}, slice{0, a.n_cols()}) = a;
   res(slice{a.n_rows(), b.n_rows()}, slice{0, a.n_cols()}) = b;
 
@@ -171,9 +178,10 @@ inline Matrix<T, 2> join_cols(const Matrix<T, 2> &a, const MatrixRef<T, 2> &b) {
 
 template <typename T>
 inline Matrix<T, 2> join_cols(const MatrixRef<T, 2> &a, const Matrix<T, 2> &b) {
+  SLAB_MATRIX_SCOPE("join_cols");
   assert(a.n_cols() == b.n_cols());
 
-  Matrix<T, 2> res(a.n_rows() + b.n_rows(), a.n_cols());
+  Matrix<T, 2> res(uninitialized, a.n_rows() + b.n_rows(), a.n_cols());
   res(slice{0, a.n_rows()}, slice{0, a.n_cols()}) = a;
   res(slice{a.n_rows(), b.n_rows()}, slice{0, a.n_cols()}) = b;
 
@@ -16,29 +16,147 @@
 
 /// @file kron.h
 /// @brief Kronecker tensor product.
+///
+/// kron(a, b) of two matrices, or of two vectors, takes matrices and views
+/// alike; kron_into(a, b, out) writes the product into an existing matrix or
+/// view and kron_add(a, b, out) adds it to one, without a temporary. All
+/// three run the kernel of kron_kernel.h.
 
 #ifndef SLAB_MATRIX_FNS_KRON_H_
 #define SLAB_MATRIX_FNS_KRON_H_
 
 namespace slab {
 
+namespace matrix_impl {
+
+// A vector as a 1 x n matrix: the product of two vectors is that of the
+// two rows.
+inline MatrixSlice<2> kron_slice(const MatrixSlice<1> &d) {
+  return MatrixSlice<2>(d.start, {1, d.extents[0]},
+                        {d.extents[0] * d.strides[0], d.strides[0]});
+}
+
+inline const MatrixSlice<2> &kron_slice(const MatrixSlice<2> &d) { return d; }
+
+template <std::size_t N>
+std::array<std::size_t, N> kron_extents(const MatrixSlice<N> &ad,
+                                        const MatrixSlice<N> &bd) {
+  static_assert(N == 1 || N == 2, "kron: vectors or matrices only");
+  std::array<std::size_t, N> exts;
+  for (std::size_t d = 0; d != N; ++d)
+    exts[d] = ad.extents[d] * bd.extents[d];
+  return exts;
+}
+
+// (cd, c) := kron((ad, a), (bd, b)), or += when add is true, for any
+// strides: a b with strided rows is copied once, and so is a c with them.
+// A c that overlaps a or b is computed into a temporary first.
 template <typename T>
-inline Matrix<T, 2> kron(const Matrix<T, 2> &a, const Matrix<T, 2> &b) {
-  const std::size_t a_rows = a.n_rows();
-  const std::size_t a_cols = a.n_cols();
-  const std::size_t b_rows = b.n_rows();
-  const std::size_t b_cols = b.n_cols();
-
-  Matrix<T, 2> res(a_rows * b_rows, a_cols * b_cols);
-  for (std::size_t j = 0; j != a_cols; ++j) {
-    for (std::size_t i = 0; i != a_rows; ++i) {
-      res(slice{i * b_rows, b_rows}, slice{j * b_cols, b_cols}) = a(i, j) * b;
-    }
+void kron_views(const T *a, const MatrixSlice<2> &ad, const T *b,
+                const MatrixSlice<2> &bd, T *c, const MatrixSlice<2> &cd,
+                bool add) {
+  if (may_view(c, cd, a, ad) || may_view(c, cd, b, bd)) {
+    Matrix<T, 2> res(uninitialized, cd.extents);
+    kron_views(a, ad, b, bd, res.data(), res.descriptor(), false);
+    MatrixRef<T, 2> out(cd, c);
+    if (add)
+      out += res;
+    else
+      out = res;
+  } else if (bd.extents[1] > 1 && bd.strides[1] != 1) {
+    const Matrix<T, 2> packed = MatrixRef<const T, 2>(bd, b);
+    kron_views(a, ad, packed.data(), packed.descriptor(), c, cd, add);
+  } else if (cd.extents[1] > 1 && cd.strides[1] != 1) {
+    MatrixRef<T, 2> out(cd, c);
+    Matrix<T, 2> res(uninitialized, cd.extents);
+    if (add) res = out;
+    kron_kernel(a, ad, b, bd, res.data(), res.descriptor(), add);
+    out = res;
+  } else {
+    kron_kernel(a, ad, b, bd, c, cd, add);
   }
+}
+
+template <typename U, typename V, std::size_t N, typename DA, typename DB,
+          typename T>
+void kron_to(const MatrixBase<U, N, DA> &a, const MatrixBase<V, N, DB> &b,
+             T *c, const MatrixSlice<N> &cd, bool add) {
+  static_assert(Same<Remove_const<U>, T>() && Same<Remove_const<V>, T>(),
+                "kron: the matrices must have the same element type");
+  SLAB_MATRIX_SCOPE("kron");
+  kron_views<T>(a.data(), kron_slice(a.descriptor()), b.data(),
+                kron_slice(b.descriptor()), c, kron_slice(cd), add);
+}
+
+}  // namespace matrix_impl
 
+//! Kronecker tensor product
+/*!
+ * For an m x n matrix a and a p x q matrix b, the mp x nq matrix of the
+ * blocks a(i, j) * b; for vectors of m and p elements, the vector of the
+ * mp elements a(i) * b(k), at i * p + k.
+ */
+template <typename U, typename V, std::size_t N, typename DA, typename DB,
+          typename T = Remove_const<U>>
+inline Matrix<T, N> kron(const MatrixBase<U, N, DA> &a,
+                         const MatrixBase<V, N, DB> &b) {
+  Matrix<T, N> res(uninitialized,
+                   matrix_impl::kron_extents(a.descriptor(), b.descriptor()));
+  matrix_impl::kron_to(a, b, res.data(), res.descriptor(), false);
   return res;
 }
 
+//! out = kron(a, b); a matrix out is resized, a view must have the extents
+//! of the product already. out may be a or b, or overlap them, at the cost
+//! of a temporary.
+///@{
+template <typename U, typename V, std::size_t N, typename DA, typename DB,
+          typename T, typename A>
+inline void kron_into(const MatrixBase<U, N, DA> &a,
+                      const MatrixBase<V, N, DB> &b, Matrix<T, N, A> &out) {
+  const auto exts = matrix_impl::kron_extents(a.descriptor(), b.descriptor());
+  if (out.descriptor().extents != exts) {
+    // made before out lets go of its elements, which a or b may be
+    Matrix<T, N, A> res(uninitialized, exts);
+    matrix_impl::kron_to(a, b, res.data(), res.descriptor(), false);
+    out = std::move(res);
+    return;
+  }
+  matrix_impl::kron_to(a, b, out.data(), out.descriptor(), false);
+}
+
+template <typename U, typename V, std::size_t N, typename DA, typename DB,
+          typename T>
+inline void kron_into(const MatrixBase<U, N, DA> &a,
+                      const MatrixBase<V, N, DB> &b, MatrixRef<T, N> out) {
+  assert(out.descriptor().extents ==
+         matrix_impl::kron_extents(a.descriptor(), b.descriptor()));
+  matrix_impl::kron_to(a, b, out.data(), out.descriptor(), false);
+}
+///@}
+
+//! out += kron(a, b), where out has the extents of the product and may be
+//! a or b, or overlap them, as for kron_into()
+///@{
+template <typename U, typename V, std::size_t N, typename DA, typename DB,
+          typename T, typename A>
+inline void kron_add(const MatrixBase<U, N, DA> &a,
+                     const MatrixBase<V, N, DB> &b, Matrix<T, N, A> &out) {
+  assert(out.descriptor().extents ==
+         matrix_impl::kron_extents(a.descriptor(), b.descriptor()));
+  matrix_impl::kron_to(a, b, out.data(), out.descriptor(), true);
+}
+
+template <typename U, typename V, std::size_t N, typename DA, typename DB,
+          typename T>
+inline void kron_add(const MatrixBase<U, N, DA> &a,
+                     const MatrixBase<V, N, DB> &b, MatrixRef<T, N> out) {
+  assert(out.descriptor().extents ==
+         matrix_impl::kron_extents(a.descriptor(), b.descriptor()));
+  matrix_impl::kron_to(a, b, out.data(), out.descriptor(), true);
+}
+///@}
+
 }  // namespace slab
 
 #endif  // SLAB_MATRIX_FNS_KRON_H_
@@ -16,62 +16,310 @@
 
 /// @file misc.h
 /// @brief Miscellaneous element-wise functions.
+///
+/// Each function f has four overloads returning a new matrix, and f_into(x,
+/// out) writing into an existing one. float and double elements go through
+/// the vectorized kernels of vmath.h, where the accuracy of each is listed.
 
 #ifndef SLAB_MATRIX_FNS_MISC_H_
 #define SLAB_MATRIX_FNS_MISC_H_
 
 namespace slab {
 
-template <typename U, std::size_t N, typename T = typename std::remove_const<U>::type>
+//! e^x element by element
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
 inline Matrix<T, N> exp(const Matrix<U, N> &x) {
-  Matrix<T, N> res = x;
-  res.apply([](T &a) { a = std::exp(a); });
-
-  return res;
+  SLAB_MATRIX_SCOPE("exp");
+  return matrix_impl::vm_apply(matrix_impl::vm_exp_kernel(), x);
 }
 
-template <typename U, std::size_t N, typename T = typename std::remove_const<U>::type>
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
 inline Matrix<T, N> exp(const MatrixRef<U, N> &x) {
-  Matrix<T, N> res = x;
-  res.apply([](T &a) { a = std::exp(a); });
+  SLAB_MATRIX_SCOPE("exp");
+  return matrix_impl::vm_apply(matrix_impl::vm_exp_kernel(), x);
+}
+
+// The overloads for temporaries compute in place of their argument; an
+// expression argument is evaluated once, into a matrix it owns if any.
+
+template <typename T, std::size_t N>
+inline Matrix<T, N> exp(Matrix<T, N> &&x) {
+  SLAB_MATRIX_SCOPE("exp");
+  return matrix_impl::vm_apply(matrix_impl::vm_exp_kernel(), std::move(x));
+}
+
+template <typename E, typename T = typename E::value_type>
+inline Matrix<T, MatrixExpr<E>::order_> exp(MatrixExpr<E> x) {
+  SLAB_MATRIX_SCOPE("exp");
+  return matrix_impl::vm_apply(matrix_impl::vm_exp_kernel(),
+                               Matrix<T, MatrixExpr<E>::order_>(std::move(x)));
+}
+
+//! out = exp(x) without a temporary; a Matrix out is resized to the extents
+//! of x, a MatrixRef out must have them. x may be out itself.
+template <typename U, std::size_t N, typename D, typename Out>
+inline void exp_into(const MatrixBase<U, N, D> &x, Out &&out) {
+  SLAB_MATRIX_SCOPE("exp_into");
+  matrix_impl::vm_into(matrix_impl::vm_exp_kernel(), x, out);
+}
 
-  return res;
+//! e^x - 1 element by element, accurate for small x
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> expm1(const Matrix<U, N> &x) {
+  SLAB_MATRIX_SCOPE("expm1");
+  return matrix_impl::vm_apply(matrix_impl::vm_expm1_kernel(), x);
+}
+
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> expm1(const MatrixRef<U, N> &x) {
+  SLAB_MATRIX_SCOPE("expm1");
+  return matrix_impl::vm_apply(matrix_impl::vm_expm1_kernel(), x);
 }
 
 template <typename T, std::size_t N>
-inline Matrix<T, N> log(const Matrix<T, N> &x) {
-  Matrix<T, N> res = x;
-  res.apply([](T &a) { a = std::log(a); });
+inline Matrix<T, N> expm1(Matrix<T, N> &&x) {
+  SLAB_MATRIX_SCOPE("expm1");
+  return matrix_impl::vm_apply(matrix_impl::vm_expm1_kernel(), std::move(x));
+}
+
+template <typename E, typename T = typename E::value_type>
+inline Matrix<T, MatrixExpr<E>::order_> expm1(MatrixExpr<E> x) {
+  SLAB_MATRIX_SCOPE("expm1");
+  return matrix_impl::vm_apply(matrix_impl::vm_expm1_kernel(),
+                               Matrix<T, MatrixExpr<E>::order_>(std::move(x)));
+}
+
+//! out = expm1(x) without a temporary; a Matrix out is resized to the extents
+//! of x, a MatrixRef out must have them. x may be out itself.
+template <typename U, std::size_t N, typename D, typename Out>
+inline void expm1_into(const MatrixBase<U, N, D> &x, Out &&out) {
+  SLAB_MATRIX_SCOPE("expm1_into");
+  matrix_impl::vm_into(matrix_impl::vm_expm1_kernel(), x, out);
+}
+
+//! natural logarithm element by element
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> log(const Matrix<U, N> &x) {
+  SLAB_MATRIX_SCOPE("log");
+  return matrix_impl::vm_apply(matrix_impl::vm_log_kernel(), x);
+}
 
-  return res;
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> log(const MatrixRef<U, N> &x) {
+  SLAB_MATRIX_SCOPE("log");
+  return matrix_impl::vm_apply(matrix_impl::vm_log_kernel(), x);
 }
 
 template <typename T, std::size_t N>
-inline Matrix<T, N> log(const MatrixRef<T, N> &x) {
-  Matrix<T, N> res = x;
-  res.apply([](T &a) { a = std::log(a); });
+inline Matrix<T, N> log(Matrix<T, N> &&x) {
+  SLAB_MATRIX_SCOPE("log");
+  return matrix_impl::vm_apply(matrix_impl::vm_log_kernel(), std::move(x));
+}
+
+template <typename E, typename T = typename E::value_type>
+inline Matrix<T, MatrixExpr<E>::order_> log(MatrixExpr<E> x) {
+  SLAB_MATRIX_SCOPE("log");
+  return matrix_impl::vm_apply(matrix_impl::vm_log_kernel(),
+                               Matrix<T, MatrixExpr<E>::order_>(std::move(x)));
+}
+
+//! out = log(x) without a temporary; a Matrix out is resized to the extents
+//! of x, a MatrixRef out must have them. x may be out itself.
+template <typename U, std::size_t N, typename D, typename Out>
+inline void log_into(const MatrixBase<U, N, D> &x, Out &&out) {
+  SLAB_MATRIX_SCOPE("log_into");
+  matrix_impl::vm_into(matrix_impl::vm_log_kernel(), x, out);
+}
+
+//! log(1 + x) element by element, accurate for small x
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> log1p(const Matrix<U, N> &x) {
+  SLAB_MATRIX_SCOPE("log1p");
+  return matrix_impl::vm_apply(matrix_impl::vm_log1p_kernel(), x);
+}
+
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> log1p(const MatrixRef<U, N> &x) {
+  SLAB_MATRIX_SCOPE("log1p");
+  return matrix_impl::vm_apply(matrix_impl::vm_log1p_kernel(), x);
+}
 
-  return res;
+template <typename T, std::size_t N>
+inline Matrix<T, N> log1p(Matrix<T, N> &&x) {
+  SLAB_MATRIX_SCOPE("log1p");
+  return matrix_impl::vm_apply(matrix_impl::vm_log1p_kernel(), std::move(x));
+}
+
+template <typename E, typename T = typename E::value_type>
+inline Matrix<T, MatrixExpr<E>::order_> log1p(MatrixExpr<E> x) {
+  SLAB_MATRIX_SCOPE("log1p");
+  return matrix_impl::vm_apply(matrix_impl::vm_log1p_kernel(),
+                               Matrix<T, MatrixExpr<E>::order_>(std::move(x)));
+}
+
+//! out = log1p(x) without a temporary; a Matrix out is resized to the extents
+//! of x, a MatrixRef out must have them. x may be out itself.
+template <typename U, std::size_t N, typename D, typename Out>
+inline void log1p_into(const MatrixBase<U, N, D> &x, Out &&out) {
+  SLAB_MATRIX_SCOPE("log1p_into");
+  matrix_impl::vm_into(matrix_impl::vm_log1p_kernel(), x, out);
 }
 
+//! x^val element by element
 template <typename T, typename T1, std::size_t N>
 inline Matrix<T, N> pow(const Matrix<T, N> &x, const T1 &val) {
+  SLAB_MATRIX_SCOPE("pow");
   static_assert(Convertible<T1, T>(), "pow(): incompatible element types");
+  return matrix_impl::vm_apply(matrix_impl::vm_pow_kernel<T1>{val}, x);
+}
 
-  Matrix<T, N> res = x;
-  res.apply([&](T &a) { a = std::pow(a, static_cast<T>(val)); });
-
-  return res;
+template <typename T, typename T1, std::size_t N>
+inline Matrix<Remove_const<T>, N> pow(const MatrixRef<T, N> &x,
+                                      const T1 &val) {
+  SLAB_MATRIX_SCOPE("pow");
+  static_assert(Convertible<T1, T>(), "pow(): incompatible element types");
+  return matrix_impl::vm_apply(matrix_impl::vm_pow_kernel<T1>{val}, x);
 }
 
 template <typename T, typename T1, std::size_t N>
-inline Matrix<T, N> pow(const MatrixRef<T, N> &x, const T1 &val) {
+inline Matrix<T, N> pow(Matrix<T, N> &&x, const T1 &val) {
+  SLAB_MATRIX_SCOPE("pow");
   static_assert(Convertible<T1, T>(), "pow(): incompatible element types");
+  return matrix_impl::vm_apply(matrix_impl::vm_pow_kernel<T1>{val},
+                               std::move(x));
+}
+
+template <typename E, typename T1, typename T = typename E::value_type>
+inline Matrix<T, MatrixExpr<E>::order_> pow(MatrixExpr<E> x, const T1 &val) {
+  SLAB_MATRIX_SCOPE("pow");
+  static_assert(Convertible<T1, T>(), "pow(): incompatible element types");
+  return matrix_impl::vm_apply(matrix_impl::vm_pow_kernel<T1>{val},
+                               Matrix<T, MatrixExpr<E>::order_>(std::move(x)));
+}
+
+//! out = pow(x, val) without a temporary, as exp_into()
+template <typename U, std::size_t N, typename D, typename T1, typename Out>
+inline void pow_into(const MatrixBase<U, N, D> &x, const T1 &val, Out &&out) {
+  SLAB_MATRIX_SCOPE("pow_into");
+  static_assert(Convertible<T1, Remove_const<U>>(),
+                "pow(): incompatible element types");
+  matrix_impl::vm_into(matrix_impl::vm_pow_kernel<T1>{val}, x, out);
+}
+
+//! square root element by element
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> sqrt(const Matrix<U, N> &x) {
+  SLAB_MATRIX_SCOPE("sqrt");
+  return matrix_impl::vm_apply(matrix_impl::vm_sqrt_kernel(), x);
+}
+
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> sqrt(const MatrixRef<U, N> &x) {
+  SLAB_MATRIX_SCOPE("sqrt");
+  return matrix_impl::vm_apply(matrix_impl::vm_sqrt_kernel(), x);
+}
+
+template <typename T, std::size_t N>
+inline Matrix<T, N> sqrt(Matrix<T, N> &&x) {
+  SLAB_MATRIX_SCOPE("sqrt");
+  return matrix_impl::vm_apply(matrix_impl::vm_sqrt_kernel(), std::move(x));
+}
+
+template <typename E, typename T = typename E::value_type>
+inline Matrix<T, MatrixExpr<E>::order_> sqrt(MatrixExpr<E> x) {
+  SLAB_MATRIX_SCOPE("sqrt");
+  return matrix_impl::vm_apply(matrix_impl::vm_sqrt_kernel(),
+                               Matrix<T, MatrixExpr<E>::order_>(std::move(x)));
+}
+
+//! out = sqrt(x) without a temporary; a Matrix out is resized to the extents
+//! of x, a MatrixRef out must have them. x may be out itself.
+template <typename U, std::size_t N, typename D, typename Out>
+inline void sqrt_into(const MatrixBase<U, N, D> &x, Out &&out) {
+  SLAB_MATRIX_SCOPE("sqrt_into");
+  matrix_impl::vm_into(matrix_impl::vm_sqrt_kernel(), x, out);
+}
+
+//! error function element by element
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> erf(const Matrix<U, N> &x) {
+  SLAB_MATRIX_SCOPE("erf");
+  return matrix_impl::vm_apply(matrix_impl::vm_erf_kernel(), x);
+}
+
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> erf(const MatrixRef<U, N> &x) {
+  SLAB_MATRIX_SCOPE("erf");
+  return matrix_impl::vm_apply(matrix_impl::vm_erf_kernel(), x);
+}
+
+template <typename T, std::size_t N>
+inline Matrix<T, N> erf(Matrix<T, N> &&x) {
+  SLAB_MATRIX_SCOPE("erf");
+  return matrix_impl::vm_apply(matrix_impl::vm_erf_kernel(), std::move(x));
+}
+
+template <typename E, typename T = typename E::value_type>
+inline Matrix<T, MatrixExpr<E>::order_> erf(MatrixExpr<E> x) {
+  SLAB_MATRIX_SCOPE("erf");
+  return matrix_impl::vm_apply(matrix_impl::vm_erf_kernel(),
+                               Matrix<T, MatrixExpr<E>::order_>(std::move(x)));
+}
+
+//! out = erf(x) without a temporary; a Matrix out is resized to the extents
+//! of x, a MatrixRef out must have them. x may be out itself.
+template <typename U, std::size_t N, typename D, typename Out>
+inline void erf_into(const MatrixBase<U, N, D> &x, Out &&out) {
+  SLAB_MATRIX_SCOPE("erf_into");
+  matrix_impl::vm_into(matrix_impl::vm_erf_kernel(), x, out);
+}
+
+//! log |gamma(x)| element by element
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> lgamma(const Matrix<U, N> &x) {
+  SLAB_MATRIX_SCOPE("lgamma");
+  return matrix_impl::vm_apply(matrix_impl::vm_lgamma_kernel(), x);
+}
+
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> lgamma(const MatrixRef<U, N> &x) {
+  SLAB_MATRIX_SCOPE("lgamma");
+  return matrix_impl::vm_apply(matrix_impl::vm_lgamma_kernel(), x);
+}
 
-  Matrix<T, N> res = x;
-  res.apply([&](T &a) { a = std::pow(a, static_cast<T>(val)); });
+template <typename T, std::size_t N>
+inline Matrix<T, N> lgamma(Matrix<T, N> &&x) {
+  SLAB_MATRIX_SCOPE("lgamma");
+  return matrix_impl::vm_apply(matrix_impl::vm_lgamma_kernel(), std::move(x));
+}
+
+template <typename E, typename T = typename E::value_type>
+inline Matrix<T, MatrixExpr<E>::order_> lgamma(MatrixExpr<E> x) {
+  SLAB_MATRIX_SCOPE("lgamma");
+  return matrix_impl::vm_apply(matrix_impl::vm_lgamma_kernel(),
+                               Matrix<T, MatrixExpr<E>::order_>(std::move(x)));
+}
 
-  return res;
+//! out = lgamma(x) without a temporary; a Matrix out is resized to the extents
+//! of x, a MatrixRef out must have them. x may be out itself.
+template <typename U, std::size_t N, typename D, typename Out>
+inline void lgamma_into(const MatrixBase<U, N, D> &x, Out &&out) {
+  SLAB_MATRIX_SCOPE("lgamma_into");
+  matrix_impl::vm_into(matrix_impl::vm_lgamma_kernel(), x, out);
 }
 
 }  // namespace slab
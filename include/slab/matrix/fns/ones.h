@@ -24,9 +24,11 @@ namespace slab {
 
 template <typename M, typename... Args>
 Enable_if<Matrix_type<M>(), M> ones(Args... args) {
+  SLAB_MATRIX_SCOPE("ones");
   assert(M::order() == sizeof...(args));
-  M res(args...);
-  res = 1;
+  M res(uninitialized, args...);
+  matrix_impl::first_touch_fill(res.data(), res.descriptor(),
+                                typename M::value_type(1));
 
   return res;
 }
@@ -24,6 +24,7 @@ namespace slab {
 
 template <typename T>
 inline bool pinv(Matrix<T, 2> &a_inv, const Matrix<T, 2> &a) {
+  SLAB_MATRIX_SCOPE("pinv");
   int m = a.n_rows();
   int n = a.n_cols();
   int k = std::min(m, n);
@@ -46,7 +47,7 @@ inline bool pinv(Matrix<T, 2> &a_inv, const Matrix<T, 2> &a) {
     u.col(i) = ui;
   }
 
-  a_inv = zeros<Matrix<T, 2>>(n, m);
+  a_inv = Matrix<T, 2>(uninitialized, n, m);
   T alpha = 1.0;
   T beta = 0.0;
   blas_gemm(CblasTrans, CblasTrans, alpha, vt, u, beta, a_inv);
@@ -56,6 +57,7 @@ inline bool pinv(Matrix<T, 2> &a_inv, const Matrix<T, 2> &a) {
 
 template <typename T>
 inline Matrix<T, 2> pinv(const Matrix<T, 2> &a) {
+  SLAB_MATRIX_SCOPE("pinv");
   Matrix<T, 2> a_inv;
   pinv(a_inv, a);
 
@@ -22,38 +22,25 @@
 
 namespace slab {
 
-template <typename T>
-inline T prod(const Matrix<T, 1> &x) {
-  return std::accumulate(x.begin(), x.end(), T{1}, std::multiplies<T>());
+//! product of the elements of a vector
+template <typename T, typename D>
+inline Remove_const<T> prod(const MatrixBase<T, 1, D> &x) {
+  SLAB_MATRIX_SCOPE("prod");
+  return matrix_impl::reduce_matrix<matrix_impl::prod_reducer>(x);
 }
 
-template <typename T>
-inline T prod(const MatrixRef<T, 1> &x) {
-  return std::accumulate(x.begin(), x.end(), T{1}, std::multiplies<T>());
+//! products along dimension dim
+template <typename T, std::size_t N, typename D>
+inline Matrix<Remove_const<T>, N - 1> prod(const MatrixBase<T, N, D> &x,
+                                           std::size_t dim) {
+  SLAB_MATRIX_SCOPE("prod");
+  return matrix_impl::reduce_matrix<matrix_impl::prod_reducer>(x, dim);
 }
 
-template <typename T>
-inline Matrix<T, 1> prod(const Matrix<T, 2> &x) {
-  Matrix<T, 1> res(x.n_cols());
-  for (std::size_t i = 0; i != x.n_cols(); ++i) {
-    Matrix<T, 1> xcol = x.col(i);
-    res(i) =
-        std::accumulate(xcol.begin(), xcol.end(), T{1}, std::multiplies<T>());
-  }
-
-  return res;
-}
-
-template <typename T>
-inline Matrix<T, 1> prod(const MatrixRef<T, 2> &x) {
-  Matrix<T, 1> res(x.n_cols());
-  for (std::size_t i = 0; i != x.n_cols(); ++i) {
-    Matrix<T, 1> xcol = x.col(i);
-    res(i) =
-        std::accumulate(xcol.begin(), xcol.end(), T{1}, std::multiplies<T>());
-  }
-
-  return res;
+//! products of the columns
+template <typename T, typename D>
+inline Matrix<Remove_const<T>, 1> prod(const MatrixBase<T, 2, D> &x) {
+  return prod(x, 0);
 }
 
 }  // namespace slab
@@ -25,12 +25,82 @@ namespace slab {
 template <typename T, std::size_t N, typename... Args>
 inline auto reshape(const Matrix<T, N> &x, Args... args)
     -> decltype(Matrix<T, sizeof...(args)>()) {
-  Matrix<T, sizeof...(args)> res(args...);
+  SLAB_MATRIX_SCOPE("reshape");
+  Matrix<T, sizeof...(args)> res(uninitialized, args...);
   std::copy(x.begin(), x.end(), res.begin());
 
   return res;
 }
 
+template <typename T, std::size_t N, typename... Args>
+inline Matrix<Remove_const<T>, sizeof...(Args)> reshape(
+    const MatrixRef<T, N> &x, Args... args) {
+  SLAB_MATRIX_SCOPE("reshape");
+  Matrix<Remove_const<T>, sizeof...(Args)> res(uninitialized, args...);
+  assert(res.size() == x.size());
+  std::copy(x.begin(), x.end(), res.begin());
+
+  return res;
+}
+
+namespace matrix_impl {
+
+// The slice of the elements of d, which must be contiguous, with the
+// extents dims...
+template <std::size_t N, typename... Dims>
+MatrixSlice<sizeof...(Dims)> reshaped(const MatrixSlice<N> &d,
+                                      Dims... dims) {
+  MatrixSlice<sizeof...(Dims)> res(dims...);
+  if (res.size != d.size)
+    err_quit("reshape_view(): %zu elements cannot be viewed as %zu", d.size,
+             res.size);
+  if (!is_contiguous(d))
+    err_quit("reshape_view(): the elements are not contiguous");
+  res.start = d.start;
+  return res;
+}
+
+}  // namespace matrix_impl
+
+//! the elements of x, viewed with the extents dims...
+/*!
+ * No element is copied: the storage of a Matrix, or of a MatrixRef whose
+ * elements are contiguous, is row-major, so any extents with the same
+ * number of elements describe it. The view of a non-contiguous MatrixRef,
+ * e.g. a column block, is an error; reshape() copies such a slice.
+ */
+///@{
+template <typename T, std::size_t N, typename A, typename... Dims>
+inline MatrixRef<T, sizeof...(Dims)> reshape_view(Matrix<T, N, A> &x,
+                                                  Dims... dims) {
+  return {matrix_impl::reshaped(x.descriptor(), dims...), x.data()};
+}
+
+template <typename T, std::size_t N, typename A, typename... Dims>
+inline MatrixRef<const T, sizeof...(Dims)> reshape_view(
+    const Matrix<T, N, A> &x, Dims... dims) {
+  return {matrix_impl::reshaped(x.descriptor(), dims...), x.data()};
+}
+
+template <typename T, std::size_t N, typename... Dims>
+inline MatrixRef<T, sizeof...(Dims)> reshape_view(MatrixRef<T, N> &x,
+                                                  Dims... dims) {
+  return {matrix_impl::reshaped(x.descriptor(), dims...), x.data()};
+}
+
+template <typename T, std::size_t N, typename... Dims>
+inline MatrixRef<T, sizeof...(Dims)> reshape_view(MatrixRef<T, N> &&x,
+                                                  Dims... dims) {
+  return {matrix_impl::reshaped(x.descriptor(), dims...), x.data()};
+}
+
+template <typename T, std::size_t N, typename... Dims>
+inline MatrixRef<const T, sizeof...(Dims)> reshape_view(
+    const MatrixRef<T, N> &x, Dims... dims) {
+  return {matrix_impl::reshaped(x.descriptor(), dims...), x.data()};
+}
+///@}
+
 }  // namespace slab
 
 #endif  // SLAB_MATRIX_FNS_RESHAPE_H_
@@ -24,12 +24,14 @@ namespace slab {
 
 template <typename T>
 inline Matrix<T, 2> solve(const Matrix<T, 2> &a, const Matrix<T, 2> &b) {
+  SLAB_MATRIX_SCOPE("solve");
   err_quit("solve(): unsupported element type");
 }
 
 template <>
 inline Matrix<double, 2> solve(const Matrix<double, 2> &a,
                                const Matrix<double, 2> &b) {
+  SLAB_MATRIX_SCOPE("solve");
   assert(a.n_rows() == b.n_rows());
   assert(a.n_rows() == a.n_cols());
 
@@ -39,7 +41,7 @@ inline Matrix<double, 2> solve(const Matrix<double, 2> &a,
   int ldb = b.n_cols();
 
   Matrix<double, 2> a_copy(a);
-  Matrix<int, 1> ipiv(n);
+  Matrix<int, 1> ipiv(uninitialized, n);
   Matrix<double, 2> b_copy(b);
 
   int info = LAPACKE_dgesv(LAPACK_ROW_MAJOR, n, nrhs, (double *)a_copy.data(),
@@ -51,6 +53,7 @@ inline Matrix<double, 2> solve(const Matrix<double, 2> &a,
 template <>
 inline Matrix<float, 2> solve(const Matrix<float, 2> &a,
                               const Matrix<float, 2> &b) {
+  SLAB_MATRIX_SCOPE("solve");
   assert(a.n_rows() == b.n_rows());
   assert(a.n_rows() == a.n_cols());
 
@@ -60,7 +63,7 @@ inline Matrix<float, 2> solve(const Matrix<float, 2> &a,
   int ldb = b.n_cols();
 
   Matrix<float, 2> a_copy(a);
-  Matrix<int, 1> ipiv(n);
+  Matrix<int, 1> ipiv(uninitialized, n);
   Matrix<float, 2> b_copy(b);
 
   int info = LAPACKE_sgesv(LAPACK_ROW_MAJOR, n, nrhs, (float *)a_copy.data(),
@@ -73,6 +76,7 @@ template <>
 inline Matrix<std::complex<double>, 2> solve(
     const Matrix<std::complex<double>, 2> &a,
     const Matrix<std::complex<double>, 2> &b) {
+  SLAB_MATRIX_SCOPE("solve");
   assert(a.n_rows() == b.n_rows());
   assert(a.n_rows() == a.n_cols());
 
@@ -82,7 +86,7 @@ inline Matrix<std::complex<double>, 2> solve(
   int ldb = b.n_cols();
 
   Matrix<std::complex<double>, 2> a_copy(a);
-  Matrix<int, 1> ipiv(n);
+  Matrix<int, 1> ipiv(uninitialized, n);
   Matrix<std::complex<double>, 2> b_copy(b);
 
   int info = LAPACKE_zgesv(
@@ -98,6 +102,7 @@ template <>
 inline Matrix<std::complex<float>, 2> solve(
     const Matrix<std::complex<float>, 2> &a,
     const Matrix<std::complex<float>, 2> &b) {
+  SLAB_MATRIX_SCOPE("solve");
   assert(a.n_rows() == b.n_rows());
   assert(a.n_rows() == a.n_cols());
 
@@ -107,7 +112,7 @@ inline Matrix<std::complex<float>, 2> solve(
   int ldb = b.n_cols();
 
   Matrix<std::complex<float>, 2> a_copy(a);
-  Matrix<int, 1> ipiv(n);
+  Matrix<int, 1> ipiv(uninitialized, n);
   Matrix<std::complex<float>, 2> b_copy(b);
 
   int info = LAPACKE_cgesv(
@@ -118,8 +123,102 @@ inline Matrix<std::complex<float>, 2> solve(
   return b_copy;
 }
 
+namespace matrix_impl {
+
+// Solves op(a) * x = b, where op is given by trans ('N', 'T' or 'C'), by an
+// LU factorization of the row-major n x n matrix a, which it overwrites, and
+// overwrites the row-major n x nrhs matrix b by x.
+inline int lu_solve(char trans, int n, int nrhs, float *a, int *ipiv,
+                    float *b) {
+  int info = LAPACKE_sgetrf(LAPACK_ROW_MAJOR, n, n, a, n, ipiv);
+  if (info == 0)
+    info = LAPACKE_sgetrs(LAPACK_ROW_MAJOR, trans, n, nrhs, a, n, ipiv, b,
+                          nrhs);
+  return info;
+}
+
+inline int lu_solve(char trans, int n, int nrhs, double *a, int *ipiv,
+                    double *b) {
+  int info = LAPACKE_dgetrf(LAPACK_ROW_MAJOR, n, n, a, n, ipiv);
+  if (info == 0)
+    info = LAPACKE_dgetrs(LAPACK_ROW_MAJOR, trans, n, nrhs, a, n, ipiv, b,
+                          nrhs);
+  return info;
+}
+
+inline int lu_solve(char trans, int n, int nrhs, std::complex<float> *a,
+                    int *ipiv, std::complex<float> *b) {
+  auto pa = reinterpret_cast<lapack_complex_float *>(a);
+  auto pb = reinterpret_cast<lapack_complex_float *>(b);
+  int info = LAPACKE_cgetrf(LAPACK_ROW_MAJOR, n, n, pa, n, ipiv);
+  if (info == 0)
+    info = LAPACKE_cgetrs(LAPACK_ROW_MAJOR, trans, n, nrhs, pa, n, ipiv, pb,
+                          nrhs);
+  return info;
+}
+
+inline int lu_solve(char trans, int n, int nrhs, std::complex<double> *a,
+                    int *ipiv, std::complex<double> *b) {
+  auto pa = reinterpret_cast<lapack_complex_double *>(a);
+  auto pb = reinterpret_cast<lapack_complex_double *>(b);
+  int info = LAPACKE_zgetrf(LAPACK_ROW_MAJOR, n, n, pa, n, ipiv);
+  if (info == 0)
+    info = LAPACKE_zgetrs(LAPACK_ROW_MAJOR, trans, n, nrhs, pa, n, ipiv, pb,
+                          nrhs);
+  return info;
+}
+
+template <typename T>
+int lu_solve(char, int, int, T *, int *, T *) {
+  err_quit("solve(): unsupported element type");
+  return -1;
+}
+
+// solve() for a view: a transposed view is factorized as stored, and
+// solved with the transpose flag, instead of being transposed first.
+template <typename T>
+Matrix<T, 2> solve_view(const GemmArg<T> &a, const Matrix<T, 2> &b) {
+  assert(a.rows() == b.n_rows());
+  assert(a.rows() == a.cols());
+
+  const std::size_t n = a.rows();
+  const BlasArg<T> op_a = blas_arg(a);
+  Matrix<T, 2> lu(uninitialized, n, n);
+  for (std::size_t i = 0; i != n; ++i) {
+    const T *row = op_a.p + i * op_a.ld;
+    std::copy(row, row + n, lu.data() + i * n);
+  }
+
+  const char trans = op_a.trans == CblasNoTrans
+                         ? 'N'
+                         : op_a.trans == CblasTrans ? 'T' : 'C';
+  Matrix<int, 1> ipiv(uninitialized, std::max<std::size_t>(n, 1));
+  Matrix<T, 2> x(b);
+  const int info = lu_solve(trans, int(n), int(b.n_cols()), lu.data(),
+                            ipiv.data(), x.data());
+  if (info > 0) err_quit("solve(): matrix A is singular");
+
+  return x;
+}
+
+}  // namespace matrix_impl
+
+template <typename T, typename U,
+          typename = Enable_if<Same<Remove_const<T>, U>()>>
+inline Matrix<U, 2> solve(const MatrixRef<T, 2> &a, const Matrix<U, 2> &b) {
+  SLAB_MATRIX_SCOPE("solve");
+  return matrix_impl::solve_view(matrix_impl::gemm_arg(a), b);
+}
+
+template <typename T>
+inline Matrix<T, 2> solve(const ConjTransposed<T> &a, const Matrix<T, 2> &b) {
+  SLAB_MATRIX_SCOPE("solve");
+  return matrix_impl::solve_view(matrix_impl::gemm_arg(a), b);
+}
+
 template <typename T>
 inline Matrix<T, 2> solve(const Matrix<T, 2> &a) {
+  SLAB_MATRIX_SCOPE("solve");
   if (a.n_rows() != a.n_cols())
     err_quit("solve(): matrix A should be a square matrix");
 
@@ -0,0 +1,133 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file stats.h
+/// @brief mean, extrema, variance and standard deviation of array elements.
+///
+/// Like sum() and prod(), each function reduces a vector to a scalar, a
+/// Matrix<T, 2> to a vector over its columns, and a matrix of any order
+/// along the dimension given as a second argument. mean(), var() and
+/// stddev() of integers are double; var() and stddev() normalize by n - 1.
+
+#ifndef SLAB_MATRIX_FNS_STATS_H_
+#define SLAB_MATRIX_FNS_STATS_H_
+
+namespace slab {
+
+template <typename T>
+using Stat_type = matrix_impl::Stat_type<Remove_const<T>>;
+
+template <typename T, typename D>
+inline Stat_type<T> mean(const MatrixBase<T, 1, D> &x) {
+  SLAB_MATRIX_SCOPE("mean");
+  return matrix_impl::reduce_matrix<matrix_impl::mean_reducer>(x);
+}
+
+template <typename T, std::size_t N, typename D>
+inline Matrix<Stat_type<T>, N - 1> mean(const MatrixBase<T, N, D> &x,
+                                        std::size_t dim) {
+  SLAB_MATRIX_SCOPE("mean");
+  return matrix_impl::reduce_matrix<matrix_impl::mean_reducer>(x, dim);
+}
+
+template <typename T, typename D>
+inline Matrix<Stat_type<T>, 1> mean(const MatrixBase<T, 2, D> &x) {
+  return mean(x, 0);
+}
+
+template <typename T, typename D>
+inline Remove_const<T> min(const MatrixBase<T, 1, D> &x) {
+  SLAB_MATRIX_SCOPE("min");
+  return matrix_impl::reduce_matrix<matrix_impl::min_reducer>(x);
+}
+
+template <typename T, std::size_t N, typename D>
+inline Matrix<Remove_const<T>, N - 1> min(const MatrixBase<T, N, D> &x,
+                                          std::size_t dim) {
+  SLAB_MATRIX_SCOPE("min");
+  return matrix_impl::reduce_matrix<matrix_impl::min_reducer>(x, dim);
+}
+
+template <typename T, typename D>
+inline Matrix<Remove_const<T>, 1> min(const MatrixBase<T, 2, D> &x) {
+  return min(x, 0);
+}
+
+template <typename T, typename D>
+inline Remove_const<T> max(const MatrixBase<T, 1, D> &x) {
+  SLAB_MATRIX_SCOPE("max");
+  return matrix_impl::reduce_matrix<matrix_impl::max_reducer>(x);
+}
+
+template <typename T, std::size_t N, typename D>
+inline Matrix<Remove_const<T>, N - 1> max(const MatrixBase<T, N, D> &x,
+                                          std::size_t dim) {
+  SLAB_MATRIX_SCOPE("max");
+  return matrix_impl::reduce_matrix<matrix_impl::max_reducer>(x, dim);
+}
+
+template <typename T, typename D>
+inline Matrix<Remove_const<T>, 1> max(const MatrixBase<T, 2, D> &x) {
+  return max(x, 0);
+}
+
+template <typename T, typename D>
+inline Stat_type<T> var(const MatrixBase<T, 1, D> &x) {
+  SLAB_MATRIX_SCOPE("var");
+  static_assert(std::is_arithmetic<Remove_const<T>>::value,
+                "var(): real elements only");
+  return matrix_impl::reduce_matrix<matrix_impl::var_reducer>(x);
+}
+
+template <typename T, std::size_t N, typename D>
+inline Matrix<Stat_type<T>, N - 1> var(const MatrixBase<T, N, D> &x,
+                                       std::size_t dim) {
+  SLAB_MATRIX_SCOPE("var");
+  static_assert(std::is_arithmetic<Remove_const<T>>::value,
+                "var(): real elements only");
+  return matrix_impl::reduce_matrix<matrix_impl::var_reducer>(x, dim);
+}
+
+template <typename T, typename D>
+inline Matrix<Stat_type<T>, 1> var(const MatrixBase<T, 2, D> &x) {
+  return var(x, 0);
+}
+
+template <typename T, typename D>
+inline Stat_type<T> stddev(const MatrixBase<T, 1, D> &x) {
+  SLAB_MATRIX_SCOPE("stddev");
+  static_assert(std::is_arithmetic<Remove_const<T>>::value,
+                "stddev(): real elements only");
+  return matrix_impl::reduce_matrix<matrix_impl::stddev_reducer>(x);
+}
+
+template <typename T, std::size_t N, typename D>
+inline Matrix<Stat_type<T>, N - 1> stddev(const MatrixBase<T, N, D> &x,
+                                          std::size_t dim) {
+  SLAB_MATRIX_SCOPE("stddev");
+  static_assert(std::is_arithmetic<Remove_const<T>>::value,
+                "stddev(): real elements only");
+  return matrix_impl::reduce_matrix<matrix_impl::stddev_reducer>(x, dim);
+}
+
+template <typename T, typename D>
+inline Matrix<Stat_type<T>, 1> stddev(const MatrixBase<T, 2, D> &x) {
+  return stddev(x, 0);
+}
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_FNS_STATS_H_
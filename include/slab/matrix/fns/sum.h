@@ -22,36 +22,25 @@
 
 namespace slab {
 
-template <typename T, std::size_t N>
-inline T sum(const Matrix<T, N> &x) {
-  return std::accumulate(x.begin(), x.end(), T{0});
+//! sum of all the elements
+template <typename T, std::size_t N, typename D>
+inline Remove_const<T> sum(const MatrixBase<T, N, D> &x) {
+  SLAB_MATRIX_SCOPE("sum");
+  return matrix_impl::reduce_matrix<matrix_impl::sum_reducer>(x);
 }
 
-template <typename T, std::size_t N>
-inline T sum(const MatrixRef<T, N> &x) {
-  return std::accumulate(x.begin(), x.end(), T{0});
+//! sums along dimension dim, e.g. sum(m, 1) are the sums of the rows of m
+template <typename T, std::size_t N, typename D>
+inline Matrix<Remove_const<T>, N - 1> sum(const MatrixBase<T, N, D> &x,
+                                          std::size_t dim) {
+  SLAB_MATRIX_SCOPE("sum");
+  return matrix_impl::reduce_matrix<matrix_impl::sum_reducer>(x, dim);
 }
 
-template <typename T>
-inline Matrix<T, 1> sum(const Matrix<T, 2> &x) {
-  Matrix<T, 1> res(x.n_cols());
-  for (std::size_t i = 0; i != x.n_cols(); ++i) {
-    Matrix<T, 1> xcol = x.col(i);
-    res(i) = std::accumulate(xcol.begin(), xcol.end(), T{0});
-  }
-
-  return res;
-}
-
-template <typename T>
-inline Matrix<T, 1> sum(const MatrixRef<T, 2> &x) {
-  Matrix<T, 1> res(x.n_cols());
-  for (std::size_t i = 0; i != x.n_cols(); ++i) {
-    Matrix<T, 1> xcol = x.col(i);
-    res(i) = std::accumulate(xcol.begin(), xcol.end(), T{0});
-  }
-
-  return res;
+//! sums of the columns
+template <typename T, typename D>
+inline Matrix<Remove_const<T>, 1> sum(const MatrixBase<T, 2, D> &x) {
+  return sum(x, 0);
 }
 
 }  // namespace slab
@@ -24,7 +24,8 @@ namespace slab {
 
 template <typename T>
 inline Matrix<T, 2> transpose(const Matrix<T, 1> &a) {
-  Matrix<T, 2> res(1, a.n_rows());
+  SLAB_MATRIX_SCOPE("transpose");
+  Matrix<T, 2> res(uninitialized, 1, a.n_rows());
   std::copy(a.begin(), a.end(), res.begin());
 
   return res;
@@ -32,7 +33,8 @@ inline Matrix<T, 2> transpose(const Matrix<T, 1> &a) {
 
 template <typename T>
 inline Matrix<T, 2> transpose(const MatrixRef<T, 1> &a) {
-  Matrix<T, 2> res(1, a.n_rows());
+  SLAB_MATRIX_SCOPE("transpose");
+  Matrix<T, 2> res(uninitialized, 1, a.n_rows());
   std::copy(a.begin(), a.end(), res.begin());
 
   return res;
@@ -40,19 +42,33 @@ inline Matrix<T, 2> transpose(const MatrixRef<T, 1> &a) {
 
 template <typename T>
 inline Matrix<T, 2> transpose(const Matrix<T, 2> &a) {
-  Matrix<T, 2> res(a.n_cols(), a.n_rows());
-  for (std::size_t i = 0; i < a.n_rows(); ++i) {
-    res.col(i) = a.row(i);
-  }
+  SLAB_MATRIX_SCOPE("transpose");
+  Matrix<T, 2> res(uninitialized, a.n_cols(), a.n_rows());
+  matrix_impl::transpose_into(a.data(), a.n_cols(), res.data(), a.n_rows(),
+                              a.n_rows(), a.n_cols());
 
   return res;
 }
 
 template <typename T>
-inline Matrix<T, 2> transpose(const MatrixRef<T, 2> &a) {
-  Matrix<T, 2> res(a.n_cols(), a.n_rows());
-  for (std::size_t i = 0; i < a.n_rows(); ++i) {
-    res.col(i) = a.row(i);
+inline Matrix<Remove_const<T>, 2> transpose(const MatrixRef<T, 2> &a) {
+  SLAB_MATRIX_SCOPE("transpose");
+  using U = Remove_const<T>;
+  const MatrixSlice<2> &d = a.descriptor();
+  const std::size_t m = a.n_rows(), n = a.n_cols();
+  Matrix<U, 2> res(uninitialized, n, m);
+  const T *p = a.data() + d.start;
+
+  if (d.strides[1] == 1) {
+    matrix_impl::transpose_into(p, d.strides[0], res.data(), m, m, n);
+  } else if (d.strides[0] == 1) {
+    // a transposed view: its transpose is stored in rows of stride s1
+    for (std::size_t j = 0; j != n; ++j)
+      std::copy(p + j * d.strides[1], p + j * d.strides[1] + m,
+                res.data() + j * m);
+  } else {
+    matrix_impl::transpose_strided(p, d.strides[0], d.strides[1], res.data(),
+                                   m, m, n);
   }
 
   return res;
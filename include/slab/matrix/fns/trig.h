@@ -21,40 +21,152 @@
 #define SLAB_MATRIX_FNS_TRIG_H_
 
 namespace slab {
-template <typename T, std::size_t N>
-inline Matrix<T, N> cos(const Matrix<T, N> &x) {
-  Matrix<T, N> res = x;
-  return res.apply([&](T &a) { a = std::cos(a); });
+
+//! cosine element by element
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> cos(const Matrix<U, N> &x) {
+  SLAB_MATRIX_SCOPE("cos");
+  return matrix_impl::vm_apply(matrix_impl::vm_cos_kernel(), x);
 }
 
-template <typename T, std::size_t N>
-inline Matrix<T, N> cos(const MatrixRef<T, N> &x) {
-  Matrix<T, N> res = x;
-  return res.apply([&](T &a) { a = std::cos(a); });
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> cos(const MatrixRef<U, N> &x) {
+  SLAB_MATRIX_SCOPE("cos");
+  return matrix_impl::vm_apply(matrix_impl::vm_cos_kernel(), x);
 }
 
+// The overloads for temporaries compute in place of their argument; an
+// expression argument is evaluated once, into a matrix it owns if any.
+
 template <typename T, std::size_t N>
-inline Matrix<T, N> sin(const Matrix<T, N> &x) {
-  Matrix<T, N> res = x;
-  return res.apply([&](T &a) { a = std::sin(a); });
+inline Matrix<T, N> cos(Matrix<T, N> &&x) {
+  SLAB_MATRIX_SCOPE("cos");
+  return matrix_impl::vm_apply(matrix_impl::vm_cos_kernel(), std::move(x));
+}
+
+template <typename E, typename T = typename E::value_type>
+inline Matrix<T, MatrixExpr<E>::order_> cos(MatrixExpr<E> x) {
+  SLAB_MATRIX_SCOPE("cos");
+  return matrix_impl::vm_apply(matrix_impl::vm_cos_kernel(),
+                               Matrix<T, MatrixExpr<E>::order_>(std::move(x)));
+}
+
+//! out = cos(x) without a temporary; a Matrix out is resized to the extents
+//! of x, a MatrixRef out must have them. x may be out itself.
+template <typename U, std::size_t N, typename D, typename Out>
+inline void cos_into(const MatrixBase<U, N, D> &x, Out &&out) {
+  SLAB_MATRIX_SCOPE("cos_into");
+  matrix_impl::vm_into(matrix_impl::vm_cos_kernel(), x, out);
+}
+
+//! sine element by element
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> sin(const Matrix<U, N> &x) {
+  SLAB_MATRIX_SCOPE("sin");
+  return matrix_impl::vm_apply(matrix_impl::vm_sin_kernel(), x);
+}
+
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> sin(const MatrixRef<U, N> &x) {
+  SLAB_MATRIX_SCOPE("sin");
+  return matrix_impl::vm_apply(matrix_impl::vm_sin_kernel(), x);
 }
 
 template <typename T, std::size_t N>
-inline Matrix<T, N> sin(const MatrixRef<T, N> &x) {
-  Matrix<T, N> res = x;
-  return res.apply([&](T &a) { a = std::sin(a); });
+inline Matrix<T, N> sin(Matrix<T, N> &&x) {
+  SLAB_MATRIX_SCOPE("sin");
+  return matrix_impl::vm_apply(matrix_impl::vm_sin_kernel(), std::move(x));
+}
+
+template <typename E, typename T = typename E::value_type>
+inline Matrix<T, MatrixExpr<E>::order_> sin(MatrixExpr<E> x) {
+  SLAB_MATRIX_SCOPE("sin");
+  return matrix_impl::vm_apply(matrix_impl::vm_sin_kernel(),
+                               Matrix<T, MatrixExpr<E>::order_>(std::move(x)));
+}
+
+//! out = sin(x) without a temporary; a Matrix out is resized to the extents
+//! of x, a MatrixRef out must have them. x may be out itself.
+template <typename U, std::size_t N, typename D, typename Out>
+inline void sin_into(const MatrixBase<U, N, D> &x, Out &&out) {
+  SLAB_MATRIX_SCOPE("sin_into");
+  matrix_impl::vm_into(matrix_impl::vm_sin_kernel(), x, out);
+}
+
+//! tangent element by element
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> tan(const Matrix<U, N> &x) {
+  SLAB_MATRIX_SCOPE("tan");
+  return matrix_impl::vm_apply(matrix_impl::vm_tan_kernel(), x);
+}
+
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> tan(const MatrixRef<U, N> &x) {
+  SLAB_MATRIX_SCOPE("tan");
+  return matrix_impl::vm_apply(matrix_impl::vm_tan_kernel(), x);
 }
 
 template <typename T, std::size_t N>
-inline Matrix<T, N> tan(const Matrix<T, N> &x) {
-  Matrix<T, N> res = x;
-  return res.apply([&](T &a) { a = std::tan(a); });
+inline Matrix<T, N> tan(Matrix<T, N> &&x) {
+  SLAB_MATRIX_SCOPE("tan");
+  return matrix_impl::vm_apply(matrix_impl::vm_tan_kernel(), std::move(x));
+}
+
+template <typename E, typename T = typename E::value_type>
+inline Matrix<T, MatrixExpr<E>::order_> tan(MatrixExpr<E> x) {
+  SLAB_MATRIX_SCOPE("tan");
+  return matrix_impl::vm_apply(matrix_impl::vm_tan_kernel(),
+                               Matrix<T, MatrixExpr<E>::order_>(std::move(x)));
+}
+
+//! out = tan(x) without a temporary; a Matrix out is resized to the extents
+//! of x, a MatrixRef out must have them. x may be out itself.
+template <typename U, std::size_t N, typename D, typename Out>
+inline void tan_into(const MatrixBase<U, N, D> &x, Out &&out) {
+  SLAB_MATRIX_SCOPE("tan_into");
+  matrix_impl::vm_into(matrix_impl::vm_tan_kernel(), x, out);
+}
+
+//! hyperbolic tangent element by element
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> tanh(const Matrix<U, N> &x) {
+  SLAB_MATRIX_SCOPE("tanh");
+  return matrix_impl::vm_apply(matrix_impl::vm_tanh_kernel(), x);
+}
+
+template <typename U, std::size_t N,
+          typename T = typename std::remove_const<U>::type>
+inline Matrix<T, N> tanh(const MatrixRef<U, N> &x) {
+  SLAB_MATRIX_SCOPE("tanh");
+  return matrix_impl::vm_apply(matrix_impl::vm_tanh_kernel(), x);
 }
 
 template <typename T, std::size_t N>
-inline Matrix<T, N> tan(const MatrixRef<T, N> &x) {
-  Matrix<T, N> res = x;
-  return res.apply([&](T &a) { a = std::tan(a); });
+inline Matrix<T, N> tanh(Matrix<T, N> &&x) {
+  SLAB_MATRIX_SCOPE("tanh");
+  return matrix_impl::vm_apply(matrix_impl::vm_tanh_kernel(), std::move(x));
+}
+
+template <typename E, typename T = typename E::value_type>
+inline Matrix<T, MatrixExpr<E>::order_> tanh(MatrixExpr<E> x) {
+  SLAB_MATRIX_SCOPE("tanh");
+  return matrix_impl::vm_apply(matrix_impl::vm_tanh_kernel(),
+                               Matrix<T, MatrixExpr<E>::order_>(std::move(x)));
+}
+
+//! out = tanh(x) without a temporary; a Matrix out is resized to the extents
+//! of x, a MatrixRef out must have them. x may be out itself.
+template <typename U, std::size_t N, typename D, typename Out>
+inline void tanh_into(const MatrixBase<U, N, D> &x, Out &&out) {
+  SLAB_MATRIX_SCOPE("tanh_into");
+  matrix_impl::vm_into(matrix_impl::vm_tanh_kernel(), x, out);
 }
 
 }  // namespace slab
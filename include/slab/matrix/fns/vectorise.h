@@ -24,9 +24,44 @@ namespace slab {
 
 template <typename T, std::size_t N>
 inline Matrix<T, 1> vectorise(const Matrix<T, N> &x) {
+  SLAB_MATRIX_SCOPE("vectorise");
   return reshape(x, x.size());
 }
 
+template <typename T, std::size_t N>
+inline Matrix<Remove_const<T>, 1> vectorise(const MatrixRef<T, N> &x) {
+  SLAB_MATRIX_SCOPE("vectorise");
+  return reshape(x, x.size());
+}
+
+//! the elements of x as a vector, without copying them; see reshape_view()
+///@{
+template <typename T, std::size_t N, typename A>
+inline MatrixRef<T, 1> vectorise_view(Matrix<T, N, A> &x) {
+  return reshape_view(x, x.size());
+}
+
+template <typename T, std::size_t N, typename A>
+inline MatrixRef<const T, 1> vectorise_view(const Matrix<T, N, A> &x) {
+  return reshape_view(x, x.size());
+}
+
+template <typename T, std::size_t N>
+inline MatrixRef<T, 1> vectorise_view(MatrixRef<T, N> &x) {
+  return reshape_view(x, x.size());
+}
+
+template <typename T, std::size_t N>
+inline MatrixRef<T, 1> vectorise_view(MatrixRef<T, N> &&x) {
+  return reshape_view(x, x.size());
+}
+
+template <typename T, std::size_t N>
+inline MatrixRef<const T, 1> vectorise_view(const MatrixRef<T, N> &x) {
+  return reshape_view(x, x.size());
+}
+///@}
+
 }  // namespace slab
 
 #endif  // SLAB_MATRIX_FNS_VECTORISE_H_
@@ -24,9 +24,11 @@ namespace slab {
 
 template <typename M, typename... Args>
 Enable_if<Matrix_type<M>(), M> zeros(Args... args) {
+  SLAB_MATRIX_SCOPE("zeros");
   assert(M::order() == sizeof...(args));
-  M res(args...);
-  res = 0;
+  M res(uninitialized, args...);
+  matrix_impl::first_touch_fill(res.data(), res.descriptor(),
+                                typename M::value_type(0));
 
   return res;
 }
@@ -0,0 +1,218 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file gemm_kernel.h
+/// @brief The native matrix product, for element types BLAS does not have
+///
+/// matmul() computes products of float, double and complex matrices with
+/// BLAS ?gemm, and of any other arithmetic type with native_gemm(), a
+/// Goto/BLIS-style packed GEMM:
+///
+/// - C is computed in nc-column by kc-deep slabs: a kc x nc block of B is
+///   packed into nr-column panels, sized to stay in the L3 cache;
+/// - for each mc-row block of A, an mc x kc block is packed into mr-row
+///   panels, sized to stay in the L2 cache;
+/// - an mr x nr register-blocked micro-kernel multiplies one panel of each,
+///   with unit-stride loads the compiler vectorizes.
+///
+/// Large products are split over num_threads() threads by blocks of rows
+/// of C, or of columns when C is wider than it is tall. Defining
+/// SLAB_MATRIX_NATIVE_GEMM also routes float, double and complex products
+/// here, e.g. to build without a BLAS library for Level 3.
+
+#ifndef SLAB_MATRIX_GEMM_KERNEL_H_
+#define SLAB_MATRIX_GEMM_KERNEL_H_
+
+#include <cstddef>
+
+#include <algorithm>
+#include <vector>
+
+#include "slab/matrix/parallel.h"
+
+namespace slab {
+
+namespace matrix_impl {
+
+// Block sizes for elements of type T: nr elements of a row of the
+// micro-kernel span 64 bytes, i.e. one or two SIMD registers.
+template <typename T>
+struct gemm_blocking {
+  static constexpr std::size_t mr = 4;
+  static constexpr std::size_t nr =
+      sizeof(T) >= 16 ? 4 : sizeof(T) <= 4 ? 16 : 64 / sizeof(T);
+  static constexpr std::size_t kc = 256;
+  static constexpr std::size_t mc = 32 * mr;
+  static constexpr std::size_t nc = 256 * nr;
+};
+
+template <typename T>
+constexpr std::size_t gemm_blocking<T>::mr;
+template <typename T>
+constexpr std::size_t gemm_blocking<T>::nr;
+template <typename T>
+constexpr std::size_t gemm_blocking<T>::kc;
+template <typename T>
+constexpr std::size_t gemm_blocking<T>::mc;
+template <typename T>
+constexpr std::size_t gemm_blocking<T>::nc;
+
+// fewest multiply-adds for which native_gemm() uses several threads
+constexpr double gemm_parallel_min = double(1 << 21);
+
+// Packs rows [i0, i0 + mb) x columns [p0, p0 + kb) of a into mr-row panels,
+// each stored k-major, the last one padded with zeros.
+template <typename T, typename A>
+void gemm_pack_a(const A &a, std::size_t i0, std::size_t mb, std::size_t p0,
+                 std::size_t kb, T *buf) {
+  const std::size_t mr = gemm_blocking<T>::mr;
+  for (std::size_t ir = 0; ir < mb; ir += mr) {
+    const std::size_t m_r = std::min(mr, mb - ir);
+    for (std::size_t p = 0; p != kb; ++p) {
+      for (std::size_t i = 0; i != m_r; ++i) *buf++ = a(i0 + ir + i, p0 + p);
+      for (std::size_t i = m_r; i != mr; ++i) *buf++ = T{0};
+    }
+  }
+}
+
+// Packs rows [p0, p0 + kb) x columns [j0, j0 + nb) of b into nr-column
+// panels, each stored k-major, the last one padded with zeros.
+template <typename T, typename B>
+void gemm_pack_b(const B &b, std::size_t p0, std::size_t kb, std::size_t j0,
+                 std::size_t nb, T *buf) {
+  const std::size_t nr = gemm_blocking<T>::nr;
+  for (std::size_t jr = 0; jr < nb; jr += nr) {
+    const std::size_t n_r = std::min(nr, nb - jr);
+    for (std::size_t p = 0; p != kb; ++p) {
+      for (std::size_t j = 0; j != n_r; ++j) *buf++ = b(p0 + p, j0 + jr + j);
+      for (std::size_t j = n_r; j != nr; ++j) *buf++ = T{0};
+    }
+  }
+}
+
+// (c, ldc) := alpha * a * b + beta * (c, ldc) for one mr x kb panel a and
+// one kb x nr panel b; only the leading m_r x n_r block of c is written.
+template <typename T>
+void gemm_micro(std::size_t kb, const T *a, const T *b, const T &alpha,
+                const T &beta, T *c, std::size_t ldc, std::size_t m_r,
+                std::size_t n_r) {
+  const std::size_t mr = gemm_blocking<T>::mr;
+  const std::size_t nr = gemm_blocking<T>::nr;
+
+  T acc[mr][nr];
+  for (std::size_t i = 0; i != mr; ++i)
+    for (std::size_t j = 0; j != nr; ++j) acc[i][j] = T{0};
+
+  for (std::size_t p = 0; p != kb; ++p) {
+    const T *ap = a + p * mr;
+    const T *bp = b + p * nr;
+    for (std::size_t i = 0; i != mr; ++i) {
+      const T ai = ap[i];
+      for (std::size_t j = 0; j != nr; ++j) acc[i][j] += ai * bp[j];
+    }
+  }
+
+  for (std::size_t i = 0; i != m_r; ++i) {
+    T *ci = c + i * ldc;
+    if (beta == T{0}) {
+      for (std::size_t j = 0; j != n_r; ++j) ci[j] = alpha * acc[i][j];
+    } else {
+      for (std::size_t j = 0; j != n_r; ++j)
+        ci[j] = alpha * acc[i][j] + beta * ci[j];
+    }
+  }
+}
+
+// The block [i0, i1) x [j0, j1) of (c, ldc) := alpha * a * b + beta * c,
+// on the calling thread.
+template <typename T, typename A, typename B>
+void gemm_blocked(std::size_t i0, std::size_t i1, std::size_t j0,
+                  std::size_t j1, std::size_t k, const T &alpha, const A &a,
+                  const B &b, const T &beta, T *c, std::size_t ldc) {
+  using Blk = gemm_blocking<T>;
+  const std::size_t m = i1 - i0, n = j1 - j0;
+  if (m == 0 || n == 0) return;
+
+  if (k == 0) {
+    for (std::size_t i = i0; i != i1; ++i)
+      for (std::size_t j = j0; j != j1; ++j) {
+        T &cc = c[i * ldc + j];
+        cc = beta == T{0} ? T{0} : beta * cc;
+      }
+    return;
+  }
+
+  const std::size_t mc = std::min(Blk::mc, m), kc = std::min(Blk::kc, k),
+                    nc = std::min(Blk::nc, n);
+  std::vector<T> pa((mc + Blk::mr - 1) / Blk::mr * Blk::mr * kc);
+  std::vector<T> pb((nc + Blk::nr - 1) / Blk::nr * Blk::nr * kc);
+
+  for (std::size_t jc = j0; jc < j1; jc += Blk::nc) {
+    const std::size_t nb = std::min(Blk::nc, j1 - jc);
+    for (std::size_t pc = 0; pc < k; pc += Blk::kc) {
+      const std::size_t kb = std::min(Blk::kc, k - pc);
+      const T beta_p = pc == 0 ? beta : T{1};
+      gemm_pack_b(b, pc, kb, jc, nb, pb.data());
+
+      for (std::size_t ic = i0; ic < i1; ic += Blk::mc) {
+        const std::size_t mb = std::min(Blk::mc, i1 - ic);
+        gemm_pack_a(a, ic, mb, pc, kb, pa.data());
+
+        for (std::size_t jr = 0; jr < nb; jr += Blk::nr) {
+          for (std::size_t ir = 0; ir < mb; ir += Blk::mr) {
+            gemm_micro(kb, pa.data() + ir * kb, pb.data() + jr * kb, alpha,
+                       beta_p, c + (ic + ir) * ldc + jc + jr, ldc,
+                       std::min(Blk::mr, mb - ir), std::min(Blk::nr, nb - jr));
+          }
+        }
+      }
+    }
+  }
+}
+
+// (c, ldc) := alpha * a * b + beta * (c, ldc), c row-major m x n, where
+// a(i, p) and b(p, j) give the elements of the m x k and k x n factors.
+template <typename T, typename A, typename B>
+void native_gemm(std::size_t m, std::size_t n, std::size_t k, const T &alpha,
+                 const A &a, const B &b, const T &beta, T *c,
+                 std::size_t ldc) {
+  using Blk = gemm_blocking<T>;
+  std::size_t nt = num_threads();
+  if (double(m) * double(n) * double(k) < gemm_parallel_min) nt = 1;
+
+  // split along the longer side of c, by whole micro-panels
+  if (m >= n) {
+    const std::size_t panels = (m + Blk::mr - 1) / Blk::mr;
+    parallel_for(panels, nt, [&](std::size_t first, std::size_t last,
+                                 std::size_t) {
+      gemm_blocked(first * Blk::mr, std::min(last * Blk::mr, m), 0, n, k,
+                   alpha, a, b, beta, c, ldc);
+    });
+  } else {
+    const std::size_t panels = (n + Blk::nr - 1) / Blk::nr;
+    parallel_for(panels, nt, [&](std::size_t first, std::size_t last,
+                                 std::size_t) {
+      gemm_blocked(0, m, first * Blk::nr, std::min(last * Blk::nr, n), k,
+                   alpha, a, b, beta, c, ldc);
+    });
+  }
+}
+
+}  // namespace matrix_impl
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_GEMM_KERNEL_H_
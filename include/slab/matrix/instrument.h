@@ -0,0 +1,274 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file instrument.h
+/// @brief Counters of the matrices, copies and allocations of the library
+///
+/// Define SLAB_MATRIX_INSTRUMENT before including the library to count, per
+/// API function (matmul, solve, join_rows, ...), the Matrix and
+/// MatrixRef objects it constructs, the element-wise copies into a Matrix and
+/// the element buffers it allocates. Without the macro every hook compiles
+/// to nothing and the queries below return zeros.
+///
+/// \code
+/// instrument_reset();
+/// mat c = matmul(a, b) + 1.0;
+/// InstrumentStats s = instrument_stats("matmul");
+/// instrument_dump();  // one line per API function, to std::cerr
+/// \endcode
+///
+/// Work is attributed to the outermost API function on the calling thread:
+/// the matrices solve() creates through matmul() count for solve(). Work done
+/// outside any API function, e.g. `mat b = a;`, counts for "(user)". Setting
+/// the SLAB_MATRIX_INSTRUMENT_DUMP environment variable, or calling
+/// instrument_dump_at_exit(), prints the table to std::cerr at exit.
+
+#ifndef SLAB_MATRIX_INSTRUMENT_H_
+#define SLAB_MATRIX_INSTRUMENT_H_
+
+#include <cstddef>
+#include <cstdlib>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace slab {
+
+//! Counters of one API function, or of all of them.
+struct InstrumentStats {
+  std::size_t matrices = 0;     //!< Matrix objects constructed
+  std::size_t refs = 0;         //!< MatrixRef objects constructed
+  std::size_t copies = 0;       //!< element-wise copies into a Matrix
+  std::size_t allocations = 0;  //!< element buffers allocated
+  std::size_t bytes = 0;        //!< bytes of the element buffers allocated
+  std::size_t peak_bytes = 0;   //!< most live element bytes seen meanwhile
+};
+
+//! whether the library was compiled with SLAB_MATRIX_INSTRUMENT
+#ifdef SLAB_MATRIX_INSTRUMENT
+constexpr bool instrument_enabled = true;
+#else
+constexpr bool instrument_enabled = false;
+#endif
+
+namespace matrix_impl {
+
+enum class instrument_event { matrix, ref, copy };
+
+// The process-wide counters, guarded by a mutex: instrumentation is a
+// debugging aid and is not meant to be cheap.
+class InstrumentRegistry {
+ public:
+  // Never destroyed, since matrices with static storage duration may still
+  // be released after the destructors of function-local statics ran.
+  static InstrumentRegistry &get() {
+    static InstrumentRegistry *r = new InstrumentRegistry;
+    return *r;
+  }
+
+  void count(const char *fn, instrument_event e) {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (InstrumentStats *s : {&total_, &fns_[fn]}) {
+      switch (e) {
+        case instrument_event::matrix:
+          ++s->matrices;
+          break;
+        case instrument_event::ref:
+          ++s->refs;
+          break;
+        case instrument_event::copy:
+          ++s->copies;
+          break;
+      }
+    }
+  }
+
+  void allocate(const char *fn, std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(mu_);
+    live_ += bytes;
+    for (InstrumentStats *s : {&total_, &fns_[fn]}) {
+      ++s->allocations;
+      s->bytes += bytes;
+      s->peak_bytes = std::max(s->peak_bytes, live_);
+    }
+  }
+
+  void deallocate(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(mu_);
+    live_ -= std::min(live_, bytes);  // buffers allocated before a reset
+  }
+
+  InstrumentStats stats(const std::string &fn) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = fns_.find(fn);
+    return it == fns_.end() ? InstrumentStats() : it->second;
+  }
+
+  InstrumentStats totals() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return total_;
+  }
+
+  void reset() {
+    std::lock_guard<std::mutex> lock(mu_);
+    fns_.clear();
+    total_ = InstrumentStats();
+  }
+
+  void dump(std::ostream &os) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    os << std::left << std::setw(16) << "function" << std::right;
+    for (const char *h : {"matrices", "refs", "copies", "allocs", "bytes",
+                          "peak bytes"})
+      os << std::setw(h[0] == 'b' || h[0] == 'p' ? 14 : 10) << h;
+    os << '\n';
+    for (const auto &entry : fns_) line(os, entry.first, entry.second);
+    line(os, "(total)", total_);
+  }
+
+  bool dump_at_exit = false;
+
+ private:
+  InstrumentRegistry() {
+    dump_at_exit = std::getenv("SLAB_MATRIX_INSTRUMENT_DUMP") != nullptr;
+    std::atexit([] {
+      const InstrumentRegistry &r = get();
+      if (r.dump_at_exit) r.dump(std::cerr);
+    });
+  }
+
+  static void line(std::ostream &os, const std::string &fn,
+                   const InstrumentStats &s) {
+    os << std::left << std::setw(16) << fn << std::right << std::setw(10)
+       << s.matrices << std::setw(10) << s.refs << std::setw(10) << s.copies
+       << std::setw(10) << s.allocations << std::setw(14) << s.bytes
+       << std::setw(14) << s.peak_bytes << '\n';
+  }
+
+  mutable std::mutex mu_;
+  std::map<std::string, InstrumentStats> fns_;
+  InstrumentStats total_;
+  std::size_t live_ = 0;
+};
+
+// The outermost API function running on this thread, if any.
+inline const char *&instrument_scope() {
+  static thread_local const char *fn = nullptr;
+  return fn;
+}
+
+inline const char *instrument_function() {
+  const char *fn = instrument_scope();
+  return fn ? fn : "(user)";
+}
+
+// Attributes the work done during its lifetime to fn, unless an enclosing
+// API function already claimed it.
+class InstrumentScope {
+ public:
+  explicit InstrumentScope(const char *fn) : nested_(instrument_scope()) {
+    if (!nested_) instrument_scope() = fn;
+  }
+  ~InstrumentScope() {
+    if (!nested_) instrument_scope() = nullptr;
+  }
+  InstrumentScope(const InstrumentScope &) = delete;
+  InstrumentScope &operator=(const InstrumentScope &) = delete;
+
+ private:
+  bool nested_;
+};
+
+#ifdef SLAB_MATRIX_INSTRUMENT
+inline void instrument_count(instrument_event e) {
+  InstrumentRegistry::get().count(instrument_function(), e);
+}
+inline void instrument_allocate(std::size_t bytes) {
+  InstrumentRegistry::get().allocate(instrument_function(), bytes);
+}
+inline void instrument_deallocate(std::size_t bytes) {
+  InstrumentRegistry::get().deallocate(bytes);
+}
+#else
+inline void instrument_count(instrument_event) {}
+inline void instrument_allocate(std::size_t) {}
+inline void instrument_deallocate(std::size_t) {}
+#endif
+
+inline void instrument_copy() { instrument_count(instrument_event::copy); }
+
+// An empty base of Matrix (E = matrix) and MatrixRef (E = ref) that counts
+// their constructions, and the copies of a Matrix.
+template <instrument_event E>
+struct Instrumented {
+#ifdef SLAB_MATRIX_INSTRUMENT
+  Instrumented() noexcept { instrument_count(E); }
+  Instrumented(const Instrumented &) noexcept {
+    instrument_count(E);
+    if (E == instrument_event::matrix) instrument_copy();
+  }
+  Instrumented(Instrumented &&) noexcept { instrument_count(E); }
+  Instrumented &operator=(const Instrumented &) noexcept {
+    if (E == instrument_event::matrix) instrument_copy();
+    return *this;
+  }
+  Instrumented &operator=(Instrumented &&) noexcept { return *this; }
+#endif
+};
+
+}  // namespace matrix_impl
+
+//! counters of the API function fn, e.g. "matmul" or "operator+"
+inline InstrumentStats instrument_stats(const std::string &fn) {
+  return matrix_impl::InstrumentRegistry::get().stats(fn);
+}
+
+//! counters summed over all API functions and user code
+inline InstrumentStats instrument_totals() {
+  return matrix_impl::InstrumentRegistry::get().totals();
+}
+
+//! zero all counters
+inline void instrument_reset() {
+  matrix_impl::InstrumentRegistry::get().reset();
+}
+
+//! print the counters, one line per API function
+inline void instrument_dump(std::ostream &os = std::cerr) {
+  matrix_impl::InstrumentRegistry::get().dump(os);
+}
+
+//! print the counters to std::cerr when the program exits
+inline void instrument_dump_at_exit(bool on = true) {
+  matrix_impl::InstrumentRegistry::get().dump_at_exit = on;
+}
+
+}  // namespace slab
+
+//! Attributes what the enclosing API function does to it (see instrument.h).
+#ifdef SLAB_MATRIX_INSTRUMENT
+#define SLAB_MATRIX_SCOPE(fn) \
+  ::slab::matrix_impl::InstrumentScope slab_matrix_scope_(fn)
+#else
+#define SLAB_MATRIX_SCOPE(fn) static_cast<void>(0)
+#endif
+
+#endif  // SLAB_MATRIX_INSTRUMENT_H_
@@ -0,0 +1,101 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file kron_kernel.h
+/// @brief The kernel behind kron(), kron_into() and kron_add()
+///
+/// The Kronecker product of an m x n matrix a and a p x q matrix b is made
+/// of m x n blocks of p x q elements, block (i, j) being a(i, j) * b. Row
+/// i * p + k of it is therefore the n scaled copies a(i, 0) * b.row(k), ...,
+/// a(i, n - 1) * b.row(k) side by side. The kernel writes the product in that
+/// order, row after row, without making any block: the result is written
+/// once and sequentially, and row k of b stays in the L1 cache across its n
+/// copies. A scaled copy, or for kron_add() a scaled update, runs in the
+/// SIMD kernels (simd_dispatch.h) when it is long enough, otherwise in a loop
+/// the compiler vectorizes. Large products are split over num_threads()
+/// threads into bands of consecutive block rows.
+
+#ifndef SLAB_MATRIX_KRON_KERNEL_H_
+#define SLAB_MATRIX_KRON_KERNEL_H_
+
+#include <cassert>
+#include <cstddef>
+
+#include "slab/matrix/matrix_slice.h"
+#include "slab/matrix/parallel.h"
+#include "slab/matrix/simd_dispatch.h"
+#include "slab/matrix/traverse.h"
+
+namespace slab {
+
+namespace matrix_impl {
+
+// fewest elements of the product for which the kernel uses several threads
+constexpr std::size_t kron_parallel_min = std::size_t(1) << 18;
+
+// y[i] = a * x[i], or y[i] += a * x[i] when add is true, for i < n
+template <typename T>
+inline void kron_row(const T &a, const T *x, T *y, std::size_t n, bool add) {
+  if (add) {
+    if (!dispatch_simd_axpy_n(a, x, y, n))
+      for (std::size_t i = 0; i != n; ++i) y[i] += a * x[i];
+  } else if (!dispatch_simd_scale_n(a, x, y, n)) {
+    for (std::size_t i = 0; i != n; ++i) y[i] = a * x[i];
+  }
+}
+
+// (cd, c) := kron((ad, a), (bd, b)), or (cd, c) += kron(...) when add is
+// true, where b and c have unit column strides (or a single column), and c
+// has the extents of the product and overlaps neither a nor b.
+template <typename T>
+void kron_kernel(const T *a, const MatrixSlice<2> &ad, const T *b,
+                 const MatrixSlice<2> &bd, T *c, const MatrixSlice<2> &cd,
+                 bool add) {
+  const std::size_t n = ad.extents[1];
+  const std::size_t p = bd.extents[0], q = bd.extents[1];
+  assert(cd.extents[0] == ad.extents[0] * p && cd.extents[1] == n * q);
+  assert(q <= 1 || bd.strides[1] == 1);
+  assert(n * q <= 1 || cd.strides[1] == 1);
+  assert(!may_view(c, cd, a, ad) && !may_view(c, cd, b, bd));
+
+  // the work is the blocks of the rows of c, each a scaled row of b,
+  // numbered row by row
+  const std::size_t blocks = cd.extents[0] * n;
+  if (blocks == 0 || q == 0) return;
+  std::size_t nt = num_threads();
+  if (cd.size < kron_parallel_min) nt = 1;
+
+  parallel_for(blocks, nt, [&](std::size_t first, std::size_t last,
+                               std::size_t) {
+    std::size_t r = first / n, j = first % n;
+    for (std::size_t u = first; u != last; ++u) {
+      const std::size_t i = r / p, k = r % p;
+      kron_row(a[ad.start + i * ad.strides[0] + j * ad.strides[1]],
+               b + bd.start + k * bd.strides[0],
+               c + cd.start + r * cd.strides[0] + j * q, q, add);
+      if (++j == n) {
+        j = 0;
+        ++r;
+      }
+    }
+  });
+}
+
+}  // namespace matrix_impl
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_KRON_KERNEL_H_
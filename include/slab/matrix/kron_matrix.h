@@ -0,0 +1,394 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file kron_matrix.h
+/// @brief The Kronecker product of two matrices, kept as its factors
+///
+/// KronMatrix<T>(a, b) stands for kron(a, b) without forming it: for an
+/// m x n matrix a and a p x q matrix b it holds the mn + pq elements of the
+/// factors rather than the mnpq of the product. Its matmul() goes through
+/// the factors by the identity
+///
+///     kron(a, b) * x = vec(a * X * b^T),
+///
+/// where X is the n x q matrix whose rows are the consecutive blocks of q
+/// elements of x, and vec() joins the rows of the m x p result: the
+/// row-major form of (A ⊗ B) vec(X) = vec(B X A^T). A product with a vector
+/// is then two blas_gemm() calls, in the cheaper of the two orders, and
+/// O(mq(n + p)) or O(np(q + m)) operations instead of O(mnpq): O(ab(a + b))
+/// rather than O(a^2 b^2) for square factors of orders a and b.
+///
+/// Since kron(a, b)^-1 = kron(a^-1, b^-1) and det(kron(a, b)) =
+/// det(a)^p det(b)^m for square factors, solve(), det(), log_det() and
+/// inverse() only factorize a and b: by Cholesky when a factor is symmetric
+/// positive definite, by LU with partial pivoting otherwise. The
+/// factorizations are made on first use, once, and shared by the copies of
+/// the KronMatrix; the factors themselves cannot be changed. Solves and
+/// determinants take float and double elements.
+
+#ifndef SLAB_MATRIX_KRON_MATRIX_H_
+#define SLAB_MATRIX_KRON_MATRIX_H_
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+
+#ifdef USE_MKL
+#include "mkl.h"
+#else
+extern "C" {
+#include "lapacke.h"
+}
+#endif
+
+#include "slab/matrix/blas_interface.h"
+#include "slab/matrix/error.h"
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/matrix_ref.h"
+#include "slab/matrix/transpose_kernel.h"
+
+namespace slab {
+
+namespace matrix_impl {
+
+// LAPACK on column-major arrays: the n x n matrix a, with leading dimension
+// n, and the n x nrhs right-hand side b, with leading dimension ldb.
+inline int kron_potrf(int n, float *a) {
+  return LAPACKE_spotrf(LAPACK_COL_MAJOR, 'L', n, a, n);
+}
+
+inline int kron_potrf(int n, double *a) {
+  return LAPACKE_dpotrf(LAPACK_COL_MAJOR, 'L', n, a, n);
+}
+
+inline int kron_getrf(int n, float *a, int *ipiv) {
+  return LAPACKE_sgetrf(LAPACK_COL_MAJOR, n, n, a, n, ipiv);
+}
+
+inline int kron_getrf(int n, double *a, int *ipiv) {
+  return LAPACKE_dgetrf(LAPACK_COL_MAJOR, n, n, a, n, ipiv);
+}
+
+inline int kron_potrs(int n, int nrhs, const float *a, float *b, int ldb) {
+  return LAPACKE_spotrs(LAPACK_COL_MAJOR, 'L', n, nrhs, a, n, b, ldb);
+}
+
+inline int kron_potrs(int n, int nrhs, const double *a, double *b, int ldb) {
+  return LAPACKE_dpotrs(LAPACK_COL_MAJOR, 'L', n, nrhs, a, n, b, ldb);
+}
+
+inline int kron_getrs(int n, int nrhs, const float *a, const int *ipiv,
+                      float *b, int ldb) {
+  return LAPACKE_sgetrs(LAPACK_COL_MAJOR, 'N', n, nrhs, a, n, ipiv, b, ldb);
+}
+
+inline int kron_getrs(int n, int nrhs, const double *a, const int *ipiv,
+                      double *b, int ldb) {
+  return LAPACKE_dgetrs(LAPACK_COL_MAJOR, 'N', n, nrhs, a, n, ipiv, b, ldb);
+}
+
+template <typename T>
+int kron_potrf(int, T *) {
+  err_quit("KronMatrix: unsupported element type");
+  return -1;
+}
+
+template <typename T>
+int kron_getrf(int, T *, int *) {
+  err_quit("KronMatrix: unsupported element type");
+  return -1;
+}
+
+template <typename T>
+int kron_potrs(int, int, const T *, T *, int) {
+  err_quit("KronMatrix: unsupported element type");
+  return -1;
+}
+
+template <typename T>
+int kron_getrs(int, int, const T *, const int *, T *, int) {
+  err_quit("KronMatrix: unsupported element type");
+  return -1;
+}
+
+// The factorization of a square factor, stored column-major.
+template <typename T>
+struct KronFactor {
+  Matrix<T, 2> f;       // the Cholesky factor L, or L and U
+  Matrix<int, 1> ipiv;  // the pivots of LU
+  bool chol = false;
+  bool singular = false;
+  T log_abs_det = T{0};  // log |det|
+  T sign = T{1};         // the sign of det, or 0
+};
+
+template <typename T>
+bool symmetric(const Matrix<T, 2> &a) {
+  for (std::size_t i = 0; i != a.n_rows(); ++i)
+    for (std::size_t j = 0; j != i; ++j)
+      if (!(a(i, j) == a(j, i))) return false;
+  return true;
+}
+
+template <typename T>
+KronFactor<T> kron_factor(const Matrix<T, 2> &a) {
+  if (a.n_rows() != a.n_cols())
+    err_quit("KronMatrix: the factors of a solve must be square");
+  const int n = int(a.n_rows());
+
+  KronFactor<T> res;
+  res.f = transpose(a);  // a, column-major
+  if (symmetric(a)) {
+    res.chol = kron_potrf(n, res.f.data()) == 0;
+    if (!res.chol) res.f = transpose(a);  // not positive definite
+  }
+  if (!res.chol) {
+    res.ipiv = Matrix<int, 1>(uninitialized, std::max(n, 1));
+    res.singular = kron_getrf(n, res.f.data(), res.ipiv.data()) != 0;
+  }
+
+  for (int i = 0; i != n; ++i) {
+    const T d = res.f(i, i);
+    if (d == T{0}) {
+      res.sign = T{0};
+      res.log_abs_det = -HUGE_VAL;
+      break;
+    }
+    res.log_abs_det += res.chol ? 2 * std::log(d) : std::log(std::abs(d));
+    if (!res.chol && (d < T{0}) != (res.ipiv(i) != i + 1))
+      res.sign = -res.sign;
+  }
+  return res;
+}
+
+// b := a^-1 b, for the factorization of the n x n matrix a and the
+// column-major n x nrhs matrix b
+template <typename T>
+void kron_factor_solve(const KronFactor<T> &fa, std::size_t n,
+                       std::size_t nrhs, T *b) {
+  if (fa.singular) err_quit("solve(): singular KronMatrix factor");
+  if (n == 0 || nrhs == 0) return;
+  if (fa.chol)
+    kron_potrs(int(n), int(nrhs), fa.f.data(), b, int(n));
+  else
+    kron_getrs(int(n), int(nrhs), fa.f.data(), fa.ipiv.data(), b, int(n));
+}
+
+// x := a^-1 x b^-T for the row-major m x p matrix x, which read
+// column-major is x^T; work holds m x p elements
+template <typename T>
+void kron_solve_block(const KronFactor<T> &fa, const KronFactor<T> &fb,
+                      T *x, std::size_t m, std::size_t p, T *work) {
+  kron_factor_solve(fb, p, m, x);  // x^T := b^-1 x^T
+  transpose_into(x, p, work, m, m, p);
+  kron_factor_solve(fa, m, p, work);  // work, column-major x, := a^-1 x
+  transpose_into(work, m, x, p, p, m);
+}
+
+// y := a x b^T for the row-major n x q matrix x and m x p matrix y
+template <typename T>
+void kron_apply_block(const Matrix<T, 2> &a, const Matrix<T, 2> &b,
+                      const T *x, T *y) {
+  const std::size_t m = a.n_rows(), n = a.n_cols();
+  const std::size_t p = b.n_rows(), q = b.n_cols();
+  const MatrixRef<const T, 2> xv(MatrixSlice<2>(0, {n, q}), x);
+  MatrixRef<T, 2> yv(MatrixSlice<2>(0, {m, p}), y);
+  if (m * q * (n + p) <= n * p * (q + m)) {
+    Matrix<T, 2> ax(uninitialized, m, q);
+    blas_gemm(CblasNoTrans, CblasNoTrans, T{1}, a, xv, T{0}, ax);
+    blas_gemm(CblasNoTrans, CblasTrans, T{1}, ax, b, T{0}, yv);
+  } else {
+    Matrix<T, 2> xb(uninitialized, n, p);
+    blas_gemm(CblasNoTrans, CblasTrans, T{1}, xv, b, T{0}, xb);
+    blas_gemm(CblasNoTrans, CblasNoTrans, T{1}, a, xb, T{0}, yv);
+  }
+}
+
+template <typename T>
+struct KronFactors {
+  std::once_flag once;
+  KronFactor<T> a;
+  KronFactor<T> b;
+};
+
+}  // namespace matrix_impl
+
+//! kron(a, b), kept as a and b
+template <typename T>
+class KronMatrix {
+ public:
+  KronMatrix(Matrix<T, 2> a, Matrix<T, 2> b)
+      : a_(std::move(a)),
+        b_(std::move(b)),
+        factors_(std::make_shared<matrix_impl::KronFactors<T>>()) {}
+
+  //! the factors
+  ///@{
+  const Matrix<T, 2> &a() const { return a_; }
+  const Matrix<T, 2> &b() const { return b_; }
+  ///@}
+
+  std::size_t n_rows() const { return a_.n_rows() * b_.n_rows(); }
+  std::size_t n_cols() const { return a_.n_cols() * b_.n_cols(); }
+
+  //! the product itself, kron(a(), b())
+  Matrix<T, 2> dense() const { return kron(a_, b_); }
+
+  //! the factorizations of a() and b(), made on the first call
+  const matrix_impl::KronFactors<T> &factors() const {
+    matrix_impl::KronFactors<T> &fs = *factors_;
+    std::call_once(fs.once, [&] {
+      fs.a = matrix_impl::kron_factor(a_);
+      fs.b = matrix_impl::kron_factor(b_);
+    });
+    return fs;
+  }
+
+ private:
+  Matrix<T, 2> a_;
+  Matrix<T, 2> b_;
+  std::shared_ptr<matrix_impl::KronFactors<T>> factors_;
+};
+
+//! matmul(kron(k.a(), k.b()), x)
+template <typename T>
+Matrix<T, 1> matmul(const KronMatrix<T> &k, const Matrix<T, 1> &x) {
+  SLAB_MATRIX_SCOPE("kron_mul");
+  assert(x.size() == k.n_cols());
+  Matrix<T, 1> y(uninitialized, k.n_rows());
+  if (y.size() != 0)
+    matrix_impl::kron_apply_block(k.a(), k.b(), x.data(), y.data());
+  return y;
+}
+
+//! matmul(kron(k.a(), k.b()), x)
+/*!
+ * Row j * q + l of x, for the n x q factor b, is element (j, l) of the
+ * n x q blocks X_c of its columns: the product takes one gemm with a for
+ * all the columns and one gemm with b per row of a (or the other way
+ * round when that is cheaper), not one pair of gemms per column.
+ */
+template <typename T>
+Matrix<T, 2> matmul(const KronMatrix<T> &k, const Matrix<T, 2> &x) {
+  SLAB_MATRIX_SCOPE("kron_mul");
+  assert(x.n_rows() == k.n_cols());
+  const Matrix<T, 2> &a = k.a(), &b = k.b();
+  const std::size_t m = a.n_rows(), n = a.n_cols();
+  const std::size_t p = b.n_rows(), q = b.n_cols(), c = x.n_cols();
+  Matrix<T, 2> y(uninitialized, m * p, c);
+  if (y.size() == 0) return y;
+
+  // x is the n x qc matrix of the rows of its n blocks of q rows, y that of
+  // m blocks of p rows; b maps block to block, a mixes the blocks
+  if (m * q * (n + p) <= n * p * (q + m)) {
+    const MatrixRef<const T, 2> xv(MatrixSlice<2>(0, {n, q * c}), x.data());
+    Matrix<T, 2> ax(uninitialized, m, q * c);
+    blas_gemm(CblasNoTrans, CblasNoTrans, T{1}, a, xv, T{0}, ax);
+    for (std::size_t i = 0; i != m; ++i) {
+      const MatrixRef<const T, 2> axi(MatrixSlice<2>(i * q * c, {q, c}),
+                                      ax.data());
+      MatrixRef<T, 2> yi(MatrixSlice<2>(i * p * c, {p, c}), y.data());
+      blas_gemm(CblasNoTrans, CblasNoTrans, T{1}, b, axi, T{0}, yi);
+    }
+  } else {
+    Matrix<T, 2> bx(uninitialized, n, p * c);
+    for (std::size_t j = 0; j != n; ++j) {
+      const MatrixRef<const T, 2> xj(MatrixSlice<2>(j * q * c, {q, c}),
+                                     x.data());
+      MatrixRef<T, 2> bxj(MatrixSlice<2>(j * p * c, {p, c}), bx.data());
+      blas_gemm(CblasNoTrans, CblasNoTrans, T{1}, b, xj, T{0}, bxj);
+    }
+    MatrixRef<T, 2> yv(MatrixSlice<2>(0, {m, p * c}), y.data());
+    blas_gemm(CblasNoTrans, CblasNoTrans, T{1}, a, bx, T{0}, yv);
+  }
+  return y;
+}
+
+//! x such that kron(k.a(), k.b()) * x = y, for square factors
+template <typename T>
+Matrix<T, 1> solve(const KronMatrix<T> &k, const Matrix<T, 1> &y) {
+  SLAB_MATRIX_SCOPE("kron_solve");
+  assert(y.size() == k.n_rows());
+  const auto &fs = k.factors();
+  const std::size_t m = k.a().n_rows(), p = k.b().n_rows();
+  Matrix<T, 1> x = y;
+  Matrix<T, 1> work(uninitialized, x.size());
+  matrix_impl::kron_solve_block(fs.a, fs.b, x.data(), m, p, work.data());
+  return x;
+}
+
+//! x such that kron(k.a(), k.b()) * x = y, column by column
+template <typename T>
+Matrix<T, 2> solve(const KronMatrix<T> &k, const Matrix<T, 2> &y) {
+  SLAB_MATRIX_SCOPE("kron_solve");
+  assert(y.n_rows() == k.n_rows());
+  const auto &fs = k.factors();
+  const std::size_t m = k.a().n_rows(), p = k.b().n_rows();
+  Matrix<T, 2> x(uninitialized, y.n_rows(), y.n_cols());
+  Matrix<T, 1> col(uninitialized, y.n_rows());
+  Matrix<T, 1> work(uninitialized, y.n_rows());
+  for (std::size_t c = 0; c != y.n_cols(); ++c) {
+    col = y.col(c);
+    matrix_impl::kron_solve_block(fs.a, fs.b, col.data(), m, p, work.data());
+    x.col(c) = col;
+  }
+  return x;
+}
+
+//! log |det(kron(k.a(), k.b()))|, for square factors of orders m and p:
+//! p log |det(a)| + m log |det(b)|
+template <typename T>
+T log_det(const KronMatrix<T> &k) {
+  const auto &fs = k.factors();
+  const T m = T(k.a().n_rows()), p = T(k.b().n_rows());
+  if (fs.a.sign == T{0} || fs.b.sign == T{0}) return -HUGE_VAL;
+  return p * fs.a.log_abs_det + m * fs.b.log_abs_det;
+}
+
+//! det(kron(k.a(), k.b())) = det(a)^p det(b)^m, for square factors of
+//! orders m and p
+template <typename T>
+T det(const KronMatrix<T> &k) {
+  const auto &fs = k.factors();
+  const std::size_t m = k.a().n_rows(), p = k.b().n_rows();
+  T sign = T{1};
+  if (fs.a.sign < T{0} && p % 2 == 1) sign = -sign;
+  if (fs.b.sign < T{0} && m % 2 == 1) sign = -sign;
+  if (fs.a.sign == T{0} || fs.b.sign == T{0}) sign = T{0};
+  return sign * std::exp(log_det(k));
+}
+
+//! kron(a^-1, b^-1), the inverse of kron(k.a(), k.b()), kept as its factors
+template <typename T>
+KronMatrix<T> inverse(const KronMatrix<T> &k) {
+  SLAB_MATRIX_SCOPE("kron_inverse");
+  const auto &fs = k.factors();
+  const auto inv = [](const matrix_impl::KronFactor<T> &f, std::size_t n) {
+    Matrix<T, 2> res(n, n);  // the identity, the same column-major
+    for (std::size_t i = 0; i != n; ++i) res(i, i) = T{1};
+    matrix_impl::kron_factor_solve(f, n, n, res.data());
+    return transpose(res);
+  };
+  return KronMatrix<T>(inv(fs.a, k.a().n_rows()), inv(fs.b, k.b().n_rows()));
+}
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_KRON_MATRIX_H_
@@ -57,7 +57,7 @@ inline int lapack_getrf(Matrix<T, 2> &a, Matrix<int, 1> &ipiv) {
 
   // assert(ipiv.size() >= std::max(1, std::min(m, n)));
   ipiv.clear();
-  ipiv = Matrix<int, 1>(std::max(1, std::min(m, n)));
+  ipiv = Matrix<int, 1>(uninitialized, std::max(1, std::min(m, n)));
 
   const int lda = n;
 
@@ -108,10 +108,13 @@ inline int lapack_gesvd(char jobu, char jobvt, Matrix<T, 2> &a, Matrix<T, 1> &s,
   int ldu = m;
   int ldvt = n;
 
-  s = zeros<Matrix<T, 1>>(std::min(m, n));
-  u = zeros<Matrix<T, 2>>(m, m);
-  vt = zeros<Matrix<T, 2>>(n, n);
-  superb = zeros<Matrix<T, 1>>(std::min(m, n));
+  // s and superb are always written; u and vt only when requested
+  s = Matrix<T, 1>(uninitialized, std::min(m, n));
+  u = (jobu == 'A' || jobu == 'S') ? Matrix<T, 2>(uninitialized, m, m)
+                                   : zeros<Matrix<T, 2>>(m, m);
+  vt = (jobvt == 'A' || jobvt == 'S') ? Matrix<T, 2>(uninitialized, n, n)
+                                      : zeros<Matrix<T, 2>>(n, n);
+  superb = Matrix<T, 1>(uninitialized, std::min(m, n));
 
   int info = 0;
   if (is_double<T>::value) {
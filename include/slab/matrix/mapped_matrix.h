@@ -0,0 +1,277 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file mapped_matrix.h
+/// @brief Matrices backed by a memory-mapped file
+
+#ifndef SLAB_MATRIX_MAPPED_MATRIX_H_
+#define SLAB_MATRIX_MAPPED_MATRIX_H_
+
+#if !defined(_WIN32)
+
+#include <cstddef>
+
+#include <array>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "slab/matrix/error.h"
+#include "slab/matrix/matrix_ref.h"
+#include "slab/matrix/matrix_slice.h"
+
+namespace slab {
+
+//! How a MappedMatrix maps its file.
+enum class map_mode {
+  read_only,      // the file must exist; writing to the elements faults
+  read_write,     // the file is created or grown as needed; writes reach it
+  copy_on_write,  // the file must exist; writes stay private to the process
+};
+
+//! Access pattern hints passed to madvise().
+enum class map_advice { normal, sequential, random, willneed, dontneed };
+
+namespace matrix_impl {
+
+// An open file and a mapping of its first length() bytes.
+class FileMapping {
+ public:
+  FileMapping(const std::string &path, map_mode mode, std::size_t bytes);
+  FileMapping(FileMapping &&x) noexcept
+      : path_(std::move(x.path_)),
+        mode_(x.mode_),
+        fd_(x.fd_),
+        addr_(x.addr_),
+        length_(x.length_) {
+    x.fd_ = -1;
+    x.addr_ = nullptr;
+    x.length_ = 0;
+  }
+  FileMapping(const FileMapping &) = delete;
+  FileMapping &operator=(const FileMapping &) = delete;
+  ~FileMapping();
+
+  void *addr() const { return addr_; }
+  std::size_t length() const { return length_; }
+  const std::string &path() const { return path_; }
+  map_mode mode() const { return mode_; }
+
+  // Sets the file size to `bytes` and maps all of it; the first
+  // min(length(), bytes) bytes are preserved. read_write only.
+  void resize(std::size_t bytes);
+  void advise(map_advice advice) const;
+  void sync() const;
+
+ private:
+  void map();
+
+  std::string path_;
+  map_mode mode_;
+  int fd_;
+  void *addr_ = nullptr;
+  std::size_t length_ = 0;
+};
+
+inline FileMapping::FileMapping(const std::string &path, map_mode mode,
+                                std::size_t bytes)
+    : path_(path), mode_(mode) {
+  const bool writable = mode == map_mode::read_write;
+  fd_ = ::open(path.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+  if (fd_ == -1) err_sys("MappedMatrix: cannot open %s", path.c_str());
+
+  struct stat st;
+  if (::fstat(fd_, &st) == -1)
+    err_sys("MappedMatrix: cannot stat %s", path.c_str());
+
+  const std::size_t file_size = static_cast<std::size_t>(st.st_size);
+  if (file_size < bytes) {
+    if (!writable)
+      err_quit("MappedMatrix: %s holds %zu bytes, %zu are needed",
+               path.c_str(), file_size, bytes);
+    if (::ftruncate(fd_, static_cast<off_t>(bytes)) == -1)
+      err_sys("MappedMatrix: cannot grow %s", path.c_str());
+  }
+
+  length_ = bytes;
+  map();
+}
+
+inline FileMapping::~FileMapping() {
+  if (addr_) ::munmap(addr_, length_);
+  if (fd_ != -1) ::close(fd_);
+}
+
+inline void FileMapping::map() {
+  addr_ = nullptr;
+  if (length_ == 0) return;  // mmap() rejects empty mappings
+
+  const int prot =
+      mode_ == map_mode::read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+  const int flags =
+      mode_ == map_mode::copy_on_write ? MAP_PRIVATE : MAP_SHARED;
+
+  void *p = ::mmap(nullptr, length_, prot, flags, fd_, 0);
+  if (p == MAP_FAILED) err_sys("MappedMatrix: cannot map %s", path_.c_str());
+  addr_ = p;
+}
+
+inline void FileMapping::resize(std::size_t bytes) {
+  if (mode_ != map_mode::read_write)
+    err_quit("MappedMatrix: %s is not mapped read-write", path_.c_str());
+  if (bytes == length_) return;
+
+  if (::ftruncate(fd_, static_cast<off_t>(bytes)) == -1)
+    err_sys("MappedMatrix: cannot resize %s", path_.c_str());
+
+#if defined(__linux__)
+  if (addr_ && bytes) {
+    void *p = ::mremap(addr_, length_, bytes, MREMAP_MAYMOVE);
+    if (p == MAP_FAILED)
+      err_sys("MappedMatrix: cannot remap %s", path_.c_str());
+    addr_ = p;
+    length_ = bytes;
+    return;
+  }
+#endif
+
+  // the data lives in the shared page cache, so unmapping loses nothing
+  if (addr_) ::munmap(addr_, length_);
+  length_ = bytes;
+  map();
+}
+
+inline void FileMapping::advise(map_advice advice) const {
+  if (!addr_) return;
+
+  int a = MADV_NORMAL;
+  switch (advice) {
+    case map_advice::normal:
+      a = MADV_NORMAL;
+      break;
+    case map_advice::sequential:
+      a = MADV_SEQUENTIAL;
+      break;
+    case map_advice::random:
+      a = MADV_RANDOM;
+      break;
+    case map_advice::willneed:
+      a = MADV_WILLNEED;
+      break;
+    case map_advice::dontneed:
+      a = MADV_DONTNEED;
+      break;
+  }
+  ::madvise(addr_, length_, a);  // only a hint, failure is harmless
+}
+
+inline void FileMapping::sync() const {
+  if (addr_ && mode_ == map_mode::read_write &&
+      ::msync(addr_, length_, MS_SYNC) == -1)
+    err_sys("MappedMatrix: cannot sync %s", path_.c_str());
+}
+
+}  // namespace matrix_impl
+
+//! MappedMatrix<T,N> is an N-dimensional matrix stored in a file.
+/*!
+ * \tparam T value type, stored in the file as raw row-major elements.
+ * \tparam N number of dimensions.
+ *
+ * The elements live in a memory-mapped file rather than on the heap, so a
+ * MappedMatrix can exceed the physical memory: pages are read on first use
+ * and written back by the kernel. A MappedMatrix is a MatrixRef that owns its
+ * mapping, hence subscripting, slicing (row(), col(), rows(), cols(),
+ * submat()), the arithmetic operators and the BLAS wrappers apply unchanged;
+ * assignment copies elements into the file.
+ *
+ * \code
+ * MappedMatrix<double, 2> x("design.bin", map_mode::read_only, n, p);
+ * x.advise(map_advice::sequential);
+ * mat xtx(p, p);
+ * blas_gemm(CblasTrans, CblasNoTrans, 1.0, x, x, 0.0, xtx);
+ * \endcode
+ */
+template <typename T, std::size_t N>
+class MappedMatrix : private matrix_impl::FileMapping, public MatrixRef<T, N> {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "MappedMatrix: T must be trivially copyable");
+
+ public:
+  //! map the file at path as a matrix with the given extents
+  template <typename... Exts>
+  MappedMatrix(const std::string &path, map_mode mode, Exts... exts)
+      : matrix_impl::FileMapping(path, mode,
+                                 MatrixSlice<N>(exts...).size * sizeof(T)),
+        MatrixRef<T, N>(MatrixSlice<N>(exts...), elements(*this)) {}
+
+  //! @cond Doxygen_Suppress
+  MappedMatrix(MappedMatrix &&x)
+      : matrix_impl::FileMapping(std::move(x)),
+        MatrixRef<T, N>(x.descriptor(), elements(*this)) {
+    x.rebind(MatrixSlice<N>(std::array<std::size_t, N>{}), nullptr);
+  }
+  MappedMatrix(const MappedMatrix &) = delete;
+  MappedMatrix &operator=(MappedMatrix &&) = delete;
+  MappedMatrix &operator=(const MappedMatrix &x) {
+    MatrixRef<T, N>::operator=(x);  // copy the elements
+    return *this;
+  }
+  ~MappedMatrix() = default;
+
+  using MatrixRef<T, N>::operator=;
+  //! @endcond
+
+  //! path of the mapped file
+  const std::string &path() const { return FileMapping::path(); }
+  //! how the file is mapped
+  map_mode mode() const { return FileMapping::mode(); }
+
+  //! change the extents, growing or shrinking the file (read_write only)
+  /*!
+   * The file keeps its first min(old, new) elements, so growing the leading
+   * extent appends rows to a row-major matrix.
+   */
+  template <typename... Exts>
+  void resize(Exts... exts) {
+    MatrixSlice<N> d(exts...);
+    FileMapping::resize(d.size * sizeof(T));
+    this->rebind(d, elements(*this));
+  }
+
+  //! tell the kernel how the elements are going to be accessed
+  void advise(map_advice advice) const { FileMapping::advise(advice); }
+
+  //! write modified pages back to the file
+  void sync() const { FileMapping::sync(); }
+
+ private:
+  // static, as it is called before the MatrixRef base is constructed
+  static T *elements(const FileMapping &m) {
+    return static_cast<T *>(m.addr());
+  }
+};
+
+}  // namespace slab
+
+#endif  // !defined(_WIN32)
+
+#endif  // SLAB_MATRIX_MAPPED_MATRIX_H_
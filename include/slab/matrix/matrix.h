@@ -27,11 +27,16 @@
 #include <string>
 #include <vector>
 
+#include "slab/matrix/error.h"
+#include "slab/matrix/storage.h"
 #include "slab/matrix/matrix_base.h"
+#include "slab/matrix/matrix_expr.h"
 #include "slab/matrix/matrix_ref.h"
 #include "slab/matrix/matrix_slice.h"
+#include "slab/matrix/numa.h"
 #include "slab/matrix/packed_matrix.h"
 #include "slab/matrix/support.h"
+#include "slab/matrix/transpose_kernel.h"
 
 namespace slab {
 
@@ -44,23 +49,39 @@ Matrix<T, 2> transpose(const Matrix<T, 2> &a);
 template <typename T>
 Matrix<T, 2> inverse(const Matrix<T, 2> &a);
 
+//! Tag selecting the Matrix constructors that leave the elements
+//! uninitialized, for outputs that are fully overwritten afterwards.
+struct uninitialized_tag {};
+constexpr uninitialized_tag uninitialized{};
+
 //! Matrix<T,N> is an N-dimensional matrix of some value type T.
 /*!
  * \tparam T value type.
  * \tparam N number of dimensions.
+ * \tparam Allocator allocator used to acquire the element storage, e.g.
+ * AlignedAllocator, MklAllocator or HugePageAllocator (see allocator.h);
+ * CowAllocator makes copies share the elements until one is modified.
+ * While an ArenaScope is alive, storage comes from the thread's arena instead
+ * (see arena.h). With the default allocator, matrices of at most
+ * SLAB_MATRIX_INLINE_SIZE elements are stored inline and never allocate
+ * (see storage.h).
  *
  * This class implements matrix class which provides support subscripting,
  * slicing and basic matrix arithmetic operations.
  */
-template <typename T, std::size_t N>
-class Matrix : public MatrixBase<T, N> {
+template <typename T, std::size_t N, typename Allocator>
+class Matrix
+    : public MatrixBase<T, N, Matrix<T, N, Allocator>>,
+      private matrix_impl::Instrumented<matrix_impl::instrument_event::matrix> {
   // ----------------------------------------
   // The core member functions in book 'TCPL'
   // ----------------------------------------
  public:
   //! @cond Doxygen_Suppress
-  using iterator = typename std::vector<T>::iterator;
-  using const_iterator = typename std::vector<T>::const_iterator;
+  using allocator_type = Allocator;
+  using iterator = typename matrix_impl::Storage<T, Allocator>::iterator;
+  using const_iterator =
+      typename matrix_impl::Storage<T, Allocator>::const_iterator;
 
   Matrix() = default;
   Matrix(Matrix &&) = default;  // move
@@ -84,10 +105,25 @@ class Matrix : public MatrixBase<T, N> {
   template <typename U>
   Matrix &operator=(const MatrixRef<U, N> &);
 
+  //! evaluate an element-wise expression (see MatrixExpr)
+  template <typename E>
+  Matrix(const MatrixExpr<E> &);
+  //! evaluate a temporary expression, in place of a matrix it owns if any
+  template <typename E>
+  Matrix(MatrixExpr<E> &&);
+  //! evaluate an element-wise expression into this matrix
+  template <typename E>
+  Matrix &operator=(const MatrixExpr<E> &);
+
   //! specify the extents
-  template <typename... Exts>
+  template <typename... Exts,
+            typename = Enable_if<matrix_impl::Requesting_element<Exts...>()>>
   explicit Matrix(Exts... exts);
 
+  //! specify the extents, leaving the elements uninitialized
+  template <typename... Exts>
+  Matrix(uninitialized_tag, Exts... exts);
+
   //! initialize from list
   Matrix(MatrixInitializer<T, N>);
   //! assign from list
@@ -115,7 +151,12 @@ class Matrix : public MatrixBase<T, N> {
   ///@}
 
  private:
-  std::vector<T> elems_;  // the elements
+  // the elements
+  matrix_impl::Storage<T, Allocator> elems_;
+
+  // Replaces the elements with those of (xd, x), which may view them.
+  template <typename U>
+  void assign_elements(const U *x, const MatrixSlice<N> &xd);
 
   // ---------------------------------------------
   // Member functions for subscripting and slicing
@@ -126,13 +167,13 @@ class Matrix : public MatrixBase<T, N> {
   template <typename... Args>
   Enable_if<matrix_impl::Requesting_element<Args...>(), T &> operator()(
       Args... args) {
-    return MatrixBase<T, N>::template operator()<Args...>(args...);
+    return MatrixBase<T, N, Matrix>::template operator()<Args...>(args...);
   }
 
   template <typename... Args>
   Enable_if<matrix_impl::Requesting_element<Args...>(), const T &> operator()(
       Args... args) const {
-    return MatrixBase<T, N>::template operator()<Args...>(args...);
+    return MatrixBase<T, N, Matrix>::template operator()<Args...>(args...);
   }
   ///@}
 
@@ -221,8 +262,20 @@ class Matrix : public MatrixBase<T, N> {
   template <typename M>
   Enable_if<Matrix_type<M>(), Matrix &> operator%=(const M &x);
 
+  // fused element-wise operations with an expression
+  template <typename E>
+  Matrix &operator+=(const MatrixExpr<E> &x);
+  template <typename E>
+  Matrix &operator-=(const MatrixExpr<E> &x);
+  template <typename E>
+  Matrix &operator*=(const MatrixExpr<E> &x);
+  template <typename E>
+  Matrix &operator/=(const MatrixExpr<E> &x);
+  template <typename E>
+  Matrix &operator%=(const MatrixExpr<E> &x);
+
   template <typename U = typename std::remove_const<T>::type>
-  Matrix<U, N> operator-() const;
+  Matrix<U, N, Rebind_alloc<Allocator, U>> operator-() const;
   //! @endcond
 
   // -----------------------------------
@@ -232,16 +285,18 @@ class Matrix : public MatrixBase<T, N> {
  public:
   //! Construct a vector from a matrix
   ///@{
-  template <typename U, std::size_t NN = N, typename = Enable_if<(NN == 1)>>
-  Matrix(const Matrix<U, 2> &x);
+  template <typename U, typename A, std::size_t NN = N,
+            typename = Enable_if<(NN == 1)>>
+  Matrix(const Matrix<U, 2, A> &x);
   template <typename U, std::size_t NN = N, typename = Enable_if<(NN == 1)>>
   Matrix(const MatrixRef<U, 2> &x);
   ///@}
 
   //！Assign a vector from a matrix
   ///@{
-  template <typename U, std::size_t NN = N, typename = Enable_if<(NN == 1)>>
-  Matrix &operator=(const Matrix<U, 2> &x);
+  template <typename U, typename A, std::size_t NN = N,
+            typename = Enable_if<(NN == 1)>>
+  Matrix &operator=(const Matrix<U, 2, A> &x);
   template <typename U, std::size_t NN = N, typename = Enable_if<(NN == 1)>>
   Matrix &operator=(const MatrixRef<U, 2> &x);
   ///@}
@@ -272,16 +327,18 @@ class Matrix : public MatrixBase<T, N> {
  public:
   //! Construct a matrix from a vector
   ///@{
-  template <typename U, std::size_t NN = N, typename = Enable_if<(NN == 2)>>
-  Matrix(const Matrix<U, 1> &x);
+  template <typename U, typename A, std::size_t NN = N,
+            typename = Enable_if<(NN == 2)>>
+  Matrix(const Matrix<U, 1, A> &x);
   template <typename U, std::size_t NN = N, typename = Enable_if<(NN == 2)>>
   Matrix(const MatrixRef<U, 1> &x);
   ///@}
 
   //! Assign a matrix from a vector
   ///@{
-  template <typename U, std::size_t NN = N, typename = Enable_if<(NN == 2)>>
-  Matrix &operator=(const Matrix<U, 1> &x);
+  template <typename U, typename A, std::size_t NN = N,
+            typename = Enable_if<(NN == 2)>>
+  Matrix &operator=(const Matrix<U, 1, A> &x);
   template <typename U, std::size_t NN = N, typename = Enable_if<(NN == 2)>>
   Matrix &operator=(const MatrixRef<U, 1> &x);
   ///@}
@@ -375,9 +432,69 @@ class Matrix : public MatrixBase<T, N> {
  public:
   void clear();
 
+  //! transposed view; a vector is viewed as a one-row matrix
+  /*!
+   * No element is copied: matmul(), solve() and the BLAS wrappers pass the
+   * view to BLAS/LAPACK with the transpose flag. The transpose of a
+   * temporary is a new Matrix, since a view would outlive its elements.
+   */
+  ///@{
+  template <std::size_t NN = N, typename = Enable_if<(NN == 1) || (NN == 2)>>
+  MatrixRef<T, 2> t() & {
+    return {matrix_impl::transposed(this->desc_), data()};
+  }
+  template <std::size_t NN = N, typename = Enable_if<(NN == 1) || (NN == 2)>>
+  MatrixRef<const T, 2> t() const & {
+    return {matrix_impl::transposed(this->desc_), data()};
+  }
+  template <std::size_t NN = N, typename = Enable_if<(NN == 1) || (NN == 2)>>
+  Matrix<T, 2> t() && {
+    return Matrix<T, 2>(static_cast<const Matrix &>(*this).t());
+  }
+  ///@}
+
+  //! conjugate-transposed view, the same as t() for real elements
+  ///@{
+  template <std::size_t NN = N, typename = Enable_if<(NN == 1) || (NN == 2)>>
+  matrix_impl::Conj_transposed<T> ht() const & {
+    return matrix_impl::conj_transposed<T>::make(
+        matrix_impl::transposed(this->desc_), data());
+  }
   template <std::size_t NN = N, typename = Enable_if<(NN == 1) || (NN == 2)>>
-  Matrix<T, 2> t() const {
-    return transpose(*this);
+  Matrix<T, 2> ht() && {
+    return Matrix<T, 2>(static_cast<const Matrix &>(*this).ht());
+  }
+  ///@}
+
+  //! change the extents, keeping the elements in row-major order
+  /*!
+   * The storage is reinterpreted, not copied, so the number of elements
+   * must not change; reshape() and reshape_view() also change the order.
+   * Views of the matrix keep the old extents.
+   */
+  template <typename... Dims>
+  Matrix &reshape(Dims... dims) {
+    MatrixSlice<N> d(dims...);
+    if (d.size != this->desc_.size)
+      err_quit("Matrix::reshape(): %zu elements cannot be reshaped to %zu",
+               this->desc_.size, d.size);
+    this->desc_ = d;
+    return *this;
+  }
+
+  //! transpose in place, without a second copy of the elements
+  /*!
+   * A square matrix swaps its blocks across the diagonal; a rectangular one
+   * follows the cycles of the transpose permutation, with one bit per
+   * element of extra memory. Views of the matrix are invalidated.
+   */
+  template <std::size_t NN = N, typename = Enable_if<(NN == 2)>>
+  Matrix &inplace_trans() {
+    SLAB_MATRIX_SCOPE("inplace_trans");
+    const std::size_t m = this->n_rows(), n = this->n_cols();
+    matrix_impl::transpose_cycles(data(), m, n);
+    this->desc_ = MatrixSlice<2>(n, m);
+    return *this;
   }
 
   template <std::size_t NN = N, typename = Enable_if<(NN == 2)>>
@@ -394,51 +511,123 @@ class Matrix : public MatrixBase<T, N> {
   void load(const std::string &filename);
 };
 
+//! Matrix whose copies share their elements until one of them is modified.
 template <typename T, std::size_t N>
+using CowMatrix = Matrix<T, N, CowAllocator<T>>;
+
+template <typename T, std::size_t N, typename Allocator>
 template <typename M, typename X>
-Matrix<T, N>::Matrix(const M &x)
-    : MatrixBase<T, N>(x.descriptor()), elems_(x.begin(), x.end()) {
+Matrix<T, N, Allocator>::Matrix(const M &x)
+    : MatrixBase<T, N, Matrix>(x.descriptor()), elems_(x.begin(), x.end()) {
   static_assert(Convertible<typename M::value_type, T>(), "");
+  matrix_impl::instrument_copy();
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename M, typename X>
-Matrix<T, N> &Matrix<T, N>::operator=(const M &x) {
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator=(const M &x) {
   static_assert(Convertible<typename M::value_type, T>(), "");
 
   this->desc_ = x.descriptor();
   elems_.assign(x.begin(), x.end());
+  matrix_impl::instrument_copy();
   return *this;
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename U>
-Matrix<T, N>::Matrix(const MatrixRef<U, N> &x)  // copy desc_ and elements
-    : MatrixBase<T, N>{x.descriptor().extents}, elems_{x.begin(), x.end()} {
+Matrix<T, N, Allocator>::Matrix(
+    const MatrixRef<U, N> &x)  // copy desc_ and elements
+    : MatrixBase<T, N, Matrix>{x.descriptor().extents},
+      elems_(this->desc_.size) {
   static_assert(Convertible<U, T>(),
                 "Matrix constructor: incompatible element types");
+  matrix_impl::copy_elements(x.data(), x.descriptor(), data(), this->desc_);
+  matrix_impl::instrument_copy();
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename U>
-Matrix<T, N> &Matrix<T, N>::operator=(const MatrixRef<U, N> &x) {
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator=(
+    const MatrixRef<U, N> &x) {
   static_assert(Convertible<U, T>(), "Matrix =: incompatible element types");
 
-  this->desc_ = x.descriptor();
-  this->desc_.start = 0;
-  elems_.assign(x.begin(), x.end());
+  assign_elements(x.data(), x.descriptor());
+  this->desc_ = MatrixSlice<N>(x.descriptor().extents);
+  matrix_impl::instrument_copy();
   return *this;
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
+template <typename E>
+Matrix<T, N, Allocator>::Matrix(const MatrixExpr<E> &x)
+    : MatrixBase<T, N, Matrix>(x.descriptor()),
+      elems_(this->desc_.size)  // allocate desc_.size elements only
+{
+  static_assert(MatrixExpr<E>::order_ == N,
+                "Matrix constructor: mismatched dimensions");
+  static_assert(Convertible<typename E::value_type, T>(),
+                "Matrix constructor: incompatible element types");
+  matrix_impl::expr_eval(data(), this->desc_, x.node(),
+                         matrix_impl::expr_copy_assign());
+}
+
+template <typename T, std::size_t N, typename Allocator>
+template <typename E>
+Matrix<T, N, Allocator>::Matrix(MatrixExpr<E> &&x) {
+  static_assert(MatrixExpr<E>::order_ == N,
+                "Matrix constructor: mismatched dimensions");
+  static_assert(Convertible<typename E::value_type, T>(),
+                "Matrix constructor: incompatible element types");
+
+  Matrix *m = matrix_impl::expr_storage(x.node(), this);
+  if (!m) {
+    *this = Matrix(x);
+    return;
+  }
+
+  matrix_impl::expr_assign(m->data(), m->descriptor(), x.node(),
+                           matrix_impl::expr_copy_assign());
+  *this = std::move(*m);
+}
+
+template <typename T, std::size_t N, typename Allocator>
+template <typename E>
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator=(
+    const MatrixExpr<E> &x) {
+  static_assert(MatrixExpr<E>::order_ == N, "Matrix =: mismatched dimensions");
+  static_assert(Convertible<typename E::value_type, T>(),
+                "Matrix =: incompatible element types");
+
+  if (x.node().extents() != this->desc_.extents) {
+    // the expression may read the current elements
+    Matrix tmp(x);
+    return *this = std::move(tmp);
+  }
+
+  matrix_impl::expr_assign(data(), this->desc_, x.node(),
+                           matrix_impl::expr_copy_assign());
+  return *this;
+}
+
+template <typename T, std::size_t N, typename Allocator>
+template <typename... Exts, typename X>
+Matrix<T, N, Allocator>::Matrix(Exts... exts)
+    : MatrixBase<T, N, Matrix>{exts...}  // copy extents
+{
+  // allocate desc_.size elements and initialize
+  matrix_impl::first_touch_init(elems_, this->desc_, T{});
+}
+
+template <typename T, std::size_t N, typename Allocator>
 template <typename... Exts>
-Matrix<T, N>::Matrix(Exts... exts)
-    : MatrixBase<T, N>{exts...},  // copy extents
-      elems_(this->desc_.size)    // allocate desc_.size elements and initialize
+Matrix<T, N, Allocator>::Matrix(uninitialized_tag, Exts... exts)
+    : MatrixBase<T, N, Matrix>{exts...},  // copy extents
+      elems_(this->desc_.size)    // allocate desc_.size elements only
 {}
 
-template <typename T, std::size_t N>
-Matrix<T, N>::Matrix(MatrixInitializer<T, N> init) {
+template <typename T, std::size_t N, typename Allocator>
+Matrix<T, N, Allocator>::Matrix(MatrixInitializer<T, N> init) {
   // intialize start
   this->desc_.start = 0;
   // deduce extents from initializer list
@@ -452,8 +641,9 @@ Matrix<T, N>::Matrix(MatrixInitializer<T, N> init) {
   assert(elems_.size() == this->desc_.size);
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> &Matrix<T, N>::operator=(MatrixInitializer<T, N> init) {
+template <typename T, std::size_t N, typename Allocator>
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator=(
+    MatrixInitializer<T, N> init) {
   elems_.clear();
 
   // intialize start
@@ -471,20 +661,20 @@ Matrix<T, N> &Matrix<T, N>::operator=(MatrixInitializer<T, N> init) {
   return *this;
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename... Args>
 Enable_if<matrix_impl::Requesting_slice<Args...>(), MatrixRef<T, N>>
-Matrix<T, N>::operator()(const Args &... args) {
+Matrix<T, N, Allocator>::operator()(const Args &... args) {
   MatrixSlice<N> d;
   d.start = matrix_impl::do_slice(this->desc_, d, args...);
   d.size = matrix_impl::compute_size(d.extents);
   return {d, data()};
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename... Args>
 Enable_if<matrix_impl::Requesting_slice<Args...>(), MatrixRef<const T, N>>
-Matrix<T, N>::operator()(const Args &... args) const {
+Matrix<T, N, Allocator>::operator()(const Args &... args) const {
   MatrixSlice<N> d;
   d.start = matrix_impl::do_slice(this->desc_, d, args...);
   d.size = matrix_impl::compute_size(d.extents);
@@ -492,16 +682,16 @@ Matrix<T, N>::operator()(const Args &... args) const {
 }
 
 // row
-template <typename T, std::size_t N>
-MatrixRef<T, N - 1> Matrix<T, N>::row(std::size_t n) {
+template <typename T, std::size_t N, typename Allocator>
+MatrixRef<T, N - 1> Matrix<T, N, Allocator>::row(std::size_t n) {
   assert(n < this->n_rows());
   MatrixSlice<N - 1> row;
   matrix_impl::slice_dim<0>(n, this->desc_, row);
   return {row, data()};
 }
 
-template <typename T, std::size_t N>
-MatrixRef<const T, N - 1> Matrix<T, N>::row(std::size_t n) const {
+template <typename T, std::size_t N, typename Allocator>
+MatrixRef<const T, N - 1> Matrix<T, N, Allocator>::row(std::size_t n) const {
   assert(n < this->n_rows());
   MatrixSlice<N - 1> row;
   matrix_impl::slice_dim<0>(n, this->desc_, row);
@@ -509,24 +699,24 @@ MatrixRef<const T, N - 1> Matrix<T, N>::row(std::size_t n) const {
 }
 
 // col
-template <typename T, std::size_t N>
-MatrixRef<T, N - 1> Matrix<T, N>::col(std::size_t n) {
+template <typename T, std::size_t N, typename Allocator>
+MatrixRef<T, N - 1> Matrix<T, N, Allocator>::col(std::size_t n) {
   assert(n < this->n_cols());
   MatrixSlice<N - 1> col;
   matrix_impl::slice_dim<1>(n, this->desc_, col);
   return {col, data()};
 }
 
-template <typename T, std::size_t N>
-MatrixRef<const T, N - 1> Matrix<T, N>::col(std::size_t n) const {
+template <typename T, std::size_t N, typename Allocator>
+MatrixRef<const T, N - 1> Matrix<T, N, Allocator>::col(std::size_t n) const {
   assert(n < this->n_cols());
   MatrixSlice<N - 1> col;
   matrix_impl::slice_dim<1>(n, this->desc_, col);
   return {col, data()};
 }
 
-template <typename T, std::size_t N>
-MatrixRef<T, N> Matrix<T, N>::rows(std::size_t i, std::size_t j) {
+template <typename T, std::size_t N, typename Allocator>
+MatrixRef<T, N> Matrix<T, N, Allocator>::rows(std::size_t i, std::size_t j) {
   assert(i <= j);
   assert(j < this->n_rows());
 
@@ -538,11 +728,13 @@ MatrixRef<T, N> Matrix<T, N>::rows(std::size_t i, std::size_t j) {
     d.start += matrix_impl::do_slice_dim2(this->desc_, d, slice{0}, NRest);
     --NRest;
   }
+  d.size = matrix_impl::compute_size(d.extents);
   return {d, data()};
 }
 
-template <typename T, std::size_t N>
-MatrixRef<const T, N> Matrix<T, N>::rows(std::size_t i, std::size_t j) const {
+template <typename T, std::size_t N, typename Allocator>
+MatrixRef<const T, N> Matrix<T, N, Allocator>::rows(std::size_t i,
+                                                    std::size_t j) const {
   assert(i <= j);
   assert(j < this->n_rows());
 
@@ -554,11 +746,12 @@ MatrixRef<const T, N> Matrix<T, N>::rows(std::size_t i, std::size_t j) const {
     d.start += matrix_impl::do_slice_dim2(this->desc_, d, slice{0}, NRest);
     --NRest;
   }
+  d.size = matrix_impl::compute_size(d.extents);
   return {d, data()};
 }
 
-template <typename T, std::size_t N>
-MatrixRef<T, N> Matrix<T, N>::cols(std::size_t i, std::size_t j) {
+template <typename T, std::size_t N, typename Allocator>
+MatrixRef<T, N> Matrix<T, N, Allocator>::cols(std::size_t i, std::size_t j) {
   assert(N >= 2);
   assert(i <= j);
   assert(j < this->n_cols());
@@ -574,11 +767,13 @@ MatrixRef<T, N> Matrix<T, N>::cols(std::size_t i, std::size_t j) {
     d.start += matrix_impl::do_slice_dim2(this->desc_, d, slice{0}, NRest);
     --NRest;
   }
+  d.size = matrix_impl::compute_size(d.extents);
   return {d, data()};
 }
 
-template <typename T, std::size_t N>
-MatrixRef<const T, N> Matrix<T, N>::cols(std::size_t i, std::size_t j) const {
+template <typename T, std::size_t N, typename Allocator>
+MatrixRef<const T, N> Matrix<T, N, Allocator>::cols(std::size_t i,
+                                                    std::size_t j) const {
   assert(N >= 2);
   assert(i <= j);
   assert(j < this->n_cols());
@@ -594,135 +789,237 @@ MatrixRef<const T, N> Matrix<T, N>::cols(std::size_t i, std::size_t j) const {
     d.start += matrix_impl::do_slice_dim2(this->desc_, d, slice{0}, NRest);
     --NRest;
   }
+  d.size = matrix_impl::compute_size(d.extents);
   return {d, data()};
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename F>
-Matrix<T, N> &Matrix<T, N>::apply(F f) {
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::apply(F f) {
   for (auto &x : elems_) f(x);  // this loop uses stride iterators
   return *this;
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename M, typename F>
-Enable_if<Matrix_type<M>(), Matrix<T, N> &> Matrix<T, N>::apply(const M &m,
-                                                                F f) {
+Enable_if<Matrix_type<M>(), Matrix<T, N, Allocator> &>
+Matrix<T, N, Allocator>::apply(const M &m, F f) {
   assert(same_extents(this->desc_, m.descriptor()));
-  auto j = m.begin();
-  for (auto i = begin(); i != end(); ++i) {
-    f(*i, *j);
-    ++j;
-  }
-
+  matrix_impl::for_each_element(data(), this->desc_, m.data(), m.descriptor(),
+                                f);
   return *this;
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> &Matrix<T, N>::operator=(const T &val) {
+template <typename T, std::size_t N, typename Allocator>
+template <typename U>
+void Matrix<T, N, Allocator>::assign_elements(const U *x,
+                                              const MatrixSlice<N> &xd) {
+  const MatrixSlice<N> d(xd.extents);
+  if (elems_.size() == d.size && !matrix_impl::may_view(x, xd, data(), d)) {
+    matrix_impl::copy_elements(x, xd, data(), d);
+    return;
+  }
+  matrix_impl::Storage<T, Allocator> elems(d.size);
+  matrix_impl::copy_elements(x, xd, elems.data(), d);
+  elems_ = std::move(elems);
+}
+
+template <typename T, std::size_t N, typename Allocator>
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator=(const T &val) {
+  if (matrix_impl::dispatch_simd_fill(val, data(), this->desc_)) return *this;
   return apply([&](T &a) { a = val; });
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> &Matrix<T, N>::operator+=(const T &val) {
+template <typename T, std::size_t N, typename Allocator>
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator+=(const T &val) {
+  if (matrix_impl::dispatch_simd_scalar(matrix_impl::SimdOp::add, val, data(),
+                                         this->desc_))
+    return *this;
   return apply([&](T &a) { a += val; });
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> &Matrix<T, N>::operator-=(const T &val) {
+template <typename T, std::size_t N, typename Allocator>
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator-=(const T &val) {
+  if (matrix_impl::dispatch_simd_scalar(matrix_impl::SimdOp::sub, val, data(),
+                                         this->desc_))
+    return *this;
   return apply([&](T &a) { a -= val; });
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> &Matrix<T, N>::operator*=(const T &val) {
+template <typename T, std::size_t N, typename Allocator>
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator*=(const T &val) {
+  if (matrix_impl::dispatch_scal(val, data(), this->desc_)) return *this;
+  if (matrix_impl::dispatch_simd_scalar(matrix_impl::SimdOp::mul, val, data(),
+                                         this->desc_))
+    return *this;
   return apply([&](T &a) { a *= val; });
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> &Matrix<T, N>::operator/=(const T &val) {
+template <typename T, std::size_t N, typename Allocator>
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator/=(const T &val) {
+  if (matrix_impl::dispatch_simd_scalar(matrix_impl::SimdOp::div, val, data(),
+                                         this->desc_))
+    return *this;
   return apply([&](T &a) { a /= val; });
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> &Matrix<T, N>::operator%=(const T &val) {
+template <typename T, std::size_t N, typename Allocator>
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator%=(const T &val) {
   return apply([&](T &a) { a %= val; });
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename M>
-Enable_if<Matrix_type<M>(), Matrix<T, N> &> Matrix<T, N>::operator+=(
-    const M &m) {
+Enable_if<Matrix_type<M>(), Matrix<T, N, Allocator> &>
+Matrix<T, N, Allocator>::operator+=(const M &m) {
   // static_assert(m.order_ == N, "+=: mismatched Matrix dimensions");
   assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
 
+  if (matrix_impl::dispatch_axpy(T(1), m.data(), m.descriptor(), data(),
+                                 this->desc_) ||
+      matrix_impl::dispatch_simd_update(matrix_impl::SimdOp::add, m.data(),
+                                        m.descriptor(), data(), this->desc_))
+    return *this;
   return apply(m, [&](T &a, const Value_type<M> &b) { a += b; });
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename M>
-Enable_if<Matrix_type<M>(), Matrix<T, N> &> Matrix<T, N>::operator-=(
-    const M &m) {
+Enable_if<Matrix_type<M>(), Matrix<T, N, Allocator> &>
+Matrix<T, N, Allocator>::operator-=(const M &m) {
   // static_assert(m.order_ == N, "-=: mismatched Matrix dimensions");
   assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
 
+  if (matrix_impl::dispatch_axpy(T(-1), m.data(), m.descriptor(), data(),
+                                 this->desc_) ||
+      matrix_impl::dispatch_simd_update(matrix_impl::SimdOp::sub, m.data(),
+                                        m.descriptor(), data(), this->desc_))
+    return *this;
   return apply(m, [&](T &a, const Value_type<M> &b) { a -= b; });
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename M>
-Enable_if<Matrix_type<M>(), Matrix<T, N> &> Matrix<T, N>::operator*=(
-    const M &m) {
+Enable_if<Matrix_type<M>(), Matrix<T, N, Allocator> &>
+Matrix<T, N, Allocator>::operator*=(const M &m) {
   assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
 
+  if (matrix_impl::dispatch_simd_update(matrix_impl::SimdOp::mul, m.data(),
+                                        m.descriptor(), data(), this->desc_))
+    return *this;
   return apply(m, [&](T &a, const Value_type<M> &b) { a *= b; });
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename M>
-Enable_if<Matrix_type<M>(), Matrix<T, N> &> Matrix<T, N>::operator/=(
-    const M &m) {
+Enable_if<Matrix_type<M>(), Matrix<T, N, Allocator> &>
+Matrix<T, N, Allocator>::operator/=(const M &m) {
   assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
 
+  if (matrix_impl::dispatch_simd_update(matrix_impl::SimdOp::div, m.data(),
+                                        m.descriptor(), data(), this->desc_))
+    return *this;
   return apply(m, [&](T &a, const Value_type<M> &b) { a /= b; });
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename M>
-Enable_if<Matrix_type<M>(), Matrix<T, N> &> Matrix<T, N>::operator%=(
-    const M &m) {
+Enable_if<Matrix_type<M>(), Matrix<T, N, Allocator> &>
+Matrix<T, N, Allocator>::operator%=(const M &m) {
   assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
 
   return apply(m, [&](T &a, const Value_type<M> &b) { a %= b; });
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
+template <typename E>
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator+=(
+    const MatrixExpr<E> &x) {
+  assert(x.node().extents() == this->desc_.extents);
+
+  matrix_impl::expr_assign(data(), this->desc_, x.node(),
+                           matrix_impl::expr_plus_assign());
+  return *this;
+}
+
+template <typename T, std::size_t N, typename Allocator>
+template <typename E>
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator-=(
+    const MatrixExpr<E> &x) {
+  assert(x.node().extents() == this->desc_.extents);
+
+  matrix_impl::expr_assign(data(), this->desc_, x.node(),
+                           matrix_impl::expr_minus_assign());
+  return *this;
+}
+
+template <typename T, std::size_t N, typename Allocator>
+template <typename E>
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator*=(
+    const MatrixExpr<E> &x) {
+  assert(x.node().extents() == this->desc_.extents);
+
+  matrix_impl::expr_assign(data(), this->desc_, x.node(),
+                           matrix_impl::expr_multiplies_assign());
+  return *this;
+}
+
+template <typename T, std::size_t N, typename Allocator>
+template <typename E>
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator/=(
+    const MatrixExpr<E> &x) {
+  assert(x.node().extents() == this->desc_.extents);
+
+  matrix_impl::expr_assign(data(), this->desc_, x.node(),
+                           matrix_impl::expr_divides_assign());
+  return *this;
+}
+
+template <typename T, std::size_t N, typename Allocator>
+template <typename E>
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator%=(
+    const MatrixExpr<E> &x) {
+  assert(x.node().extents() == this->desc_.extents);
+
+  matrix_impl::expr_assign(data(), this->desc_, x.node(),
+                           matrix_impl::expr_modulus_assign());
+  return *this;
+}
+
+template <typename T, std::size_t N, typename Allocator>
 template <typename U>
-Matrix<U, N> Matrix<T, N>::operator-() const {
-  Matrix<U, N> res(*this);
+Matrix<U, N, Rebind_alloc<Allocator, U>> Matrix<T, N, Allocator>::operator-()
+    const {
+  Matrix<U, N, Rebind_alloc<Allocator, U>> res(*this);
   return res.apply([&](T &a) { a = -a; });
 }
 
-template <typename T, std::size_t N>
-template <typename U, std::size_t NN, typename X>
-Matrix<T, N>::Matrix(const Matrix<U, 2> &x)
-    : MatrixBase<T, N>{x.n_rows()}, elems_{x.begin(), x.end()} {
+template <typename T, std::size_t N, typename Allocator>
+template <typename U, typename A, std::size_t NN, typename X>
+Matrix<T, N, Allocator>::Matrix(const Matrix<U, 2, A> &x)
+    : MatrixBase<T, N, Matrix>{x.n_rows()}, elems_{x.begin(), x.end()} {
   static_assert(Convertible<U, T>(),
                 "Matrix constructor: incompatible element types");
+  matrix_impl::instrument_copy();
   assert(x.n_cols() == 1);
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename U, std::size_t NN, typename X>
-Matrix<T, N>::Matrix(const MatrixRef<U, 2> &x)
-    : MatrixBase<T, N>{x.n_rows()}, elems_{x.begin(), x.end()} {
+Matrix<T, N, Allocator>::Matrix(const MatrixRef<U, 2> &x)
+    : MatrixBase<T, N, Matrix>{x.n_rows()}, elems_(this->desc_.size) {
   static_assert(Convertible<U, T>(),
                 "Matrix constructor: incompatible element types");
+  matrix_impl::copy_elements(
+      x.data(), matrix_impl::vector_slice(x.descriptor()), data(), this->desc_);
+  matrix_impl::instrument_copy();
   assert(x.n_cols() == 1);
 }
 
-template <typename T, std::size_t N>
-template <typename U, std::size_t NN, typename X>
-Matrix<T, N> &Matrix<T, N>::operator=(const Matrix<U, 2> &x) {
+template <typename T, std::size_t N, typename Allocator>
+template <typename U, typename A, std::size_t NN, typename X>
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator=(
+    const Matrix<U, 2, A> &x) {
   static_assert(Convertible<U, T>(), "Matrix =: incompatible element types");
   assert(x.n_cols() == 1);
 
@@ -732,13 +1029,15 @@ Matrix<T, N> &Matrix<T, N>::operator=(const Matrix<U, 2> &x) {
   this->desc_.strides[0] = 1;
 
   elems_.assign(x.begin(), x.end());
+  matrix_impl::instrument_copy();
 
   return *this;
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename U, std::size_t NN, typename X>
-Matrix<T, N> &Matrix<T, N>::operator=(const MatrixRef<U, 2> &x) {
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator=(
+    const MatrixRef<U, 2> &x) {
   static_assert(Convertible<U, T>(), "Matrix =: incompatible element types");
   assert(x.n_cols() == 1);
 
@@ -747,30 +1046,36 @@ Matrix<T, N> &Matrix<T, N>::operator=(const MatrixRef<U, 2> &x) {
   this->desc_.extents[0] = x.n_rows();
   this->desc_.strides[0] = 1;
 
-  elems_.assign(x.begin(), x.end());
+  assign_elements(x.data(), matrix_impl::vector_slice(x.descriptor()));
+  matrix_impl::instrument_copy();
 
   return *this;
 }
 
-template <typename T, std::size_t N>
-template <typename U, std::size_t NN, typename X>
-Matrix<T, N>::Matrix(const Matrix<U, 1> &x)
-    : MatrixBase<T, N>{x.n_rows(), 1}, elems_{x.begin(), x.end()} {
+template <typename T, std::size_t N, typename Allocator>
+template <typename U, typename A, std::size_t NN, typename X>
+Matrix<T, N, Allocator>::Matrix(const Matrix<U, 1, A> &x)
+    : MatrixBase<T, N, Matrix>{x.n_rows(), 1}, elems_{x.begin(), x.end()} {
   static_assert(Convertible<U, T>(),
                 "Matrix constructor: incompatible element types");
+  matrix_impl::instrument_copy();
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename U, std::size_t NN, typename X>
-Matrix<T, N>::Matrix(const MatrixRef<U, 1> &x)
-    : MatrixBase<T, N>{x.n_rows(), 1}, elems_{x.begin(), x.end()} {
+Matrix<T, N, Allocator>::Matrix(const MatrixRef<U, 1> &x)
+    : MatrixBase<T, N, Matrix>{x.n_rows(), 1}, elems_(this->desc_.size) {
   static_assert(Convertible<U, T>(),
                 "Matrix constructor: incompatible element types");
+  matrix_impl::copy_elements(
+      x.data(), matrix_impl::column_slice(x.descriptor()), data(), this->desc_);
+  matrix_impl::instrument_copy();
 }
 
-template <typename T, std::size_t N>
-template <typename U, std::size_t NN, typename X>
-Matrix<T, N> &Matrix<T, N>::operator=(const Matrix<U, 1> &x) {
+template <typename T, std::size_t N, typename Allocator>
+template <typename U, typename A, std::size_t NN, typename X>
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator=(
+    const Matrix<U, 1, A> &x) {
   static_assert(Convertible<U, T>(), "Matrix =: incompatible element types");
 
   this->desc_.size = x.descriptor().size;
@@ -781,13 +1086,15 @@ Matrix<T, N> &Matrix<T, N>::operator=(const Matrix<U, 1> &x) {
   this->desc_.strides[1] = 1;
 
   elems_.assign(x.begin(), x.end());
+  matrix_impl::instrument_copy();
 
   return *this;
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename U, std::size_t NN, typename X>
-Matrix<T, N> &Matrix<T, N>::operator=(const MatrixRef<U, 1> &x) {
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator=(
+    const MatrixRef<U, 1> &x) {
   static_assert(Convertible<U, T>(), "Matrix =: incompatible element types");
 
   this->desc_.size = x.descriptor().size;
@@ -797,15 +1104,16 @@ Matrix<T, N> &Matrix<T, N>::operator=(const MatrixRef<U, 1> &x) {
   this->desc_.strides[0] = x.n_rows();
   this->desc_.strides[1] = 1;
 
-  elems_.assign(x.begin(), x.end());
+  assign_elements(x.data(), matrix_impl::column_slice(x.descriptor()));
+  matrix_impl::instrument_copy();
 
   return *this;
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename U, typename TRI, std::size_t NN, typename X>
-Matrix<T, N>::Matrix(const SymmetricMatrix<U, TRI> &x)
-    : MatrixBase<T, N>{x.n_rows(), x.n_cols()} {
+Matrix<T, N, Allocator>::Matrix(const SymmetricMatrix<U, TRI> &x)
+    : MatrixBase<T, N, Matrix>{x.n_rows(), x.n_cols()} {
   static_assert(Convertible<U, T>(),
                 "Matrix constructor: incompatible element types");
   for (std::size_t i = 0; i != x.n_rows(); ++i) {
@@ -815,10 +1123,10 @@ Matrix<T, N>::Matrix(const SymmetricMatrix<U, TRI> &x)
   }
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename U, typename TRI, std::size_t NN, typename X>
-Matrix<T, N>::Matrix(const TriangularMatrix<U, TRI> &x)
-    : MatrixBase<T, N>{x.n_rows(), x.n_cols()} {
+Matrix<T, N, Allocator>::Matrix(const TriangularMatrix<U, TRI> &x)
+    : MatrixBase<T, N, Matrix>{x.n_rows(), x.n_cols()} {
   static_assert(Convertible<U, T>(),
                 "Matrix constructor: incompatible element types");
   for (std::size_t i = 0; i != x.n_rows(); ++i) {
@@ -828,10 +1136,10 @@ Matrix<T, N>::Matrix(const TriangularMatrix<U, TRI> &x)
   }
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename U, typename TRI, std::size_t NN, typename X>
-Matrix<T, N>::Matrix(const HermitianMatrix<U, TRI> &x)
-    : MatrixBase<T, N>{x.n_rows(), x.n_cols()} {
+Matrix<T, N, Allocator>::Matrix(const HermitianMatrix<U, TRI> &x)
+    : MatrixBase<T, N, Matrix>{x.n_rows(), x.n_cols()} {
   static_assert(Convertible<U, T>(),
                 "Matrix constructor: incompatible element types");
   for (std::size_t i = 0; i != x.n_rows(); ++i) {
@@ -841,9 +1149,10 @@ Matrix<T, N>::Matrix(const HermitianMatrix<U, TRI> &x)
   }
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename U, typename TRI, std::size_t NN, typename X>
-Matrix<T, N> &Matrix<T, N>::operator=(const SymmetricMatrix<U, TRI> &x)
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator=(
+    const SymmetricMatrix<U, TRI> &x)
 {
   static_assert(Convertible<U, T>(),
                 "Matrix =: incompatible element types");
@@ -868,9 +1177,10 @@ Matrix<T, N> &Matrix<T, N>::operator=(const SymmetricMatrix<U, TRI> &x)
   return *this;
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename U, typename TRI, std::size_t NN, typename X>
-Matrix<T, N> &Matrix<T, N>::operator=(const TriangularMatrix<U, TRI> &x)
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator=(
+    const TriangularMatrix<U, TRI> &x)
 {
   static_assert(Convertible<U, T>(),
                 "Matrix =: incompatible element types");
@@ -895,9 +1205,10 @@ Matrix<T, N> &Matrix<T, N>::operator=(const TriangularMatrix<U, TRI> &x)
   return *this;
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator>
 template <typename U, typename TRI, std::size_t NN, typename X>
-Matrix<T, N> &Matrix<T, N>::operator=(const HermitianMatrix<U, TRI> &x)
+Matrix<T, N, Allocator> &Matrix<T, N, Allocator>::operator=(
+    const HermitianMatrix<U, TRI> &x)
 {
   static_assert(Convertible<U, T>(),
                 "Matrix =: incompatible element types");
@@ -922,14 +1233,14 @@ Matrix<T, N> &Matrix<T, N>::operator=(const HermitianMatrix<U, TRI> &x)
   return *this;
 }
 
-template <typename T, std::size_t N>
-void Matrix<T, N>::clear() {
+template <typename T, std::size_t N, typename Allocator>
+void Matrix<T, N, Allocator>::clear() {
   this->desc_.clear();
   elems_.clear();
 }
 
-template <typename T, std::size_t N>
-void Matrix<T, N>::load(const std::string &filename) {
+template <typename T, std::size_t N, typename Allocator>
+void Matrix<T, N, Allocator>::load(const std::string &filename) {
   std::ifstream is(filename);
   if (is.is_open()) {
     // read the first line
@@ -950,7 +1261,14 @@ void Matrix<T, N>::load(const std::string &filename) {
         matrix_impl::compute_strides(this->desc_.extents, this->desc_.strides);
 
     std::istream_iterator<T> in(is), end;
-    elems_.assign(in, end);
+    if (matrix_impl::parallel_first_touch<T>(this->desc_.size)) {
+      // place the pages first, then parse into them
+      matrix_impl::first_touch_init(elems_, this->desc_, T{});
+      T *p = data();
+      for (T *last = p + size(); in != end && p != last; ++in) *p++ = *in;
+    } else {
+      elems_.assign(in, end);
+    }
   } else {
     std::cout << "Fail to open the file" << std::endl;
   }
@@ -963,8 +1281,9 @@ void Matrix<T, N>::load(const std::string &filename) {
  * Matrix<T,0> is not really a matrix. It stores a single element of
  * type T and can be converted to a reference to that type.
  */
-template <typename T>
-class Matrix<T, 0> : public MatrixBase<T, 0> {
+template <typename T, typename Allocator>
+class Matrix<T, 0, Allocator>
+    : public MatrixBase<T, 0, Matrix<T, 0, Allocator>> {
  public:
   //! @cond Doxygen_Suppress
   using iterator = typename std::array<T, 1>::iterator;
@@ -1012,8 +1331,8 @@ class Matrix<T, 0> : public MatrixBase<T, 0> {
   std::array<T, 1> elem_;
 };
 
-template <typename T>
-std::ostream &operator<<(std::ostream &os, const Matrix<T, 0> &m0) {
+template <typename T, typename Allocator>
+std::ostream &operator<<(std::ostream &os, const Matrix<T, 0, Allocator> &m0) {
   return os << (const T &)m0();
 }
 
@@ -32,11 +32,27 @@
 
 namespace slab {
 
-template <typename T, std::size_t N>
+//! The common base of Matrix and MatrixRef.
+/*!
+ * MatrixBase<T, N, D> is a CRTP base: D is the derived Matrix or MatrixRef,
+ * and size(), data() and subscripting call D's members directly, so that
+ * element loops written against a MatrixBase inline and vectorize. Functions
+ * taking any matrix of order N are templates on D:
+ *
+ * \code
+ * template <typename T, typename D>
+ * T sum(const MatrixBase<T, 1, D> &x);
+ * \endcode
+ *
+ * Where one function must take matrices of any type at run time, e.g. behind
+ * a virtual interface, use the type-erased AnyMatrix<T, N> instead.
+ */
+template <typename T, std::size_t N, typename D>
 class MatrixBase {
  public:
   static constexpr std::size_t order_ = N;  // number of dimensions
   using value_type = T;
+  using derived_type = D;
 
   MatrixBase() = default;
   MatrixBase(MatrixBase &&) = default;  // move
@@ -51,6 +67,12 @@ class MatrixBase {
 
   explicit MatrixBase(const MatrixSlice<N> &ms) : desc_{ms} {}
 
+  //! the Matrix or MatrixRef this is the base of
+  ///@{
+  D &derived() { return static_cast<D &>(*this); }
+  const D &derived() const { return static_cast<const D &>(*this); }
+  ///@}
+
   //! number of dimensions
   static constexpr std::size_t order() { return order_; }
   //! #elements in the nth dimension
@@ -59,14 +81,14 @@ class MatrixBase {
     return desc_.extents[n];
   }
   //! total number of elements
-  virtual std::size_t size() const = 0;
+  std::size_t size() const { return derived().size(); }
   //! the slice defining subscripting
   const MatrixSlice<N> &descriptor() const { return desc_; }
 
   //! "flat" element access
   ///@{
-  virtual T *data() = 0;
-  virtual const T *data() const = 0;
+  T *data() { return derived().data(); }
+  const T *data() const { return derived().data(); }
   ///@}
 
   std::size_t n_rows() const { return desc_.extents[0]; }
@@ -83,18 +105,21 @@ class MatrixBase {
   MatrixSlice<N> desc_;  // slice defining extents in the N dimensions
 };
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename D>
+constexpr std::size_t MatrixBase<T, N, D>::order_;
+
+template <typename T, std::size_t N, typename D>
 template <typename... Args>
-T &MatrixBase<T, N>::operator()(Args... args) {
+T &MatrixBase<T, N, D>::operator()(Args... args) {
   assert(matrix_impl::check_bounds(this->desc_, args...));
-  return *(data() + this->desc_(args...));
+  return *(derived().data() + this->desc_(args...));
 }
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename D>
 template <typename... Args>
-const T &MatrixBase<T, N>::operator()(Args... args) const {
+const T &MatrixBase<T, N, D>::operator()(Args... args) const {
   assert(matrix_impl::check_bounds(this->desc_, args...));
-  return *(data() + this->desc_(args...));
+  return *(derived().data() + this->desc_(args...));
 }
 
 template <typename M>
@@ -0,0 +1,822 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file matrix_expr.h
+/// @brief Lazily evaluated element-wise expressions of matrices
+
+#ifndef SLAB_MATRIX_MATRIX_EXPR_H_
+#define SLAB_MATRIX_MATRIX_EXPR_H_
+
+#include <cassert>
+#include <cstddef>
+
+#include <array>
+#include <complex>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "slab/matrix/blas_dispatch.h"
+#include "slab/matrix/matrix_fwd.h"
+#include "slab/matrix/matrix_slice.h"
+#include "slab/matrix/simd_dispatch.h"
+#include "slab/matrix/support.h"
+#include "slab/matrix/traits.h"
+
+namespace slab {
+
+template <typename E>
+class MatrixExpr;
+
+namespace matrix_impl {
+
+// Expression nodes
+//
+// A node computes the elements of an expression on demand, either by flat
+// index when every leaf is contiguous (contiguous(), prepare(), flat(i)) or
+// row by row along the last dimension (seek(r), at(j)). prepare() and seek()
+// position cursors that are mutable, so a node is evaluated by one loop at a
+// time.
+
+// A leaf referring to the elements of a Matrix or a MatrixRef.
+template <typename T, std::size_t N>
+class ExprView {
+ public:
+  using value_type = T;
+  static constexpr std::size_t order = N;
+  static constexpr bool is_scalar = false;
+
+  ExprView(const MatrixSlice<N> &d, const T *base)
+      : desc_(d), base_(base), contiguous_(is_contiguous(d)) {}
+
+  const std::array<std::size_t, N> &extents() const { return desc_.extents; }
+  bool contiguous() const { return contiguous_; }
+
+  const ExprView &view() const { return *this; }
+  const MatrixSlice<N> &descriptor() const { return desc_; }
+  const T *base() const { return base_; }
+
+  void prepare() const { row_ = base_ + desc_.start; }
+  T flat(std::size_t i) const { return row_[i]; }
+
+  void seek(std::size_t r) const { row_ = base_ + row_offset(desc_, r); }
+  T at(std::size_t j) const { return row_[j * desc_.strides[N - 1]]; }
+
+  // Whether writing the elements (d, dst) one by one may change elements of
+  // this leaf that are still to be read. Overlapping the destination is
+  // harmless only if both are the same view.
+  bool conflicts(const T *dst, const MatrixSlice<N> &d) const {
+    return shifted_overlap(base_, desc_, dst, d);
+  }
+
+  // elements of another type cannot be the destination
+  template <typename U>
+  bool conflicts(const U *, const MatrixSlice<N> &) const {
+    return false;
+  }
+
+ private:
+  MatrixSlice<N> desc_;
+  const T *base_;
+  bool contiguous_;
+  mutable const T *row_ = nullptr;
+};
+
+// A leaf owning a temporary Matrix, e.g. the result of matmul(), so that the
+// expression can outlive the full-expression that created the temporary.
+template <typename T, std::size_t N, typename A>
+class ExprOwned {
+ public:
+  using value_type = T;
+  static constexpr std::size_t order = N;
+  static constexpr bool is_scalar = false;
+
+  explicit ExprOwned(Matrix<T, N, A> &&m) : m_(std::move(m)) {}
+
+  const std::array<std::size_t, N> &extents() const {
+    return m_.descriptor().extents;
+  }
+  bool contiguous() const { return true; }
+
+  ExprView<T, N> view() const {
+    return ExprView<T, N>(m_.descriptor(), m_.data());
+  }
+
+  void prepare() const { row_ = m_.data(); }
+  T flat(std::size_t i) const { return row_[i]; }
+
+  void seek(std::size_t r) const { row_ = m_.data() + r * m_.extent(N - 1); }
+  T at(std::size_t j) const { return row_[j]; }
+
+  template <typename U, std::size_t M>
+  bool conflicts(const U *, const MatrixSlice<M> &) const {
+    return false;
+  }
+
+  // the moved-in matrix, which a Matrix evaluated from a temporary
+  // expression may take over (see expr_storage())
+  Matrix<T, N, A> &storage() const { return m_; }
+
+ private:
+  mutable Matrix<T, N, A> m_;
+  mutable const T *row_ = nullptr;
+};
+
+// A scalar operand.
+template <typename T>
+class ExprScalar {
+ public:
+  using value_type = T;
+  static constexpr std::size_t order = 0;
+  static constexpr bool is_scalar = true;
+
+  explicit ExprScalar(const T &val) : val_(val) {}
+
+  bool contiguous() const { return true; }
+  const T &value() const { return val_; }
+
+  void prepare() const {}
+  T flat(std::size_t) const { return val_; }
+
+  void seek(std::size_t) const {}
+  T at(std::size_t) const { return val_; }
+
+  template <typename U, std::size_t M>
+  bool conflicts(const U *, const MatrixSlice<M> &) const {
+    return false;
+  }
+
+ private:
+  T val_;
+};
+
+template <typename T, typename R>
+auto expr_extents(const ExprScalar<T> &, const R &r) -> decltype(r.extents()) {
+  return r.extents();
+}
+
+template <typename L, typename R>
+auto expr_extents(const L &l, const R &) -> decltype(l.extents()) {
+  return l.extents();
+}
+
+// An element-wise binary operation; at most one operand is a scalar.
+template <typename Op, typename L, typename R>
+class ExprBinary {
+ public:
+  using value_type = typename std::conditional<
+      L::is_scalar, typename R::value_type, typename L::value_type>::type;
+  static constexpr std::size_t order = L::is_scalar ? R::order : L::order;
+  static constexpr bool is_scalar = false;
+
+  ExprBinary(L l, R r) : l_(std::move(l)), r_(std::move(r)) {}
+
+  const std::array<std::size_t, order> &extents() const {
+    return expr_extents(l_, r_);
+  }
+  bool contiguous() const { return l_.contiguous() && r_.contiguous(); }
+
+  const L &left() const { return l_; }
+  const R &right() const { return r_; }
+
+  void prepare() const {
+    l_.prepare();
+    r_.prepare();
+  }
+  value_type flat(std::size_t i) const {
+    return Op::apply(l_.flat(i), r_.flat(i));
+  }
+
+  void seek(std::size_t r) const {
+    l_.seek(r);
+    r_.seek(r);
+  }
+  value_type at(std::size_t j) const { return Op::apply(l_.at(j), r_.at(j)); }
+
+  template <typename U, std::size_t M>
+  bool conflicts(const U *dst, const MatrixSlice<M> &d) const {
+    return l_.conflicts(dst, d) || r_.conflicts(dst, d);
+  }
+
+ private:
+  L l_;
+  R r_;
+};
+
+// An element-wise unary operation.
+template <typename Op, typename A>
+class ExprUnary {
+ public:
+  using value_type = typename A::value_type;
+  static constexpr std::size_t order = A::order;
+  static constexpr bool is_scalar = false;
+
+  explicit ExprUnary(A a) : a_(std::move(a)) {}
+
+  const std::array<std::size_t, order> &extents() const {
+    return a_.extents();
+  }
+  bool contiguous() const { return a_.contiguous(); }
+
+  const A &operand() const { return a_; }
+
+  void prepare() const { a_.prepare(); }
+  value_type flat(std::size_t i) const { return Op::apply(a_.flat(i)); }
+
+  void seek(std::size_t r) const { a_.seek(r); }
+  value_type at(std::size_t j) const { return Op::apply(a_.at(j)); }
+
+  template <typename U, std::size_t M>
+  bool conflicts(const U *dst, const MatrixSlice<M> &d) const {
+    return a_.conflicts(dst, d);
+  }
+
+ private:
+  A a_;
+};
+
+template <typename T>
+T conj_value(const T &a) {
+  return a;
+}
+
+template <typename T>
+std::complex<T> conj_value(const std::complex<T> &a) {
+  return std::conj(a);
+}
+
+struct expr_conj {
+  template <typename T>
+  static T apply(const T &a) {
+    return conj_value(a);
+  }
+};
+
+struct expr_plus {
+  template <typename T>
+  static T apply(const T &a, const T &b) {
+    return a + b;
+  }
+};
+
+struct expr_minus {
+  template <typename T>
+  static T apply(const T &a, const T &b) {
+    return a - b;
+  }
+};
+
+struct expr_multiplies {
+  template <typename T>
+  static T apply(const T &a, const T &b) {
+    return a * b;
+  }
+};
+
+struct expr_divides {
+  template <typename T>
+  static T apply(const T &a, const T &b) {
+    return a / b;
+  }
+};
+
+struct expr_modulus {
+  template <typename T>
+  static T apply(const T &a, const T &b) {
+    return a % b;
+  }
+};
+
+// The assignments of an element of an expression to an element of the
+// destination; named so that expr_blas() can recognize them.
+
+struct expr_copy_assign {
+  template <typename T, typename U>
+  void operator()(T &a, const U &b) const {
+    a = b;
+  }
+};
+
+struct expr_plus_assign {
+  template <typename T, typename U>
+  void operator()(T &a, const U &b) const {
+    a += b;
+  }
+};
+
+struct expr_minus_assign {
+  template <typename T, typename U>
+  void operator()(T &a, const U &b) const {
+    a -= b;
+  }
+};
+
+struct expr_multiplies_assign {
+  template <typename T, typename U>
+  void operator()(T &a, const U &b) const {
+    a *= b;
+  }
+};
+
+struct expr_divides_assign {
+  template <typename T, typename U>
+  void operator()(T &a, const U &b) const {
+    a /= b;
+  }
+};
+
+struct expr_modulus_assign {
+  template <typename T, typename U>
+  void operator()(T &a, const U &b) const {
+    a %= b;
+  }
+};
+
+// BLAS Level 1 routing
+//
+// expr_blas(base, d, e, op) computes the few expressions that map onto
+// copy/axpy/scal (see blas_dispatch.h) and returns true, or returns false
+// for the fused loop to run. Like expr_eval(), it assumes e.conflicts() is
+// false: every operand is disjoint from the destination or the same view.
+
+template <typename X>
+struct is_expr_leaf : std::false_type {};
+
+template <typename T, std::size_t N>
+struct is_expr_leaf<ExprView<T, N>> : std::true_type {};
+
+template <typename T, std::size_t N, typename A>
+struct is_expr_leaf<ExprOwned<T, N, A>> : std::true_type {};
+
+// Whether X is a leaf whose elements are of type T.
+template <typename X, typename T>
+constexpr bool Expr_leaf() {
+  return is_expr_leaf<X>::value && Same<typename X::value_type, T>();
+}
+
+template <typename T, std::size_t N, typename E, typename Op>
+bool expr_blas(T *, const MatrixSlice<N> &, const E &, Op) {
+  return false;
+}
+
+// y = x, y += x, y -= x
+template <typename T, std::size_t N, typename L>
+Enable_if<Expr_leaf<L, T>(), bool> expr_blas(T *y, const MatrixSlice<N> &yd,
+                                             const L &l, expr_copy_assign) {
+  const auto &x = l.view();
+  return dispatch_copy(x.base(), x.descriptor(), y, yd);
+}
+
+template <typename T, std::size_t N, typename L>
+Enable_if<Expr_leaf<L, T>(), bool> expr_blas(T *y, const MatrixSlice<N> &yd,
+                                             const L &l, expr_plus_assign) {
+  const auto &x = l.view();
+  return dispatch_axpy(T(1), x.base(), x.descriptor(), y, yd);
+}
+
+template <typename T, std::size_t N, typename L>
+Enable_if<Expr_leaf<L, T>(), bool> expr_blas(T *y, const MatrixSlice<N> &yd,
+                                             const L &l, expr_minus_assign) {
+  const auto &x = l.view();
+  return dispatch_axpy(T(-1), x.base(), x.descriptor(), y, yd);
+}
+
+// y = a * x, y += a * x, y -= a * x
+template <typename T, std::size_t N, typename L, typename Op>
+bool expr_blas_scaled(T *y, const MatrixSlice<N> &yd, const T &a, const L &l,
+                      Op) {
+  const auto &x = l.view();
+  if (Same<Op, expr_plus_assign>())
+    return dispatch_axpy(a, x.base(), x.descriptor(), y, yd);
+  if (Same<Op, expr_minus_assign>())
+    return dispatch_axpy(T(-a), x.base(), x.descriptor(), y, yd);
+  if (!Same<Op, expr_copy_assign>() || a == T{0} ||
+      !blas_routable(x.descriptor(), yd))
+    return false;
+
+  dispatch_copy(x.base(), x.descriptor(), y, yd);
+  return dispatch_scal(a, y, yd);
+}
+
+template <typename T, std::size_t N, typename L, typename Op>
+Enable_if<Expr_leaf<L, T>(), bool> expr_blas(
+    T *y, const MatrixSlice<N> &yd,
+    const ExprBinary<expr_multiplies, ExprScalar<T>, L> &e, Op op) {
+  return expr_blas_scaled(y, yd, e.left().value(), e.right(), op);
+}
+
+template <typename T, std::size_t N, typename L, typename Op>
+Enable_if<Expr_leaf<L, T>(), bool> expr_blas(
+    T *y, const MatrixSlice<N> &yd,
+    const ExprBinary<expr_multiplies, L, ExprScalar<T>> &e, Op op) {
+  return expr_blas_scaled(y, yd, e.right().value(), e.left(), op);
+}
+
+// y = x + z, y = x - z
+template <typename T, std::size_t N, typename L, typename R>
+Enable_if<Expr_leaf<L, T>() && Expr_leaf<R, T>(), bool> expr_blas(
+    T *y, const MatrixSlice<N> &yd, const ExprBinary<expr_plus, L, R> &e,
+    expr_copy_assign) {
+  const auto &x = e.left().view();
+  const auto &z = e.right().view();
+  if (!blas_routable(x.descriptor(), yd) || !blas_routable(z.descriptor(), yd))
+    return false;
+
+  if (same_view(z.base(), z.descriptor(), y, yd))
+    return dispatch_axpy(T(1), x.base(), x.descriptor(), y, yd);
+  dispatch_copy(x.base(), x.descriptor(), y, yd);
+  return dispatch_axpy(T(1), z.base(), z.descriptor(), y, yd);
+}
+
+template <typename T, std::size_t N, typename L, typename R>
+Enable_if<Expr_leaf<L, T>() && Expr_leaf<R, T>(), bool> expr_blas(
+    T *y, const MatrixSlice<N> &yd, const ExprBinary<expr_minus, L, R> &e,
+    expr_copy_assign) {
+  const auto &x = e.left().view();
+  const auto &z = e.right().view();
+  if (!blas_routable(x.descriptor(), yd) || !blas_routable(z.descriptor(), yd))
+    return false;
+
+  if (same_view(z.base(), z.descriptor(), y, yd)) {
+    if (same_view(x.base(), x.descriptor(), y, yd)) return false;  // y - y
+    dispatch_scal(T(-1), y, yd);
+    return dispatch_axpy(T(1), x.base(), x.descriptor(), y, yd);
+  }
+  dispatch_copy(x.base(), x.descriptor(), y, yd);
+  return dispatch_axpy(T(-1), z.base(), z.descriptor(), y, yd);
+}
+
+// SIMD kernels
+//
+// expr_simd(base, d, e, op) computes y = x op z, y = x op a and y = a op x,
+// for leaves x and z, scalar a and op one of + - * /, with the element-wise
+// kernels (see simd_dispatch.h) and returns true, or returns false for the
+// fused loop to run. It makes the same assumption as expr_blas().
+
+template <typename Op>
+struct expr_simd_op : std::false_type {};
+
+template <>
+struct expr_simd_op<expr_plus> : std::true_type {
+  static constexpr SimdOp op() { return SimdOp::add; }
+};
+
+template <>
+struct expr_simd_op<expr_minus> : std::true_type {
+  static constexpr SimdOp op() { return SimdOp::sub; }
+};
+
+template <>
+struct expr_simd_op<expr_multiplies> : std::true_type {
+  static constexpr SimdOp op() { return SimdOp::mul; }
+};
+
+template <>
+struct expr_simd_op<expr_divides> : std::true_type {
+  static constexpr SimdOp op() { return SimdOp::div; }
+};
+
+template <typename T, std::size_t N, typename E, typename Op>
+bool expr_simd(T *, const MatrixSlice<N> &, const E &, Op) {
+  return false;
+}
+
+template <typename T, std::size_t N, typename Op, typename L, typename R>
+Enable_if<expr_simd_op<Op>::value && Expr_leaf<L, T>() && Expr_leaf<R, T>(),
+          bool>
+expr_simd(T *y, const MatrixSlice<N> &yd, const ExprBinary<Op, L, R> &e,
+          expr_copy_assign) {
+  const auto &x = e.left().view();
+  const auto &z = e.right().view();
+  return dispatch_simd_binary(expr_simd_op<Op>::op(), x.base(), x.descriptor(),
+                              z.base(), z.descriptor(), y, yd);
+}
+
+template <typename T, std::size_t N, typename Op, typename L>
+Enable_if<expr_simd_op<Op>::value && Expr_leaf<L, T>(), bool> expr_simd(
+    T *y, const MatrixSlice<N> &yd, const ExprBinary<Op, L, ExprScalar<T>> &e,
+    expr_copy_assign) {
+  const auto &x = e.left().view();
+  return dispatch_simd_scaled(expr_simd_op<Op>::op(), false,
+                              e.right().value(), x.base(), x.descriptor(), y,
+                              yd);
+}
+
+template <typename T, std::size_t N, typename Op, typename R>
+Enable_if<expr_simd_op<Op>::value && Expr_leaf<R, T>(), bool> expr_simd(
+    T *y, const MatrixSlice<N> &yd, const ExprBinary<Op, ExprScalar<T>, R> &e,
+    expr_copy_assign) {
+  const auto &x = e.right().view();
+  return dispatch_simd_scaled(expr_simd_op<Op>::op(), true, e.left().value(),
+                              x.base(), x.descriptor(), y, yd);
+}
+
+// The first matrix of type M that the expression owns, or nullptr. The
+// expression is element-wise, so it can be evaluated into that matrix in
+// place, and the result then takes over its elements.
+template <typename X, typename M>
+M *expr_storage(const X &, M *) {
+  return nullptr;
+}
+
+template <typename T, std::size_t N, typename A>
+Matrix<T, N, A> *expr_storage(const ExprOwned<T, N, A> &x, Matrix<T, N, A> *) {
+  return &x.storage();
+}
+
+template <typename Op, typename A, typename M>
+M *expr_storage(const ExprUnary<Op, A> &e, M *tag) {
+  return expr_storage(e.operand(), tag);
+}
+
+template <typename Op, typename L, typename R, typename M>
+M *expr_storage(const ExprBinary<Op, L, R> &e, M *tag) {
+  M *m = expr_storage(e.left(), tag);
+  return m ? m : expr_storage(e.right(), tag);
+}
+
+// Evaluation
+
+// Performs op(dst[i], e[i]) for every element of the destination (d, base)
+// in a single pass, assuming e.conflicts() is false. With contiguous operands
+// this is one flat loop the compiler can vectorize; large expressions of the
+// forms expr_blas() knows are computed by BLAS instead, and those expr_simd()
+// knows by the kernels of the widest instruction set of the CPU.
+template <typename T, std::size_t N, typename E, typename Op>
+void expr_eval(T *base, const MatrixSlice<N> &d, const E &e, Op op) {
+  if (expr_blas(base, d, e, op) || expr_simd(base, d, e, op)) return;
+
+  if (is_contiguous(d) && e.contiguous()) {
+    T *p = base + d.start;
+    const std::size_t n = d.size;
+    e.prepare();
+    for (std::size_t i = 0; i != n; ++i) op(p[i], e.flat(i));
+    return;
+  }
+
+  const std::size_t cols = d.extents[N - 1];
+  const std::size_t rows = cols ? d.size / cols : 0;
+  const std::size_t stride = d.strides[N - 1];
+  for (std::size_t r = 0; r != rows; ++r) {
+    T *p = base + row_offset(d, r);
+    e.seek(r);
+    for (std::size_t j = 0; j != cols; ++j) op(p[j * stride], e.at(j));
+  }
+}
+
+// As expr_eval(), but evaluates e into a temporary first when the
+// destination overlaps one of its operands in a way that would let the loop
+// read elements it already wrote.
+template <typename T, std::size_t N, typename E, typename Op>
+void expr_assign(T *base, const MatrixSlice<N> &d, const E &e, Op op) {
+  if (!e.conflicts(base, d)) {
+    expr_eval(base, d, e, op);
+    return;
+  }
+
+  using V = typename E::value_type;
+  const MatrixSlice<N> td(d.extents);
+  std::vector<V> tmp(td.size);
+  expr_eval(tmp.data(), td, e, expr_copy_assign());
+  expr_eval(base, d, ExprView<V, N>(td, tmp.data()), op);
+}
+
+}  // namespace matrix_impl
+
+//! MatrixExpr<E> is an element-wise expression of matrices, evaluated lazily.
+/*!
+ * The element-wise operators +, -, *, / and % between Matrix, MatrixRef and
+ * scalar operands return a MatrixExpr instead of a Matrix. Nothing is
+ * computed until the expression is assigned to a Matrix or a MatrixRef
+ * (=, +=, -=, *=, /=, %=): then all operations run in one loop over the
+ * elements, without temporaries:
+ *
+ * \code
+ * mat r = a + b * c - 2.0 * d;  // one pass, one allocation
+ * r.row(0) += a.row(1) * 0.5;   // in place, no allocation
+ * \endcode
+ *
+ * Assigning into a matrix that an operand overlaps at a different position
+ * (e.g. `x(slice{0, n - 1}) = x(slice{1, n - 1}) + 1`) goes through a
+ * temporary, so the result is always that of the eager evaluation.
+ *
+ * Operands are referenced, except temporary matrices which are moved into
+ * the expression: keeping an expression with `auto` past the lifetime of a
+ * named operand dangles. A Matrix constructed from a temporary expression
+ * reuses the elements of such a moved-in matrix, so that
+ * `mat r = matmul(a, b) + c` or `exp(a + b)` allocate only once. Use eval()
+ * to get a Matrix, e.g. to pass an expression to functions expecting one.
+ */
+template <typename E>
+class MatrixExpr {
+ public:
+  //! @cond Doxygen_Suppress
+  using node_type = E;
+  using value_type = typename E::value_type;
+  static constexpr std::size_t order_ = E::order;
+
+  explicit MatrixExpr(E e) : e_(std::move(e)) {}
+
+  const E &node() const & { return e_; }
+  E node() && { return std::move(e_); }
+  //! @endcond
+
+  //! number of dimensions
+  static constexpr std::size_t order() { return order_; }
+  //! #elements in the nth dimension
+  std::size_t extent(std::size_t n) const {
+    assert(n < order_);
+    return e_.extents()[n];
+  }
+  std::size_t n_rows() const { return extent(0); }
+  std::size_t n_cols() const { return extent(1); }
+  //! total number of elements
+  std::size_t size() const { return matrix_impl::compute_size(e_.extents()); }
+  //! the slice of the Matrix the expression evaluates to
+  MatrixSlice<order_> descriptor() const {
+    return MatrixSlice<order_>(e_.extents());
+  }
+
+  //! compute the single element at the given subscripts
+  template <typename... Args>
+  Enable_if<matrix_impl::Requesting_element<Args...>(), value_type>
+  operator()(Args... args) const {
+    static_assert(sizeof...(Args) == order_,
+                  "MatrixExpr(): dimension mismatch");
+    const std::array<std::size_t, order_> idx{{std::size_t(args)...}};
+    const auto exts = e_.extents();
+    std::size_t r = 0;
+    for (std::size_t k = 0; k + 1 < order_; ++k) {
+      assert(idx[k] < exts[k]);
+      r = r * exts[k] + idx[k];
+    }
+    assert(idx[order_ - 1] < exts[order_ - 1]);
+    e_.seek(r);
+    return e_.at(idx[order_ - 1]);
+  }
+
+  //! evaluate into a Matrix
+  Matrix<value_type, order_> eval() const {
+    return Matrix<value_type, order_>(*this);
+  }
+
+ private:
+  E e_;
+};
+
+template <typename E>
+constexpr std::size_t MatrixExpr<E>::order_;
+
+//! The conjugate transpose of a complex matrix, a lazy view (see ht()).
+template <typename T>
+using ConjTransposed = MatrixExpr<matrix_impl::ExprUnary<
+    matrix_impl::expr_conj, matrix_impl::ExprView<T, 2>>>;
+
+namespace matrix_impl {
+
+// What ht() returns: the transposed view itself for real elements.
+template <typename T>
+struct conj_transposed {
+  using type = MatrixRef<const T, 2>;
+
+  static type make(const MatrixSlice<2> &d, const T *base) {
+    return type(d, base);
+  }
+};
+
+template <typename T>
+struct conj_transposed<std::complex<T>> {
+  using type = ConjTransposed<std::complex<T>>;
+
+  static type make(const MatrixSlice<2> &d, const std::complex<T> *base) {
+    using View = ExprView<std::complex<T>, 2>;
+    return type(ExprUnary<expr_conj, View>(View(d, base)));
+  }
+};
+
+template <typename T>
+using Conj_transposed = typename conj_transposed<Remove_const<T>>::type;
+
+template <typename X>
+struct is_matrix_expr : std::false_type {};
+
+template <typename E>
+struct is_matrix_expr<MatrixExpr<E>> : std::true_type {};
+
+template <typename X>
+constexpr bool Matrix_expr() {
+  return is_matrix_expr<typename std::decay<X>::type>::value;
+}
+
+// Whether X can be an operand of the element-wise operators.
+template <typename X>
+constexpr bool Expr_operand() {
+  return Matrix_type<typename std::decay<X>::type>() || Matrix_expr<X>();
+}
+
+template <typename X>
+using Expr_value = typename std::remove_const<
+    typename std::decay<X>::type::value_type>::type;
+
+// The node standing for an operand.
+template <typename T, std::size_t N, typename A>
+ExprView<T, N> expr_node(const Matrix<T, N, A> &x) {
+  return ExprView<T, N>(x.descriptor(), x.data());
+}
+
+template <typename T, std::size_t N, typename A>
+ExprOwned<T, N, A> expr_node(Matrix<T, N, A> &&x) {
+  return ExprOwned<T, N, A>(std::move(x));
+}
+
+template <typename T, std::size_t N>
+ExprView<typename std::remove_const<T>::type, N> expr_node(
+    const MatrixRef<T, N> &x) {
+  using U = typename std::remove_const<T>::type;
+  return ExprView<U, N>(x.descriptor(), x.data());
+}
+
+template <typename E>
+const E &expr_node(const MatrixExpr<E> &x) {
+  return x.node();
+}
+
+template <typename E>
+E expr_node(MatrixExpr<E> &&x) {
+  return std::move(x).node();
+}
+
+template <typename X>
+using Expr_node =
+    typename std::decay<decltype(expr_node(std::declval<X>()))>::type;
+
+template <typename Op, typename X, typename Y>
+using Binary_expr = MatrixExpr<ExprBinary<Op, Expr_node<X>, Expr_node<Y>>>;
+
+template <typename Op, typename X>
+using Scalar_right_expr =
+    MatrixExpr<ExprBinary<Op, Expr_node<X>, ExprScalar<Expr_value<X>>>>;
+
+template <typename Op, typename X>
+using Scalar_left_expr =
+    MatrixExpr<ExprBinary<Op, ExprScalar<Expr_value<X>>, Expr_node<X>>>;
+
+template <typename Op, typename X, typename Y>
+Binary_expr<Op, X, Y> make_expr(X &&x, Y &&y) {
+  static_assert(Same<Expr_value<X>, Expr_value<Y>>(),
+                "element-wise operation: incompatible element types");
+  static_assert(std::decay<X>::type::order_ == std::decay<Y>::type::order_,
+                "element-wise operation: mismatched dimensions");
+  assert(x.descriptor().extents == y.descriptor().extents);
+
+  using Node = typename Binary_expr<Op, X, Y>::node_type;
+  return Binary_expr<Op, X, Y>(
+      Node(expr_node(std::forward<X>(x)), expr_node(std::forward<Y>(y))));
+}
+
+template <typename Op, typename X, typename S>
+Scalar_right_expr<Op, X> make_expr_scalar(X &&x, const S &val) {
+  using Node = typename Scalar_right_expr<Op, X>::node_type;
+  return Scalar_right_expr<Op, X>(
+      Node(expr_node(std::forward<X>(x)),
+           ExprScalar<Expr_value<X>>(static_cast<Expr_value<X>>(val))));
+}
+
+template <typename Op, typename S, typename X>
+Scalar_left_expr<Op, X> make_scalar_expr(const S &val, X &&x) {
+  using Node = typename Scalar_left_expr<Op, X>::node_type;
+  return Scalar_left_expr<Op, X>(
+      Node(ExprScalar<Expr_value<X>>(static_cast<Expr_value<X>>(val)),
+           expr_node(std::forward<X>(x))));
+}
+
+// Evaluates expressions to a Matrix and passes anything else through.
+template <typename M>
+const M &materialize(const M &m) {
+  return m;
+}
+
+template <typename E>
+Matrix<typename E::value_type, E::order> materialize(const MatrixExpr<E> &x) {
+  return x.eval();
+}
+
+}  // namespace matrix_impl
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_MATRIX_EXPR_H_
@@ -32,6 +32,10 @@ extern "C" {
 }
 #endif
 
+#include "slab/matrix/kron_kernel.h"
+#include "slab/matrix/reduce_kernel.h"
+#include "slab/matrix/vmath.h"
+
 #include "slab/matrix/fns/eye.h"
 #include "slab/matrix/fns/ones.h"
 #include "slab/matrix/fns/zeros.h"
@@ -42,6 +46,7 @@ extern "C" {
 #include "slab/matrix/fns/kron.h"
 #include "slab/matrix/fns/prod.h"
 #include "slab/matrix/fns/reshape.h"
+#include "slab/matrix/fns/stats.h"
 #include "slab/matrix/fns/sum.h"
 #include "slab/matrix/fns/trans.h"
 #include "slab/matrix/fns/vectorise.h"
@@ -22,6 +22,8 @@
 
 #include <cstddef>
 
+#include <memory>
+
 namespace slab {
 
 // Declarations
@@ -30,12 +32,15 @@ struct slice;
 template <std::size_t N>
 struct MatrixSlice;
 
-template <typename T, std::size_t N>
+template <typename T, std::size_t N, typename Allocator = std::allocator<T>>
 class Matrix;
 
 template <typename T, std::size_t N>
 class MatrixRef;
 
+template <typename E>
+class MatrixExpr;
+
 }  // namespace slab
 
 #endif  // SLAB_MATRIX_MATRIX_FWD_H_
\ No newline at end of file
@@ -25,6 +25,9 @@
 
 #include <algorithm>
 #include <complex>
+#include <ostream>
+#include <utility>
+#include <vector>
 
 #ifdef USE_MKL
 #include "mkl.h"
@@ -34,9 +37,12 @@ extern "C" {
 }
 #endif
 
+#include "slab/matrix/blas_dispatch.h"
 #include "slab/matrix/error.h"
+#include "slab/matrix/gemm_kernel.h"
 #include "slab/matrix/matrix.h"
 #include "slab/matrix/matrix_base.h"
+#include "slab/matrix/matrix_expr.h"
 #include "slab/matrix/matrix_ref.h"
 #include "slab/matrix/support.h"
 
@@ -46,7 +52,12 @@ template <typename M1, typename M2>
 inline Enable_if<Matrix_type<M1>() && Matrix_type<M2>(), bool> operator==(
     const M1 &a, const M2 &b) {
   assert(same_extents(a.descriptor(), b.descriptor()));
-  return std::equal(a.begin(), a.end(), b.begin());
+  bool equal;
+  if (matrix_impl::dispatch_simd_equal(a.data(), a.descriptor(), b.data(),
+                                       b.descriptor(), equal))
+    return equal;
+  return matrix_impl::equal_elements(a.data(), a.descriptor(), b.data(),
+                                     b.descriptor());
 }
 
 template <typename M1, typename M2>
@@ -55,414 +66,636 @@ inline Enable_if<Matrix_type<M1>() && Matrix_type<M2>(), bool> operator!=(
   return !(a == b);
 }
 
-// Scalar Addtion
-//
-// res = X + val or res = val + X
+template <typename E1, typename M2>
+inline Enable_if<Matrix_type<M2>() || matrix_impl::Matrix_expr<M2>(), bool>
+operator==(const MatrixExpr<E1> &a, const M2 &b) {
+  return matrix_impl::materialize(a) == matrix_impl::materialize(b);
+}
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator+(const Matrix<T, N> &x, const T &val) {
-  Matrix<T, N> res = x;
-  res += val;
-  return res;
+template <typename M1, typename E2>
+inline Enable_if<Matrix_type<M1>(), bool> operator==(const M1 &a,
+                                                      const MatrixExpr<E2> &b) {
+  return a == matrix_impl::materialize(b);
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator+(const MatrixRef<T, N> &x, const T &val) {
-  Matrix<T, N> res = x;
-  res += val;
-  return res;
+template <typename E1, typename M2>
+inline Enable_if<Matrix_type<M2>() || matrix_impl::Matrix_expr<M2>(), bool>
+operator!=(const MatrixExpr<E1> &a, const M2 &b) {
+  return !(a == b);
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator+(const T &val, const Matrix<T, N> &x) {
-  Matrix<T, N> res = x;
-  res += val;
-  return res;
+template <typename M1, typename E2>
+inline Enable_if<Matrix_type<M1>(), bool> operator!=(const M1 &a,
+                                                      const MatrixExpr<E2> &b) {
+  return !(a == b);
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator+(const T &val, const MatrixRef<T, N> &x) {
-  Matrix<T, N> res = x;
-  res += val;
-  return res;
+template <typename E>
+std::ostream &operator<<(std::ostream &os, const MatrixExpr<E> &x) {
+  return os << x.eval();
 }
 
-// Scalar Subtraction
+// Element-wise arithmetic
 //
-// res = X - val
+// The operators below build a MatrixExpr instead of a Matrix; the whole
+// expression is evaluated in one loop when it is assigned (see matrix_expr.h).
+// Operands are any mix of Matrix, MatrixRef and MatrixExpr of the same order
+// and element type, and scalars convertible to that element type.
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator-(const Matrix<T, N> &x, const T &val) {
-  Matrix<T, N> res = x;
-  res -= val;
-  return res;
-}
+// Addition
+//
+// res = X + Y, X + val or val + X
+
+template <typename X, typename Y,
+          typename = Enable_if<matrix_impl::Expr_operand<X>() &&
+                               matrix_impl::Expr_operand<Y>()>>
+inline matrix_impl::Binary_expr<matrix_impl::expr_plus, X, Y>
+operator+(X &&x, Y &&y) {
+  return matrix_impl::make_expr<matrix_impl::expr_plus>(
+      std::forward<X>(x), std::forward<Y>(y));
+}
+
+template <typename X, typename S,
+          typename = Enable_if<matrix_impl::Expr_operand<X>() &&
+                               !matrix_impl::Expr_operand<S>() &&
+                               Convertible<S, matrix_impl::Expr_value<X>>()>>
+inline matrix_impl::Scalar_right_expr<matrix_impl::expr_plus, X>
+operator+(X &&x, const S &val) {
+  return matrix_impl::make_expr_scalar<matrix_impl::expr_plus>(
+      std::forward<X>(x), val);
+}
+
+template <typename S, typename X,
+          typename = Enable_if<matrix_impl::Expr_operand<X>() &&
+                               !matrix_impl::Expr_operand<S>() &&
+                               Convertible<S, matrix_impl::Expr_value<X>>()>>
+inline matrix_impl::Scalar_left_expr<matrix_impl::expr_plus, X>
+operator+(const S &val, X &&x) {
+  return matrix_impl::make_scalar_expr<matrix_impl::expr_plus>(
+      val, std::forward<X>(x));
+}
+
+// Subtraction
+//
+// res = X - Y, X - val or val - X
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator-(const MatrixRef<T, N> &x, const T &val) {
-  Matrix<T, N> res = x;
-  res -= val;
-  return res;
+template <typename X, typename Y,
+          typename = Enable_if<matrix_impl::Expr_operand<X>() &&
+                               matrix_impl::Expr_operand<Y>()>>
+inline matrix_impl::Binary_expr<matrix_impl::expr_minus, X, Y>
+operator-(X &&x, Y &&y) {
+  return matrix_impl::make_expr<matrix_impl::expr_minus>(
+      std::forward<X>(x), std::forward<Y>(y));
 }
 
-// Scalar Multiplication
-//
-// res = X * val or res = val * X
+template <typename X, typename S,
+          typename = Enable_if<matrix_impl::Expr_operand<X>() &&
+                               !matrix_impl::Expr_operand<S>() &&
+                               Convertible<S, matrix_impl::Expr_value<X>>()>>
+inline matrix_impl::Scalar_right_expr<matrix_impl::expr_minus, X>
+operator-(X &&x, const S &val) {
+  return matrix_impl::make_expr_scalar<matrix_impl::expr_minus>(
+      std::forward<X>(x), val);
+}
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator*(const Matrix<T, N> &x, const T &val) {
-  Matrix<T, N> res = x;
-  res *= val;
-  return res;
+template <typename S, typename X,
+          typename = Enable_if<matrix_impl::Expr_operand<X>() &&
+                               !matrix_impl::Expr_operand<S>() &&
+                               Convertible<S, matrix_impl::Expr_value<X>>()>>
+inline matrix_impl::Scalar_left_expr<matrix_impl::expr_minus, X>
+operator-(const S &val, X &&x) {
+  return matrix_impl::make_scalar_expr<matrix_impl::expr_minus>(
+      val, std::forward<X>(x));
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator*(const MatrixRef<T, N> &x, const T &val) {
-  Matrix<T, N> res = x;
-  res *= val;
-  return res;
+// Element-wise Multiplication
+//
+// res = X * Y, X * val or val * X
+
+template <typename X, typename Y,
+          typename = Enable_if<matrix_impl::Expr_operand<X>() &&
+                               matrix_impl::Expr_operand<Y>()>>
+inline matrix_impl::Binary_expr<matrix_impl::expr_multiplies, X, Y>
+operator*(X &&x, Y &&y) {
+  return matrix_impl::make_expr<matrix_impl::expr_multiplies>(
+      std::forward<X>(x), std::forward<Y>(y));
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator*(const T &val, const Matrix<T, N> &x) {
-  Matrix<T, N> res = x;
-  res *= val;
-  return res;
+template <typename X, typename S,
+          typename = Enable_if<matrix_impl::Expr_operand<X>() &&
+                               !matrix_impl::Expr_operand<S>() &&
+                               Convertible<S, matrix_impl::Expr_value<X>>()>>
+inline matrix_impl::Scalar_right_expr<matrix_impl::expr_multiplies, X>
+operator*(X &&x, const S &val) {
+  return matrix_impl::make_expr_scalar<matrix_impl::expr_multiplies>(
+      std::forward<X>(x), val);
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator*(const T &val, const MatrixRef<T, N> &x) {
-  Matrix<T, N> res = x;
-  res *= val;
-  return res;
+template <typename S, typename X,
+          typename = Enable_if<matrix_impl::Expr_operand<X>() &&
+                               !matrix_impl::Expr_operand<S>() &&
+                               Convertible<S, matrix_impl::Expr_value<X>>()>>
+inline matrix_impl::Scalar_left_expr<matrix_impl::expr_multiplies, X>
+operator*(const S &val, X &&x) {
+  return matrix_impl::make_scalar_expr<matrix_impl::expr_multiplies>(
+      val, std::forward<X>(x));
 }
 
-// Scalar Division
+// Element-wise Division
 //
-// res = X / val
+// res = X / Y, X / val or val / X
+
+template <typename X, typename Y,
+          typename = Enable_if<matrix_impl::Expr_operand<X>() &&
+                               matrix_impl::Expr_operand<Y>()>>
+inline matrix_impl::Binary_expr<matrix_impl::expr_divides, X, Y>
+operator/(X &&x, Y &&y) {
+  return matrix_impl::make_expr<matrix_impl::expr_divides>(
+      std::forward<X>(x), std::forward<Y>(y));
+}
+
+template <typename X, typename S,
+          typename = Enable_if<matrix_impl::Expr_operand<X>() &&
+                               !matrix_impl::Expr_operand<S>() &&
+                               Convertible<S, matrix_impl::Expr_value<X>>()>>
+inline matrix_impl::Scalar_right_expr<matrix_impl::expr_divides, X>
+operator/(X &&x, const S &val) {
+  return matrix_impl::make_expr_scalar<matrix_impl::expr_divides>(
+      std::forward<X>(x), val);
+}
+
+template <typename S, typename X,
+          typename = Enable_if<matrix_impl::Expr_operand<X>() &&
+                               !matrix_impl::Expr_operand<S>() &&
+                               Convertible<S, matrix_impl::Expr_value<X>>()>>
+inline matrix_impl::Scalar_left_expr<matrix_impl::expr_divides, X>
+operator/(const S &val, X &&x) {
+  return matrix_impl::make_scalar_expr<matrix_impl::expr_divides>(
+      val, std::forward<X>(x));
+}
+
+// Element-wise Modulus
+//
+// res = X % Y, X % val or val % X
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator/(const Matrix<T, N> &x, const T &val) {
-  Matrix<T, N> res = x;
-  res /= val;
-  return res;
+template <typename X, typename Y,
+          typename = Enable_if<matrix_impl::Expr_operand<X>() &&
+                               matrix_impl::Expr_operand<Y>()>>
+inline matrix_impl::Binary_expr<matrix_impl::expr_modulus, X, Y>
+operator%(X &&x, Y &&y) {
+  return matrix_impl::make_expr<matrix_impl::expr_modulus>(
+      std::forward<X>(x), std::forward<Y>(y));
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator/(const MatrixRef<T, N> &x, const T &val) {
-  Matrix<T, N> res = x;
-  res /= val;
-  return res;
+template <typename X, typename S,
+          typename = Enable_if<matrix_impl::Expr_operand<X>() &&
+                               !matrix_impl::Expr_operand<S>() &&
+                               Convertible<S, matrix_impl::Expr_value<X>>()>>
+inline matrix_impl::Scalar_right_expr<matrix_impl::expr_modulus, X>
+operator%(X &&x, const S &val) {
+  return matrix_impl::make_expr_scalar<matrix_impl::expr_modulus>(
+      std::forward<X>(x), val);
 }
 
-// Scalar Modulus
+template <typename S, typename X,
+          typename = Enable_if<matrix_impl::Expr_operand<X>() &&
+                               !matrix_impl::Expr_operand<S>() &&
+                               Convertible<S, matrix_impl::Expr_value<X>>()>>
+inline matrix_impl::Scalar_left_expr<matrix_impl::expr_modulus, X>
+operator%(const S &val, X &&x) {
+  return matrix_impl::make_scalar_expr<matrix_impl::expr_modulus>(
+      val, std::forward<X>(x));
+}
+
+//
+// Matrix Multiplication
 //
-// res = X % val
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator%(const Matrix<T, N> &x, const T &val) {
-  Matrix<T, N> res = x;
-  res %= val;
-  return res;
-}
+namespace matrix_impl {
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator%(const MatrixRef<T, N> &x, const T &val) {
-  Matrix<T, N> res = x;
-  res %= val;
-  return res;
-}
+// An operand of a matrix product: the elements (desc, base) as a matrix,
+// read conjugated if conj. Transposing it only swaps the dimensions of desc,
+// so transposed views reach BLAS as a transpose flag.
+template <typename T>
+struct GemmArg {
+  const T *base;
+  MatrixSlice<2> desc;
+  bool conj;
 
-// Matrix Addtion
-//
-// res = A + B
+  std::size_t rows() const { return desc.extents[0]; }
+  std::size_t cols() const { return desc.extents[1]; }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator+(const Matrix<T, N> &a, const Matrix<T, N> &b) {
-  Matrix<T, N> res = a;
-  res += b;
-  return res;
-}
+  T operator()(std::size_t i, std::size_t j) const {
+    const T &v = base[desc.start + i * desc.strides[0] + j * desc.strides[1]];
+    return conj ? conj_value(v) : v;
+  }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator+(const MatrixRef<T, N> &a, const MatrixRef<T, N> &b) {
-  Matrix<T, N> res = a;
-  res += b;
-  return res;
+  GemmArg t() const { return {base, transposed(desc), conj}; }
+  GemmArg h() const { return {base, transposed(desc), !conj}; }
+
+  GemmArg op(CBLAS_TRANSPOSE trans) const {
+    return trans == CblasNoTrans ? *this : trans == CblasTrans ? t() : h();
+  }
+};
+
+template <typename T, typename DA>
+GemmArg<Remove_const<T>> gemm_arg(const MatrixBase<T, 2, DA> &a) {
+  return {a.data(), a.descriptor(), false};
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator+(const Matrix<T, N> &a, const MatrixRef<T, N> &b) {
-  Matrix<T, N> res = a;
-  res += b;
-  return res;
+// a vector is a one-column matrix
+template <typename T, typename DX>
+GemmArg<Remove_const<T>> gemm_arg(const MatrixBase<T, 1, DX> &x) {
+  const GemmArg<Remove_const<T>> row{x.data(), transposed(x.descriptor()),
+                                      false};
+  return row.t();
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator+(const MatrixRef<T, N> &a, const Matrix<T, N> &b) {
-  Matrix<T, N> res = a;
-  res += b;
-  return res;
+template <typename T>
+GemmArg<T> gemm_arg(const ConjTransposed<T> &a) {
+  const ExprView<T, 2> &v = a.node().operand();
+  return {v.base(), v.descriptor(), true};
 }
 
-// Matrix Subtraction
-//
-// res = A - B
+// An operand as BLAS takes it: the row-major matrix (p, ld) read as op(p).
+// Layouts BLAS cannot describe, e.g. a conjugated matrix that is not
+// transposed, are copied into copy first.
+template <typename T>
+struct BlasArg {
+  const T *p;
+  int ld;
+  CBLAS_TRANSPOSE trans;
+  std::vector<T> copy;
+};
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator-(const Matrix<T, N> &a, const Matrix<T, N> &b) {
-  Matrix<T, N> res = a;
-  res -= b;
+template <typename T>
+BlasArg<T> blas_arg(const GemmArg<T> &a) {
+  const MatrixSlice<2> &d = a.desc;
+  const std::size_t m = a.rows(), n = a.cols();
+  const T *p = a.base + d.start;
+
+  if (!a.conj && (n <= 1 || d.strides[1] == 1) && (m <= 1 || d.strides[0] >= n))
+    return {p, int(m > 1 ? d.strides[0] : std::max<std::size_t>(n, 1)),
+            CblasNoTrans, {}};
+  if ((m <= 1 || d.strides[0] == 1) && (n <= 1 || d.strides[1] >= m))
+    return {p, int(n > 1 ? d.strides[1] : std::max<std::size_t>(m, 1)),
+            a.conj ? CblasConjTrans : CblasTrans, {}};
+
+  BlasArg<T> res{nullptr, int(std::max<std::size_t>(n, 1)), CblasNoTrans, {}};
+  res.copy.resize(m * n);
+  for (std::size_t i = 0; i != m; ++i)
+    for (std::size_t j = 0; j != n; ++j) res.copy[i * n + j] = a(i, j);
+  res.p = res.copy.data();
   return res;
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator-(const MatrixRef<T, N> &a, const MatrixRef<T, N> &b) {
-  Matrix<T, N> res = a;
-  res -= b;
-  return res;
+// Whether products of T go to BLAS ?gemm rather than native_gemm().
+template <typename T>
+constexpr bool Blas_gemm() {
+#ifdef SLAB_MATRIX_NATIVE_GEMM
+  return false;
+#else
+  return Blas_type<T>();
+#endif
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator-(const Matrix<T, N> &a, const MatrixRef<T, N> &b) {
-  Matrix<T, N> res = a;
-  res -= b;
-  return res;
+// (c, ldc) := alpha * a * b + beta * (c, ldc), c row-major
+template <typename T>
+Enable_if<Blas_gemm<T>()> gemm_into(const T &alpha, const GemmArg<T> &a,
+                                    const GemmArg<T> &b, const T &beta, T *c,
+                                    std::size_t ldc) {
+  assert(a.cols() == b.rows());
+  const std::size_t m = a.rows(), n = b.cols();
+  if (m == 0 || n == 0) return;
+
+  const BlasArg<T> pa = blas_arg(a);
+  const BlasArg<T> pb = blas_arg(b);
+  l3_gemm(pa.trans, pb.trans, int(m), int(n), int(a.cols()), alpha, pa.p,
+          pa.ld, pb.p, pb.ld, beta, c, int(ldc));
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator-(const MatrixRef<T, N> &a, const Matrix<T, N> &b) {
-  Matrix<T, N> res = a;
-  res -= b;
-  return res;
+template <typename T>
+Enable_if<!Blas_gemm<T>()> gemm_into(const T &alpha, const GemmArg<T> &a,
+                                     const GemmArg<T> &b, const T &beta, T *c,
+                                     std::size_t ldc) {
+  assert(a.cols() == b.rows());
+  native_gemm(a.rows(), b.cols(), a.cols(), alpha, a, b, beta, c, ldc);
 }
 
-// Element-wise Multiplication
-//
-// res = A * B
+// (y, incy) := alpha * a * (x, incx) + beta * (y, incy)
+template <typename T>
+Enable_if<Blas_type<T>()> gemv_into(const T &alpha, const GemmArg<T> &a,
+                                    const T *x, std::ptrdiff_t incx,
+                                    const T &beta, T *y, std::ptrdiff_t incy) {
+  const std::size_t m = a.rows(), n = a.cols();
+  if (m == 0) return;
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator*(const Matrix<T, N> &a, const Matrix<T, N> &b) {
-  Matrix<T, N> res = a;
-  res *= b;
-  return res;
+  const BlasArg<T> pa = blas_arg(a);
+  // BLAS takes the extents of the matrix as stored
+  const bool stored_t = pa.trans != CblasNoTrans;
+  l2_gemv(pa.trans, int(stored_t ? n : m), int(stored_t ? m : n), alpha, pa.p,
+          pa.ld, x, int(incx), beta, y, int(incy));
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator*(const MatrixRef<T, N> &a, const MatrixRef<T, N> &b) {
-  Matrix<T, N> res = a;
-  res *= b;
-  return res;
+template <typename T>
+Enable_if<!Blas_type<T>()> gemv_into(const T &alpha, const GemmArg<T> &a,
+                                     const T *x, std::ptrdiff_t incx,
+                                     const T &beta, T *y,
+                                     std::ptrdiff_t incy) {
+  for (std::size_t i = 0; i != a.rows(); ++i) {
+    T yi = T{0};
+    for (std::size_t j = 0; j != a.cols(); ++j) yi += a(i, j) * x[j * incx];
+    T &yy = y[i * incy];
+    yy = beta == T{0} ? alpha * yi : alpha * yi + beta * yy;
+  }
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator*(const Matrix<T, N> &a, const MatrixRef<T, N> &b) {
-  Matrix<T, N> res = a;
-  res *= b;
-  return res;
+template <typename T>
+Matrix<T, 2> gemm(const GemmArg<T> &a, const GemmArg<T> &b) {
+  assert(a.cols() == b.rows());
+  Matrix<T, 2> c(uninitialized, a.rows(), b.cols());
+  gemm_into(T{1}, a, b, T{0}, c.data(), b.cols());
+  return c;
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator*(const MatrixRef<T, N> &a, const Matrix<T, N> &b) {
-  Matrix<T, N> res = a;
-  res *= b;
-  return res;
+template <typename T, typename U, typename DX>
+Matrix<T, 1> gemv(const GemmArg<T> &a, const MatrixBase<U, 1, DX> &x) {
+  assert(a.cols() == x.extent(0));
+  Matrix<T, 1> y(uninitialized, a.rows());
+  if (a.cols() == 0) {
+    std::fill(y.begin(), y.end(), T{0});
+    return y;
+  }
+  const MatrixSlice<1> &xd = x.descriptor();
+  gemv_into(T{1}, a, x.data() + xd.start, xd.strides[0], T{0}, y.data(), 1);
+  return y;
 }
 
-// Element-wise Division
-//
-// res = A / B
+}  // namespace matrix_impl
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator/(const Matrix<T, N> &a, const Matrix<T, N> &b) {
-  Matrix<T, N> res = a;
-  res /= b;
-  return res;
-}
+// The products below take Matrix and MatrixRef operands, including the
+// transposed views of t() and ht(), and pass transposes to BLAS as flags.
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator/(const MatrixRef<T, N> &a, const MatrixRef<T, N> &b) {
-  Matrix<T, N> res = a;
-  res /= b;
-  return res;
+template <typename T, typename U, typename DA, typename DB,
+          typename = Enable_if<Same<Remove_const<T>, Remove_const<U>>()>>
+inline Matrix<Remove_const<T>, 2> matmul(const MatrixBase<T, 1, DA> &a,
+                                         const MatrixBase<U, 2, DB> &b) {
+  SLAB_MATRIX_SCOPE("matmul");
+  assert(b.n_rows() == 1);
+  return matrix_impl::gemm(matrix_impl::gemm_arg(a), matrix_impl::gemm_arg(b));
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator/(const Matrix<T, N> &a, const MatrixRef<T, N> &b) {
-  Matrix<T, N> res = a;
-  res /= b;
-  return res;
+template <typename T, typename U, typename DA, typename DX,
+          typename = Enable_if<Same<Remove_const<T>, Remove_const<U>>()>>
+inline Matrix<Remove_const<T>, 1> matmul(const MatrixBase<T, 2, DA> &a,
+                                         const MatrixBase<U, 1, DX> &x) {
+  SLAB_MATRIX_SCOPE("matmul");
+  return matrix_impl::gemv(matrix_impl::gemm_arg(a), x);
 }
 
-template <typename T, std::size_t N>
-Matrix<T, N> operator/(const MatrixRef<T, N> &a, const Matrix<T, N> &b) {
-  Matrix<T, N> res = a;
-  res /= b;
-  return res;
+template <typename T, typename U, typename DA, typename DB,
+          typename = Enable_if<Same<Remove_const<T>, Remove_const<U>>()>>
+inline Matrix<Remove_const<T>, 2> matmul(const MatrixBase<T, 2, DA> &a,
+                                         const MatrixBase<U, 2, DB> &b) {
+  SLAB_MATRIX_SCOPE("matmul");
+  return matrix_impl::gemm(matrix_impl::gemm_arg(a), matrix_impl::gemm_arg(b));
 }
 
-//
-// Matrix Multiplication
-//
+template <typename T, typename U, typename DX,
+          typename = Enable_if<Same<T, Remove_const<U>>()>>
+inline Matrix<T, 1> matmul(const ConjTransposed<T> &a,
+                           const MatrixBase<U, 1, DX> &x) {
+  SLAB_MATRIX_SCOPE("matmul");
+  return matrix_impl::gemv(matrix_impl::gemm_arg(a), x);
+}
 
-template <typename T>
-inline Matrix<T, 2> matmul(const MatrixBase<T, 1> &a,
-                           const MatrixBase<T, 2> &b) {
-  assert(b.n_rows() == 1);
+template <typename T, typename U, typename DB,
+          typename = Enable_if<Same<T, Remove_const<U>>()>>
+inline Matrix<T, 2> matmul(const ConjTransposed<T> &a,
+                           const MatrixBase<U, 2, DB> &b) {
+  SLAB_MATRIX_SCOPE("matmul");
+  return matrix_impl::gemm(matrix_impl::gemm_arg(a), matrix_impl::gemm_arg(b));
+}
 
-  Matrix<T, 2> mat_a(a.n_rows(), 1);
-  for (std::size_t i = 0; i != a.n_rows(); ++i) mat_a(i, 0) = a(i);
+template <typename T, typename U, typename DA,
+          typename = Enable_if<Same<Remove_const<T>, U>()>>
+inline Matrix<U, 2> matmul(const MatrixBase<T, 2, DA> &a,
+                           const ConjTransposed<U> &b) {
+  SLAB_MATRIX_SCOPE("matmul");
+  return matrix_impl::gemm(matrix_impl::gemm_arg(a), matrix_impl::gemm_arg(b));
+}
 
-  return matmul(mat_a, b);
+template <typename T>
+inline Matrix<T, 2> matmul(const ConjTransposed<T> &a,
+                           const ConjTransposed<T> &b) {
+  SLAB_MATRIX_SCOPE("matmul");
+  return matrix_impl::gemm(matrix_impl::gemm_arg(a), matrix_impl::gemm_arg(b));
 }
 
 template <typename T>
-inline Matrix<T, 1> matmul(const MatrixBase<T, 2> &a,
-                           const MatrixBase<T, 1> &x) {
-  assert(a.extent(1) == x.extent(0));
+inline const Matrix<T, 1> &matmul_n(const Matrix<T, 1> &x) {
+  return x;
+}
 
-  const std::size_t m = a.n_rows();
-  const std::size_t n = a.n_cols();
-  Matrix<T, 1> y(m);
+template <typename T>
+inline const Matrix<T, 2> &matmul_n(const Matrix<T, 2> &x) {
+  return x;
+}
 
-  for (std::size_t i = 0; i != m; ++i)
-    for (std::size_t j = 0; j != n; ++j) y(i) += a(i, j) * x(j);
+namespace matrix_impl {
 
-  return y;
-}
+// Matrix chain products
+//
+// matmul_n() multiplies its operands in the order that needs the fewest
+// scalar multiplications, found by the classic O(n^3) dynamic program over
+// the operand shapes. Intermediate products live in buffers that are
+// returned to a pool as soon as they are consumed, and a product with a
+// single row or column is computed by GEMV.
 
-template <>
-inline Matrix<double, 1> matmul(const MatrixBase<double, 2> &a,
-                                const MatrixBase<double, 1> &x) {
-  assert(a.extent(1) == x.extent(0));
-  const int m = a.n_rows();
-  const int n = a.n_cols();
-  const int lda = n;
-  const int incx = x.descriptor().strides[0];
-  const int incy = 1;
+template <typename... Args>
+struct chain_last;
 
-  Matrix<double, 1> y(m);
-  cblas_dgemv(CblasRowMajor, CblasNoTrans, m, n, (const double)1.0,
-              (const double *)(a.data() + a.descriptor().start), lda,
-              (const double *)(x.data() + x.descriptor().start), incx,
-              (const double)0.0, (double *)y.data(), incy);
+template <typename A>
+struct chain_last<A> {
+  using type = A;
+};
 
-  return y;
-}
+template <typename A, typename... Args>
+struct chain_last<A, Args...> : chain_last<Args...> {};
 
-template <>
-inline Matrix<float, 1> matmul(const MatrixBase<float, 2> &a,
-                               const MatrixBase<float, 1> &x) {
-  assert(a.extent(1) == x.extent(0));
-  const int m = a.n_rows();
-  const int n = a.n_cols();
-  const int lda = n;
-  const int incx = x.descriptor().strides[0];
-  const int incy = 1;
+// the product is a vector if the last operand is one
+template <typename X, typename... Args>
+using Chain_result =
+    Matrix<Remove_const<typename X::value_type>,
+           chain_last<X, Args...>::type::order_ == 1 ? 1 : 2>;
 
-  Matrix<float, 1> y(m);
-  cblas_sgemv(CblasRowMajor, CblasNoTrans, m, n, (const float)1.0,
-              (const float *)(a.data() + a.descriptor().start), lda,
-              (const float *)(x.data() + x.descriptor().start), incx,
-              (const float)0.0, (float *)y.data(), incy);
+template <typename M>
+Enable_if<M::order_ == 1, M> chain_alloc(std::size_t m, std::size_t) {
+  return M(uninitialized, m);
+}
 
-  return y;
+template <typename M>
+Enable_if<M::order_ == 2, M> chain_alloc(std::size_t m, std::size_t n) {
+  return M(uninitialized, m, n);
 }
 
 template <typename T>
-inline Matrix<T, 2> matmul(const MatrixBase<T, 2> &a,
-                           const MatrixBase<T, 2> &b) {
-  assert(a.extent(1) == b.extent(0));
-
-  const std::size_t m = a.n_rows();
-  const std::size_t n = b.n_cols();
-  const std::size_t k = a.n_cols();
-
-  Matrix<T, 2> c(m, n);
-
-  for (std::size_t i = 0; i != m; ++i) {
-    for (std::size_t j = 0; j != n; ++j) {
-      for (std::size_t idx = 0; idx != k; ++idx) {
-        c(i, j) += a(i, idx) * b(idx, j);
+void chain_push(std::vector<GemmArg<T>> &) {}
+
+template <typename T, typename A, typename... Args>
+void chain_push(std::vector<GemmArg<T>> &ops, const A &a,
+                const Args &... args) {
+  ops.push_back(gemm_arg(a));
+  chain_push(ops, args...);
+}
+
+// split[i * n + j] is where the optimal product of ops[i..j] is split
+inline std::vector<std::size_t> chain_order(
+    const std::vector<std::size_t> &dims) {
+  const std::size_t n = dims.size() - 1;
+  std::vector<double> cost(n * n, 0.0);
+  std::vector<std::size_t> split(n * n, 0);
+
+  for (std::size_t len = 2; len <= n; ++len) {
+    for (std::size_t i = 0; i + len <= n; ++i) {
+      const std::size_t j = i + len - 1;
+      double best = -1.0;
+      for (std::size_t k = i; k != j; ++k) {
+        const double c = cost[i * n + k] + cost[(k + 1) * n + j] +
+                         double(dims[i]) * dims[k + 1] * dims[j + 1];
+        if (best < 0.0 || c < best) {
+          best = c;
+          split[i * n + j] = k;
+        }
       }
+      cost[i * n + j] = best;
     }
   }
 
-  return c;
+  return split;
 }
 
-template <>
-inline Matrix<double, 2> matmul(const MatrixBase<double, 2> &a,
-                                const MatrixBase<double, 2> &b) {
-  assert(a.extent(1) == b.extent(0));
-
-  const int m = a.n_rows();
-  const int n = b.n_cols();
-  const int k = a.n_cols();
-
-  const int lda = a.n_cols();
-  const int ldb = b.n_cols();
-  const int ldc = b.n_cols();
-
-  Matrix<double, 2> c(m, n);
-  cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, m, n, k,
-              (const double)1.0,
-              (const double *)(a.data() + a.descriptor().start), lda,
-              (const double *)(b.data() + b.descriptor().start), ldb,
-              (const double)0.0, (double *)c.data(), ldc);
-
-  return c;
-}
-
-template <>
-inline Matrix<float, 2> matmul(const MatrixBase<float, 2> &a,
-                               const MatrixBase<float, 2> &b) {
-  assert(a.extent(1) == b.extent(0));
+// Buffers for the intermediate products: a product takes the smallest
+// free buffer that is large enough, and gives it back once consumed.
+template <typename T>
+class ChainBuffers {
+ public:
+  std::vector<T> acquire(std::size_t size) {
+    auto fit = free_.end();
+    for (auto it = free_.begin(); it != free_.end(); ++it) {
+      if (it->capacity() >= size &&
+          (fit == free_.end() || it->capacity() < fit->capacity()))
+        fit = it;
+    }
+    if (fit == free_.end() && !free_.empty()) fit = free_.begin();
 
-  const int m = a.n_rows();
-  const int n = b.n_cols();
-  const int k = a.n_cols();
+    std::vector<T> buf;
+    if (fit != free_.end()) {
+      buf = std::move(*fit);
+      free_.erase(fit);
+    }
+    buf.resize(size);
+    return buf;
+  }
 
-  const int lda = a.n_cols();
-  const int ldb = b.n_cols();
-  const int ldc = b.n_cols();
+  void release(std::vector<T> &buf) {
+    if (buf.capacity() != 0) free_.push_back(std::move(buf));
+  }
 
-  Matrix<float, 2> c(m, n);
-  cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, m, n, k,
-              (const float)1.0,
-              (const float *)(a.data() + a.descriptor().start), lda,
-              (const float *)(b.data() + b.descriptor().start), ldb,
-              (const float)0.0, (float *)c.data(), ldc);
+ private:
+  std::vector<std::vector<T>> free_;
+};
 
-  return c;
-}
+template <typename T>
+struct ChainNode {
+  GemmArg<T> arg;
+  std::vector<T> buf;  // holds arg's elements if it is an intermediate
+};
 
+// (c, ldc) := a * b, by GEMV if either factor is a single vector
 template <typename T>
-inline const Matrix<T, 1> &matmul_n(const Matrix<T, 1> &x) {
-  return x;
+void chain_product(const GemmArg<T> &a, const GemmArg<T> &b, T *c,
+                   std::size_t ldc) {
+  const MatrixSlice<2> &ad = a.desc, &bd = b.desc;
+  if (b.cols() == 1 && !b.conj) {
+    gemv_into(T{1}, a, b.base + bd.start, bd.strides[0], T{0}, c,
+              std::ptrdiff_t(ldc));
+  } else if (a.rows() == 1 && !a.conj) {
+    gemv_into(T{1}, b.t(), a.base + ad.start, ad.strides[1], T{0}, c, 1);
+  } else {
+    gemm_into(T{1}, a, b, T{0}, c, ldc);
+  }
 }
 
+// the product of ops[i..j], into res if given (the final product)
 template <typename T>
-inline const Matrix<T, 2> &matmul_n(const Matrix<T, 2> &x) {
-  return x;
+ChainNode<T> chain_eval(const std::vector<GemmArg<T>> &ops,
+                        const std::vector<std::size_t> &split,
+                        ChainBuffers<T> &pool, std::size_t i, std::size_t j,
+                        T *res = nullptr) {
+  if (i == j) return {ops[i], {}};
+
+  const std::size_t k = split[i * ops.size() + j];
+  ChainNode<T> a = chain_eval(ops, split, pool, i, k);
+  ChainNode<T> b = chain_eval(ops, split, pool, k + 1, j);
+  const std::size_t m = a.arg.rows(), n = b.arg.cols();
+
+  ChainNode<T> c{{nullptr, MatrixSlice<2>(m, n), false}, {}};
+  if (!res) {
+    c.buf = pool.acquire(m * n);
+    res = c.buf.data();
+  }
+  c.arg.base = res;
+  if (a.arg.cols() == 0)
+    std::fill(res, res + m * n, T{0});
+  else
+    chain_product(a.arg, b.arg, res, n);
+
+  pool.release(a.buf);
+  pool.release(b.buf);
+  return c;
 }
 
-template <typename T, typename... Args>
-inline auto matmul_n(const Matrix<T, 2> &x, Args... args)
-    -> decltype(matmul(x, matmul_n(args...))) {
-  return matmul(x, matmul_n(args...));
+}  // namespace matrix_impl
+
+// matmul_n(a, b, c, ...) is the product a * b * c * ..., computed in the
+// cheapest order; a vector is taken as a column, so only the last operand
+// may be one. Operands are Matrix and MatrixRef, including t() and ht().
+template <typename X, typename... Args>
+inline Enable_if<(sizeof...(Args) > 0),
+                 matrix_impl::Chain_result<X, Args...>>
+matmul_n(const X &x, const Args &... args) {
+  SLAB_MATRIX_SCOPE("matmul_n");
+  using T = Remove_const<typename X::value_type>;
+
+  std::vector<matrix_impl::GemmArg<T>> ops;
+  matrix_impl::chain_push(ops, x, args...);
+
+  std::vector<std::size_t> dims(1, ops.front().rows());
+  for (std::size_t i = 0; i != ops.size(); ++i) {
+    assert(i == 0 || ops[i - 1].cols() == ops[i].rows());
+    dims.push_back(ops[i].cols());
+  }
+
+  auto res = matrix_impl::chain_alloc<matrix_impl::Chain_result<X, Args...>>(
+      dims.front(), dims.back());
+  matrix_impl::ChainBuffers<T> pool;
+  matrix_impl::chain_eval(ops, matrix_impl::chain_order(dims), pool, 0,
+                          ops.size() - 1, res.data());
+  return res;
 }
 
 template <typename T>
 inline Matrix<T, 2> diag(const Matrix<T, 1> &x) {
+  SLAB_MATRIX_SCOPE("diag");
   Matrix<T, 2> res(x.size(), x.size());
   res.diag() = x;
 
   return res;
 }
 
-template <typename T>
-inline T dot(const MatrixBase<T, 1> &a, const MatrixBase<T, 1> &b) {
+template <typename T, typename DA, typename DB>
+inline T dot(const MatrixBase<T, 1, DA> &a, const MatrixBase<T, 1, DB> &b) {
   assert(a.size() == b.size());
 
   T res = T{0};
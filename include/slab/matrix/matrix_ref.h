@@ -27,11 +27,13 @@
 #include <string>
 #include <type_traits>
 
+#include "slab/matrix/instrument.h"
 #include "slab/matrix/matrix.h"
 #include "slab/matrix/matrix_base.h"
 #include "slab/matrix/matrix_slice.h"
 #include "slab/matrix/packed_matrix.h"
 #include "slab/matrix/support.h"
+#include "slab/matrix/traverse.h"
 
 namespace slab {
 
@@ -39,7 +41,9 @@ template <typename T, std::size_t N>
 class MatrixRefIterator;
 
 template <typename T, std::size_t N>
-class MatrixRef : public MatrixBase<T, N> {
+class MatrixRef
+    : public MatrixBase<T, N, MatrixRef<T, N>>,
+      private matrix_impl::Instrumented<matrix_impl::instrument_event::ref> {
   // ----------------------------------------
   // The core member functions in book 'TCPL'
   // ----------------------------------------
@@ -64,16 +68,21 @@ class MatrixRef : public MatrixBase<T, N> {
   MatrixRef& operator=(const MatrixRef<U, N>& x);
 
   //! construct from Matrix
-  template <typename U>
-  MatrixRef(const Matrix<U, N> &);
+  template <typename U, typename A>
+  MatrixRef(const Matrix<U, N, A> &);
   //! assign from Matrix
-  template <typename U>
-  MatrixRef &operator=(const Matrix<U, N> &);
+  template <typename U, typename A>
+  MatrixRef &operator=(const Matrix<U, N, A> &);
 
   //! assign from list
   MatrixRef &operator=(MatrixInitializer<T, N>);
 
-  MatrixRef(const MatrixSlice<N> &s, T *p) : MatrixBase<T, N>{s}, ptr_{p} {}
+  //! evaluate an element-wise expression into the view (see MatrixExpr)
+  template <typename E>
+  MatrixRef &operator=(const MatrixExpr<E> &);
+
+  MatrixRef(const MatrixSlice<N> &s, T *p)
+      : MatrixBase<T, N, MatrixRef>{s}, ptr_{p} {}
 
   //! total number of elements
   std::size_t size() const { return this->desc_.size; }
@@ -84,6 +93,14 @@ class MatrixRef : public MatrixBase<T, N> {
   const T *data() const { return ptr_; }
   ///@}
 
+ protected:
+  // Points the view at other elements, for views that own their elements
+  // (see MappedMatrix).
+  void rebind(const MatrixSlice<N> &s, T *p) {
+    this->desc_ = s;
+    ptr_ = p;
+  }
+
  private:
   T *ptr_;
 
@@ -96,13 +113,13 @@ class MatrixRef : public MatrixBase<T, N> {
   template <typename... Args>
   Enable_if<matrix_impl::Requesting_element<Args...>(), T &> operator()(
       Args... args) {
-    return MatrixBase<T, N>::template operator()<Args...>(args...);
+    return MatrixBase<T, N, MatrixRef>::template operator()<Args...>(args...);
   }
 
   template <typename... Args>
   Enable_if<matrix_impl::Requesting_element<Args...>(), const T &> operator()(
       Args... args) const {
-    return MatrixBase<T, N>::template operator()<Args...>(args...);
+    return MatrixBase<T, N, MatrixRef>::template operator()<Args...>(args...);
   }
   ///@}
 
@@ -190,6 +207,18 @@ class MatrixRef : public MatrixBase<T, N> {
   template <typename M>
   Enable_if<Matrix_type<M>(), MatrixRef &> operator%=(const M &x);
 
+  // fused element-wise operations with an expression
+  template <typename E>
+  MatrixRef &operator+=(const MatrixExpr<E> &x);
+  template <typename E>
+  MatrixRef &operator-=(const MatrixExpr<E> &x);
+  template <typename E>
+  MatrixRef &operator*=(const MatrixExpr<E> &x);
+  template <typename E>
+  MatrixRef &operator/=(const MatrixExpr<E> &x);
+  template <typename E>
+  MatrixRef &operator%=(const MatrixExpr<E> &x);
+
   template <typename U = typename std::remove_const<T>::type>
   Matrix<U, N> operator-() const;
   //! @endcond
@@ -202,19 +231,22 @@ class MatrixRef : public MatrixBase<T, N> {
     assert(this->size() == x.size());
     assert(x.n_cols() == 1);
 
-    std::copy(x.begin(), x.end(), begin());
+    matrix_impl::copy_elements(
+        x.data(), matrix_impl::vector_slice(x.descriptor()), ptr_, this->desc_);
 
     return *this;
   }
 
-  template <typename U, std::size_t NN = N, typename = Enable_if<(NN == 1)>>
-  MatrixRef &operator=(const Matrix<U, 2> &x) {
+  template <typename U, typename A, std::size_t NN = N,
+            typename = Enable_if<(NN == 1)>>
+  MatrixRef &operator=(const Matrix<U, 2, A> &x) {
     static_assert(Convertible<U, T>(),
                   "MatrixRef =: incompatible element types");
     assert(this->size() == x.size());
     assert(x.n_cols() == 1);
 
-    std::copy(x.begin(), x.end(), begin());
+    matrix_impl::copy_elements(
+        x.data(), matrix_impl::vector_slice(x.descriptor()), ptr_, this->desc_);
 
     return *this;
   }
@@ -240,19 +272,22 @@ class MatrixRef : public MatrixBase<T, N> {
     assert(this->size() == x.size());
     assert(this->n_cols() == 1);
 
-    std::copy(x.begin(), x.end(), begin());
+    matrix_impl::copy_elements(
+        x.data(), matrix_impl::column_slice(x.descriptor()), ptr_, this->desc_);
 
     return *this;
   }
 
-  template <typename U, std::size_t NN = N, typename = Enable_if<(NN == 2)>>
-  MatrixRef &operator=(const Matrix<U, 1> &x) {
+  template <typename U, typename A, std::size_t NN = N,
+            typename = Enable_if<(NN == 2)>>
+  MatrixRef &operator=(const Matrix<U, 1, A> &x) {
     static_assert(Convertible<U, T>(),
                   "MatrixRef =: incompatible element types");
     assert(this->size() == x.size());
     assert(this->n_cols() == 1);
 
-    std::copy(x.begin(), x.end(), begin());
+    matrix_impl::copy_elements(
+        x.data(), matrix_impl::column_slice(x.descriptor()), ptr_, this->desc_);
 
     return *this;
   }
@@ -310,16 +345,25 @@ class MatrixRef : public MatrixBase<T, N> {
     }
   }
 
+  //! transposed view; a vector is viewed as a one-row matrix
   template <std::size_t NN = N, typename = Enable_if<(NN == 1) || (NN == 2)>>
-  Matrix<T, 2> t() const {
-    return transpose(*this);
+  MatrixRef<T, 2> t() const {
+    return {matrix_impl::transposed(this->desc_), ptr_};
+  }
+
+  //! conjugate-transposed view, the same as t() for real elements
+  template <std::size_t NN = N, typename = Enable_if<(NN == 1) || (NN == 2)>>
+  matrix_impl::Conj_transposed<T> ht() const {
+    return matrix_impl::conj_transposed<Remove_const<T>>::make(
+        matrix_impl::transposed(this->desc_), ptr_);
   }
 };
 
 template <typename T, std::size_t N>
 MatrixRef<T, N> &MatrixRef<T, N>::operator=(MatrixRef &&x) {
   assert(same_extents(this->desc_, x.desc_));
-  std::move(x.begin(), x.end(), begin());
+  matrix_impl::for_each_element(ptr_, this->desc_, x.ptr_, x.desc_,
+                                [](T &a, T &b) { a = std::move(b); });
 
   return *this;
 }
@@ -327,7 +371,7 @@ MatrixRef<T, N> &MatrixRef<T, N>::operator=(MatrixRef &&x) {
 template <typename T, std::size_t N>
 MatrixRef<T, N> &MatrixRef<T, N>::operator=(const MatrixRef &x) {
   assert(same_extents(this->desc_, x.desc_));
-  std::copy(x.begin(), x.end(), begin());
+  matrix_impl::copy_elements(x.ptr_, x.desc_, ptr_, this->desc_);
 
   return *this;
 }
@@ -335,7 +379,7 @@ MatrixRef<T, N> &MatrixRef<T, N>::operator=(const MatrixRef &x) {
 template <typename T, std::size_t N>
 template <typename U>
 MatrixRef<T, N>::MatrixRef(const MatrixRef<U, N>& x)
-    : MatrixBase<T, N>{x.descriptor()}, ptr_(x.data()) {}
+    : MatrixBase<T, N, MatrixRef>{x.descriptor()}, ptr_(x.data()) {}
 
 template <typename T, std::size_t N>
 template <typename U>
@@ -344,22 +388,22 @@ MatrixRef<T, N>& MatrixRef<T, N>::operator=(const MatrixRef<U, N>& x)
   static_assert(Convertible<U, T>(), "MatrixRef =: incompatible element types");
   assert(this->desc_.extents == x.descriptor().extents);
 
-  std::copy(x.begin(), x.end(), begin());
+  matrix_impl::copy_elements(x.data(), x.descriptor(), ptr_, this->desc_);
   return *this;
 }
 
 template <typename T, std::size_t N>
-template <typename U>
-MatrixRef<T, N>::MatrixRef(const Matrix<U, N> &x)
-    : MatrixBase<T, N>{x.descriptor()}, ptr_(x.data()) {}
+template <typename U, typename A>
+MatrixRef<T, N>::MatrixRef(const Matrix<U, N, A> &x)
+    : MatrixBase<T, N, MatrixRef>{x.descriptor()}, ptr_(x.data()) {}
 
 template <typename T, std::size_t N>
-template <typename U>
-MatrixRef<T, N> &MatrixRef<T, N>::operator=(const Matrix<U, N> &x) {
+template <typename U, typename A>
+MatrixRef<T, N> &MatrixRef<T, N>::operator=(const Matrix<U, N, A> &x) {
   static_assert(Convertible<U, T>(), "MatrixRef =: incompatible element types");
   assert(this->desc_.extents == x.descriptor().extents);
 
-  std::copy(x.begin(), x.end(), begin());
+  matrix_impl::copy_elements(x.data(), x.descriptor(), ptr_, this->desc_);
   return *this;
 }
 
@@ -441,6 +485,7 @@ MatrixRef<T, N> MatrixRef<T, N>::rows(std::size_t i, std::size_t j) {
     d.start += matrix_impl::do_slice_dim2(this->desc_, d, slice{0}, NRest);
     --NRest;
   }
+  d.size = matrix_impl::compute_size(d.extents);
   return {d, data()};
 }
 
@@ -458,6 +503,7 @@ MatrixRef<const T, N> MatrixRef<T, N>::rows(std::size_t i,
     d.start += matrix_impl::do_slice_dim2(this->desc_, d, slice{0}, NRest);
     --NRest;
   }
+  d.size = matrix_impl::compute_size(d.extents);
   return {d, data()};
 }
 
@@ -478,6 +524,7 @@ MatrixRef<T, N> MatrixRef<T, N>::cols(std::size_t i, std::size_t j) {
     d.start += matrix_impl::do_slice_dim2(this->desc_, d, slice{0}, NRest);
     --NRest;
   }
+  d.size = matrix_impl::compute_size(d.extents);
   return {d, data()};
 }
 
@@ -499,13 +546,14 @@ MatrixRef<const T, N> MatrixRef<T, N>::cols(std::size_t i,
     d.start += matrix_impl::do_slice_dim2(this->desc_, d, slice{0}, NRest);
     --NRest;
   }
+  d.size = matrix_impl::compute_size(d.extents);
   return {d, data()};
 }
 
 template <typename T, std::size_t N>
 template <typename F>
 MatrixRef<T, N> &MatrixRef<T, N>::apply(F f) {
-  for (auto iter = begin(); iter != end(); ++iter) f(*iter);
+  matrix_impl::for_each_element(ptr_, this->desc_, f);
   return *this;
 }
 
@@ -514,37 +562,47 @@ template <typename M, typename F>
 Enable_if<Matrix_type<M>(), MatrixRef<T, N> &> MatrixRef<T, N>::apply(
     const M &m, F f) {
   assert(same_extents(this->desc_, m.descriptor()));
-  auto j = m.begin();
-  for (auto i = begin(); i != end(); ++i) {
-    f(*i, *j);
-    ++j;
-  }
-
+  matrix_impl::for_each_element(data(), this->desc_, m.data(), m.descriptor(),
+                                f);
   return *this;
 }
 
 template <typename T, std::size_t N>
 MatrixRef<T, N> &MatrixRef<T, N>::operator=(const T &val) {
+  if (matrix_impl::dispatch_simd_fill(val, data(), this->desc_)) return *this;
   return apply([&](T &a) { a = val; });
 }
 
 template <typename T, std::size_t N>
 MatrixRef<T, N> &MatrixRef<T, N>::operator+=(const T &val) {
+  if (matrix_impl::dispatch_simd_scalar(matrix_impl::SimdOp::add, val, data(),
+                                         this->desc_))
+    return *this;
   return apply([&](T &a) { a += val; });
 }
 
 template <typename T, std::size_t N>
 MatrixRef<T, N> &MatrixRef<T, N>::operator-=(const T &val) {
+  if (matrix_impl::dispatch_simd_scalar(matrix_impl::SimdOp::sub, val, data(),
+                                         this->desc_))
+    return *this;
   return apply([&](T &a) { a -= val; });
 }
 
 template <typename T, std::size_t N>
 MatrixRef<T, N> &MatrixRef<T, N>::operator*=(const T &val) {
+  if (matrix_impl::dispatch_scal(val, data(), this->desc_)) return *this;
+  if (matrix_impl::dispatch_simd_scalar(matrix_impl::SimdOp::mul, val, data(),
+                                         this->desc_))
+    return *this;
   return apply([&](T &a) { a *= val; });
 }
 
 template <typename T, std::size_t N>
 MatrixRef<T, N> &MatrixRef<T, N>::operator/=(const T &val) {
+  if (matrix_impl::dispatch_simd_scalar(matrix_impl::SimdOp::div, val, data(),
+                                         this->desc_))
+    return *this;
   return apply([&](T &a) { a /= val; });
 }
 
@@ -560,6 +618,11 @@ Enable_if<Matrix_type<M>(), MatrixRef<T, N> &> MatrixRef<T, N>::operator+=(
   // static_assert(m.order_ == N, "+=: mismatched Matrix dimensions");
   assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
 
+  if (matrix_impl::dispatch_axpy(T(1), m.data(), m.descriptor(), data(),
+                                 this->desc_) ||
+      matrix_impl::dispatch_simd_update(matrix_impl::SimdOp::add, m.data(),
+                                        m.descriptor(), data(), this->desc_))
+    return *this;
   return apply(m, [&](T &a, const Value_type<M> &b) { a += b; });
 }
 
@@ -570,6 +633,11 @@ Enable_if<Matrix_type<M>(), MatrixRef<T, N> &> MatrixRef<T, N>::operator-=(
   // static_assert(m.order_ == N, "+=: mismatched Matrix dimensions");
   assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
 
+  if (matrix_impl::dispatch_axpy(T(-1), m.data(), m.descriptor(), data(),
+                                 this->desc_) ||
+      matrix_impl::dispatch_simd_update(matrix_impl::SimdOp::sub, m.data(),
+                                        m.descriptor(), data(), this->desc_))
+    return *this;
   return apply(m, [&](T &a, const Value_type<M> &b) { a -= b; });
 }
 
@@ -579,6 +647,9 @@ Enable_if<Matrix_type<M>(), MatrixRef<T, N> &> MatrixRef<T, N>::operator*=(
     const M &m) {
   assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
 
+  if (matrix_impl::dispatch_simd_update(matrix_impl::SimdOp::mul, m.data(),
+                                        m.descriptor(), data(), this->desc_))
+    return *this;
   return apply(m, [&](T &a, const Value_type<M> &b) { a *= b; });
 }
 
@@ -588,6 +659,9 @@ Enable_if<Matrix_type<M>(), MatrixRef<T, N> &> MatrixRef<T, N>::operator/=(
     const M &m) {
   assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
 
+  if (matrix_impl::dispatch_simd_update(matrix_impl::SimdOp::div, m.data(),
+                                        m.descriptor(), data(), this->desc_))
+    return *this;
   return apply(m, [&](T &a, const Value_type<M> &b) { a /= b; });
 }
 
@@ -600,6 +674,70 @@ Enable_if<Matrix_type<M>(), MatrixRef<T, N> &> MatrixRef<T, N>::operator%=(
   return apply(m, [&](T &a, const Value_type<M> &b) { a %= b; });
 }
 
+template <typename T, std::size_t N>
+template <typename E>
+MatrixRef<T, N> &MatrixRef<T, N>::operator=(const MatrixExpr<E> &x) {
+  static_assert(MatrixExpr<E>::order_ == N,
+                "MatrixRef =: mismatched dimensions");
+  static_assert(Convertible<typename E::value_type, T>(),
+                "MatrixRef =: incompatible element types");
+  assert(x.node().extents() == this->desc_.extents);
+
+  matrix_impl::expr_assign(data(), this->desc_, x.node(),
+                           matrix_impl::expr_copy_assign());
+  return *this;
+}
+
+template <typename T, std::size_t N>
+template <typename E>
+MatrixRef<T, N> &MatrixRef<T, N>::operator+=(const MatrixExpr<E> &x) {
+  assert(x.node().extents() == this->desc_.extents);
+
+  matrix_impl::expr_assign(data(), this->desc_, x.node(),
+                           matrix_impl::expr_plus_assign());
+  return *this;
+}
+
+template <typename T, std::size_t N>
+template <typename E>
+MatrixRef<T, N> &MatrixRef<T, N>::operator-=(const MatrixExpr<E> &x) {
+  assert(x.node().extents() == this->desc_.extents);
+
+  matrix_impl::expr_assign(data(), this->desc_, x.node(),
+                           matrix_impl::expr_minus_assign());
+  return *this;
+}
+
+template <typename T, std::size_t N>
+template <typename E>
+MatrixRef<T, N> &MatrixRef<T, N>::operator*=(const MatrixExpr<E> &x) {
+  assert(x.node().extents() == this->desc_.extents);
+
+  matrix_impl::expr_assign(data(), this->desc_, x.node(),
+                           matrix_impl::expr_multiplies_assign());
+  return *this;
+}
+
+template <typename T, std::size_t N>
+template <typename E>
+MatrixRef<T, N> &MatrixRef<T, N>::operator/=(const MatrixExpr<E> &x) {
+  assert(x.node().extents() == this->desc_.extents);
+
+  matrix_impl::expr_assign(data(), this->desc_, x.node(),
+                           matrix_impl::expr_divides_assign());
+  return *this;
+}
+
+template <typename T, std::size_t N>
+template <typename E>
+MatrixRef<T, N> &MatrixRef<T, N>::operator%=(const MatrixExpr<E> &x) {
+  assert(x.node().extents() == this->desc_.extents);
+
+  matrix_impl::expr_assign(data(), this->desc_, x.node(),
+                           matrix_impl::expr_modulus_assign());
+  return *this;
+}
+
 template <typename T, std::size_t N>
 template <typename U>
 Matrix<U, N> MatrixRef<T, N>::operator-() const {
@@ -608,7 +746,7 @@ Matrix<U, N> MatrixRef<T, N>::operator-() const {
 }
 
 template <typename T>
-class MatrixRef<T, 0> : public MatrixBase<T, 0> {
+class MatrixRef<T, 0> : public MatrixBase<T, 0, MatrixRef<T, 0>> {
  public:
   using iterator = T *;
   using const_iterator = const T *;
@@ -644,75 +782,114 @@ std::ostream &operator<<(std::ostream &os, const MatrixRef<T, 0> &mr0) {
   return os << (const T &)mr0;
 }
 
+// A random-access iterator over the elements of a slice, in the row-major
+// order of its extents. Besides the index and the address of the element,
+// which ++ and -- update with a carry, it keeps the position of the element
+// in that order, from which += finds the index in O(N), and - and the
+// comparisons need nothing else.
 template <typename T, std::size_t N>
 class MatrixRefIterator {
+  template <typename U, std::size_t NN>
+  friend class MatrixRefIterator;
   template <typename U, size_t NN>
   friend std::ostream &operator<<(std::ostream &os,
                                   const MatrixRefIterator<U, NN> &iter);
 
  public:
-  using iterator_category = std::forward_iterator_tag;
+  using iterator_category = std::random_access_iterator_tag;
   using value_type = typename std::remove_const<T>::type;
   using pointer = T *;
   using reference = T &;
   using difference_type = std::ptrdiff_t;
 
+  MatrixRefIterator() : desc_(nullptr), base_(nullptr), pos_(0), ptr_(nullptr) {
+    indx_.fill(0);
+  }
   MatrixRefIterator(const MatrixSlice<N> &s, T *base, bool limit = false);
-  MatrixRefIterator &operator=(const MatrixRefIterator &);
-
-  const MatrixSlice<N> &descriptor() const { return desc_; }
 
-  T &operator*() { return *ptr_; }
-  T *operator->() { return ptr_; }
-
-  const T &operator*() const { return *ptr_; }
-  const T *operator->() const { return ptr_; }
+  //! iterator to const_iterator
+  template <typename U,
+            typename = Enable_if<Same<const U, T>() && !Same<U, T>()>>
+  MatrixRefIterator(const MatrixRefIterator<U, N> &iter)
+      : indx_(iter.indx_),
+        desc_(iter.desc_),
+        base_(iter.base_),
+        pos_(iter.pos_),
+        ptr_(iter.ptr_) {}
+
+  const MatrixSlice<N> &descriptor() const { return *desc_; }
+  const std::array<size_t, N> &index() const { return indx_; }
+  //! the position of the element, from 0 to the size of the slice
+  difference_type position() const { return pos_; }
+
+  T &operator*() const { return *ptr_; }
+  T *operator->() const { return ptr_; }
+  T &operator[](difference_type n) const { return *(*this + n); }
 
   MatrixRefIterator &operator++();
   MatrixRefIterator operator++(int);
+  MatrixRefIterator &operator--();
+  MatrixRefIterator operator--(int);
+  MatrixRefIterator &operator+=(difference_type n);
+  MatrixRefIterator &operator-=(difference_type n) { return *this += -n; }
 
  private:
   void increment();
+  void decrement();
+  void seek(std::size_t pos);
 
   std::array<size_t, N> indx_;
-  const MatrixSlice<N> &desc_;
+  const MatrixSlice<N> *desc_;
+  T *base_;
+  difference_type pos_;
   T *ptr_;
 };
 
 template <typename T, std::size_t N>
 MatrixRefIterator<T, N>::MatrixRefIterator(const MatrixSlice<N> &s, T *base,
                                            bool limit)
-    : desc_(s) {
-  std::fill(indx_.begin(), indx_.end(), 0);
-
-  if (limit) {
-    indx_[0] = desc_.extents[0];
-    ptr_ = base + desc_.offset(indx_);
-  } else {
-    ptr_ = base + s.start;
-  }
+    : desc_(&s), base_(base) {
+  seek(limit ? s.size : 0);
 }
 
 template <typename T, std::size_t N>
-MatrixRefIterator<T, N> &MatrixRefIterator<T, N>::operator=(
-    const MatrixRefIterator &iter) {
-  std::copy(iter.indx_.begin(), iter.indx_.end(), indx_.begin());
-  ptr_ = iter.ptr_;
-
+MatrixRefIterator<T, N> &MatrixRefIterator<T, N>::operator++() {
+  increment();
+  ++pos_;
   return *this;
 }
 
 template <typename T, std::size_t N>
-MatrixRefIterator<T, N> &MatrixRefIterator<T, N>::operator++() {
-  increment();
+MatrixRefIterator<T, N> MatrixRefIterator<T, N>::operator++(int) {
+  MatrixRefIterator<T, N> x = *this;
+  ++*this;
+  return x;
+}
+
+template <typename T, std::size_t N>
+MatrixRefIterator<T, N> &MatrixRefIterator<T, N>::operator--() {
+  decrement();
+  --pos_;
   return *this;
 }
 
 template <typename T, std::size_t N>
-MatrixRefIterator<T, N> MatrixRefIterator<T, N>::operator++(int) {
+MatrixRefIterator<T, N> MatrixRefIterator<T, N>::operator--(int) {
   MatrixRefIterator<T, N> x = *this;
-  increment();
-  return *x;
+  --*this;
+  return x;
+}
+
+template <typename T, std::size_t N>
+MatrixRefIterator<T, N> &MatrixRefIterator<T, N>::operator+=(
+    difference_type n) {
+  if (n == 1)
+    ++*this;
+  else if (n == -1)
+    --*this;
+  else if (n != 0)
+    seek(pos_ + n);
+  return *this;
 }
 
 template <typename T, std::size_t N>
@@ -720,13 +897,13 @@ void MatrixRefIterator<T, N>::increment() {
   std::size_t d = N - 1;
 
   while (true) {
-    ptr_ += desc_.strides[d];
+    ptr_ += desc_->strides[d];
     ++indx_[d];
 
-    if (indx_[d] != desc_.extents[d]) break;
+    if (indx_[d] != desc_->extents[d]) break;
 
     if (d != 0) {
-      ptr_ -= desc_.strides[d] * desc_.extents[d];
+      ptr_ -= desc_->strides[d] * desc_->extents[d];
       indx_[d] = 0;
       --d;
     } else {
@@ -735,6 +912,37 @@ void MatrixRefIterator<T, N>::increment() {
   }
 }
 
+// the reverse of increment(), which leaves the end at index {extents[0], 0,
+// ..., 0}
+template <typename T, std::size_t N>
+void MatrixRefIterator<T, N>::decrement() {
+  for (std::size_t d = N - 1;; --d) {
+    if (indx_[d] != 0 || d == 0) {
+      --indx_[d];
+      ptr_ -= desc_->strides[d];
+      break;
+    }
+    indx_[d] = desc_->extents[d] - 1;
+    ptr_ += desc_->strides[d] * indx_[d];
+  }
+}
+
+template <typename T, std::size_t N>
+void MatrixRefIterator<T, N>::seek(std::size_t pos) {
+  assert(pos <= desc_->size);
+  pos_ = pos;
+  if (pos == desc_->size) {  // the end, as increment() leaves it
+    indx_.fill(0);
+    indx_[0] = desc_->extents[0];
+  } else {
+    for (std::size_t d = N; d != 0; --d) {
+      indx_[d - 1] = pos % desc_->extents[d - 1];
+      pos /= desc_->extents[d - 1];
+    }
+  }
+  ptr_ = base_ + desc_->offset(indx_);
+}
+
 template <typename T, size_t N>
 std::ostream &operator<<(std::ostream &os,
                          const MatrixRefIterator<T, N> &iter) {
@@ -742,11 +950,37 @@ std::ostream &operator<<(std::ostream &os,
   return os;
 }
 
+template <typename T, std::size_t N>
+inline MatrixRefIterator<T, N> operator+(MatrixRefIterator<T, N> a,
+                                         std::ptrdiff_t n) {
+  return a += n;
+}
+
+template <typename T, std::size_t N>
+inline MatrixRefIterator<T, N> operator+(std::ptrdiff_t n,
+                                         MatrixRefIterator<T, N> a) {
+  return a += n;
+}
+
+template <typename T, std::size_t N>
+inline MatrixRefIterator<T, N> operator-(MatrixRefIterator<T, N> a,
+                                         std::ptrdiff_t n) {
+  return a -= n;
+}
+
+template <typename T, std::size_t N>
+inline std::ptrdiff_t operator-(const MatrixRefIterator<T, N> &a,
+                                const MatrixRefIterator<T, N> &b) {
+  return a.position() - b.position();
+}
+
 template <typename T, std::size_t N>
 inline bool operator==(const MatrixRefIterator<T, N> &a,
                        const MatrixRefIterator<T, N> &b) {
   assert(a.descriptor() == b.descriptor());
-  return &*a == &*b;
+  // compare positions, not addresses: with a transposed view the element
+  // past the last row may alias one inside the view
+  return a.position() == b.position();
 }
 
 template <typename T, std::size_t N>
@@ -755,6 +989,30 @@ inline bool operator!=(const MatrixRefIterator<T, N> &a,
   return !(a == b);
 }
 
+template <typename T, std::size_t N>
+inline bool operator<(const MatrixRefIterator<T, N> &a,
+                      const MatrixRefIterator<T, N> &b) {
+  return a.position() < b.position();
+}
+
+template <typename T, std::size_t N>
+inline bool operator>(const MatrixRefIterator<T, N> &a,
+                      const MatrixRefIterator<T, N> &b) {
+  return b < a;
+}
+
+template <typename T, std::size_t N>
+inline bool operator<=(const MatrixRefIterator<T, N> &a,
+                       const MatrixRefIterator<T, N> &b) {
+  return !(b < a);
+}
+
+template <typename T, std::size_t N>
+inline bool operator>=(const MatrixRefIterator<T, N> &a,
+                       const MatrixRefIterator<T, N> &b) {
+  return !(a < b);
+}
+
 }  // namespace slab
 
 #endif  // SLAB_MATRIX_MATRIX_REF_H_
@@ -25,6 +25,7 @@
 
 #include <algorithm>
 #include <array>
+#include <functional>
 #include <initializer_list>
 #include <iostream>
 #include <numeric>  // std::inner_product
@@ -144,6 +145,80 @@ bool same_extents(const MatrixSlice<N> &a, const MatrixSlice<N> &b) {
   return a.extents == b.extents;
 }
 
+namespace matrix_impl {
+
+// Whether the elements of d are stored row-major without gaps.
+template <std::size_t N>
+bool is_contiguous(const MatrixSlice<N> &d) {
+  std::size_t stride = 1;
+  for (std::size_t k = N; k-- > 0;) {
+    if (d.extents[k] != 1 && d.strides[k] != stride) return false;
+    stride *= d.extents[k];
+  }
+  return true;
+}
+
+// Offset of the first element of row r of d, where the rows are the
+// one-dimensional slices along the last dimension, numbered row-major.
+template <std::size_t N>
+std::size_t row_offset(const MatrixSlice<N> &d, std::size_t r) {
+  std::size_t off = d.start;
+  for (std::size_t k = N - 1; k-- > 0;) {
+    off += r % d.extents[k] * d.strides[k];
+    r /= d.extents[k];
+  }
+  return off;
+}
+
+// Number of elements between the first and one past the last element of d.
+template <std::size_t N>
+std::size_t span(const MatrixSlice<N> &d) {
+  std::size_t s = 1;
+  for (std::size_t k = 0; k != N; ++k) {
+    if (d.extents[k] == 0) return 0;
+    s += (d.extents[k] - 1) * d.strides[k];
+  }
+  return s;
+}
+
+// Whether (da, a) and (db, b), of the same extents, are the same elements in
+// the same order.
+template <typename T, std::size_t N>
+bool same_view(const T *a, const MatrixSlice<N> &da, const T *b,
+               const MatrixSlice<N> &db) {
+  return a + da.start == b + db.start && da.strides == db.strides;
+}
+
+// Whether the elements (da, a) and (db, b) overlap without being the same
+// view, so that writing one element by element may change elements of the
+// other that are still to be read.
+template <typename T, std::size_t N>
+bool shifted_overlap(const T *a, const MatrixSlice<N> &da, const T *b,
+                     const MatrixSlice<N> &db) {
+  const T *a_first = a + da.start;
+  const T *a_last = a_first + span(da);
+  const T *b_first = b + db.start;
+  const T *b_last = b_first + span(db);
+  std::less<const T *> less;
+  if (!less(b_first, a_last) || !less(a_first, b_last)) return false;
+  return !same_view(a, da, b, db);
+}
+
+// The slice of the transpose of the matrix (d, base): the extents and
+// strides of its two dimensions swapped.
+inline MatrixSlice<2> transposed(const MatrixSlice<2> &d) {
+  return MatrixSlice<2>(d.start, {d.extents[1], d.extents[0]},
+                        {d.strides[1], d.strides[0]});
+}
+
+// The slice of the transpose of the vector (d, base), a one-row matrix.
+inline MatrixSlice<2> transposed(const MatrixSlice<1> &d) {
+  return MatrixSlice<2>(d.start, {1, d.extents[0]},
+                        {d.extents[0] * d.strides[0], d.strides[0]});
+}
+
+}  // namespace matrix_impl
+
 template <std::size_t N>
 std::ostream &operator<<(std::ostream &os,
                          const std::array<std::size_t, N> &a) {
@@ -14,48 +14,86 @@
 // limitations under the License.
 //
 
+/// @file mkl_allocator.h
+/// @brief An allocator backed by mkl_malloc()/mkl_free()
+
 #ifndef SLAB_MATRIX_MKL_ALLOCATOR_H_
 #define SLAB_MATRIX_MKL_ALLOCATOR_H_
 
-template <class T>
+#include <cstddef>
+
+#include <new>
+
+#ifdef USE_MKL
+#include "mkl.h"
+#endif
+
+#include "slab/matrix/allocator.h"
+
+namespace slab {
+
+//! MklAllocator<T, Alignment> allocates through mkl_malloc().
+/*!
+ * \tparam T value type.
+ * \tparam Alignment alignment in bytes, 64 by default as recommended by the
+ * Intel(R) MKL documentation.
+ *
+ * Without USE_MKL the allocator falls back to aligned system storage with the
+ * same alignment, so code written against it builds with any BLAS.
+ */
+template <typename T, std::size_t Alignment = 64>
 struct MklAllocator {
-  typedef T value_type;
-  MklAllocator() noexcept {
-  }  // default ctor not required by C++ Standard Library
-
-  // A converting copy constructor:
-  template <class U>
-  MklAllocator(const MklAllocator<U>&) noexcept {}
-  template <class U>
-  bool operator==(const MklAllocator<U>&) const noexcept {
-    return true;
-  }
-  template <class U>
-  bool operator!=(const Mallocator<U>&) const noexcept {
-    return false;
-  }
-  T* allocate(const size_t n) const;
-  void deallocate(T* const p, size_t) const noexcept;
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = MklAllocator<U, Alignment>;
+  };
+
+  MklAllocator() noexcept {}
+  template <typename U>
+  MklAllocator(const MklAllocator<U, Alignment> &) noexcept {}
+
+  T *allocate(std::size_t n) const;
+  void deallocate(T *p, std::size_t) const noexcept;
 };
 
-template <class T>
-T* MklAllocator<T>::allocate(const size_t n) const {
-  if (n == 0) {
-    return nullptr;
-  }
-  if (n > static_cast<size_t>(-1) / sizeof(T)) {
-    throw std::bad_array_new_length();
-  }
-  void* const pv = malloc(n * sizeof(T));
-  if (!pv) {
-    throw std::bad_alloc();
-  }
-  return static_cast<T*>(pv);
+template <typename T, std::size_t Alignment>
+T *MklAllocator<T, Alignment>::allocate(std::size_t n) const {
+#ifdef USE_MKL
+  if (n == 0) return nullptr;
+  if (n > static_cast<std::size_t>(-1) / sizeof(T)) throw std::bad_alloc();
+
+  void *p = mkl_malloc(n * sizeof(T), Alignment);
+  if (!p) throw std::bad_alloc();
+
+  return static_cast<T *>(p);
+#else
+  return matrix_impl::allocate_aligned<T>(n, Alignment);
+#endif
+}
+
+template <typename T, std::size_t Alignment>
+void MklAllocator<T, Alignment>::deallocate(T *p, std::size_t) const noexcept {
+#ifdef USE_MKL
+  mkl_free(p);
+#else
+  matrix_impl::aligned_free(p);
+#endif
+}
+
+template <typename T, typename U, std::size_t Alignment>
+inline bool operator==(const MklAllocator<T, Alignment> &,
+                       const MklAllocator<U, Alignment> &) noexcept {
+  return true;
 }
 
-template <class T>
-void MklAllocator<T>::deallocate(T* const p, size_t) const noexcept {
-  free(p);
+template <typename T, typename U, std::size_t Alignment>
+inline bool operator!=(const MklAllocator<T, Alignment> &,
+                       const MklAllocator<U, Alignment> &) noexcept {
+  return false;
 }
 
+}  // namespace slab
+
 #endif  // SLAB_MATRIX_MKL_ALLOCATOR_H_
@@ -0,0 +1,169 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file numa.h
+/// @brief NUMA-aware first touch of the elements of large matrices
+
+#ifndef SLAB_MATRIX_NUMA_H_
+#define SLAB_MATRIX_NUMA_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+
+#if !defined(_WIN32)
+#include <unistd.h>  // sysconf
+#endif
+
+#include "slab/matrix/matrix_slice.h"
+#include "slab/matrix/parallel.h"
+#include "slab/matrix/simd_dispatch.h"
+
+namespace slab {
+
+//! Who writes the elements of a new matrix first.
+/*!
+ * On NUMA machines a page is placed on the node of the thread that first
+ * writes it. With `serial` the constructing thread touches every page, so a
+ * large matrix lands on a single node and threads on the other sockets run
+ * at remote-memory bandwidth.
+ */
+enum class first_touch {
+  serial,      // the constructing thread initializes all elements
+  row_blocks,  // num_threads() threads initialize contiguous row blocks
+  interleave,  // num_threads() threads initialize pages round-robin
+};
+
+namespace matrix_impl {
+
+struct FirstTouchSetting {
+  std::atomic<int> policy{static_cast<int>(first_touch::serial)};
+  std::atomic<std::size_t> min_bytes{std::size_t(4) << 20};
+};
+
+inline FirstTouchSetting &first_touch_setting() {
+  static FirstTouchSetting s;
+  return s;
+}
+
+}  // namespace matrix_impl
+
+//! select how Matrix construction, zeros(), ones(), eye() and load() touch
+//! the elements of matrices of at least min_bytes bytes
+/*!
+ * `row_blocks` splits the rows into num_threads() contiguous blocks, as
+ * the parallel kernels of the library do, so that each thread later works
+ * on node-local memory; `interleave` spreads the pages over the threads
+ * round-robin, which evens out the bandwidth for access patterns that do
+ * not follow rows. Threads are not pinned: combine it with the OS or BLAS
+ * affinity settings (e.g. OMP_PROC_BIND=spread).
+ *
+ * Only element types that are trivially default constructible (float,
+ * double, integers) are left untouched by the allocation; std::complex
+ * elements are always touched by the constructing thread.
+ */
+inline void set_first_touch(first_touch policy,
+                            std::size_t min_bytes = std::size_t(4) << 20) {
+  matrix_impl::first_touch_setting().policy.store(static_cast<int>(policy));
+  matrix_impl::first_touch_setting().min_bytes.store(min_bytes);
+}
+
+//! the current first touch policy
+inline first_touch get_first_touch() {
+  return static_cast<first_touch>(
+      matrix_impl::first_touch_setting().policy.load());
+}
+
+namespace matrix_impl {
+
+// Whether n elements of type T are initialized by several threads.
+template <typename T>
+inline bool parallel_first_touch(std::size_t n) {
+  return std::is_trivially_default_constructible<T>::value &&
+         get_first_touch() != first_touch::serial &&
+         n * sizeof(T) >= first_touch_setting().min_bytes.load() &&
+         num_threads() > 1;
+}
+
+inline std::size_t page_size() {
+#if defined(_WIN32)
+  return 4096;
+#else
+  static const std::size_t sz = sysconf(_SC_PAGESIZE);
+  return sz;
+#endif
+}
+
+// Sets the d.size elements at p to val, which is the first write to them,
+// following the first touch policy.
+template <typename T, std::size_t N>
+void first_touch_fill(T *p, const MatrixSlice<N> &d, const T &val) {
+  const std::size_t n = d.size;
+  if (!parallel_first_touch<T>(n)) {
+    fill_elements(p, n, val);
+    return;
+  }
+
+  if (get_first_touch() == first_touch::row_blocks) {
+    const std::size_t rows = N == 0 ? 1 : d.extents[0];
+    const std::size_t row_size = rows ? n / rows : 0;
+    parallel_for(rows, [=](std::size_t first, std::size_t last, std::size_t) {
+      fill_elements(p + first * row_size, (last - first) * row_size, val);
+    });
+    return;
+  }
+
+  // interleave: thread t touches the pages t, t + nt, t + 2 * nt, ...
+  const std::size_t page = page_size();
+  const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(p);
+  const std::uintptr_t end = begin + n * sizeof(T);
+  const std::uintptr_t first_page = begin / page;
+  const std::size_t pages = (end - 1) / page - first_page + 1;
+  const std::size_t nt = std::min(num_threads(), pages);
+
+  parallel_for(nt, nt, [=](std::size_t, std::size_t, std::size_t t) {
+    for (std::size_t k = t; k < pages; k += nt) {
+      const std::uintptr_t lo = std::max(begin, (first_page + k) * page);
+      const std::uintptr_t hi = std::min(end, (first_page + k + 1) * page);
+      // a page boundary may split an element, which then goes to the page
+      // holding its first byte
+      T *first = p + (lo - begin + sizeof(T) - 1) / sizeof(T);
+      T *last = p + std::min(n, (hi - begin + sizeof(T) - 1) / sizeof(T));
+      fill_elements(first, std::size_t(last - first), val);
+    }
+  });
+}
+
+// Makes v hold d.size elements equal to val, touching them according to
+// the first touch policy.
+template <typename Vec, std::size_t N, typename T>
+void first_touch_init(Vec &v, const MatrixSlice<N> &d, const T &val) {
+  if (parallel_first_touch<T>(d.size)) {
+    v = Vec(d.size);  // allocates without writing
+    first_touch_fill(v.data(), d, val);
+  } else {
+    v.assign(d.size, val);
+  }
+}
+
+}  // namespace matrix_impl
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_NUMA_H_
@@ -0,0 +1,130 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file parallel.h
+/// @brief Thread count and the static parallel loop of the library
+
+#ifndef SLAB_MATRIX_PARALLEL_H_
+#define SLAB_MATRIX_PARALLEL_H_
+
+#include <cstddef>
+#include <cstdlib>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace slab {
+
+namespace matrix_impl {
+
+inline std::atomic<std::size_t> &num_threads_setting() {
+  static std::atomic<std::size_t> n{0};  // 0: not decided yet
+  return n;
+}
+
+// true on the worker threads of parallel_for(), which run nested loops
+// serially
+inline bool &in_parallel_region() {
+  static thread_local bool flag = false;
+  return flag;
+}
+
+// The [first, last) share of n iterations that thread t of nt gets: the
+// iterations are split into nt contiguous blocks whose sizes differ by at
+// most one. Kernels that want to reuse the placement of first_touch
+// partition their rows the same way.
+inline void block_range(std::size_t n, std::size_t nt, std::size_t t,
+                        std::size_t &first, std::size_t &last) {
+  const std::size_t q = n / nt;
+  const std::size_t r = n % nt;
+  first = t * q + std::min(t, r);
+  last = first + q + (t < r ? 1 : 0);
+}
+
+}  // namespace matrix_impl
+
+//! number of threads used by the parallel kernels of the library
+/*!
+ * Defaults to the SLAB_NUM_THREADS environment variable or, when it is not
+ * set, to std::thread::hardware_concurrency().
+ */
+inline std::size_t num_threads() {
+  std::size_t n = matrix_impl::num_threads_setting().load();
+  if (n == 0) {
+    const char *env = std::getenv("SLAB_NUM_THREADS");
+    if (env) n = std::strtoul(env, nullptr, 10);
+    if (n == 0) n = std::thread::hardware_concurrency();
+    if (n == 0) n = 1;
+    matrix_impl::num_threads_setting().store(n);
+  }
+  return n;
+}
+
+//! set the number of threads used by the parallel kernels of the library
+inline void set_num_threads(std::size_t n) {
+  matrix_impl::num_threads_setting().store(n ? n : 1);
+}
+
+namespace matrix_impl {
+
+// Runs f(first, last, t) for t = 0..nt-1 on nt threads, the calling thread
+// taking block 0, where [first, last) is block t of [0, n) as given by
+// block_range(). Called from inside such a loop, or with nt <= 1, it runs
+// serially.
+template <typename F>
+void parallel_for(std::size_t n, std::size_t nt, F f) {
+  nt = std::min(nt, n);
+  if (nt <= 1 || in_parallel_region()) {
+    for (std::size_t t = 0; t < nt; ++t) {
+      std::size_t first, last;
+      block_range(n, nt, t, first, last);
+      f(first, last, t);
+    }
+    return;
+  }
+
+  std::vector<std::thread> workers;
+  workers.reserve(nt - 1);
+  for (std::size_t t = 1; t != nt; ++t) {
+    workers.emplace_back([=]() {
+      in_parallel_region() = true;
+      std::size_t first, last;
+      block_range(n, nt, t, first, last);
+      f(first, last, t);
+    });
+  }
+
+  std::size_t first, last;
+  block_range(n, nt, 0, first, last);
+  in_parallel_region() = true;
+  f(first, last, 0);
+  in_parallel_region() = false;
+
+  for (auto &w : workers) w.join();
+}
+
+template <typename F>
+void parallel_for(std::size_t n, F f) {
+  parallel_for(n, num_threads(), f);
+}
+
+}  // namespace matrix_impl
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_PARALLEL_H_
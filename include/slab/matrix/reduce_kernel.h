@@ -0,0 +1,371 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file reduce_kernel.h
+/// @brief The reduction engine behind sum(), prod(), mean(), min(), max(),
+/// var() and stddev()
+///
+/// A reducer R<T> describes one reduction by a per-output State with
+///
+/// - R::init(), the state of no elements;
+/// - R::push(s, x), which adds the element x to s;
+/// - R::merge(s, t), which adds the elements counted by t to s;
+/// - R::result(s, n), the value for the n elements pushed into s.
+///
+/// A matrix is reduced along dimension dim without copying it:
+///
+/// - along the last dimension, every row is one output, reduced with
+///   reduce_lanes interleaved states so that independent additions can be
+///   vectorized and rounding errors do not pile up in one accumulator;
+/// - along any other dimension, the rows along dim are pushed one after
+///   the other into a block of states, one per element of the row, so that
+///   the input is read row-major and the push loop runs over unit-stride
+///   arrays.
+///
+/// Sums are compensated (Kahan) for non-integral types, the compensation
+/// being dropped once the sum is infinite or NaN, and var() uses Welford's
+/// update with Chan's merge. Matrices of reduce_parallel_min
+/// elements or more are split over num_threads() threads.
+
+#ifndef SLAB_MATRIX_REDUCE_KERNEL_H_
+#define SLAB_MATRIX_REDUCE_KERNEL_H_
+
+#include <cmath>
+#include <cstddef>
+
+#include <algorithm>
+#include <array>
+#include <complex>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/matrix_base.h"
+#include "slab/matrix/matrix_slice.h"
+#include "slab/matrix/parallel.h"
+
+namespace slab {
+
+namespace matrix_impl {
+
+// interleaved states per reduced row
+constexpr std::size_t reduce_lanes = 8;
+
+// most states of one block of outputs, i.e. elements of a row
+constexpr std::size_t reduce_block = 256;
+
+// fewest elements for which a reduction uses several threads
+constexpr std::size_t reduce_parallel_min = std::size_t(1) << 18;
+
+// the type of mean() and var() of elements of type T
+template <typename T>
+using Stat_type =
+    typename std::conditional<std::is_integral<T>::value, double, T>::type;
+
+// whether x is neither infinite nor NaN
+template <typename T>
+inline bool reduce_finite(const T &x) { return std::isfinite(x); }
+
+template <typename T>
+inline bool reduce_finite(const std::complex<T> &x) {
+  return std::isfinite(x.real()) && std::isfinite(x.imag());
+}
+
+template <typename T>
+struct sum_reducer {
+  using result_type = T;
+  // the sum is s - c, c being the rounding error of s
+  struct State {
+    T s, c;
+  };
+
+  static State init() { return {T{0}, T{0}}; }
+  static void push(State &a, const T &x) {
+    if (std::is_integral<T>::value) {
+      a.s += x;
+    } else {
+      // once the sum overflows, or meets an infinity, t - s would be
+      // inf - inf: the sum stays t, uncompensated
+      const T y = x - a.c;
+      const T t = a.s + y;
+      a.c = reduce_finite(t) ? (t - a.s) - y : T{0};
+      a.s = t;
+    }
+  }
+  static void merge(State &a, const State &b) {
+    if (!reduce_finite(a.s) || !reduce_finite(b.s)) {
+      a.s += b.s;
+      a.c = T{0};
+      return;
+    }
+    push(a, b.s);
+    push(a, -b.c);
+  }
+  static T result(const State &a, std::size_t) {
+    return reduce_finite(a.s) ? a.s - a.c : a.s;
+  }
+};
+
+template <typename T>
+struct prod_reducer {
+  using result_type = T;
+  struct State {
+    T p;
+  };
+
+  static State init() { return {T{1}}; }
+  static void push(State &a, const T &x) { a.p *= x; }
+  static void merge(State &a, const State &b) { a.p *= b.p; }
+  static T result(const State &a, std::size_t) { return a.p; }
+};
+
+template <typename T>
+struct min_reducer {
+  using result_type = T;
+  struct State {
+    T m;
+  };
+
+  static State init() {
+    return {std::numeric_limits<T>::has_infinity
+                ? std::numeric_limits<T>::infinity()
+                : std::numeric_limits<T>::max()};
+  }
+  static void push(State &a, const T &x) { a.m = x < a.m ? x : a.m; }
+  static void merge(State &a, const State &b) { push(a, b.m); }
+  static T result(const State &a, std::size_t) { return a.m; }
+};
+
+template <typename T>
+struct max_reducer {
+  using result_type = T;
+  struct State {
+    T m;
+  };
+
+  static State init() {
+    return {std::numeric_limits<T>::has_infinity
+                ? -std::numeric_limits<T>::infinity()
+                : std::numeric_limits<T>::lowest()};
+  }
+  static void push(State &a, const T &x) { a.m = a.m < x ? x : a.m; }
+  static void merge(State &a, const State &b) { push(a, b.m); }
+  static T result(const State &a, std::size_t) { return a.m; }
+};
+
+template <typename T>
+struct mean_reducer {
+  using result_type = Stat_type<T>;
+  using Sum = sum_reducer<result_type>;
+  using State = typename Sum::State;
+
+  static State init() { return Sum::init(); }
+  static void push(State &a, const T &x) { Sum::push(a, result_type(x)); }
+  static void merge(State &a, const State &b) { Sum::merge(a, b); }
+  static result_type result(const State &a, std::size_t n) {
+    return Sum::result(a, n) / result_type(n);
+  }
+};
+
+// the variance, normalized by n - 1
+template <typename T>
+struct var_reducer {
+  using result_type = Stat_type<T>;
+  using U = result_type;
+  struct State {
+    U n, mean, m2;  // m2: sum of squared deviations from mean
+  };
+
+  static State init() { return {U{0}, U{0}, U{0}}; }
+  static void push(State &a, const T &x) {
+    a.n += U{1};
+    const U d = U(x) - a.mean;
+    a.mean += d / a.n;
+    a.m2 += d * (U(x) - a.mean);
+  }
+  static void merge(State &a, const State &b) {
+    if (b.n == U{0}) return;
+    const U n = a.n + b.n;
+    const U d = b.mean - a.mean;
+    a.m2 += b.m2 + d * d * (a.n * b.n / n);
+    a.mean += d * (b.n / n);
+    a.n = n;
+  }
+  static U result(const State &a, std::size_t n) {
+    return n > 1 ? a.m2 / U(n - 1) : U{0};
+  }
+};
+
+template <typename T>
+struct stddev_reducer : var_reducer<T> {
+  using State = typename var_reducer<T>::State;
+  using U = typename var_reducer<T>::result_type;
+
+  static U result(const State &a, std::size_t n) {
+    using std::sqrt;
+    return sqrt(var_reducer<T>::result(a, n));
+  }
+};
+
+// The state of the n elements p[0], p[s], ..., p[(n - 1) * s].
+template <typename R, typename T>
+typename R::State reduce_fiber(const T *p, std::size_t n, std::size_t s) {
+  using State = typename R::State;
+  State st[reduce_lanes];
+  for (std::size_t l = 0; l != reduce_lanes; ++l) st[l] = R::init();
+
+  std::size_t i = 0;
+  if (s == 1) {
+    for (; i + reduce_lanes <= n; i += reduce_lanes)
+      for (std::size_t l = 0; l != reduce_lanes; ++l) R::push(st[l], p[i + l]);
+  } else {
+    for (; i + reduce_lanes <= n; i += reduce_lanes)
+      for (std::size_t l = 0; l != reduce_lanes; ++l)
+        R::push(st[l], p[(i + l) * s]);
+  }
+  for (; i != n; ++i) R::push(st[i % reduce_lanes], p[i * s]);
+
+  for (std::size_t l = 1; l != reduce_lanes; ++l) R::merge(st[0], st[l]);
+  return st[0];
+}
+
+// st[j] += p[k * sk + j * sj] for k < nk and j < nj: the rows along the
+// reduced dimension are read one after the other.
+template <typename R, typename T>
+void reduce_rows(const T *p, std::size_t nk, std::size_t sk, std::size_t nj,
+                 std::size_t sj, typename R::State *st) {
+  for (std::size_t k = 0; k != nk; ++k) {
+    const T *row = p + k * sk;
+    if (sj == 1) {
+      for (std::size_t j = 0; j != nj; ++j) R::push(st[j], row[j]);
+    } else {
+      for (std::size_t j = 0; j != nj; ++j) R::push(st[j], row[j * sj]);
+    }
+  }
+}
+
+// The state of all the elements of the slice d of base.
+template <typename R, typename T, std::size_t N>
+typename R::State reduce_all(const MatrixSlice<N> &d, const T *base) {
+  using State = typename R::State;
+  const std::size_t size = compute_size(d.extents);
+  if (size == 0) return R::init();
+
+  std::size_t nt = num_threads();
+  if (size < reduce_parallel_min) nt = 1;
+  std::vector<State> part(std::max<std::size_t>(nt, 1), R::init());
+
+  if (is_contiguous(d)) {
+    const T *p = base + d.start;
+    parallel_for(size, nt, [&](std::size_t first, std::size_t last,
+                               std::size_t t) {
+      part[t] = reduce_fiber<R>(p + first, last - first, 1);
+    });
+  } else {
+    const std::size_t len = d.extents[N - 1], s = d.strides[N - 1];
+    parallel_for(size / len, nt, [&](std::size_t first, std::size_t last,
+                                     std::size_t t) {
+      for (std::size_t r = first; r != last; ++r)
+        R::merge(part[t], reduce_fiber<R>(base + row_offset(d, r), len, s));
+    });
+  }
+
+  for (std::size_t t = 1; t < part.size(); ++t) R::merge(part[0], part[t]);
+  return part[0];
+}
+
+// out[...] = the reduction along dimension dim of the slice d of base,
+// where out is row-major with the extents of d except dim.
+template <typename R, typename T, std::size_t N>
+void reduce_dim(const MatrixSlice<N> &d, const T *base, std::size_t dim,
+                typename R::result_type *out) {
+  using State = typename R::State;
+  const std::size_t size = compute_size(d.extents);
+  const std::size_t nk = d.extents[dim], sk = d.strides[dim];
+  if (size == 0 && nk != 0) return;  // no outputs
+
+  std::size_t nt = num_threads();
+  if (size < reduce_parallel_min) nt = 1;
+
+  if (dim == N - 1) {
+    // every row is one output
+    std::size_t n_out = 1;
+    for (std::size_t k = 0; k != N - 1; ++k) n_out *= d.extents[k];
+    parallel_for(n_out, nt, [&](std::size_t first, std::size_t last,
+                                std::size_t) {
+      for (std::size_t r = first; r != last; ++r)
+        out[r] = R::result(reduce_fiber<R>(base + row_offset(d, r), nk, sk),
+                           nk);
+    });
+    return;
+  }
+
+  // the outputs form groups of rows of length nj along the last dimension,
+  // each cut into blocks of at most reduce_block states
+  const std::size_t nj = d.extents[N - 1], sj = d.strides[N - 1];
+  MatrixSlice<N> dg = d;  // one element per group
+  dg.extents[dim] = 1;
+  dg.extents[N - 1] = 1;
+  const std::size_t groups = compute_size(dg.extents);
+  const std::size_t blocks = (nj + reduce_block - 1) / reduce_block;
+
+  parallel_for(groups * blocks, nt, [&](std::size_t first, std::size_t last,
+                                        std::size_t) {
+    State st[reduce_block];
+    for (std::size_t w = first; w != last; ++w) {
+      const std::size_t g = w / blocks, j0 = w % blocks * reduce_block;
+      const std::size_t nb = std::min(reduce_block, nj - j0);
+      for (std::size_t j = 0; j != nb; ++j) st[j] = R::init();
+      reduce_rows<R>(base + row_offset(dg, g) + j0 * sj, nk, sk, nb, sj, st);
+      for (std::size_t j = 0; j != nb; ++j)
+        out[g * nj + j0 + j] = R::result(st[j], nk);
+    }
+  });
+}
+
+// R over all the elements of x
+template <template <typename> class R, typename T, std::size_t N,
+          typename D>
+typename R<Remove_const<T>>::result_type reduce_matrix(
+    const MatrixBase<T, N, D> &x) {
+  using Red = R<Remove_const<T>>;
+  const MatrixSlice<N> &d = x.descriptor();
+  return Red::result(reduce_all<Red>(d, x.data()), compute_size(d.extents));
+}
+
+// R along dimension dim of x: the result has the extents of x except dim
+template <template <typename> class R, typename T, std::size_t N,
+          typename D>
+Matrix<typename R<Remove_const<T>>::result_type, N - 1> reduce_matrix(
+    const MatrixBase<T, N, D> &x, std::size_t dim) {
+  static_assert(N >= 2, "reduce_matrix(): reduce a vector to a scalar");
+  using Red = R<Remove_const<T>>;
+  if (dim >= N) err_quit("dimension %zu of a matrix of order %zu", dim, N);
+
+  std::array<std::size_t, N - 1> exts;
+  for (std::size_t k = 0, e = 0; k != N; ++k)
+    if (k != dim) exts[e++] = x.descriptor().extents[k];
+  Matrix<typename Red::result_type, N - 1> res(uninitialized, exts);
+  reduce_dim<Red>(x.descriptor(), x.data(), dim, res.data());
+  return res;
+}
+
+}  // namespace matrix_impl
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_REDUCE_KERNEL_H_
@@ -0,0 +1,358 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file simd_dispatch.h
+/// @brief Routing of element-wise operations to the compiled SIMD kernels
+///
+/// When the program links the matrix library (which defines
+/// SLAB_MATRIX_SIMD for its users), element-wise arithmetic on float, double
+/// and int matrices of at least simd_min_size elements runs in the kernels
+/// of simd_kernels.h, built for the widest instruction set of the CPU,
+/// instead of the loops of the headers, which are vectorized only for the
+/// instruction set the program is compiled for:
+///
+/// - the scalar and compound operators of Matrix and MatrixRef, and
+///   assignment of a scalar;
+/// - the expressions `x op z` and `x op a` (op one of + - * /);
+/// - operator==, filling (zeros(), ones(), ...) and construction of a
+///   matrix from one of another element type;
+/// - the scaled rows of kron(), kron_into() and kron_add().
+///
+/// Large scal, axpy and copy operations go to BLAS first (blas_dispatch.h).
+/// A matrix is handed to the kernels as one array when it is contiguous,
+/// otherwise as one array per row when its rows are contiguous; matrices
+/// with strided rows keep the loops of the headers.
+///
+/// Without SLAB_MATRIX_SIMD every dispatch_simd_*() returns false.
+
+#ifndef SLAB_MATRIX_SIMD_DISPATCH_H_
+#define SLAB_MATRIX_SIMD_DISPATCH_H_
+
+#include <cstddef>
+
+#include <algorithm>
+#include <memory>
+
+#include "slab/matrix/matrix_slice.h"
+#include "slab/matrix/simd_kernels.h"
+#include "slab/matrix/traits.h"
+
+namespace slab {
+
+namespace matrix_impl {
+
+// Whether T is an element type of the kernels in this build.
+template <typename T>
+constexpr bool Simd_type() {
+#ifdef SLAB_MATRIX_SIMD
+  return Same<T, float>() || Same<T, double>() || Same<T, int>();
+#else
+  return false;
+#endif
+}
+
+// Fewer elements, or rows, than this are not worth an indirect call.
+constexpr std::size_t simd_min_size = 64;
+constexpr std::size_t simd_min_row = 16;
+
+template <typename T>
+const SimdKernels<T> &simd_kernels();
+
+#ifdef SLAB_MATRIX_SIMD
+template <>
+inline const SimdKernels<float> &simd_kernels<float>() {
+  return simd_table().f32;
+}
+template <>
+inline const SimdKernels<double> &simd_kernels<double>() {
+  return simd_table().f64;
+}
+template <>
+inline const SimdKernels<int> &simd_kernels<int>() {
+  return simd_table().i32;
+}
+#endif
+
+// Whether slices of the same extents can be traversed as arrays: all are
+// contiguous, or all have contiguous rows long enough for a call each.
+template <std::size_t N>
+bool simd_routable(const MatrixSlice<N> &d) {
+  return d.size >= simd_min_size &&
+         (is_contiguous(d) ||
+          (d.strides[N - 1] == 1 && d.extents[N - 1] >= simd_min_row));
+}
+
+template <std::size_t N>
+bool simd_routable(const MatrixSlice<N> &xd, const MatrixSlice<N> &yd) {
+  if (yd.size < simd_min_size) return false;
+  if (is_contiguous(xd) && is_contiguous(yd)) return true;
+  return simd_routable(xd) && simd_routable(yd);
+}
+
+template <std::size_t N>
+bool simd_routable(const MatrixSlice<N> &xd, const MatrixSlice<N> &zd,
+                   const MatrixSlice<N> &yd) {
+  if (yd.size < simd_min_size) return false;
+  if (is_contiguous(xd) && is_contiguous(zd) && is_contiguous(yd))
+    return true;
+  return simd_routable(xd) && simd_routable(zd) && simd_routable(yd);
+}
+
+// Calls f(n, yoff) for each array of the routable slice yd.
+template <std::size_t N, typename F>
+void simd_arrays(const MatrixSlice<N> &yd, F f) {
+  if (is_contiguous(yd)) {
+    f(yd.size, yd.start);
+    return;
+  }
+  const std::size_t cols = yd.extents[N - 1];
+  for (std::size_t r = 0; r != yd.size / cols; ++r) f(cols, row_offset(yd, r));
+}
+
+// Calls f(n, xoff, yoff) for each array of the routable slices, in step.
+template <std::size_t N, typename F>
+void simd_arrays(const MatrixSlice<N> &xd, const MatrixSlice<N> &yd, F f) {
+  if (is_contiguous(xd) && is_contiguous(yd)) {
+    f(yd.size, xd.start, yd.start);
+    return;
+  }
+  const std::size_t cols = yd.extents[N - 1];
+  for (std::size_t r = 0; r != yd.size / cols; ++r)
+    f(cols, row_offset(xd, r), row_offset(yd, r));
+}
+
+// Calls f(n, xoff, zoff, yoff) for each array of the routable slices.
+template <std::size_t N, typename F>
+void simd_arrays(const MatrixSlice<N> &xd, const MatrixSlice<N> &zd,
+                 const MatrixSlice<N> &yd, F f) {
+  if (is_contiguous(xd) && is_contiguous(zd) && is_contiguous(yd)) {
+    f(yd.size, xd.start, zd.start, yd.start);
+    return;
+  }
+  const std::size_t cols = yd.extents[N - 1];
+  for (std::size_t r = 0; r != yd.size / cols; ++r)
+    f(cols, row_offset(xd, r), row_offset(zd, r), row_offset(yd, r));
+}
+
+// The kernels below return false, doing nothing, when the operation is not
+// routed to them: the element type is not a kernel type, the slices are
+// not routable, or a source overlaps the destination shifted. The caller
+// then runs its own loop.
+
+// (yd, y) := a
+template <typename T, std::size_t N>
+Enable_if<Simd_type<T>(), bool> dispatch_simd_fill(const T &a, T *y,
+                                                   const MatrixSlice<N> &yd) {
+  if (!simd_routable(yd)) return false;
+  const auto fill = simd_kernels<T>().fill;
+  simd_arrays(yd,
+              [&](std::size_t n, std::size_t yoff) { fill(n, a, y + yoff); });
+  return true;
+}
+
+// (yd, y) := (yd, y) op a
+template <typename T, std::size_t N>
+Enable_if<Simd_type<T>(), bool> dispatch_simd_scalar(SimdOp op, const T &a,
+                                                     T *y,
+                                                     const MatrixSlice<N> &yd) {
+  if (!simd_routable(yd)) return false;
+  const auto k = simd_kernels<T>().scalar[std::size_t(op)];
+  simd_arrays(yd, [&](std::size_t n, std::size_t yoff) {
+    k(n, y + yoff, a, y + yoff);
+  });
+  return true;
+}
+
+// (yd, y) := (yd, y) op (xd, x)
+template <typename T, std::size_t N>
+Enable_if<Simd_type<T>(), bool> dispatch_simd_update(SimdOp op, const T *x,
+                                                     const MatrixSlice<N> &xd,
+                                                     T *y,
+                                                     const MatrixSlice<N> &yd) {
+  if (!simd_routable(xd, yd) || shifted_overlap(x, xd, y, yd)) return false;
+  const auto k = simd_kernels<T>().binary[std::size_t(op)];
+  simd_arrays(xd, yd, [&](std::size_t n, std::size_t xoff, std::size_t yoff) {
+    k(n, y + yoff, x + xoff, y + yoff);
+  });
+  return true;
+}
+
+// (yd, y) := (xd, x) op (zd, z), where neither source overlaps the
+// destination shifted
+template <typename T, std::size_t N>
+Enable_if<Simd_type<T>(), bool> dispatch_simd_binary(
+    SimdOp op, const T *x, const MatrixSlice<N> &xd, const T *z,
+    const MatrixSlice<N> &zd, T *y, const MatrixSlice<N> &yd) {
+  if (!simd_routable(xd, zd, yd)) return false;
+  const auto k = simd_kernels<T>().binary[std::size_t(op)];
+  simd_arrays(xd, zd, yd, [&](std::size_t n, std::size_t xoff,
+                              std::size_t zoff, std::size_t yoff) {
+    k(n, x + xoff, z + zoff, y + yoff);
+  });
+  return true;
+}
+
+// (yd, y) := (xd, x) op a, or a op (xd, x) when left is true, where the
+// source does not overlap the destination shifted
+template <typename T, std::size_t N>
+Enable_if<Simd_type<T>(), bool> dispatch_simd_scaled(
+    SimdOp op, bool left, const T &a, const T *x, const MatrixSlice<N> &xd,
+    T *y, const MatrixSlice<N> &yd) {
+  if (!simd_routable(xd, yd)) return false;
+  const auto &ks = simd_kernels<T>();
+  const auto k = ks.scalar[std::size_t(op)];
+  const auto kl = ks.scalar_left[std::size_t(op)];
+  simd_arrays(xd, yd, [&](std::size_t n, std::size_t xoff, std::size_t yoff) {
+    if (left)
+      kl(n, a, x + xoff, y + yoff);
+    else
+      k(n, x + xoff, a, y + yoff);
+  });
+  return true;
+}
+
+// equal := whether (xd, x) and (yd, y) are equal element-wise
+template <typename T, std::size_t N>
+Enable_if<Simd_type<T>(), bool> dispatch_simd_equal(const T *x,
+                                                    const MatrixSlice<N> &xd,
+                                                    const T *y,
+                                                    const MatrixSlice<N> &yd,
+                                                    bool &equal) {
+  if (!simd_routable(xd, yd)) return false;
+  const auto k = simd_kernels<T>().equal;
+  equal = true;
+  simd_arrays(xd, yd, [&](std::size_t n, std::size_t xoff, std::size_t yoff) {
+    equal = equal && k(n, x + xoff, y + yoff);
+  });
+  return true;
+}
+
+// the n elements at y := a
+template <typename T>
+Enable_if<Simd_type<T>(), bool> dispatch_simd_fill_n(const T &a, T *y,
+                                                     std::size_t n) {
+  if (n < simd_min_size) return false;
+  simd_kernels<T>().fill(n, a, y);
+  return true;
+}
+
+// the n elements at y := a * (the n elements at x)
+template <typename T>
+Enable_if<Simd_type<T>(), bool> dispatch_simd_scale_n(const T &a, const T *x,
+                                                      T *y, std::size_t n) {
+  if (n < simd_min_row) return false;
+  simd_kernels<T>().scalar[std::size_t(SimdOp::mul)](n, x, a, y);
+  return true;
+}
+
+// the n elements at y += a * (the n elements at x)
+template <typename T>
+Enable_if<Simd_type<T>(), bool> dispatch_simd_axpy_n(const T &a, const T *x,
+                                                     T *y, std::size_t n) {
+  if (n < simd_min_row) return false;
+  simd_kernels<T>().axpy(n, a, x, y);
+  return true;
+}
+
+template <typename T, typename U, std::size_t N>
+bool dispatch_simd_fill(const U &, T *, const MatrixSlice<N> &) {
+  return false;
+}
+
+template <typename T, typename U>
+bool dispatch_simd_fill_n(const U &, T *, std::size_t) {
+  return false;
+}
+
+template <typename T, typename U>
+bool dispatch_simd_scale_n(const U &, const T *, T *, std::size_t) {
+  return false;
+}
+
+template <typename T, typename U>
+bool dispatch_simd_axpy_n(const U &, const T *, T *, std::size_t) {
+  return false;
+}
+
+template <typename T, typename U, std::size_t N>
+bool dispatch_simd_scalar(SimdOp, const U &, T *, const MatrixSlice<N> &) {
+  return false;
+}
+
+template <typename T, typename U, std::size_t N>
+bool dispatch_simd_update(SimdOp, const U *, const MatrixSlice<N> &, T *,
+                          const MatrixSlice<N> &) {
+  return false;
+}
+
+template <typename T, typename U, typename V, std::size_t N>
+bool dispatch_simd_binary(SimdOp, const U *, const MatrixSlice<N> &,
+                          const V *, const MatrixSlice<N> &, T *,
+                          const MatrixSlice<N> &) {
+  return false;
+}
+
+template <typename T, typename U, typename V, std::size_t N>
+bool dispatch_simd_scaled(SimdOp, bool, const V &, const U *,
+                          const MatrixSlice<N> &, T *,
+                          const MatrixSlice<N> &) {
+  return false;
+}
+
+template <typename T, typename U, std::size_t N>
+bool dispatch_simd_equal(const T *, const MatrixSlice<N> &, const U *,
+                         const MatrixSlice<N> &, bool &) {
+  return false;
+}
+
+// Sets the n elements at p to val.
+template <typename T>
+void fill_elements(T *p, std::size_t n, const T &val) {
+  if (!dispatch_simd_fill_n(val, p, n)) std::fill(p, p + n, val);
+}
+
+// Copies [first, last) to the uninitialized elements at d, converting them
+// to the element type of d with the kernels where they apply.
+template <typename InputIt, typename T>
+void uninitialized_convert(InputIt first, InputIt last, T *d) {
+  std::uninitialized_copy(first, last, d);
+}
+
+#ifdef SLAB_MATRIX_SIMD
+#define SLAB_MATRIX_SIMD_CONVERT(From, To, kernel)                      \
+  inline void uninitialized_convert(From *first, From *last, To *d) {  \
+    const std::size_t n = last - first;                                \
+    if (n >= simd_min_size)                                            \
+      simd_table().cvt.kernel(n, first, d);                            \
+    else                                                               \
+      std::uninitialized_copy(first, last, d);                         \
+  }
+
+SLAB_MATRIX_SIMD_CONVERT(const float, double, float_double)
+SLAB_MATRIX_SIMD_CONVERT(const double, float, double_float)
+SLAB_MATRIX_SIMD_CONVERT(const int, float, int_float)
+SLAB_MATRIX_SIMD_CONVERT(const int, double, int_double)
+SLAB_MATRIX_SIMD_CONVERT(const float, int, float_int)
+SLAB_MATRIX_SIMD_CONVERT(const double, int, double_int)
+
+#undef SLAB_MATRIX_SIMD_CONVERT
+#endif
+
+}  // namespace matrix_impl
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_SIMD_DISPATCH_H_
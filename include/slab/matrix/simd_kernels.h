@@ -0,0 +1,118 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file simd_kernels.h
+/// @brief The element-wise kernels of the compiled matrix library
+///
+/// The matrix library (the `matrix` target, src/) compiles one set of
+/// element-wise kernels per instruction set: the baseline of the build,
+/// SSE4.2, AVX2 with FMA, and AVX-512 (F, DQ, BW, VL) on x86-64 with GCC or
+/// Clang. The first call picks the widest set the CPU and the operating
+/// system support, by CPUID; the headers call the kernels through that
+/// table of function pointers (see simd_dispatch.h).
+///
+/// This header declares the table only. It has no inline functions, since
+/// it is compiled into the kernels of every instruction set, whose copies
+/// of an inline function must not be mixed up by the linker.
+
+#ifndef SLAB_MATRIX_SIMD_KERNELS_H_
+#define SLAB_MATRIX_SIMD_KERNELS_H_
+
+#include <cstddef>
+
+namespace slab {
+
+//! instruction sets of the element-wise kernels, in increasing order
+enum class SimdLevel { baseline, sse42, avx2, avx512 };
+
+//! the instruction set of the element-wise kernels in use
+/*!
+ * The widest one that the CPU supports, unless capped by set_simd_level()
+ * or the SLAB_SIMD_LEVEL environment variable ("baseline", "sse4.2",
+ * "avx2" or "avx512"). Defined in the matrix library.
+ */
+SimdLevel simd_level();
+
+//! the widest instruction set that the CPU and the library support
+SimdLevel simd_max_level();
+
+//! use the kernels of level, or of simd_max_level() if that is lower
+void set_simd_level(SimdLevel level);
+
+//! the name of level, as accepted by SLAB_SIMD_LEVEL
+const char *simd_level_name(SimdLevel level);
+
+namespace matrix_impl {
+
+// the binary operations of the kernels
+enum class SimdOp { add, sub, mul, div, min, max };
+constexpr std::size_t simd_ops = 6;
+
+// the comparisons of the kernels
+enum class SimdCmp { eq, ne, lt, le, gt, ge };
+constexpr std::size_t simd_cmps = 6;
+
+// The kernels for one element type; x, y and z may be the same array, but
+// must not overlap otherwise.
+template <typename T>
+struct SimdKernels {
+  // z[i] = x[i] op y[i], indexed by SimdOp
+  void (*binary[simd_ops])(std::size_t n, const T *x, const T *y, T *z);
+  // z[i] = x[i] op a
+  void (*scalar[simd_ops])(std::size_t n, const T *x, T a, T *z);
+  // z[i] = a op x[i]
+  void (*scalar_left[simd_ops])(std::size_t n, T a, const T *x, T *z);
+  // w[i] = x[i] * y[i] + z[i], fused where the CPU has FMA
+  void (*fma)(std::size_t n, const T *x, const T *y, const T *z, T *w);
+  // y[i] += a * x[i]
+  void (*axpy)(std::size_t n, T a, const T *x, T *y);
+  // z[i] = |x[i]|
+  void (*abs)(std::size_t n, const T *x, T *z);
+  // z[i] = a
+  void (*fill)(std::size_t n, T a, T *z);
+  // m[i] = x[i] cmp y[i] ? 1 : 0, indexed by SimdCmp
+  void (*compare[simd_cmps])(std::size_t n, const T *x, const T *y,
+                             unsigned char *m);
+  // whether x[i] == y[i] for every i
+  bool (*equal)(std::size_t n, const T *x, const T *y);
+};
+
+// y[i] = x[i] converted, float and double to int by truncation
+struct SimdConversions {
+  void (*float_double)(std::size_t n, const float *x, double *y);
+  void (*double_float)(std::size_t n, const double *x, float *y);
+  void (*int_float)(std::size_t n, const int *x, float *y);
+  void (*int_double)(std::size_t n, const int *x, double *y);
+  void (*float_int)(std::size_t n, const float *x, int *y);
+  void (*double_int)(std::size_t n, const double *x, int *y);
+};
+
+struct SimdTable {
+  SimdLevel level;
+  SimdKernels<float> f32;
+  SimdKernels<double> f64;
+  SimdKernels<int> i32;
+  SimdConversions cvt;
+};
+
+// the kernels of simd_level()
+const SimdTable &simd_table();
+
+}  // namespace matrix_impl
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_SIMD_KERNELS_H_
@@ -0,0 +1,453 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file storage.h
+/// @brief The element storage of Matrix
+
+#ifndef SLAB_MATRIX_STORAGE_H_
+#define SLAB_MATRIX_STORAGE_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "slab/matrix/allocator.h"
+#include "slab/matrix/arena.h"
+#include "slab/matrix/instrument.h"
+#include "slab/matrix/simd_dispatch.h"
+
+//! Number of elements a Matrix keeps inline instead of on the heap.
+/*!
+ * Matrices with at most this many elements (a 4x4 matrix by default) live
+ * inside the Matrix object, so creating one does not allocate. Define it to
+ * 0 before including the library to disable the inline storage.
+ */
+#ifndef SLAB_MATRIX_INLINE_SIZE
+#define SLAB_MATRIX_INLINE_SIZE 16
+#endif
+
+namespace slab {
+namespace matrix_impl {
+
+// The allocator adaptor Matrix stores its elements with.
+//
+// Value-less construction default-initializes instead of value-initializing,
+// so std::vector<T, StorageAllocator<A>>(n) leaves trivial element types
+// uninitialized, while construction from a value still goes through the
+// wrapped allocator.
+//
+// While an ArenaScope is alive on the calling thread, storage is taken from
+// the thread's arena; deallocating arena storage is a no-op.
+template <typename A>
+class StorageAllocator : public A {
+  using traits = std::allocator_traits<A>;
+
+ public:
+  using value_type = typename traits::value_type;
+  using pointer = value_type *;
+
+  template <typename U>
+  struct rebind {
+    using other = StorageAllocator<typename traits::template rebind_alloc<U>>;
+  };
+
+  using A::A;
+
+  StorageAllocator() = default;
+  StorageAllocator(const A &a) : A(a) {}
+
+  pointer allocate(std::size_t n) {
+    instrument_allocate(n * sizeof(value_type));
+    Arena &arena = thread_arena();
+    if (arena.active()) {
+      if (n > static_cast<std::size_t>(-1) / sizeof(value_type))
+        throw std::bad_alloc();
+      return static_cast<pointer>(arena.allocate(n * sizeof(value_type)));
+    }
+    return traits::allocate(static_cast<A &>(*this), n);
+  }
+
+  void deallocate(pointer p, std::size_t n) {
+    instrument_deallocate(n * sizeof(value_type));
+    const Arena &arena = thread_arena();
+    if (!arena.empty() && arena.owns(p)) return;
+    traits::deallocate(static_cast<A &>(*this), p, n);
+  }
+
+  template <typename U>
+  void construct(U *p) noexcept(
+      std::is_nothrow_default_constructible<U>::value) {
+    ::new (static_cast<void *>(p)) U;
+  }
+
+  template <typename U, typename... Args>
+  void construct(U *p, Args &&... args) {
+    traits::construct(static_cast<A &>(*this), p, std::forward<Args>(args)...);
+  }
+};
+
+// A std::vector look-alike that keeps up to Small elements in an inline
+// buffer and moves to storage from StorageAllocator<A> beyond that. It only
+// provides what Matrix needs, requires a trivially copyable T and a stateless
+// allocator. Moving a SmallVector whose elements are inline copies them, so
+// pointers into the source do not survive the move.
+template <typename T, typename A, std::size_t Small>
+class SmallVector : private StorageAllocator<A> {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SmallVector: T must be trivially copyable");
+
+  using alloc_type = StorageAllocator<A>;
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = T *;
+  using const_iterator = const T *;
+
+  SmallVector() noexcept : data_(inline_data()), size_(0), capacity_(Small) {}
+
+  explicit SmallVector(std::size_t n) : SmallVector() {
+    reserve(n);
+    for (std::size_t i = 0; i != n; ++i) ::new (data_ + i) T;
+    size_ = n;
+  }
+
+  SmallVector(std::size_t n, const T &val) : SmallVector() {
+    reserve(n);
+    std::uninitialized_fill_n(data_, n, val);
+    size_ = n;
+  }
+
+  template <typename InputIt,
+            typename = typename std::iterator_traits<InputIt>::value_type>
+  SmallVector(InputIt first, InputIt last) : SmallVector() {
+    assign(first, last);
+  }
+
+  SmallVector(const SmallVector &x) : SmallVector() {
+    reserve(x.size_);
+    copy_n(x.data_, x.size_, data_);
+    size_ = x.size_;
+  }
+
+  SmallVector(SmallVector &&x) noexcept : SmallVector() { steal(x); }
+
+  SmallVector &operator=(const SmallVector &x) {
+    if (this != &x) {
+      size_ = 0;
+      reserve(x.size_);
+      copy_n(x.data_, x.size_, data_);
+      size_ = x.size_;
+    }
+    return *this;
+  }
+
+  SmallVector &operator=(SmallVector &&x) noexcept {
+    if (this != &x) {
+      release();
+      steal(x);
+    }
+    return *this;
+  }
+
+  ~SmallVector() { release(); }
+
+  void assign(std::size_t n, const T &val) {
+    size_ = 0;
+    reserve(n);
+    std::uninitialized_fill_n(data_, n, val);
+    size_ = n;
+  }
+
+  template <typename InputIt,
+            typename = typename std::iterator_traits<InputIt>::value_type>
+  void assign(InputIt first, InputIt last) {
+    size_ = 0;
+    append(first, last,
+           typename std::iterator_traits<InputIt>::iterator_category());
+  }
+
+  // Only insertion at the end is needed to build a Matrix from nested lists.
+  template <typename InputIt>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    assert(pos == end());
+    const std::size_t off = size_;
+    append(first, last,
+           typename std::iterator_traits<InputIt>::iterator_category());
+    return data_ + off;
+  }
+
+  void push_back(const T &val) {
+    if (size_ == capacity_) {
+      const T tmp = val;  // val may live in *this
+      reserve(2 * capacity_ + 1);
+      ::new (data_ + size_++) T(tmp);
+    } else {
+      ::new (data_ + size_++) T(val);
+    }
+  }
+
+  void reserve(std::size_t n) {
+    if (n <= capacity_) return;
+
+    T *p = alloc().allocate(n);
+    copy_n(data_, size_, p);
+    release();
+    data_ = p;
+    capacity_ = n;
+  }
+
+  void clear() noexcept { size_ = 0; }
+
+  std::size_t size() const noexcept { return size_; }
+  std::size_t capacity() const noexcept { return capacity_; }
+  bool empty() const noexcept { return size_ == 0; }
+  bool is_inline() const noexcept { return data_ == inline_data(); }
+
+  T *data() noexcept { return data_; }
+  const T *data() const noexcept { return data_; }
+
+  iterator begin() noexcept { return data_; }
+  const_iterator begin() const noexcept { return data_; }
+  const_iterator cbegin() const noexcept { return data_; }
+  iterator end() noexcept { return data_ + size_; }
+  const_iterator end() const noexcept { return data_ + size_; }
+  const_iterator cend() const noexcept { return data_ + size_; }
+
+ private:
+  alloc_type &alloc() noexcept { return *this; }
+
+  T *inline_data() noexcept { return reinterpret_cast<T *>(&buf_); }
+  const T *inline_data() const noexcept {
+    return reinterpret_cast<const T *>(&buf_);
+  }
+
+  static void copy_n(const T *src, std::size_t n, T *dst) {
+    if (n) std::memcpy(static_cast<void *>(dst), src, n * sizeof(T));
+  }
+
+  template <typename InputIt>
+  void append(InputIt first, InputIt last, std::input_iterator_tag) {
+    for (; first != last; ++first) push_back(*first);
+  }
+
+  template <typename ForwardIt>
+  void append(ForwardIt first, ForwardIt last, std::forward_iterator_tag) {
+    const std::size_t n = std::distance(first, last);
+    reserve(size_ + n);
+    uninitialized_convert(first, last, data_ + size_);
+    size_ += n;
+  }
+
+  // Takes over the elements of x and leaves it empty and inline.
+  void steal(SmallVector &x) noexcept {
+    if (x.is_inline()) {
+      copy_n(x.data_, x.size_, data_);
+    } else {
+      data_ = x.data_;
+      capacity_ = x.capacity_;
+      x.data_ = x.inline_data();
+      x.capacity_ = Small;
+    }
+    size_ = x.size_;
+    x.size_ = 0;
+  }
+
+  // Gives back the heap storage, if any, and returns to the inline buffer.
+  void release() noexcept {
+    if (!is_inline()) alloc().deallocate(data_, capacity_);
+    data_ = inline_data();
+    capacity_ = Small;
+  }
+
+  T *data_;
+  std::size_t size_;
+  std::size_t capacity_;
+  typename std::aligned_storage<sizeof(T) * Small, alignof(T)>::type buf_;
+};
+
+// A reference-counted vector with copy-on-write semantics, the storage of
+// Matrix<T, N, CowAllocator<T, A>>. Copies share the elements; a mutable
+// access to shared elements (non-const data(), begin(), end() or any
+// modifier) first clones them. The count is atomic, so copies may be read
+// and destroyed on different threads.
+template <typename T, typename A>
+class CowVector {
+  using vector_type = std::vector<T, StorageAllocator<A>>;
+
+  struct Rep {
+    template <typename... Args>
+    explicit Rep(Args &&... args)
+        : refs(1), elems(std::forward<Args>(args)...) {}
+
+    std::atomic<std::size_t> refs;
+    vector_type elems;
+  };
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = T *;
+  using const_iterator = const T *;
+
+  CowVector() noexcept : rep_(nullptr) {}
+  explicit CowVector(std::size_t n) : rep_(new Rep(n)) {}
+  CowVector(std::size_t n, const T &val) : rep_(new Rep(n, val)) {}
+
+  template <typename InputIt,
+            typename = typename std::iterator_traits<InputIt>::value_type>
+  CowVector(InputIt first, InputIt last) : rep_(new Rep(first, last)) {}
+
+  CowVector(const CowVector &x) noexcept : rep_(x.rep_) {
+    if (rep_) rep_->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+  CowVector(CowVector &&x) noexcept : rep_(x.rep_) { x.rep_ = nullptr; }
+
+  CowVector &operator=(const CowVector &x) noexcept {
+    CowVector(x).swap(*this);
+    return *this;
+  }
+  CowVector &operator=(CowVector &&x) noexcept {
+    CowVector(std::move(x)).swap(*this);
+    return *this;
+  }
+
+  ~CowVector() { release(); }
+
+  void swap(CowVector &x) noexcept { std::swap(rep_, x.rep_); }
+
+  // The modifiers that replace all elements do not clone them first.
+  void assign(std::size_t n, const T &val) { fresh().assign(n, val); }
+
+  template <typename InputIt,
+            typename = typename std::iterator_traits<InputIt>::value_type>
+  void assign(InputIt first, InputIt last) {
+    if (shared()) {
+      // the other owners keep [first, last) alive even if it is ours
+      CowVector(first, last).swap(*this);
+      return;
+    }
+    fresh().assign(first, last);
+  }
+
+  template <typename InputIt>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    const std::size_t off = pos - cbegin();
+    vector_type &v = own();
+    return v.data() + (v.insert(v.begin() + off, first, last) - v.begin());
+  }
+
+  void push_back(const T &val) { own().push_back(val); }
+  void reserve(std::size_t n) { own().reserve(n); }
+
+  void clear() noexcept {
+    if (shared())
+      release();
+    else if (rep_)
+      rep_->elems.clear();
+  }
+
+  std::size_t size() const noexcept { return rep_ ? rep_->elems.size() : 0; }
+  std::size_t capacity() const noexcept {
+    return rep_ ? rep_->elems.capacity() : 0;
+  }
+  bool empty() const noexcept { return size() == 0; }
+
+  // number of CowVectors sharing the elements, 0 when there are none
+  std::size_t use_count() const noexcept {
+    return rep_ ? rep_->refs.load(std::memory_order_acquire) : 0;
+  }
+
+  T *data() { return rep_ ? own().data() : nullptr; }
+  const T *data() const noexcept {
+    return rep_ ? rep_->elems.data() : nullptr;
+  }
+
+  iterator begin() { return data(); }
+  const_iterator begin() const noexcept { return data(); }
+  const_iterator cbegin() const noexcept { return data(); }
+  iterator end() { return data() + size(); }
+  const_iterator end() const noexcept { return data() + size(); }
+  const_iterator cend() const noexcept { return data() + size(); }
+
+ private:
+  // the acquire load orders our writes after the reads of former owners
+  bool shared() const noexcept { return use_count() > 1; }
+
+  // Makes the elements unshared, cloning them if needed.
+  vector_type &own() {
+    if (!rep_) {
+      rep_ = new Rep();
+    } else if (shared()) {
+      Rep *r = new Rep(rep_->elems);
+      release();
+      rep_ = r;
+    }
+    return rep_->elems;
+  }
+
+  // Makes the elements unshared without keeping their values.
+  vector_type &fresh() {
+    if (shared()) release();
+    if (!rep_) rep_ = new Rep();
+    return rep_->elems;
+  }
+
+  void release() noexcept {
+    if (rep_ && rep_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete rep_;
+    rep_ = nullptr;
+  }
+
+  Rep *rep_;
+};
+
+// The container a Matrix keeps its elements in: a SmallVector for trivially
+// copyable elements with the default allocator, a CowVector for CowAllocator
+// and a std::vector otherwise. Custom allocators are taken as a request for
+// their storage (alignment, huge pages, MKL), so they always get it.
+constexpr std::size_t inline_size = SLAB_MATRIX_INLINE_SIZE;
+
+template <typename T, typename A>
+struct StorageOf {
+  using type = typename std::conditional<
+      inline_size != 0 && std::is_same<A, std::allocator<T>>::value &&
+          std::is_trivially_copyable<T>::value,
+      SmallVector<T, A, inline_size>,
+      std::vector<T, StorageAllocator<A>>>::type;
+};
+
+template <typename T, typename U, typename A>
+struct StorageOf<T, CowAllocator<U, A>> {
+  using type = CowVector<T, A>;
+};
+
+template <typename T, typename A>
+using Storage = typename StorageOf<T, A>::type;
+
+}  // namespace matrix_impl
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_STORAGE_H_
@@ -21,6 +21,7 @@
 #define SLAB_MATRIX_TRAITS_H_
 
 #include <complex>
+#include <memory>  // std::allocator_traits
 #include <type_traits>  // std::enable_if/is_convertible
 
 namespace slab {
@@ -62,8 +63,8 @@ struct substitution_succeeded<substitution_failure> : std::false_type {};
 
 template <typename M>
 struct get_matrix_type_result {
-  template <typename T, size_t N, typename = Enable_if<(N >= 1)>>
-  static bool check(const Matrix<T, N> &m);
+  template <typename T, size_t N, typename A, typename = Enable_if<(N >= 1)>>
+  static bool check(const Matrix<T, N, A> &m);
 
   template <typename T, size_t N, typename = Enable_if<(N >= 1)>>
   static bool check(const MatrixRef<T, N> &m);
@@ -93,6 +94,13 @@ constexpr bool Matrix_type() {
 template <typename C>
 using Value_type = typename C::value_type;
 
+template <typename T>
+using Remove_const = typename std::remove_const<T>::type;
+
+template <typename A, typename U>
+using Rebind_alloc =
+    typename std::allocator_traits<A>::template rebind_alloc<U>;
+
 template <typename T>
 struct is_double : public std::false_type {};
 
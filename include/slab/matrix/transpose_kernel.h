@@ -0,0 +1,243 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file transpose_kernel.h
+/// @brief The transpose kernels behind transpose() and inplace_trans()
+///
+/// Copying row i of a to column i of the result writes one element per
+/// cache line; past the L2 size nearly every write misses. Instead:
+///
+/// - out of place, the matrix is halved along its longer side until a
+///   block fits in the L1 cache (so the traversal is cache-oblivious), and
+///   a block is transposed in 4 x 4 tiles held in registers, with SSE
+///   shuffles for float and double. Large matrices are split over
+///   num_threads() threads by blocks of rows of the result;
+/// - in place, a square matrix swaps its tiles across the diagonal;
+/// - in place, a rectangular matrix is permuted by following the cycles of
+///   the transpose permutation, with one bit of bookkeeping per element
+///   instead of a second copy of the matrix.
+
+#ifndef SLAB_MATRIX_TRANSPOSE_KERNEL_H_
+#define SLAB_MATRIX_TRANSPOSE_KERNEL_H_
+
+#include <cstddef>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "slab/matrix/parallel.h"
+
+namespace slab {
+
+namespace matrix_impl {
+
+// side of the register tiles
+constexpr std::size_t trans_tile = 4;
+
+// most bytes of a block of the source transposed without further splitting,
+// i.e. half of a 32 KiB L1 cache for source and result together
+constexpr std::size_t trans_block_bytes = 16384;
+
+// fewest elements for which the transposes use several threads
+constexpr std::size_t trans_parallel_min = std::size_t(1) << 18;
+
+// b(j, i) = a(i, j) for a 4 x 4 tile; a has row stride lda and b has row
+// stride ldb, both with unit column stride.
+template <typename T>
+inline void trans_tile4(const T *a, std::size_t lda, T *b, std::size_t ldb) {
+  T r[trans_tile][trans_tile];
+  for (std::size_t i = 0; i != trans_tile; ++i)
+    for (std::size_t j = 0; j != trans_tile; ++j) r[j][i] = a[i * lda + j];
+  for (std::size_t j = 0; j != trans_tile; ++j)
+    for (std::size_t i = 0; i != trans_tile; ++i) b[j * ldb + i] = r[j][i];
+}
+
+#if defined(__SSE2__)
+inline void trans_tile4(const float *a, std::size_t lda, float *b,
+                        std::size_t ldb) {
+  __m128 r0 = _mm_loadu_ps(a);
+  __m128 r1 = _mm_loadu_ps(a + lda);
+  __m128 r2 = _mm_loadu_ps(a + 2 * lda);
+  __m128 r3 = _mm_loadu_ps(a + 3 * lda);
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+  _mm_storeu_ps(b, r0);
+  _mm_storeu_ps(b + ldb, r1);
+  _mm_storeu_ps(b + 2 * ldb, r2);
+  _mm_storeu_ps(b + 3 * ldb, r3);
+}
+
+// a 4 x 4 tile of doubles is four 2 x 2 tiles of one register row each
+inline void trans_tile4(const double *a, std::size_t lda, double *b,
+                        std::size_t ldb) {
+  for (std::size_t i = 0; i != trans_tile; i += 2) {
+    for (std::size_t j = 0; j != trans_tile; j += 2) {
+      const __m128d x0 = _mm_loadu_pd(a + i * lda + j);
+      const __m128d x1 = _mm_loadu_pd(a + (i + 1) * lda + j);
+      _mm_storeu_pd(b + j * ldb + i, _mm_unpacklo_pd(x0, x1));
+      _mm_storeu_pd(b + (j + 1) * ldb + i, _mm_unpackhi_pd(x0, x1));
+    }
+  }
+}
+#endif
+
+// b(j, i) = a(i, j) for an m x n block that fits in the L1 cache
+template <typename T>
+void trans_block(const T *a, std::size_t lda, T *b, std::size_t ldb,
+                 std::size_t m, std::size_t n) {
+  const std::size_t m4 = m - m % trans_tile, n4 = n - n % trans_tile;
+  for (std::size_t i = 0; i != m4; i += trans_tile) {
+    for (std::size_t j = 0; j != n4; j += trans_tile)
+      trans_tile4(a + i * lda + j, lda, b + j * ldb + i, ldb);
+    for (std::size_t j = n4; j != n; ++j)
+      for (std::size_t ii = i; ii != i + trans_tile; ++ii)
+        b[j * ldb + ii] = a[ii * lda + j];
+  }
+  for (std::size_t i = m4; i != m; ++i)
+    for (std::size_t j = 0; j != n; ++j) b[j * ldb + i] = a[i * lda + j];
+}
+
+// b(j, i) = a(i, j) for an m x n matrix a, halving the longer side (at a
+// multiple of the tile) until a block is small enough for trans_block().
+template <typename T>
+void trans_recursive(const T *a, std::size_t lda, T *b, std::size_t ldb,
+                     std::size_t m, std::size_t n) {
+  if (m * n * sizeof(T) <= trans_block_bytes || (m <= trans_tile &&
+                                                 n <= trans_tile)) {
+    trans_block(a, lda, b, ldb, m, n);
+  } else if (m >= n) {
+    const std::size_t h = std::max(m / 2 / trans_tile * trans_tile,
+                                   trans_tile);
+    trans_recursive(a, lda, b, ldb, h, n);
+    trans_recursive(a + h * lda, lda, b + h, ldb, m - h, n);
+  } else {
+    const std::size_t h = std::max(n / 2 / trans_tile * trans_tile,
+                                   trans_tile);
+    trans_recursive(a, lda, b, ldb, m, h);
+    trans_recursive(a + h, lda, b + h * ldb, ldb, m, n - h);
+  }
+}
+
+// b(j, i) = a(i, j) for an m x n matrix a with row stride lda and unit
+// column stride; b has row stride ldb.
+template <typename T>
+void transpose_into(const T *a, std::size_t lda, T *b, std::size_t ldb,
+                    std::size_t m, std::size_t n) {
+  std::size_t nt = num_threads();
+  if (m * n < trans_parallel_min) nt = 1;
+
+  // each thread writes whole tile rows of b, i.e. reads tile columns of a
+  const std::size_t panels = (n + trans_tile - 1) / trans_tile;
+  parallel_for(panels, nt, [&](std::size_t first, std::size_t last,
+                               std::size_t) {
+    const std::size_t j0 = first * trans_tile;
+    const std::size_t j1 = std::min(last * trans_tile, n);
+    if (j0 < j1) trans_recursive(a + j0, lda, b + j0 * ldb, ldb, m, j1 - j0);
+  });
+}
+
+// b(j, i) = a(i, j) for an m x n matrix a with strides (s0, s1), neither
+// of them 1, e.g. a column of blocks; b has row stride ldb.
+template <typename T>
+void transpose_strided(const T *a, std::size_t s0, std::size_t s1, T *b,
+                       std::size_t ldb, std::size_t m, std::size_t n) {
+  const std::size_t blk = 32;
+  for (std::size_t i0 = 0; i0 < m; i0 += blk)
+    for (std::size_t j0 = 0; j0 < n; j0 += blk)
+      for (std::size_t i = i0; i != std::min(i0 + blk, m); ++i)
+        for (std::size_t j = j0; j != std::min(j0 + blk, n); ++j)
+          b[j * ldb + i] = a[i * s0 + j * s1];
+}
+
+// swaps the p x q block at a with the transpose of the q x p block at b,
+// both with row stride lda
+template <typename T>
+void trans_swap_block(T *a, T *b, std::size_t lda, std::size_t p,
+                      std::size_t q) {
+  using std::swap;
+  for (std::size_t i = 0; i != p; ++i)
+    for (std::size_t j = 0; j != q; ++j) swap(a[i * lda + j], b[j * lda + i]);
+}
+
+// Transposes the n x n matrix a, row stride lda, in place: the blocks of a
+// above the diagonal are swapped with those below, block row by block row.
+template <typename T>
+void transpose_square_inplace(T *a, std::size_t n, std::size_t lda) {
+  const std::size_t blk = 32;
+  const std::size_t nb = (n + blk - 1) / blk;
+  std::size_t nt = num_threads();
+  if (n * n < trans_parallel_min) nt = 1;
+
+  // block row r swaps nb - r blocks, so the rows are dealt out cyclically
+  // to give every thread a similar share
+  nt = std::max<std::size_t>(std::min(nt, nb), 1);
+  parallel_for(nt, nt, [&](std::size_t, std::size_t, std::size_t t) {
+    for (std::size_t r = t; r < nb; r += nt) {
+      const std::size_t i0 = r * blk, p = std::min(blk, n - i0);
+      T *d = a + i0 * lda + i0;
+      for (std::size_t i = 0; i != p; ++i)
+        trans_swap_block(d + i * lda + i + 1, d + (i + 1) * lda + i, lda, 1,
+                         p - i - 1);
+      for (std::size_t j0 = i0 + blk; j0 < n; j0 += blk) {
+        const std::size_t q = std::min(blk, n - j0);
+        trans_swap_block(a + i0 * lda + j0, a + j0 * lda + i0, lda, p, q);
+      }
+    }
+  });
+}
+
+// Transposes the m x n row-major matrix a into the n x m row-major matrix
+// in the same m * n elements. Element k < m * n - 1 moves to k * m mod
+// (m * n - 1); every cycle of that permutation is rotated once, from its
+// first unvisited element.
+template <typename T>
+void transpose_cycles(T *a, std::size_t m, std::size_t n) {
+  const std::size_t size = m * n;
+  if (m <= 1 || n <= 1) return;  // the elements are already in place
+  if (m == n) {
+    transpose_square_inplace(a, n, n);
+    return;
+  }
+
+  const std::size_t q = size - 1;
+  std::vector<bool> moved(size);
+  for (std::size_t start = 1; start < q; ++start) {
+    if (moved[start]) continue;
+    T x = std::move(a[start]);
+    std::size_t k = start;
+    do {
+      // the element that belongs at k comes from k * n mod q
+      const std::size_t from = (k * n) % q;
+      moved[k] = true;
+      if (from == start) {
+        a[k] = std::move(x);
+      } else {
+        a[k] = std::move(a[from]);
+      }
+      k = from;
+    } while (k != start);
+  }
+}
+
+}  // namespace matrix_impl
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_TRANSPOSE_KERNEL_H_
@@ -0,0 +1,282 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file traverse.h
+/// @brief Row-by-row traversal of matrix slices
+///
+/// The element loops of MatrixRef (assignment, the compound operators,
+/// apply(), copying into a Matrix, ==) walk their slices with RowWalk
+/// rather than with MatrixRefIterator, whose increment() carries over all
+/// N dimensions at every element.
+///
+/// RowWalk merges the trailing dimensions that are laid out as one in every
+/// slice walked in step: a dimension whose stride is the extent times the
+/// stride of the next. A contiguous matrix, or a block of full rows, is
+/// then a single row; a submatrix is one row per row; a column is one row
+/// with the stride of the column. Only the dimensions left outside the rows
+/// are carried, once per row, and the rows run as plain loops that the
+/// compiler vectorizes when their stride is 1, or as memcpy for copies.
+/// When there are several rows the start of the next row is prefetched
+/// while the current one runs.
+///
+/// Every walk visits the elements in the order of MatrixRefIterator, so
+/// that an assignment between overlapping views gives the same result.
+
+#ifndef SLAB_MATRIX_TRAVERSE_H_
+#define SLAB_MATRIX_TRAVERSE_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+#include <array>
+#include <functional>
+#include <type_traits>
+
+#include "slab/matrix/matrix_slice.h"
+#include "slab/matrix/traits.h"
+
+#if defined(__GNUC__)
+#define SLAB_MATRIX_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define SLAB_MATRIX_PREFETCH(p) ((void)(p))
+#endif
+
+namespace slab {
+
+namespace matrix_impl {
+
+template <std::size_t K>
+using Offsets = std::array<std::size_t, K>;
+
+// The rows of K slices of the same extents, walked in step.
+template <std::size_t N, std::size_t K>
+class RowWalk {
+  using Slices = std::array<const MatrixSlice<N> *, K>;
+
+ public:
+  explicit RowWalk(const MatrixSlice<N> &d) : RowWalk(Slices{{&d}}) {}
+  RowWalk(const MatrixSlice<N> &a, const MatrixSlice<N> &b)
+      : RowWalk(Slices{{&a, &b}}) {}
+
+  //! number of rows
+  std::size_t rows() const { return rows_; }
+  //! elements per row
+  std::size_t cols() const { return cols_; }
+  //! stride between the elements of a row, per slice
+  const Offsets<K> &incs() const { return inc_; }
+
+  //! f(row, next) for each row, with the offsets of its first element in
+  //! each slice, and those of the next row (of the last row at the end)
+  template <typename F>
+  void for_each(F f) const;
+
+ private:
+  explicit RowWalk(const Slices &ds);
+
+  std::size_t outer_;                  // dimensions outside the rows
+  std::array<std::size_t, N> extents_;  // of those dimensions
+  std::array<Offsets<N>, K> strides_;
+  Offsets<K> start_;
+  Offsets<K> inc_;
+  std::size_t rows_;
+  std::size_t cols_;
+};
+
+template <std::size_t N, std::size_t K>
+RowWalk<N, K>::RowWalk(const Slices &ds)
+    : extents_(ds[0]->extents), cols_(1) {
+  inc_.fill(0);
+  std::size_t d = N;
+  for (; d != 0; --d) {
+    const std::size_t e = extents_[d - 1];
+    if (e == 1) continue;  // its stride does not matter
+    if (cols_ == 1) {
+      for (std::size_t k = 0; k != K; ++k) inc_[k] = ds[k]->strides[d - 1];
+    } else {
+      bool merge = true;
+      for (std::size_t k = 0; k != K; ++k)
+        merge = merge && ds[k]->strides[d - 1] == inc_[k] * cols_;
+      if (!merge) break;
+    }
+    cols_ *= e;
+  }
+
+  outer_ = d;
+  rows_ = 1;
+  for (std::size_t i = 0; i != outer_; ++i) rows_ *= extents_[i];
+  for (std::size_t k = 0; k != K; ++k) {
+    start_[k] = ds[k]->start;
+    strides_[k] = ds[k]->strides;
+  }
+}
+
+template <std::size_t N, std::size_t K>
+template <typename F>
+void RowWalk<N, K>::for_each(F f) const {
+  if (rows_ == 0 || cols_ == 0) return;
+
+  std::array<std::size_t, N> index;
+  index.fill(0);
+  Offsets<K> row = start_;
+  for (std::size_t r = 0; r != rows_; ++r) {
+    Offsets<K> next = row;
+    for (std::size_t d = outer_; d != 0; --d) {
+      for (std::size_t k = 0; k != K; ++k) next[k] += strides_[k][d - 1];
+      if (++index[d - 1] != extents_[d - 1]) break;
+      for (std::size_t k = 0; k != K; ++k)
+        next[k] -= strides_[k][d - 1] * extents_[d - 1];
+      index[d - 1] = 0;
+    }
+    f(row, r + 1 != rows_ ? next : row);
+    row = next;
+  }
+}
+
+// The slice of the n x 1 matrix d as a vector, and of the vector d as an
+// n x 1 matrix: the same elements in the same order.
+inline MatrixSlice<1> vector_slice(const MatrixSlice<2> &d) {
+  return MatrixSlice<1>(d.start, {d.extents[0]}, {d.strides[0]});
+}
+
+inline MatrixSlice<2> column_slice(const MatrixSlice<1> &d) {
+  return MatrixSlice<2>(d.start, {d.extents[0], 1}, {d.strides[0], 1});
+}
+
+// Whether (xd, x) may view some of the elements (d, p).
+template <typename T, std::size_t N, typename U>
+bool may_view(const U *x, const MatrixSlice<N> &xd, const T *p,
+              const MatrixSlice<N> &d) {
+  if (!Same<Remove_const<U>, T>()) return false;
+  const void *x_first = x + xd.start;
+  const void *x_last = x + xd.start + span(xd);
+  const void *p_first = p + d.start;
+  const void *p_last = p + d.start + span(d);
+  std::less<const void *> less;
+  return less(x_first, p_last) && less(p_first, x_last);
+}
+
+// f(p[0]), f(p[inc]), ..., f(p[(n - 1) * inc])
+template <typename T, typename F>
+void row_apply(T *p, std::size_t n, std::size_t inc, F &f) {
+  if (inc == 1) {
+    for (std::size_t i = 0; i != n; ++i) f(p[i]);
+    return;
+  }
+  for (std::size_t i = 0; i != n; ++i, p += inc) f(*p);
+}
+
+// f(y[0], x[0]), f(y[incy], x[incx]), ...
+template <typename T, typename U, typename F>
+void row_apply(T *y, std::size_t incy, U *x, std::size_t incx, std::size_t n,
+               F &f) {
+  if (incy == 1 && incx == 1) {
+    for (std::size_t i = 0; i != n; ++i) f(y[i], x[i]);
+    return;
+  }
+  for (std::size_t i = 0; i != n; ++i, y += incy, x += incx) f(*y, *x);
+}
+
+// f(e) for every element e of (d, p), in the order of MatrixRefIterator
+template <typename T, std::size_t N, typename F>
+void for_each_element(T *p, const MatrixSlice<N> &d, F f) {
+  const RowWalk<N, 1> walk(d);
+  const std::size_t n = walk.cols();
+  const std::size_t inc = walk.incs()[0];
+  const bool prefetch = walk.rows() > 1;
+  walk.for_each([&](const Offsets<1> &row, const Offsets<1> &next) {
+    if (prefetch) SLAB_MATRIX_PREFETCH(p + next[0]);
+    row_apply(p + row[0], n, inc, f);
+  });
+}
+
+// f(a, b) for the elements a of (yd, y) and b of (xd, x) in step
+template <typename T, std::size_t N, typename U, typename F>
+void for_each_element(T *y, const MatrixSlice<N> &yd, U *x,
+                      const MatrixSlice<N> &xd, F f) {
+  assert(same_extents(yd, xd));
+  const RowWalk<N, 2> walk(yd, xd);
+  const std::size_t n = walk.cols();
+  const std::size_t incy = walk.incs()[0];
+  const std::size_t incx = walk.incs()[1];
+  const bool prefetch = walk.rows() > 1;
+  walk.for_each([&](const Offsets<2> &row, const Offsets<2> &next) {
+    if (prefetch) {
+      SLAB_MATRIX_PREFETCH(y + next[0]);
+      SLAB_MATRIX_PREFETCH(x + next[1]);
+    }
+    row_apply(y + row[0], incy, x + row[1], incx, n, f);
+  });
+}
+
+// (yd, y) := (xd, x), element by element in the order of std::copy when
+// the two overlap shifted, otherwise row by row with memcpy where it can
+template <typename T, std::size_t N, typename U>
+void copy_elements(const U *x, const MatrixSlice<N> &xd, T *y,
+                   const MatrixSlice<N> &yd) {
+  const auto assign = [](T &a, const U &b) { a = b; };
+  if (!Same<T, U>() || !std::is_trivially_copyable<T>::value ||
+      shifted_overlap(reinterpret_cast<const T *>(x), xd, y, yd)) {
+    for_each_element(y, yd, x, xd, assign);
+    return;
+  }
+
+  const RowWalk<N, 2> walk(yd, xd);
+  if (walk.incs()[0] != 1 || walk.incs()[1] != 1) {
+    for_each_element(y, yd, x, xd, assign);
+    return;
+  }
+  const std::size_t bytes = walk.cols() * sizeof(T);
+  const bool prefetch = walk.rows() > 1;
+  walk.for_each([&](const Offsets<2> &row, const Offsets<2> &next) {
+    if (prefetch) SLAB_MATRIX_PREFETCH(x + next[1]);
+    if (y + row[0] != reinterpret_cast<const T *>(x) + row[1])
+      std::memcpy(y + row[0], x + row[1], bytes);
+  });
+}
+
+// whether (xd, x) and (yd, y) are equal element-wise, stopping at the
+// first row that differs
+template <typename T, std::size_t N, typename U>
+bool equal_elements(const T *x, const MatrixSlice<N> &xd, const U *y,
+                    const MatrixSlice<N> &yd) {
+  assert(same_extents(xd, yd));
+  const RowWalk<N, 2> walk(xd, yd);
+  const std::size_t n = walk.cols();
+  const std::size_t incx = walk.incs()[0];
+  const std::size_t incy = walk.incs()[1];
+  bool equal = true;
+  walk.for_each([&](const Offsets<2> &row, const Offsets<2> &) {
+    if (!equal) return;
+    const T *a = x + row[0];
+    const U *b = y + row[1];
+    unsigned differ = 0;  // no early exit, so that the loop vectorizes
+    if (incx == 1 && incy == 1) {
+      for (std::size_t i = 0; i != n; ++i) differ |= !(a[i] == b[i]);
+    } else {
+      for (std::size_t i = 0; i != n; ++i)
+        differ |= !(a[i * incx] == b[i * incy]);
+    }
+    equal = !differ;
+  });
+  return equal;
+}
+
+}  // namespace matrix_impl
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_TRAVERSE_H_
@@ -22,6 +22,7 @@
 
 #include <complex>
 
+#include "slab/matrix/fixed_matrix.h"
 #include "slab/matrix/matrix.h"
 #include "slab/matrix/packed_matrix.h"
 
@@ -64,6 +65,24 @@ using ivec = Matrix<int, 1>;
 using imat = Matrix<int, 2>;
 using icube = Matrix<int, 3>;
 
+// Fixed-size Matrix -- 2x2 / 3x3 / 4x4 matrices and column vectors
+
+using mat22 = FixedMatrix<double, 2, 2>;
+using mat33 = FixedMatrix<double, 3, 3>;
+using mat44 = FixedMatrix<double, 4, 4>;
+
+using vec2 = FixedMatrix<double, 2, 1>;
+using vec3 = FixedMatrix<double, 3, 1>;
+using vec4 = FixedMatrix<double, 4, 1>;
+
+using fmat22 = FixedMatrix<float, 2, 2>;
+using fmat33 = FixedMatrix<float, 3, 3>;
+using fmat44 = FixedMatrix<float, 4, 4>;
+
+using fvec2 = FixedMatrix<float, 2, 1>;
+using fvec3 = FixedMatrix<float, 3, 1>;
+using fvec4 = FixedMatrix<float, 4, 1>;
+
 // Packed Matrix -- Symmetric Matrix / Triangular Matrix / Hermitian Matrix
 
 using symm_mat = SymmetricMatrix<double, upper>;
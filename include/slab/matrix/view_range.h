@@ -0,0 +1,243 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file view_range.h
+/// @brief Ranges of the rows and of the columns of a matrix
+///
+/// row_views(m) and col_views(m) are ranges of the views m.row(i) and
+/// m.col(j). Their iterators make each view when dereferenced, a MatrixRef
+/// returned by value rather than a reference to a stored element, so they
+/// are input iterators: they go to the standard algorithms that read each
+/// view once (for_each, transform, find_if, count_if, ...), not to those
+/// that assign or swap through *it, such as sort. Like indices, they can
+/// also be moved by any distance and subtracted in constant time, so that
+/// a range can be split into blocks by position between threads:
+///
+/// @code
+/// auto rows = row_views(m);
+/// matrix_impl::parallel_for(rows.size(), [&](std::size_t first,
+///                                             std::size_t last, std::size_t) {
+///   std::for_each(rows.begin() + first, rows.begin() + last, f);
+/// });
+/// @endcode
+///
+/// A range holds the slice of the matrix and a pointer to its elements,
+/// not the matrix, which must outlive it.
+
+#ifndef SLAB_MATRIX_VIEW_RANGE_H_
+#define SLAB_MATRIX_VIEW_RANGE_H_
+
+#include <cassert>
+#include <cstddef>
+
+#include <iterator>
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/matrix_ref.h"
+#include "slab/matrix/matrix_slice.h"
+#include "slab/matrix/support.h"
+
+namespace slab {
+
+namespace matrix_impl {
+
+// The views of a slice at the positions i of its dimension D: an input
+// iterator, since it yields the views by value, that is indexed by its
+// position.
+template <std::size_t D, typename T, std::size_t N>
+class SliceIterator {
+ public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type = MatrixRef<T, N - 1>;
+  using pointer = void;
+  using reference = MatrixRef<T, N - 1>;  // made on the fly
+  using difference_type = std::ptrdiff_t;
+
+  SliceIterator() : ptr_(nullptr), pos_(0) {}
+  SliceIterator(const MatrixSlice<N> &d, T *p, std::size_t i)
+      : desc_(d), ptr_(p), pos_(i) {}
+
+  //! the position of the view in dimension D
+  difference_type position() const { return pos_; }
+
+  reference operator*() const { return (*this)[0]; }
+  reference operator[](difference_type n) const {
+    MatrixSlice<N - 1> s;
+    slice_dim<D>(pos_ + n, desc_, s);
+    return {s, ptr_};
+  }
+
+  SliceIterator &operator++() {
+    ++pos_;
+    return *this;
+  }
+  SliceIterator operator++(int) {
+    SliceIterator x = *this;
+    ++pos_;
+    return x;
+  }
+  SliceIterator &operator--() {
+    --pos_;
+    return *this;
+  }
+  SliceIterator operator--(int) {
+    SliceIterator x = *this;
+    --pos_;
+    return x;
+  }
+  SliceIterator &operator+=(difference_type n) {
+    pos_ += n;
+    return *this;
+  }
+  SliceIterator &operator-=(difference_type n) {
+    pos_ -= n;
+    return *this;
+  }
+
+ private:
+  MatrixSlice<N> desc_;
+  T *ptr_;
+  difference_type pos_;
+};
+
+template <std::size_t D, typename T, std::size_t N>
+inline SliceIterator<D, T, N> operator+(SliceIterator<D, T, N> a,
+                                        std::ptrdiff_t n) {
+  return a += n;
+}
+
+template <std::size_t D, typename T, std::size_t N>
+inline SliceIterator<D, T, N> operator+(std::ptrdiff_t n,
+                                        SliceIterator<D, T, N> a) {
+  return a += n;
+}
+
+template <std::size_t D, typename T, std::size_t N>
+inline SliceIterator<D, T, N> operator-(SliceIterator<D, T, N> a,
+                                        std::ptrdiff_t n) {
+  return a -= n;
+}
+
+template <std::size_t D, typename T, std::size_t N>
+inline std::ptrdiff_t operator-(const SliceIterator<D, T, N> &a,
+                                const SliceIterator<D, T, N> &b) {
+  return a.position() - b.position();
+}
+
+template <std::size_t D, typename T, std::size_t N>
+inline bool operator==(const SliceIterator<D, T, N> &a,
+                       const SliceIterator<D, T, N> &b) {
+  return a.position() == b.position();
+}
+
+template <std::size_t D, typename T, std::size_t N>
+inline bool operator!=(const SliceIterator<D, T, N> &a,
+                       const SliceIterator<D, T, N> &b) {
+  return !(a == b);
+}
+
+template <std::size_t D, typename T, std::size_t N>
+inline bool operator<(const SliceIterator<D, T, N> &a,
+                      const SliceIterator<D, T, N> &b) {
+  return a.position() < b.position();
+}
+
+template <std::size_t D, typename T, std::size_t N>
+inline bool operator>(const SliceIterator<D, T, N> &a,
+                      const SliceIterator<D, T, N> &b) {
+  return b < a;
+}
+
+template <std::size_t D, typename T, std::size_t N>
+inline bool operator<=(const SliceIterator<D, T, N> &a,
+                       const SliceIterator<D, T, N> &b) {
+  return !(b < a);
+}
+
+template <std::size_t D, typename T, std::size_t N>
+inline bool operator>=(const SliceIterator<D, T, N> &a,
+                       const SliceIterator<D, T, N> &b) {
+  return !(a < b);
+}
+
+// The views of a slice along its dimension D.
+template <std::size_t D, typename T, std::size_t N>
+class SliceRange {
+  static_assert(D < N, "SliceRange: no such dimension");
+
+ public:
+  using iterator = SliceIterator<D, T, N>;
+  using value_type = MatrixRef<T, N - 1>;
+
+  SliceRange(const MatrixSlice<N> &d, T *p) : desc_(d), ptr_(p) {}
+
+  std::size_t size() const { return desc_.extents[D]; }
+  bool empty() const { return size() == 0; }
+
+  iterator begin() const { return {desc_, ptr_, 0}; }
+  iterator end() const { return {desc_, ptr_, size()}; }
+
+  value_type operator[](std::size_t i) const {
+    assert(i < size());
+    return begin()[i];
+  }
+
+ private:
+  MatrixSlice<N> desc_;
+  T *ptr_;
+};
+
+}  // namespace matrix_impl
+
+//! the rows of m, as a range of m.row(i)
+///@{
+template <typename T, std::size_t N, typename A>
+matrix_impl::SliceRange<0, T, N> row_views(Matrix<T, N, A> &m) {
+  return {m.descriptor(), m.data()};
+}
+
+template <typename T, std::size_t N, typename A>
+matrix_impl::SliceRange<0, const T, N> row_views(const Matrix<T, N, A> &m) {
+  return {m.descriptor(), m.data()};
+}
+
+template <typename T, std::size_t N>
+matrix_impl::SliceRange<0, T, N> row_views(MatrixRef<T, N> m) {
+  return {m.descriptor(), m.data()};
+}
+///@}
+
+//! the columns of m, as a range of m.col(j)
+///@{
+template <typename T, std::size_t N, typename A>
+matrix_impl::SliceRange<1, T, N> col_views(Matrix<T, N, A> &m) {
+  return {m.descriptor(), m.data()};
+}
+
+template <typename T, std::size_t N, typename A>
+matrix_impl::SliceRange<1, const T, N> col_views(const Matrix<T, N, A> &m) {
+  return {m.descriptor(), m.data()};
+}
+
+template <typename T, std::size_t N>
+matrix_impl::SliceRange<1, T, N> col_views(MatrixRef<T, N> m) {
+  return {m.descriptor(), m.data()};
+}
+///@}
+
+}  // namespace slab
+
+#endif  // SLAB_MATRIX_VIEW_RANGE_H_
@@ -14,11 +14,101 @@
 // limitations under the License.
 //
 // -----------------------------------------------------------------------------
-// library.h
+// library.cc
 // -----------------------------------------------------------------------------
 
 #include "library.h"
 
-#include <iostream>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
 
-void hello() { std::cout << "Hello, World!" << std::endl; }
\ No newline at end of file
+namespace slab {
+
+namespace {
+
+// The widest instruction set the CPU supports; __builtin_cpu_supports()
+// also checks that the operating system saves the AVX and AVX-512 registers.
+SimdLevel detect_simd_level() {
+#ifdef SLAB_MATRIX_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") &&
+      __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl"))
+    return SimdLevel::avx512;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    return SimdLevel::avx2;
+  if (__builtin_cpu_supports("sse4.2")) return SimdLevel::sse42;
+#endif
+  return SimdLevel::baseline;
+}
+
+const SimdLevel simd_levels[] = {SimdLevel::baseline, SimdLevel::sse42,
+                                 SimdLevel::avx2, SimdLevel::avx512};
+
+const matrix_impl::SimdTable &simd_table_of(SimdLevel level) {
+  switch (level) {
+#ifdef SLAB_MATRIX_SIMD_X86
+    case SimdLevel::avx512:
+      return matrix_impl::simd_table_avx512;
+    case SimdLevel::avx2:
+      return matrix_impl::simd_table_avx2;
+    case SimdLevel::sse42:
+      return matrix_impl::simd_table_sse42;
+#endif
+    default:
+      return matrix_impl::simd_table_baseline;
+  }
+}
+
+// simd_max_level(), capped by SLAB_SIMD_LEVEL when it names a level
+SimdLevel initial_simd_level() {
+  const SimdLevel max = simd_max_level();
+  const char *env = std::getenv("SLAB_SIMD_LEVEL");
+  if (env) {
+    for (SimdLevel level : simd_levels)
+      if (std::strcmp(env, simd_level_name(level)) == 0)
+        return level < max ? level : max;
+  }
+  return max;
+}
+
+std::atomic<const matrix_impl::SimdTable *> &simd_table_setting() {
+  static std::atomic<const matrix_impl::SimdTable *> table{
+      &simd_table_of(initial_simd_level())};
+  return table;
+}
+
+}  // namespace
+
+SimdLevel simd_level() { return matrix_impl::simd_table().level; }
+
+SimdLevel simd_max_level() {
+  static const SimdLevel level = detect_simd_level();
+  return level;
+}
+
+void set_simd_level(SimdLevel level) {
+  const SimdLevel max = simd_max_level();
+  simd_table_setting().store(&simd_table_of(level < max ? level : max));
+}
+
+const char *simd_level_name(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::sse42:
+      return "sse4.2";
+    case SimdLevel::avx2:
+      return "avx2";
+    case SimdLevel::avx512:
+      return "avx512";
+    default:
+      return "baseline";
+  }
+}
+
+namespace matrix_impl {
+
+const SimdTable &simd_table() { return *simd_table_setting().load(); }
+
+}  // namespace matrix_impl
+
+}  // namespace slab
@@ -19,5 +19,24 @@
 //
 #ifndef MATRIX_LIBRARY_H
 #define MATRIX_LIBRARY_H
-void hello();
-#endif
\ No newline at end of file
+
+#include "slab/matrix/simd_kernels.h"
+
+namespace slab {
+
+namespace matrix_impl {
+
+// The kernels of each instruction set the library is built for; the ones
+// other than baseline exist only on x86-64 with GCC or Clang.
+extern const SimdTable simd_table_baseline;
+#ifdef SLAB_MATRIX_SIMD_X86
+extern const SimdTable simd_table_sse42;
+extern const SimdTable simd_table_avx2;
+extern const SimdTable simd_table_avx512;
+#endif
+
+}  // namespace matrix_impl
+
+}  // namespace slab
+
+#endif
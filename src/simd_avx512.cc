@@ -0,0 +1,26 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// simd_avx512.cc
+// -----------------------------------------------------------------------------
+//
+// The element-wise kernels for AVX-512, compiled with
+// -mavx512f -mavx512dq -mavx512bw -mavx512vl.
+
+#define SLAB_MATRIX_SIMD_TABLE simd_table_avx512
+#define SLAB_MATRIX_SIMD_LEVEL SimdLevel::avx512
+
+#include "simd_kernels.inc"
@@ -0,0 +1,25 @@
+//
+// Copyright 2019 The Statslabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// simd_baseline.cc
+// -----------------------------------------------------------------------------
+//
+// The element-wise kernels for the baseline instruction set of the build.
+
+#define SLAB_MATRIX_SIMD_TABLE simd_table_baseline
+#define SLAB_MATRIX_SIMD_LEVEL SimdLevel::baseline
+
+#include "simd_kernels.inc"
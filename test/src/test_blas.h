@@ -1,6 +1,10 @@
 #ifndef MATRIX_TEST_MATRIX_BLAS_H
 #define MATRIX_TEST_MATRIX_BLAS_H
 
+#include <cmath>
+
+#include <limits>
+
 #include "slab/matrix.h"
 
 namespace slab {
@@ -98,6 +102,102 @@ TEST(BLASL1Test, IAMAX) {
   EXPECT_EQ(1, idx2);
 }
 
+TEST(BLASL1Test, Dispatch) {
+  const std::size_t threshold = blas_threshold();
+  set_blas_threshold(1);  // route every operation that can be routed
+
+  mat a(3, 70), b(3, 70);
+  for (std::size_t i = 0; i != 3; ++i)
+    for (std::size_t j = 0; j != 70; ++j) {
+      a(i, j) = i * 70 + j;
+      b(i, j) = 2.0 * j - i;
+    }
+
+  mat c = 2.0 * a;  // copy & scal
+  mat d = a + b;    // copy & axpy
+  mat e = a - b;
+  mat f = b;
+  f += a * 0.5;  // axpy
+  f -= a;
+  mat g = b;
+  g = a - g;  // the right operand is the destination
+  for (std::size_t i = 0; i != 3; ++i)
+    for (std::size_t j = 0; j != 70; ++j) {
+      EXPECT_EQ(2.0 * a(i, j), c(i, j));
+      EXPECT_EQ(a(i, j) + b(i, j), d(i, j));
+      EXPECT_EQ(a(i, j) - b(i, j), e(i, j));
+      EXPECT_EQ(b(i, j) - 0.5 * a(i, j), f(i, j));
+      EXPECT_EQ(a(i, j) - b(i, j), g(i, j));
+    }
+
+  // strided columns, and rows of a submatrix
+  mat h = a;
+  h.col(3) *= 2.0;
+  h.col(4) += b.col(4);
+  h.submat(1, 0, 2, 68) -= a.submat(0, 1, 1, 69);
+  EXPECT_EQ(2 * a(0, 3), h(0, 3));
+  EXPECT_EQ(2 * a(2, 3) - a(1, 4), h(2, 3));
+  EXPECT_EQ(a(2, 4) + b(2, 4) - a(1, 5), h(2, 4));
+  EXPECT_EQ(a(1, 6) - a(0, 7), h(1, 6));
+  EXPECT_EQ(a(1, 69), h(1, 69));
+  EXPECT_EQ(a(0, 5), h(0, 5));
+
+  // a shifted overlap keeps the result of the native loop
+  vec v = {1, 2, 3, 4, 5};
+  v(slice{1, 4}) += v(slice{0, 4});
+  EXPECT_EQ(vec({1, 3, 6, 10, 15}), v);
+
+  fvec x = {1, 2, 3};
+  x *= 2.0f;
+  EXPECT_EQ(fvec({2, 4, 6}), x);
+
+  cx_vec z = {{1, 1}, {2, -1}};
+  z *= std::complex<double>(0, 1);
+  cx_vec w = z + z;
+  EXPECT_EQ(std::complex<double>(-1, 1), z(0));
+  EXPECT_EQ(std::complex<double>(2, 4), w(1));
+
+  set_blas_threshold(threshold);
+}
+
+TEST(BLASL1Test, DispatchZeroScale) {
+  // above blas_threshold(), 0 * NaN and 0 * Inf stay NaN as in the loops
+  const std::size_t n = 40000;
+  ASSERT_LE(blas_threshold(), n);
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const double inf = std::numeric_limits<double>::infinity();
+  vec x(n);
+  x = 1.0;
+  x(0) = nan;
+  x(1) = inf;
+  x(2) = -inf;
+
+  vec y = x;
+  y *= 0.0;
+  vec z = 0.0 * x;
+  vec w(n);
+  w = 2.0;
+  w += 0.0 * x;
+  vec u(n);
+  u = 2.0;
+  u -= x * 0.0;
+  for (std::size_t i = 0; i != 3; ++i) {
+    EXPECT_TRUE(std::isnan(y(i))) << i;
+    EXPECT_TRUE(std::isnan(z(i))) << i;
+    EXPECT_TRUE(std::isnan(w(i))) << i;
+    EXPECT_TRUE(std::isnan(u(i))) << i;
+  }
+  EXPECT_EQ(0.0, y(n - 1));
+  EXPECT_EQ(0.0, z(n - 1));
+  EXPECT_EQ(2.0, w(n - 1));
+  EXPECT_EQ(2.0, u(n - 1));
+
+  mat m(200, 200);
+  m = inf;
+  m *= 0.0;
+  EXPECT_TRUE(std::isnan(m(7, 6)));
+}
+
 TEST(BLASlevel2Test, GEMV) {
   Matrix<double, 2> a1 = {{8.0, 3.0, 1.0}, {4.0, 5.0, 3.0}, {7.0, 1.0, 2.0}};
 
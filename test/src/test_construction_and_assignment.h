@@ -2,6 +2,7 @@
 #define MATRIX_TEST_CONSTRUCT_AND_ASSIGNMENT_H
 
 #include <array>
+#include <cstdint>
 
 #include <gtest/gtest.h>
 #include "slab/matrix.h"
@@ -176,6 +177,40 @@ TEST(MatrixAssignmentTest, AssignFromMatrixRef) {
   EXPECT_EQ(9, m3sub(1, 1, 1));
 }
 
+TEST(MatrixConstructionTest, ConstructUninitialized) {
+  Matrix<double, 2> m(uninitialized, 3, 4);
+  auto ms = m.descriptor();
+
+  EXPECT_EQ(12, ms.size);
+  EXPECT_EQ(3, ms.extents[0]);
+  EXPECT_EQ(4, ms.extents[1]);
+  EXPECT_EQ(4, ms.strides[0]);
+
+  m = 7;
+  EXPECT_EQ(7, m(2, 3));
+
+  EXPECT_EQ(mat({{0, 0}, {0, 0}}), zeros<mat>(2, 2));
+  EXPECT_EQ(mat({{1, 1}, {1, 1}}), ones<mat>(2, 2));
+  EXPECT_EQ(mat({{1, 0}, {0, 1}}), eye<mat>(2, 2));
+}
+
+TEST(MatrixConstructionTest, ConstructWithAllocator) {
+  Matrix<double, 2, AlignedAllocator<double>> m1(3, 5);
+  EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(m1.data()) % 64);
+  EXPECT_EQ(0, m1(2, 4));
+
+  Matrix<double, 2, MklAllocator<double>> m2 = {{1, 2}, {3, 4}};
+  EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(m2.data()) % 64);
+
+  Matrix<double, 1, HugePageAllocator<double>> m3(std::size_t(1) << 19);
+  EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(m3.data()) % (2 << 20));
+
+  Matrix<double, 2> m4 = m2;  // copy across allocators
+  EXPECT_EQ(m2, m4);
+  EXPECT_EQ(m2, m2 + 0.0);
+  EXPECT_EQ(4, (m2 * m2)(0, 1));
+}
+
 }  // namespace slab
 
 #endif  // MATRIX_TEST_CONSTRUCT_AND_ASSIGNMENT_H
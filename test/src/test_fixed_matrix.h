@@ -0,0 +1,100 @@
+#ifndef MATRIX_TEST_FIXED_MATRIX_H
+#define MATRIX_TEST_FIXED_MATRIX_H
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+template <typename T, std::size_t R, std::size_t C>
+void expect_near(const FixedMatrix<T, R, C> &a, const FixedMatrix<T, R, C> &b,
+                 double tol = 1e-12) {
+  for (std::size_t i = 0; i != R * C; ++i)
+    EXPECT_NEAR(a(i), b(i), tol) << "matrices differ at index " << i;
+}
+
+TEST(FixedMatrixTest, Interoperability) {
+  mat33 a = {{1, 2, 3}, {4, 5, 6}, {7, 8, 10}};
+  EXPECT_EQ(3, a.n_rows());
+  EXPECT_EQ(9, mat33::size());
+  EXPECT_EQ(6, a(1, 2));
+
+  mat m = a;
+  mat m_expected = {{1, 2, 3}, {4, 5, 6}, {7, 8, 10}};
+  EXPECT_EQ(m_expected, m);
+
+  mat22 b(m(slice{1, 2}, slice{0, 2}));
+  mat22 b_expected = {{4, 5}, {7, 8}};
+  EXPECT_EQ(b_expected, b);
+
+  a.ref().row(0) = 0;
+  EXPECT_EQ(0, a(0, 2));
+  EXPECT_EQ(m(2, 2), a(2, 2));
+
+  mat product = matmul(m, m);
+  mat33 fixed_product = matmul(mat33(m), mat33(m));
+  EXPECT_EQ(product, mat(fixed_product));
+}
+
+TEST(FixedMatrixTest, Kernels) {
+  FixedMatrix<double, 2, 3> a = {{1, 2, 3}, {4, 5, 6}};
+  FixedMatrix<double, 3, 2> at = transpose(a);
+  FixedMatrix<double, 3, 2> at_expected = {{1, 4}, {2, 5}, {3, 6}};
+  EXPECT_EQ(at_expected, at);
+  mat22 aat = {{14, 32}, {32, 77}};
+  EXPECT_EQ(aat, matmul(a, at));
+
+  mat22 m2 = {{4, 7}, {2, 6}};
+  mat33 m3 = {{2, -1, 0}, {-1, 2, -1}, {0, -1, 2}};
+  mat44 m4 = {{4, 1, 0, 2}, {1, 5, 1, 0}, {0, 1, 6, 1}, {2, 0, 1, 7}};
+  FixedMatrix<double, 5, 5> m5;
+  for (std::size_t i = 0; i != 5; ++i)
+    for (std::size_t j = 0; j != 5; ++j)
+      m5(i, j) = i == j ? 10 : 1.0 / (1 + i + j);
+
+  EXPECT_DOUBLE_EQ(10, det(m2));
+  EXPECT_DOUBLE_EQ(4, det(m3));
+  // closed form against LU
+  FixedMatrix<double, 4, 4> m4_lu = m4;
+  EXPECT_NEAR((det<double, 4>(m4_lu)), det(m4), 1e-9);
+
+  // the closed forms against the identity
+  mat22 i2 = matmul(m2, inverse(m2));
+  mat33 i3 = matmul(m3, inverse(m3));
+  mat44 i4 = matmul(m4, inverse(m4));
+  FixedMatrix<double, 5, 5> i5 = matmul(m5, inverse(m5));
+  mat22 e2;
+  mat33 e3;
+  mat44 e4;
+  FixedMatrix<double, 5, 5> e5;
+  for (std::size_t i = 0; i != 5; ++i) {
+    if (i < 2) e2(i, i) = 1;
+    if (i < 3) e3(i, i) = 1;
+    if (i < 4) e4(i, i) = 1;
+    e5(i, i) = 1;
+  }
+  expect_near(e2, i2);
+  expect_near(e3, i3);
+  expect_near(e4, i4);
+  expect_near(e5, i5);
+
+  // the closed forms against LAPACK
+  expect_near(mat44(inverse(mat(m4))), inverse(m4));
+
+  // chol: m4 = r^T * r with r upper triangular
+  mat44 r = chol(m4);
+  EXPECT_EQ(0, r(3, 0));
+  expect_near(m4, matmul(transpose(r), r));
+  expect_near(mat44(chol(mat(m4))), r);
+
+  // solve
+  vec4 b = {{1}, {2}, {3}, {4}};
+  vec4 x = solve(m4, b);
+  expect_near(b, matmul(m4, x));
+}
+
+}  // namespace slab
+
+#endif  // MATRIX_TEST_FIXED_MATRIX_H
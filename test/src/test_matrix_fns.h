@@ -1,6 +1,10 @@
 #ifndef STATSLABS_MATRIX_TEST_MATRIX_FNS_H_
 #define STATSLABS_MATRIX_TEST_MATRIX_FNS_H_
 
+#include <cmath>
+
+#include <limits>
+
 #include "slab/matrix.h"
 
 namespace slab {
@@ -23,6 +27,398 @@ TEST(MatrixFunctions, Sum) {
   EXPECT_EQ(m_sum_ans, sum(m));
 }
 
+TEST(MatrixFunctions, Reductions) {
+  mat m = {{1, 2, 3}, {4, 5, 6}};
+  EXPECT_EQ(vec({6, 15}), sum(m, 1));
+  EXPECT_EQ(vec({2.5, 3.5, 4.5}), mean(m));
+  EXPECT_EQ(vec({2, 5}), mean(m, 1));
+  EXPECT_EQ(vec({1, 2, 3}), min(m));
+  EXPECT_EQ(vec({3, 6}), max(m, 1));
+  EXPECT_EQ(vec({4.5, 4.5, 4.5}), var(m));
+  EXPECT_EQ(vec({1, 1}), stddev(m, 1));
+  EXPECT_EQ(vec({6, 120}), prod(m, 1));
+  EXPECT_EQ(21, sum(vectorise_view(m)));
+  EXPECT_EQ(vec({5, 11}), sum(m.cols(1, 2), 1));
+  EXPECT_EQ(4.5, mean(m.col(2)));
+
+  Matrix<int, 1> v = {3, -1, 4, 1, 5};
+  EXPECT_EQ(-1, min(v));
+  EXPECT_EQ(5, max(v));
+  EXPECT_DOUBLE_EQ(2.4, mean(v));
+  EXPECT_DOUBLE_EQ(5.8, var(v));
+
+  // infinite terms and overflowing sums stay infinite, not NaN
+  const double inf = std::numeric_limits<double>::infinity();
+  EXPECT_EQ(inf, sum(vec{1, inf, 2}));
+  EXPECT_EQ(-inf, sum(vec{1, -inf, 2}));
+  EXPECT_EQ(inf, sum(vec{1e308, 1e308}));
+  EXPECT_EQ(-inf, sum(vec{-1e308, -1e308, 1}));
+  EXPECT_TRUE(std::isnan(sum(vec{inf, -inf})));
+  EXPECT_EQ(inf, mean(vec{1, inf, 2}));
+  EXPECT_EQ(-inf, mean(vec{-1e308, -1e308}));
+  mat mi = {{1, inf}, {2, 3}};
+  EXPECT_EQ(vec({3, inf}), sum(mi));
+  EXPECT_EQ(vec({inf, 5}), sum(mi, 1));
+  EXPECT_EQ(vec({1.5, inf}), mean(mi, 0));
+  mat mo = {{1e308, -inf}, {1e308, 1}};
+  EXPECT_EQ(vec({inf, -inf}), sum(mo, 0));
+  EXPECT_EQ(vec({-inf, 1e308}), sum(mo, 1));
+  Matrix<float, 1> fo(300000);
+  fo = 1e34f;  // overflows float, in every thread
+  EXPECT_EQ(std::numeric_limits<float>::infinity(), sum(fo));
+  EXPECT_EQ(std::numeric_limits<float>::infinity(), mean(fo));
+
+  // along every dimension of a Matrix<T, 3>, also through a strided view
+  Matrix<double, 3> c(3, 4, 5);
+  for (std::size_t i = 0; i != c.size(); ++i) c.data()[i] = double(i % 11);
+  auto cv = c(slice{0, 3}, slice{1, 3}, slice{0, 3, 2});
+  mat s0(4, 5), s1(3, 5), s2(3, 4), v0(3, 3);
+  for (std::size_t i = 0; i != 3; ++i)
+    for (std::size_t j = 0; j != 4; ++j)
+      for (std::size_t k = 0; k != 5; ++k) {
+        s0(j, k) += c(i, j, k);
+        s1(i, k) += c(i, j, k);
+        s2(i, j) += c(i, j, k);
+      }
+  for (std::size_t i = 0; i != 3; ++i)
+    for (std::size_t j = 0; j != 3; ++j)
+      for (std::size_t k = 0; k != 3; ++k) v0(j, k) += cv(i, j, k) / 3;
+  EXPECT_EQ(s0, sum(c, 0));
+  EXPECT_EQ(s1, sum(c, 1));
+  EXPECT_EQ(s2, sum(c, 2));
+  EXPECT_EQ(s2 / 5.0, mean(c, 2));
+  const mat m0 = mean(cv, 0);
+  for (std::size_t i = 0; i != v0.size(); ++i)
+    EXPECT_DOUBLE_EQ(v0.data()[i], m0.data()[i]);
+  EXPECT_DOUBLE_EQ(sum(vectorise_view(s0)), sum(c));
+  EXPECT_DOUBLE_EQ(sum(vectorise(cv)), sum(cv));
+
+  // compensated sums of floats, on several threads
+  const std::size_t nt = num_threads();
+  set_num_threads(4);
+  Matrix<float, 2> f(1000, 400);
+  f = 0.1f;
+  EXPECT_NEAR(40000.0, sum(vectorise_view(f)), 40000.0 * 1e-6);
+  for (float x : sum(f, 1)) EXPECT_NEAR(40.0, x, 40.0 * 1e-6);
+  for (float x : sum(f, 0)) EXPECT_NEAR(100.0, x, 100.0 * 1e-6);
+  EXPECT_NEAR(0.0, max(var(f)), 1e-9);
+  set_num_threads(nt);
+}
+
+// distance of a from b in units in the last place of b, 0 for equal
+// specials
+template <typename T>
+double ulp_distance(T a, T b) {
+  if (std::isnan(b)) return std::isnan(a) ? 0 : 1e30;
+  if (std::isinf(b)) return a == b ? 0 : 1e30;
+  if (b == 0) return a == 0 && std::signbit(a) == std::signbit(b) ? 0 : 1e30;
+  const T u = std::nextafter(std::abs(b), std::numeric_limits<T>::infinity()) -
+              std::abs(b);
+  return double(std::abs(a - b) / u);
+}
+
+// f(x) against the std:: function g, element by element
+template <typename T, typename F, typename G>
+void expect_elementwise(const Matrix<T, 1> &x, F f, G g, double max_ulps) {
+  const Matrix<T, 1> y = f(x);
+  ASSERT_EQ(x.size(), y.size());
+  for (std::size_t i = 0; i != x.size(); ++i)
+    EXPECT_LE(ulp_distance(y(i), T(g(x(i)))), max_ulps) << "x = " << x(i);
+}
+
+template <typename T>
+void expect_elementwise_math(double max_ulps) {
+  using M = Matrix<T, 1>;
+  const T inf = std::numeric_limits<T>::infinity();
+  const T nan = std::numeric_limits<T>::quiet_NaN();
+  const T denorm = std::numeric_limits<T>::denorm_min();
+  M x(uninitialized, 4001);
+  for (std::size_t i = 0; i != x.size(); ++i) x(i) = T(-100 + 0.05 * i);
+  M specials = {0, T(-0.0), inf, -inf, nan, denorm, -denorm, -1, 1, 1e-20};
+
+  for (const M &a : {x, specials}) {
+    expect_elementwise(a, [](const M &m) { return exp(m); },
+                       [](T v) { return std::exp(v); }, max_ulps);
+    expect_elementwise(a, [](const M &m) { return expm1(m); },
+                       [](T v) { return std::expm1(v); }, max_ulps);
+    expect_elementwise(a, [](const M &m) { return log(m); },
+                       [](T v) { return std::log(v); }, max_ulps);
+    expect_elementwise(a, [](const M &m) { return log1p(m); },
+                       [](T v) { return std::log1p(v); }, max_ulps);
+    expect_elementwise(a, [](const M &m) { return sin(m); },
+                       [](T v) { return std::sin(v); }, max_ulps);
+    expect_elementwise(a, [](const M &m) { return cos(m); },
+                       [](T v) { return std::cos(v); }, max_ulps);
+    expect_elementwise(a, [](const M &m) { return tan(m); },
+                       [](T v) { return std::tan(v); }, 2 * max_ulps);
+    expect_elementwise(a, [](const M &m) { return tanh(m); },
+                       [](T v) { return std::tanh(v); }, max_ulps);
+    expect_elementwise(a, [](const M &m) { return sqrt(m); },
+                       [](T v) { return std::sqrt(v); }, 0);
+    expect_elementwise(a, [](const M &m) { return erf(m); },
+                       [](T v) { return std::erf(v); }, 0);
+    expect_elementwise(a, [](const M &m) { return lgamma(m); },
+                       [](T v) { return std::lgamma(v); }, 0);
+    expect_elementwise(a, [](const M &m) { return pow(m, 2); },
+                       [](T v) { return v * v; }, 0);
+    expect_elementwise(a, [](const M &m) { return pow(m, 1.5); },
+                       [](T v) { return std::pow(v, T(1.5)); }, 0);
+    // the square root, within the error of std::pow, and in place
+    expect_elementwise(a, [](const M &m) { return pow(m, 0.5); },
+                       [](T v) { return std::pow(v, T(0.5)); }, 1);
+    expect_elementwise(a, [](const M &m) { return pow(M(m), 0.5); },
+                       [](T v) { return std::pow(v, T(0.5)); }, 1);
+  }
+
+  // the large arguments of sin, cos and tan are reduced by the std::
+  // functions
+  const M big = {T(1e6), T(-3e7), T(1e20)};
+  EXPECT_EQ(std::sin(big(0)), sin(big)(0));
+  EXPECT_EQ(std::cos(big(1)), cos(big)(1));
+  EXPECT_EQ(std::tan(big(2)), tan(big)(2));
+}
+
+TEST(MatrixFunctions, ElementwiseMath) {
+  expect_elementwise_math<double>(4);
+  expect_elementwise_math<float>(1);
+
+  mat m(3, 4);
+  for (std::size_t i = 0; i != m.size(); ++i) m.data()[i] = 0.25 * i;
+  const mat e = exp(m);
+  EXPECT_DOUBLE_EQ(std::exp(2.75), e(2, 3));
+
+  // views, temporaries and expressions
+  EXPECT_EQ(vec(e.col(1)), exp(m.col(1)));
+  EXPECT_EQ(vec(e.row(2)), exp(m.row(2)));
+  EXPECT_EQ(e, exp(mat(m)));
+  EXPECT_EQ(e, exp(m * 1.0));
+  mat c = m;
+  mat d = log(std::move(c));
+  EXPECT_DOUBLE_EQ(std::log(0.25), d(0, 1));
+
+  // into a matrix, resized if need be, or into a view of the same extents
+  mat out;
+  exp_into(m, out);
+  EXPECT_EQ(e, out);
+  exp_into(m.col(1), out.col(2));
+  EXPECT_EQ(vec(e.col(1)), vec(out.col(2)));
+  sqrt_into(m, m);
+  EXPECT_DOUBLE_EQ(std::sqrt(2.75), m(2, 3));
+  pow_into(m, 2, out);
+  EXPECT_DOUBLE_EQ(2.75, out(2, 3));
+  Matrix<int, 1> iv = {4, 9, -2};
+  EXPECT_EQ((Matrix<int, 1>{1, 1, 1}), pow(iv, 0));
+  EXPECT_EQ((Matrix<int, 1>{16, 81, 4}), pow(iv, 2));
+
+  // other element types go through the std:: functions
+  cx_vec z = {{0, 1}, {1, 1}};
+  EXPECT_EQ(std::exp(std::complex<double>(1, 1)), exp(z)(1));
+
+  // the same results on several threads
+  const std::size_t nt = num_threads();
+  vec x(uninitialized, std::size_t(1) << 16);
+  for (std::size_t i = 0; i != x.size(); ++i) x(i) = 1e-3 * i;
+  set_num_threads(1);
+  const vec serial = sin(x);
+  set_num_threads(4);
+  EXPECT_EQ(serial, sin(x));
+  set_num_threads(nt);
+}
+
+TEST(MatrixFunctions, Reshape) {
+  mat m = {{1, 2, 3}, {4, 5, 6}};
+
+  EXPECT_EQ(mat({{1, 2}, {3, 4}, {5, 6}}), reshape(m, 3, 2));
+  EXPECT_EQ(vec({1, 2, 3, 4, 5, 6}), vectorise(m));
+
+  // views share the elements of m
+  MatrixRef<double, 2> r = reshape_view(m, 3, 2);
+  EXPECT_EQ(mat({{1, 2}, {3, 4}, {5, 6}}), mat(r));
+  r(2, 0) = 50;
+  EXPECT_EQ(50, m(1, 1));
+  MatrixRef<double, 1> v = vectorise_view(m);
+  EXPECT_EQ(6, v.size());
+  v(0) = 10;
+  EXPECT_EQ(10, m(0, 0));
+  const mat &cm = m;
+  EXPECT_EQ(cm.data(), vectorise_view(cm).data());
+  vectorise_view(m.row(0))(0) = 1;
+  EXPECT_EQ(1, m(0, 0));
+
+  // a contiguous slice is viewed, a column block is copied
+  Matrix<double, 3> c(2, 2, 3);
+  for (std::size_t i = 0; i != c.size(); ++i) c.data()[i] = double(i);
+  MatrixRef<double, 2> c1 = c[1];
+  EXPECT_EQ(c.data() + 6, vectorise_view(c1).data() +
+                               vectorise_view(c1).descriptor().start);
+  EXPECT_EQ(vec({6, 7, 8, 9, 10, 11}), vec(vectorise_view(c1)));
+  EXPECT_EQ(mat({{2, 3, 50, 6}}), reshape(m.cols(1, 2), 1, 4));
+  EXPECT_EQ(vec({2, 3, 50, 6}), vectorise(cm.cols(1, 2)));
+
+  mat n = {{1, 2, 3}, {4, 5, 6}};
+  const double *p = n.data();
+  n.reshape(3, 2);
+  EXPECT_EQ(p, n.data());
+  EXPECT_EQ(3, n.n_rows());
+  EXPECT_EQ(mat({{1, 2}, {3, 4}, {5, 6}}), n);
+}
+
+namespace {
+
+// kron(a, b) by its definition
+template <typename T>
+Matrix<T, 2> naive_kron(const Matrix<T, 2> &a, const Matrix<T, 2> &b) {
+  const std::size_t p = b.n_rows(), q = b.n_cols();
+  Matrix<T, 2> res(a.n_rows() * p, a.n_cols() * q);
+  for (std::size_t i = 0; i != res.n_rows(); ++i)
+    for (std::size_t j = 0; j != res.n_cols(); ++j)
+      res(i, j) = a(i / p, j / q) * b(i % p, j % q);
+  return res;
+}
+
+// whether a and b agree to within tol, element by element
+template <typename T, std::size_t N>
+void expect_close(const Matrix<T, N> &a, const Matrix<T, N> &b,
+                  double tol = 1e-9) {
+  ASSERT_EQ(a.descriptor().extents, b.descriptor().extents);
+  for (std::size_t i = 0; i != a.size(); ++i)
+    EXPECT_NEAR(a.data()[i], b.data()[i], tol) << "differ at index " << i;
+}
+
+}  // namespace
+
+TEST(MatrixFunctions, Kron) {
+  mat a = {{1, 2}, {3, 4}};
+  mat b = {{0, 5}, {6, 7}};
+  EXPECT_EQ(mat({{0, 5, 0, 10},
+                 {6, 7, 12, 14},
+                 {0, 15, 0, 20},
+                 {18, 21, 24, 28}}),
+            kron(a, b));
+  EXPECT_EQ(vec({3, 4, 6, 8}), kron(vec({1, 2}), vec({3, 4})));
+
+  // rows long enough for the SIMD kernels, split over threads
+  const std::size_t nt = num_threads();
+  set_num_threads(3);
+  mat c(64, 48), d(9, 40);
+  for (std::size_t i = 0; i != c.size(); ++i) c.data()[i] = double(i % 11);
+  for (std::size_t i = 0; i != d.size(); ++i) d.data()[i] = double(i % 13);
+  const mat expect = naive_kron(c, d);
+  EXPECT_EQ(expect, kron(c, d));
+  mat out(3, 3);
+  kron_into(c, d, out);
+  EXPECT_EQ(expect, out);
+  kron_add(c, d, out);
+  EXPECT_EQ(2.0 * expect, out);
+  set_num_threads(nt);
+
+  // views: a column block, a transpose (strided rows), and strided outputs
+  auto cv = c.cols(1, 3);
+  EXPECT_EQ(naive_kron(mat(cv), mat(d.t())), kron(cv, d.t()));
+  const mat &cc = c;
+  EXPECT_EQ(naive_kron(mat(cc.rows(0, 1)), b), kron(cc.rows(0, 1), b));
+  mat t(8, 4);
+  kron_into(a, b, t(slice{0, 4, 2}, slice{0, 4}).t());
+  EXPECT_EQ(mat(kron(a, b).t()), mat(t(slice{0, 4, 2}, slice{0, 4})));
+  kron_add(a, b, t(slice{0, 4, 2}, slice{0, 4}).t());
+  EXPECT_EQ(mat(2.0 * kron(a, b).t()), mat(t(slice{0, 4, 2}, slice{0, 4})));
+  EXPECT_EQ(0, t(1, 0));
+
+  vec x = {1, 2, 3, 4, 5, 6};
+  vec y(6);
+  kron_into(x(slice{0, 3, 2}), vec({1, -1}), y);
+  EXPECT_EQ(vec({1, -1, 3, -3, 5, -5}), y);
+  kron_add(vec({1, 1}), x(slice{0, 3}), y);
+  EXPECT_EQ(vec({2, 1, 6, -2, 7, -2}), y);
+
+  Matrix<int, 2> ia = {{1, -1}}, ib = {{2}, {3}};
+  EXPECT_EQ((Matrix<int, 2>{{2, -2}, {3, -3}}), kron(ia, ib));
+
+  // an output that is, or overlaps, an operand
+  mat s = {{2}};
+  mat r = a;
+  kron_into(r, b, r);  // resized
+  EXPECT_EQ(kron(a, b), r);
+  r = b;
+  kron_into(a, r, r);
+  EXPECT_EQ(kron(a, b), r);
+  r = a;
+  kron_into(r, s, r);  // the same extents
+  EXPECT_EQ(2.0 * a, r);
+  kron_add(s, r, r);
+  EXPECT_EQ(6.0 * a, r);
+  mat w(4, 4);
+  w = 1;
+  w(slice{0, 2}, slice{0, 2}) = a;
+  kron_into(w(slice{0, 2}, slice{0, 2}), b, w);
+  EXPECT_EQ(kron(a, b), w);
+  w = 1;
+  w(slice{2, 2}, slice{2, 2}) = a;
+  kron_add(vec{1}, w.row(3), w.row(3));
+  EXPECT_EQ(vec({2, 2, 6, 8}), vec(w.row(3)));
+  w(slice{0, 2}, slice{0, 2}) = b;
+  kron_into(s, w(slice{0, 2}, slice{0, 2}), w(slice{1, 2}, slice{1, 2}));
+  EXPECT_EQ(mat({{0, 10}, {12, 14}}), mat(w(slice{1, 2}, slice{1, 2})));
+}
+
+TEST(MatrixFunctions, KronMatrix) {
+  // products, in both orders of the two gemms
+  mat a(3, 4), b(5, 2);
+  for (std::size_t i = 0; i != a.size(); ++i) a.data()[i] = double(i % 7) - 3;
+  for (std::size_t i = 0; i != b.size(); ++i) b.data()[i] = double(i % 5) + 1;
+  for (const KronMatrix<double> &k :
+       {KronMatrix<double>(a, b), KronMatrix<double>(b, a)}) {
+    const mat dense = naive_kron(k.a(), k.b());
+    EXPECT_EQ(dense, k.dense());
+    EXPECT_EQ(dense.n_rows(), k.n_rows());
+    EXPECT_EQ(dense.n_cols(), k.n_cols());
+    vec x(k.n_cols());
+    mat xs(k.n_cols(), 3);
+    for (std::size_t i = 0; i != x.size(); ++i) x(i) = double(i % 4) - 1.5;
+    for (std::size_t i = 0; i != xs.size(); ++i) xs.data()[i] = double(i % 9);
+    expect_close(matmul(dense, x), matmul(k, x));
+    expect_close(matmul(dense, xs), matmul(k, xs));
+  }
+
+  // symmetric positive definite factors, by Cholesky: det 18 and 3
+  const KronMatrix<double> spd(mat{{4, 1, 0}, {1, 3, 1}, {0, 1, 2}},
+                               mat{{2, -1}, {-1, 2}});
+  EXPECT_TRUE(spd.factors().a.chol && spd.factors().b.chol);
+  EXPECT_NEAR(18.0 * 18.0 * 27.0, det(spd), 1e-6);
+  EXPECT_NEAR(std::log(18.0 * 18.0 * 27.0), log_det(spd), 1e-9);
+
+  // general factors, by LU: det -2 and -21
+  const KronMatrix<double> lu(mat{{0, 2}, {1, 1}},
+                              mat{{1, 2, 0}, {3, 1, 1}, {0, 1, 4}});
+  EXPECT_FALSE(lu.factors().a.chol || lu.factors().b.chol);
+  EXPECT_NEAR(-8.0 * 441.0, det(lu), 1e-6);
+
+  // symmetric but indefinite, by LU after Cholesky fails: det -3 and 3
+  const KronMatrix<double> ind(mat{{1, 2}, {2, 1}}, mat{{2, -1}, {-1, 2}});
+  EXPECT_FALSE(ind.factors().a.chol);
+  EXPECT_NEAR(81.0, det(ind), 1e-9);
+
+  for (const KronMatrix<double> &k : {spd, lu, ind}) {
+    const mat dense = k.dense();
+    vec y(k.n_rows());
+    mat ys(k.n_rows(), 2);
+    for (std::size_t i = 0; i != y.size(); ++i) y(i) = double(i) - 2;
+    for (std::size_t i = 0; i != ys.size(); ++i) ys.data()[i] = double(i % 5);
+    expect_close(y, matmul(dense, solve(k, y)));
+    expect_close(ys, matmul(dense, solve(k, ys)));
+
+    mat id(k.n_rows(), k.n_rows());
+    for (std::size_t i = 0; i != id.n_rows(); ++i) id(i, i) = 1;
+    expect_close(id, matmul(inverse(k).dense(), dense));
+  }
+
+  Matrix<float, 2> fa = {{2, 1}, {1, 2}}, fb = {{3}};
+  const KronMatrix<float> fk(fa, fb);
+  EXPECT_NEAR(27.0f, det(fk), 1e-4f);
+  const Matrix<float, 1> fy = {3, 0};
+  expect_close(fy, matmul(fk, solve(fk, fy)), 1e-5);
+}
+
 }  // namespace slab
 
 #endif  // STATSLABS_MATRIX_TEST_MATRIX_FNS_H_
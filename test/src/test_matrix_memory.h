@@ -0,0 +1,327 @@
+#ifndef MATRIX_TEST_MATRIX_MEMORY_H
+#define MATRIX_TEST_MATRIX_MEMORY_H
+
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+TEST(MatrixMemoryTest, ArenaScope) {
+  // large enough not to be stored inline
+  Matrix<double, 2> a = {{1, 2, 3, 4, 5}, {6, 7, 8, 9, 10}, {1, 1, 1, 1, 1},
+                         {2, 2, 2, 2, 2}, {3, 0, 3, 0, 3}};
+  Matrix<double, 2> b = transpose(a);
+  Matrix<double, 2> res(5, 5);
+
+  const std::size_t used = ArenaScope::stats().bytes_in_use;
+  const std::size_t allocs = ArenaScope::stats().num_allocations;
+  {
+    ArenaScope scope;
+    Matrix<double, 2> c = a + b * 2.0 - a;
+    EXPECT_TRUE(matrix_impl::thread_arena().owns(c.data()));
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(c.data()) % 64);
+    EXPECT_LT(allocs, ArenaScope::stats().num_allocations);
+    EXPECT_LT(used, ArenaScope::stats().bytes_in_use);
+
+    {
+      ArenaScope inner;
+      Matrix<double, 2> d = matmul(c, c);
+      EXPECT_TRUE(matrix_impl::thread_arena().owns(d.data()));
+      res += d;
+    }
+    const std::size_t outer_used = ArenaScope::stats().bytes_in_use;
+    EXPECT_LE(outer_used, ArenaScope::stats().high_water_mark);
+
+    res += c;
+  }
+  EXPECT_EQ(used, ArenaScope::stats().bytes_in_use);
+  EXPECT_LE(ArenaScope::stats().bytes_in_use,
+            ArenaScope::stats().high_water_mark);
+
+  Matrix<double, 2> cc = b * 2.0;
+  Matrix<double, 2> expected = matmul(cc, cc) + cc;
+  EXPECT_EQ(expected, res);
+
+  // outside of any scope the heap is used again
+  Matrix<double, 2> e = a + b;
+  EXPECT_FALSE(matrix_impl::thread_arena().owns(e.data()));
+
+  ArenaScope::release();
+  EXPECT_EQ(0, ArenaScope::stats().capacity);
+}
+
+TEST(MatrixMemoryTest, InlineStorage) {
+  static_assert(matrix_impl::inline_size == SLAB_MATRIX_INLINE_SIZE, "");
+
+  Matrix<double, 2> a = {{1, 2}, {3, 4}};
+  const double *pa = a.data();
+  if (matrix_impl::inline_size >= 4) {
+    EXPECT_TRUE(pa >= reinterpret_cast<const double *>(&a) &&
+                pa < reinterpret_cast<const double *>(&a + 1));
+  }
+
+  // moves copy inline elements and steal heap buffers
+  Matrix<double, 2> b = std::move(a);
+  Matrix<double, 2> expected = {{1, 2}, {3, 4}};
+  EXPECT_EQ(expected, b);
+  if (matrix_impl::inline_size >= 4) {
+    EXPECT_NE(pa, b.data());
+  }
+
+  Matrix<double, 2> big(10, 10);
+  big = 1;
+  const double *pbig = big.data();
+  Matrix<double, 2> c = std::move(big);
+  EXPECT_EQ(pbig, c.data());
+  EXPECT_EQ(100, c.size());
+
+  // an inline matrix grows onto the heap when needed
+  b = c;
+  EXPECT_EQ(c, b);
+  b = expected;
+  EXPECT_EQ(expected, b);
+
+  // data() can be handed to BLAS
+  Matrix<double, 2> d = matmul(b, b);
+  Matrix<double, 2> d_expected = {{7, 10}, {15, 22}};
+  EXPECT_EQ(d_expected, d);
+  Matrix<double, 1> v = {1, 1, 1};
+  EXPECT_EQ(3, blas_dot(v, v));
+
+  // custom allocators always get their own storage
+  Matrix<double, 2, AlignedAllocator<double>> e(2, 2);
+  EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(e.data()) % 64);
+}
+
+TEST(MatrixMemoryTest, MappedMatrix) {
+  const std::string path = ::testing::TempDir() + "slab_mapped_matrix.bin";
+  std::remove(path.c_str());
+
+  mat a = {{1, 2, 3}, {4, 5, 6}};
+  {
+    MappedMatrix<double, 2> m(path, map_mode::read_write, 2, 3);
+    EXPECT_EQ(6, m.size());
+    m = a;
+    m.sync();
+  }
+
+  {
+    MappedMatrix<double, 2> m(path, map_mode::read_only, 2, 3);
+    m.advise(map_advice::sequential);
+    EXPECT_EQ(a, m);
+    EXPECT_EQ(5, m(1, 1));
+
+    // slicing, arithmetic and BLAS work as on any MatrixRef
+    mat cols_expected = {{2, 3}, {5, 6}};
+    EXPECT_EQ(cols_expected, mat(m.cols(1, 2)));
+    mat sub_expected = {{5, 6}};
+    EXPECT_EQ(sub_expected, mat(m.submat(1, 1, 1, 2)));
+    EXPECT_EQ(a + a, m + m);
+    mat mtm(3, 3);
+    blas_gemm(CblasTrans, CblasNoTrans, 1.0, m, m, 0.0, mtm);
+    EXPECT_EQ(matmul(transpose(a), a), mtm);
+    EXPECT_EQ(14, blas_dot(m.row(0), m.row(0)));
+  }
+
+  {
+    // copy_on_write: changes stay in memory
+    MappedMatrix<double, 2> m(path, map_mode::copy_on_write, 2, 3);
+    m(0, 0) = 100;
+    EXPECT_EQ(100, m(0, 0));
+  }
+
+  {
+    // grow the file by a row, then move the matrix
+    MappedMatrix<double, 2> m(path, map_mode::read_write, 2, 3);
+    EXPECT_EQ(1, m(0, 0));
+    m.resize(3, 3);
+    m.row(2) = 7;
+    MappedMatrix<double, 2> moved(std::move(m));
+    EXPECT_EQ(0, m.size());
+    mat grown = {{1, 2, 3}, {4, 5, 6}, {7, 7, 7}};
+    EXPECT_EQ(grown, moved);
+  }
+
+  MappedMatrix<double, 1> v(path, map_mode::read_only, 9);
+  EXPECT_EQ(7, v(8));
+  std::remove(path.c_str());
+}
+
+TEST(MatrixMemoryTest, FirstTouch) {
+  // block_range covers [0, n) with contiguous, balanced blocks
+  std::size_t first, last, covered = 0;
+  for (std::size_t t = 0; t != 3; ++t) {
+    matrix_impl::block_range(10, 3, t, first, last);
+    EXPECT_EQ(covered, first);
+    EXPECT_LE(last - first, 4u);
+    covered = last;
+  }
+  EXPECT_EQ(10, covered);
+
+  const std::size_t saved_threads = num_threads();
+  set_num_threads(4);
+  std::vector<int> hits(103, 0);
+  matrix_impl::parallel_for(
+      hits.size(), [&](std::size_t first, std::size_t last, std::size_t) {
+        for (std::size_t i = first; i != last; ++i) ++hits[i];
+      });
+  EXPECT_EQ(std::vector<int>(103, 1), hits);
+
+  for (first_touch policy :
+       {first_touch::row_blocks, first_touch::interleave}) {
+    set_first_touch(policy, 0);
+    EXPECT_EQ(policy, get_first_touch());
+
+    mat a(1000, 37);
+    EXPECT_EQ(0, *std::max_element(a.begin(), a.end()));
+    mat o = ones<mat>(1000, 37);
+    EXPECT_EQ(1000 * 37, std::accumulate(o.begin(), o.end(), 0.0));
+    mat e = eye<mat>(300, 300);
+    EXPECT_EQ(300, std::accumulate(e.begin(), e.end(), 0.0));
+    EXPECT_EQ(1, e(299, 299));
+    EXPECT_EQ(0, e(299, 298));
+    Matrix<float, 3> z = zeros<Matrix<float, 3>>(7, 100, 51);
+    EXPECT_EQ(0, *std::max_element(z.begin(), z.end()));
+  }
+
+  set_first_touch(first_touch::serial);
+  set_num_threads(saved_threads);
+}
+
+TEST(MatrixMemoryTest, CopyOnWrite) {
+  CowMatrix<double, 2> a = {{1, 2, 3}, {4, 5, 6}};
+  const CowMatrix<double, 2> &ca = a;
+
+  // copies share the elements while they are read
+  const CowMatrix<double, 2> b = a;
+  CowMatrix<double, 2> c = b;
+  const CowMatrix<double, 2> &cc = c;
+  EXPECT_EQ(ca.data(), b.data());
+  EXPECT_EQ(ca.data(), cc.data());
+  EXPECT_EQ(6, b(1, 2));
+  EXPECT_EQ(b, c);
+  EXPECT_EQ(ca.data(), cc.data());
+
+  // the first write clones
+  c(0, 0) = 100;
+  EXPECT_NE(ca.data(), cc.data());
+  EXPECT_EQ(1, a(0, 0));
+  EXPECT_EQ(100, c(0, 0));
+  const double *p = cc.data();
+  c(0, 1) = 200;  // c owns its elements now
+  EXPECT_EQ(p, cc.data());
+
+  // writes through slices, iterators and the operators
+  CowMatrix<double, 2> d = a;
+  d.row(1) = 0;
+  EXPECT_EQ(5, a(1, 1));
+  EXPECT_EQ(0, d(1, 1));
+  CowMatrix<double, 2> e = a;
+  for (auto &x : e) x = -x;
+  EXPECT_EQ(-4, e(1, 0));
+  EXPECT_EQ(4, a(1, 0));
+  CowMatrix<double, 2> f = a * 2.0;
+  EXPECT_EQ(12, f(1, 2));
+  EXPECT_EQ(6, a(1, 2));
+  f += a;
+  EXPECT_EQ(18, f(1, 2));
+
+  // assignment shares again, reassignment does not touch the old owners
+  f = a;
+  const CowMatrix<double, 2> &cf = f;
+  EXPECT_EQ(ca.data(), cf.data());
+  f = {{7, 8}, {9, 10}};
+  EXPECT_EQ(1, a(0, 0));
+  EXPECT_EQ(10, f(1, 1));
+
+  // conversions to and from the default storage copy the elements
+  mat m = a;
+  CowMatrix<double, 2> g = m;
+  EXPECT_EQ(a, m);
+  EXPECT_EQ(m, g);
+}
+
+TEST(MatrixMemoryTest, Instrumentation) {
+  mat a(30, 30), b(30, 30);
+  instrument_reset();
+
+  mat c = a + b;
+  mat j = join_rows(a, b);
+  auto r = a.row(0);
+  mat d = r;
+
+  if (!instrument_enabled) {
+    EXPECT_EQ(0, instrument_totals().matrices);
+    EXPECT_EQ(0, instrument_stats("operator+").copies);
+    return;
+  }
+
+  const std::size_t bytes = 30 * 30 * sizeof(double);
+  InstrumentStats plus = instrument_stats("operator+");
+  EXPECT_EQ(0, plus.allocations);  // a + b is evaluated into c directly
+
+  InstrumentStats join = instrument_stats("join_rows");
+  EXPECT_EQ(0, join.copies);
+  EXPECT_EQ(2 * bytes, join.bytes);
+  EXPECT_GE(join.peak_bytes, 3 * bytes);
+
+  // done outside the API functions
+  InstrumentStats user = instrument_stats("(user)");
+  EXPECT_EQ(1, user.copies);  // d = r
+  EXPECT_EQ(2, user.allocations);  // c and d
+  EXPECT_EQ(bytes + 30 * sizeof(double), user.bytes);
+  EXPECT_LE(1u, user.refs);
+
+  InstrumentStats total = instrument_totals();
+  EXPECT_EQ(1, total.copies);
+  EXPECT_EQ(join.bytes + user.bytes, total.bytes);
+
+  std::ostringstream os;
+  instrument_dump(os);
+  EXPECT_NE(std::string::npos, os.str().find("join_rows"));
+}
+
+TEST(MatrixMemoryTest, ReuseTemporaries) {
+  mat a(30, 30), b(30, 30);
+  a.apply([](double &x) { x = 0.5; });
+  b.apply([](double &x) { x = 0.25; });
+  instrument_reset();
+
+  // the result takes over the elements of the temporary operand
+  mat c = matmul(a, b) + a;
+  EXPECT_DOUBLE_EQ(15 * 0.25 + 0.5, c(3, 4));
+  const double *p = c.data();
+  mat d = std::move(c) * 2.0 - b;
+  EXPECT_EQ(p, d.data());
+  EXPECT_DOUBLE_EQ(2 * (15 * 0.25 + 0.5) - 0.25, d(0, 0));
+
+  mat e = exp(std::move(d));
+  EXPECT_EQ(p, e.data());
+  EXPECT_DOUBLE_EQ(std::exp(2 * (15 * 0.25 + 0.5) - 0.25), e(29, 29));
+  mat f = sin(a + b);
+  EXPECT_DOUBLE_EQ(std::sin(0.75), f(1, 2));
+  mat g = pow(a * 1.0 + matmul(a, b), 2);
+  EXPECT_DOUBLE_EQ(std::pow(0.5 + 15 * 0.25, 2), g(0, 1));
+
+  if (!instrument_enabled) return;
+
+  // only the products and sin(a + b) allocate
+  EXPECT_EQ(2, instrument_stats("matmul").allocations);
+  EXPECT_EQ(0, instrument_stats("(user)").allocations);
+  EXPECT_EQ(0, instrument_stats("exp").allocations);
+  EXPECT_EQ(1, instrument_stats("sin").allocations);
+  EXPECT_EQ(0, instrument_stats("pow").allocations);
+}
+
+}  // namespace slab
+
+#endif  // MATRIX_TEST_MATRIX_MEMORY_H
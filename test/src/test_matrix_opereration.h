@@ -40,6 +40,56 @@ TEST(MatrixOperationTest, Transpose_Mat) {
   EXPECT_EQ(9, m2(2, 2));
 }
 
+template <typename T>
+Matrix<T, 2> naive_transpose(const Matrix<T, 2> &a) {
+  Matrix<T, 2> res(a.n_cols(), a.n_rows());
+  for (std::size_t i = 0; i != a.n_rows(); ++i)
+    for (std::size_t j = 0; j != a.n_cols(); ++j) res(j, i) = a(i, j);
+  return res;
+}
+
+template <typename T>
+void expect_transposes(std::size_t m, std::size_t n) {
+  Matrix<T, 2> a(m, n);
+  for (std::size_t i = 0; i != a.size(); ++i) a.data()[i] = T(i % 1000);
+  const Matrix<T, 2> at = naive_transpose(a);
+
+  EXPECT_EQ(at, transpose(a));
+  EXPECT_EQ(at, transpose(a(slice{0, m}, slice{0, n})));
+  EXPECT_EQ(a, transpose(a.t()));
+  const Matrix<T, 2> b = a;
+  const Matrix<T, 2> sub = b.submat(1, 1, m - 2, n - 2);
+  EXPECT_EQ(naive_transpose(sub), transpose(b.submat(1, 1, m - 2, n - 2)));
+  const Matrix<T, 2> strided = b(slice{0, m / 2, 2}, slice{0, n / 3, 3});
+  EXPECT_EQ(naive_transpose(strided),
+            transpose(b(slice{0, m / 2, 2}, slice{0, n / 3, 3})));
+
+  Matrix<T, 2> c = a;
+  c.inplace_trans();
+  EXPECT_EQ(at, c);
+  c.inplace_trans();
+  EXPECT_EQ(a, c);
+}
+
+TEST(MatrixOperationTest, BlockedTranspose) {
+  const std::size_t nt = num_threads();
+  set_num_threads(4);
+
+  // tile remainders, recursion and, for the largest, several threads
+  expect_transposes<float>(37, 53);
+  expect_transposes<double>(67, 67);
+  expect_transposes<double>(130, 61);
+  expect_transposes<int>(600, 500);
+  expect_transposes<float>(517, 517);
+  expect_transposes<std::complex<double>>(9, 14);
+
+  mat v = {{1, 2, 3}};
+  v.inplace_trans();
+  EXPECT_EQ(mat({{1}, {2}, {3}}), v);
+
+  set_num_threads(nt);
+}
+
 TEST(MatrixOperationTest, Matmul_Mat_Vec) {
   mat m1 = {{8, 4, 7}, {3, 5, 1}, {1, 3, 2}};
   vec v1 = {-1, 2, 1};
@@ -83,6 +133,201 @@ TEST(MatrixOperationTest, Matmul_N) {
   EXPECT_EQ(2412, res(2, 2));
 }
 
+TEST(MatrixOperationTest, MatmulChain) {
+  // (A1 A2) A3 costs 7500 multiplications, A1 (A2 A3) 75000
+  std::vector<std::size_t> split =
+      matrix_impl::chain_order(std::vector<std::size_t>{10, 100, 5, 50});
+  EXPECT_EQ(1, split[0 * 3 + 2]);
+  split = matrix_impl::chain_order(std::vector<std::size_t>{50, 5, 100, 10});
+  EXPECT_EQ(0, split[0 * 3 + 2]);
+
+  mat x = {{1, 2}, {3, 4}, {5, 6}};
+  mat w = {{2, 0, 1}, {1, 3, 0}, {0, 1, 4}};
+  vec v = {1, -1};
+  mat xtwx = matmul(matmul(transpose(x), w), x);
+
+  EXPECT_EQ(xtwx, matmul_n(x.t(), w, x));
+  EXPECT_EQ(matmul(xtwx, v), matmul_n(x.t(), w, x, v));
+  EXPECT_EQ(matmul(matmul(xtwx, xtwx), xtwx), matmul_n(xtwx, xtwx, xtwx));
+
+  // a single row on the left, and an outer product on the right
+  mat r = {{1, 2, 3}};
+  EXPECT_EQ(matmul(matmul(r, w), x), matmul_n(r, w, x));
+  vec c = {1, 2, 3};
+  EXPECT_EQ(matmul(matmul(w, c), r), matmul_n(w, c, r));
+
+  // element types without BLAS
+  imat xi = {{1, 2}, {3, 4}};
+  ivec vi = {1, 1};
+  EXPECT_EQ(ivec({17, 37}), matmul_n(xi, xi, vi));
+}
+
+TEST(MatrixOperationTest, NativeGemm) {
+  // sizes that cross the mc, kc and nr block edges
+  const std::size_t m = 131, k = 257, n = 70;
+  imat a(m, k), b(k, n);
+  for (std::size_t i = 0; i != m; ++i)
+    for (std::size_t p = 0; p != k; ++p) a(i, p) = int((i * 7 + p) % 11) - 5;
+  for (std::size_t p = 0; p != k; ++p)
+    for (std::size_t j = 0; j != n; ++j) b(p, j) = int((p + j * 3) % 7) - 3;
+
+  imat expected = zeros<imat>(m, n);
+  for (std::size_t i = 0; i != m; ++i)
+    for (std::size_t j = 0; j != n; ++j)
+      for (std::size_t p = 0; p != k; ++p) expected(i, j) += a(i, p) * b(p, j);
+
+  const std::size_t nt = num_threads();
+  set_num_threads(1);
+  EXPECT_EQ(expected, matmul(a, b));
+  set_num_threads(4);
+  EXPECT_EQ(expected, matmul(a, b));
+  EXPECT_EQ(transpose(expected), matmul(b.t(), a.t()));
+  set_num_threads(nt);
+
+  // beta and empty inner dimensions
+  imat c = ones<imat>(m, n);
+  const auto arg_a = matrix_impl::gemm_arg(a), arg_b = matrix_impl::gemm_arg(b);
+  matrix_impl::native_gemm(m, n, k, 2, arg_a, arg_b, 3, c.data(), n);
+  EXPECT_EQ(2 * expected(5, 6) + 3, c(5, 6));
+  matrix_impl::native_gemm(m, n, 0, 2, arg_a, arg_b, 3, c.data(), n);
+  EXPECT_EQ(3 * (2 * expected(5, 6) + 3), c(5, 6));
+
+  // the same engine for types BLAS has, conjugated operands included
+  using cx = std::complex<double>;
+  cx_mat z(40, 30);
+  for (std::size_t i = 0; i != z.size(); ++i)
+    z.data()[i] = cx(double(i % 13) - 6, double(i % 5));
+  cx_mat zz = zeros<cx_mat>(30, 30);
+  const auto arg_zh = matrix_impl::gemm_arg(z.ht());
+  matrix_impl::native_gemm<cx>(30, 30, 40, 1, arg_zh, matrix_impl::gemm_arg(z),
+                               0, zz.data(), 30);
+  EXPECT_EQ(matmul(z.ht(), z), zz);
+}
+
+TEST(MatrixOperationTest, Expression) {
+  mat a = {{1, 2, 3}, {4, 5, 6}};
+  mat b = {{6, 5, 4}, {3, 2, 1}};
+  mat c = {{2, 2, 2}, {3, 3, 3}};
+  mat d = {{1, 0, 1}, {0, 1, 0}};
+
+  mat r = a + b * c - 2.0 * d;
+  EXPECT_EQ(11, r(0, 0));
+  EXPECT_EQ(12, r(0, 1));
+  EXPECT_EQ(9, r(0, 2));
+  EXPECT_EQ(13, r(1, 0));
+  EXPECT_EQ(9, r(1, 1));
+  EXPECT_EQ(9, r(1, 2));
+  EXPECT_EQ(r, (a + b * c - 2.0 * d).eval());
+  EXPECT_EQ(12, (a + b * c - 2.0 * d)(0, 1));
+
+  mat s = 2.0 - a / 1.0;
+  EXPECT_EQ(1, s(0, 0));
+  EXPECT_EQ(-4, s(1, 2));
+
+  // into views and through strided operands
+  mat e = zeros<mat>(2, 3);
+  e.row(1) = a.row(0) + b.row(1);
+  EXPECT_EQ(4, e(1, 0));
+  EXPECT_EQ(4, e(1, 2));
+  e.col(0) += a.col(2) * b.col(0);
+  EXPECT_EQ(18, e(0, 0));
+  EXPECT_EQ(22, e(1, 0));
+
+  // compound assignment and the same matrix on both sides
+  mat f = a;
+  f += a * b;
+  EXPECT_EQ(7, f(0, 0));
+  f = f - a;
+  EXPECT_EQ(a * b, f);
+
+  // overlapping views are evaluated as if eagerly
+  vec v = {1, 2, 3, 4, 5};
+  v(slice{1, 4}) = v(slice{0, 4}) + 1.0;
+  EXPECT_EQ(vec({1, 2, 3, 4, 5}), v);
+  v(slice{0, 4}) = v(slice{1, 4}) * 2.0;
+  EXPECT_EQ(vec({4, 6, 8, 10, 5}), v);
+
+  // temporaries are kept alive by the expression
+  vec w = {1, 1};
+  vec t = matmul(a, vec({1, 0, 0})) + w;
+  EXPECT_EQ(vec({2, 5}), t);
+}
+
+TEST(MatrixOperationTest, TransposedView) {
+  mat a = {{1, 2, 3}, {4, 5, 6}};
+  mat b = {{1, 0}, {2, 1}, {0, 3}};
+  vec v = {1, 2};
+
+  // t() is a view: no copy is made, writes go through to a
+  mat at = a.t();
+  EXPECT_EQ(transpose(a), at);
+  at = zeros<mat>(1, 1);
+  at = a.t();
+  EXPECT_EQ(transpose(a), at);
+  a.t()(2, 1) = 60;
+  EXPECT_EQ(60, a(1, 2));
+  a(1, 2) = 6;
+  EXPECT_EQ(vec({1, 4}), vec(a.t().row(0)));
+  EXPECT_EQ(1, v.t().n_rows());
+  EXPECT_EQ(2, v.t().n_cols());
+
+  // element-wise expressions read the strided view directly
+  mat sum = a.t() + b;
+  EXPECT_EQ(transpose(a) + b, sum);
+
+  // matmul folds the transposes into the GEMM/GEMV flags
+  EXPECT_EQ(matmul(transpose(a), transpose(b)), matmul(a.t(), b.t()));
+  EXPECT_EQ(matmul(b, a), matmul(b.t().t(), a));
+  EXPECT_EQ(matmul(transpose(a), v), matmul(a.t(), v));
+  EXPECT_EQ(matmul(b, transpose(b)), matmul(b, b.t()));
+
+  // sub-matrix views have a leading dimension larger than their width
+  mat big = {{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}};
+  mat sub = big.submat(0, 1, 2, 2);
+  EXPECT_EQ(matmul(transpose(sub), sub),
+            matmul(big.submat(0, 1, 2, 2).t(), big.submat(0, 1, 2, 2)));
+
+  // BLAS wrappers
+  mat c = zeros<mat>(3, 3);
+  blas_gemm(CblasNoTrans, CblasNoTrans, 1.0, a.t(), b.t(), 0.0, c);
+  EXPECT_EQ(matmul(transpose(a), transpose(b)), c);
+  vec y = zeros<vec>(3);
+  blas_gemv(CblasNoTrans, 1.0, a.t(), v, 0.0, y);
+  EXPECT_EQ(matmul(transpose(a), v), y);
+
+  // the conjugate transpose of a complex matrix
+  using cx = std::complex<double>;
+  cx_mat z = {{cx(1, 1), cx(2, -1)}, {cx(0, 3), cx(4, 0)}};
+  cx_mat zh = {{cx(1, -1), cx(0, -3)}, {cx(2, 1), cx(4, 0)}};
+  cx_mat h = z.ht();
+  EXPECT_EQ(zh, h);
+  EXPECT_EQ(matmul(zh, z), matmul(z.ht(), z));
+  EXPECT_EQ(matmul(z, zh), matmul(z, z.ht()));
+  EXPECT_EQ(matmul(zh, zh), matmul(z.ht(), z.ht()));
+  EXPECT_EQ(zh + z, cx_mat(z.ht() + z));
+  EXPECT_EQ(transpose(a), a.ht());
+
+  // solve with a transposed coefficient matrix
+  mat s = {{4, 1, 2}, {1, 5, 3}, {2, 0, 6}};
+  mat rhs = {{1, 2}, {3, 4}, {5, 6}};
+  mat x1 = solve(s.t(), rhs);
+  mat x2 = solve(transpose(s), rhs);
+  for (std::size_t i = 0; i != x1.size(); ++i)
+    EXPECT_NEAR(x2.data()[i], x1.data()[i], 1e-12);
+  cx_mat zb = {{cx(1, 0)}, {cx(0, 1)}};
+  cx_mat zx = solve(z.ht(), zb);
+  cx_mat zr = matmul(zh, zx);
+  for (std::size_t i = 0; i != zr.size(); ++i)
+    EXPECT_NEAR(0, std::abs(zr.data()[i] - zb.data()[i]), 1e-12);
+
+  // a singular coefficient matrix is reported, transposed or not
+  mat sing = {{1, 2, 3}, {2, 4, 6}, {1, 0, 1}};
+  EXPECT_EXIT(solve(sing.t(), rhs), ::testing::ExitedWithCode(1),
+              "singular");
+  EXPECT_EXIT(solve(sing(slice{0, 3}, slice{0, 3}), rhs),
+              ::testing::ExitedWithCode(1), "singular");
+}
+
 TEST(MatrixOperationTest, Exp) {
   mat m = zeros<mat>(3, 3);
   mat res = exp(m);
@@ -128,6 +373,94 @@ TEST(MatrixOperationTest, Pow) {
   EXPECT_EQ(0.5, res(2, 2));
 }
 
+// The element-wise operators of matrices large enough for the SIMD kernels,
+// contiguous and by rows, against element-by-element loops.
+template <typename T>
+void expect_elementwise_operators() {
+  Matrix<T, 2> a(5, 40), b(5, 40);
+  for (std::size_t i = 0; i != 5; ++i)
+    for (std::size_t j = 0; j != 40; ++j) {
+      a(i, j) = T(int(i * 40 + j) % 23 - 11);
+      b(i, j) = T(int(j) % 7 + 1);
+    }
+
+  Matrix<T, 2> c = a;
+  c += b;
+  c *= T(3);
+  c -= T(2);
+  c /= b;
+  Matrix<T, 2> d = a * b;
+  Matrix<T, 2> e = a - T(4);
+  Matrix<T, 2> f = T(4) / b;
+  Matrix<T, 2> g = a;
+  g.submat(1, 2, 3, 37) += b.submat(0, 0, 2, 35);  // rows of submatrices
+  g.submat(0, 20, 4, 39) = T(7);
+  for (std::size_t i = 0; i != 5; ++i)
+    for (std::size_t j = 0; j != 40; ++j) {
+      EXPECT_EQ(((a(i, j) + b(i, j)) * T(3) - T(2)) / b(i, j), c(i, j));
+      EXPECT_EQ(a(i, j) * b(i, j), d(i, j));
+      EXPECT_EQ(a(i, j) - T(4), e(i, j));
+      EXPECT_EQ(T(4) / b(i, j), f(i, j));
+      T gij = a(i, j);
+      if (i >= 1 && i <= 3 && j >= 2 && j <= 37) gij += b(i - 1, j - 2);
+      if (j >= 20) gij = T(7);
+      EXPECT_EQ(gij, g(i, j));
+    }
+
+  Matrix<T, 2> h = a;
+  EXPECT_TRUE(h == a);
+  h(4, 39) += T(1);
+  EXPECT_FALSE(h == a);
+  EXPECT_TRUE(h.submat(0, 0, 3, 39) == a.submat(0, 0, 3, 39));
+  EXPECT_TRUE((Matrix<T, 2>(Matrix<double, 2>(a)) == a));  // conversions
+}
+
+TEST(MatrixOperationTest, SimdKernels) {
+#ifdef SLAB_MATRIX_SIMD
+  const SimdLevel level = simd_level();
+  for (int l = 0; l <= int(simd_max_level()); ++l) {
+    set_simd_level(SimdLevel(l));
+    EXPECT_EQ(SimdLevel(l), simd_level());
+    SCOPED_TRACE(simd_level_name(simd_level()));
+#endif
+    expect_elementwise_operators<float>();
+    expect_elementwise_operators<double>();
+    expect_elementwise_operators<int>();
+#ifdef SLAB_MATRIX_SIMD
+    // the kernels the operators do not use
+    const auto &k = matrix_impl::simd_table();
+    const double x[] = {1.5, -2, 0, 4, -0.0, 7};
+    const double y[] = {2, -2, -1, 3, 0, 8};
+    double z[6];
+    k.f64.binary[std::size_t(matrix_impl::SimdOp::min)](6, x, y, z);
+    EXPECT_EQ(-2, z[1]);
+    EXPECT_EQ(-1, z[2]);
+    k.f64.scalar_left[std::size_t(matrix_impl::SimdOp::max)](6, 1, x, z);
+    EXPECT_EQ(1, z[2]);
+    EXPECT_EQ(7, z[5]);
+    k.f64.fma(6, x, y, x, z);
+    EXPECT_EQ(4.5, z[0]);
+    k.f64.axpy(6, 2.0, x, z);
+    EXPECT_EQ(7.5, z[0]);
+    k.f64.abs(6, x, z);
+    EXPECT_EQ(2, z[1]);
+    EXPECT_FALSE(std::signbit(z[4]));
+    unsigned char m[6];
+    k.f64.compare[std::size_t(matrix_impl::SimdCmp::le)](6, x, y, m);
+    EXPECT_EQ(std::vector<unsigned char>({1, 1, 0, 0, 1, 1}),
+              std::vector<unsigned char>(m, m + 6));
+    int i[6];
+    k.cvt.double_int(6, x, i);
+    EXPECT_EQ(std::vector<int>({1, -2, 0, 4, 0, 7}),
+              std::vector<int>(i, i + 6));
+    float f[6];
+    k.cvt.int_float(6, i, f);
+    EXPECT_EQ(-2.0f, f[1]);
+  }
+  set_simd_level(level);
+#endif
+}
+
 }  // namespace slab
 
 #endif  // MATRIX_TEST_MATRIX_OPERERATION_H
@@ -1,6 +1,11 @@
 #ifndef MATRIX_TEST_MATRIX_SUBSCRIPT_H_
 #define MATRIX_TEST_MATRIX_SUBSCRIPT_H_
 
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
 #include <gtest/gtest.h>
 #include "slab/matrix.h"
 
@@ -17,6 +22,194 @@ TEST(MatrixSubscriptTest, SubscriptByFortranStyle) {
   EXPECT_EQ(99, m(1, 2));
 }
 
+namespace {
+
+// generic code resolves element access at compile time
+template <typename T, typename D>
+Remove_const<T> sum_elements(const MatrixBase<T, 2, D> &m) {
+  Remove_const<T> res = 0;
+  for (std::size_t i = 0; i != m.n_rows(); ++i)
+    for (std::size_t j = 0; j != m.n_cols(); ++j) res += m(i, j);
+  return res;
+}
+
+// a non-template taking any matrix at run time
+int trace(AnyMatrix<const int, 2> m) {
+  int res = 0;
+  for (std::size_t i = 0; i != std::min(m.n_rows(), m.n_cols()); ++i)
+    res += m(i, i);
+  return res;
+}
+
+void scale(AnyMatrix<int, 2> m, int val) {
+  for (std::size_t i = 0; i != m.n_rows(); ++i)
+    for (std::size_t j = 0; j != m.n_cols(); ++j) m(i, j) *= val;
+}
+
+}  // namespace
+
+TEST(MatrixSubscriptTest, StaticAndErasedAccess) {
+  Matrix<int, 2> m{{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+  const Matrix<int, 2> &cm = m;
+
+  EXPECT_EQ(45, sum_elements(m));
+  EXPECT_EQ(45, sum_elements(cm.submat(0, 0, 2, 2)));
+  MatrixBase<int, 2, Matrix<int, 2>> &base = m;
+  EXPECT_EQ(m.data(), base.data());
+  EXPECT_EQ(9, base.size());
+
+  EXPECT_EQ(15, trace(m));
+  EXPECT_EQ(15, trace(cm));
+  EXPECT_EQ(14, trace(m.submat(1, 1, 2, 2)));
+  EXPECT_EQ(15, trace(cm.t()));
+
+  scale(m, 2);
+  EXPECT_EQ(30, trace(m));
+  auto r = m.submat(1, 0, 1, 2);
+  scale(r, 0);
+  EXPECT_EQ(0, m(1, 1));
+
+  // the handle follows the matrix when it is reallocated
+  CowMatrix<int, 2> c = {{1, 2}, {3, 4}};
+  CowMatrix<int, 2> shared = c;
+  AnyMatrix<int, 2> h = c;
+  h(0, 0) = 10;
+  EXPECT_EQ(10, c(0, 0));
+  EXPECT_EQ(1, shared(0, 0));
+  c = Matrix<int, 2>(uninitialized, 3, 3);
+  EXPECT_EQ(9, h.size());
+  EXPECT_EQ(3, h.ref().n_rows());
+}
+
+TEST(MatrixSubscriptTest, ViewTraversal) {
+  Matrix<double, 3> c(4, 5, 6);
+  for (std::size_t i = 0; i != c.size(); ++i) c.data()[i] = double(i);
+
+  // views whose trailing dimensions merge fully, partly or not at all, and
+  // the elements MatrixRefIterator visits, in its order
+  auto full = c(slice{1, 2}, slice{0, 5}, slice{0, 6});
+  auto rows = c(slice{0, 4}, slice{1, 3}, slice{0, 6});
+  auto strided = c(slice{0, 2, 2}, slice{0, 5}, slice{1, 3, 2});
+  std::vector<double> expect(strided.begin(), strided.end());
+  Matrix<double, 3> copy = strided;
+  EXPECT_EQ(expect, std::vector<double>(copy.begin(), copy.end()));
+  EXPECT_EQ(double(c(2, 4, 5)), copy(1, 4, 2));
+  EXPECT_TRUE((Matrix<double, 3>(full) == full));
+  EXPECT_TRUE((Matrix<int, 3>(rows) == rows));  // converting
+
+  Matrix<double, 3> d(4, 5, 6);
+  d(slice{1, 2}, slice{0, 5}, slice{0, 6}) = full;
+  d(slice{0, 4}, slice{1, 3}, slice{0, 6}) += rows;
+  d(slice{0, 2, 2}, slice{0, 5}, slice{1, 3, 2}) -= strided;
+  for (std::size_t i = 0; i != 4; ++i)
+    for (std::size_t j = 0; j != 5; ++j)
+      for (std::size_t k = 0; k != 6; ++k) {
+        double x = i >= 1 && i <= 2 ? c(i, j, k) : 0;
+        if (j >= 1 && j <= 3) x += c(i, j, k);
+        if (i % 2 == 0 && k % 2 == 1 && k <= 5) x -= c(i, j, k);
+        EXPECT_EQ(x, d(i, j, k));
+      }
+
+  // columns and transposes, into vectors and back
+  mat m = {{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+  vec col = m.col(1);
+  EXPECT_EQ(vec({2, 5, 8}), col);
+  mat t = m.t();
+  EXPECT_EQ(4, t(0, 1));
+  m.col(0) = m.row(2);
+  EXPECT_EQ(vec({7, 8, 9}), vec(m.col(0)));
+
+  // overlapping views copy in the order of std::copy
+  vec v = {1, 2, 3, 4, 5};
+  v(slice{1, 4}) = v(slice{0, 4});
+  EXPECT_EQ(vec({1, 1, 1, 1, 1}), v);
+  vec w = {1, 2, 3, 4, 5};
+  w = w(slice{1, 3});
+  EXPECT_EQ(vec({2, 3, 4}), w);
+}
+
+TEST(MatrixSubscriptTest, ViewIterators) {
+  Matrix<double, 3> c(3, 4, 5);
+  for (std::size_t i = 0; i != c.size(); ++i) c.data()[i] = double(i);
+
+  // random access agrees with stepping, both ways
+  auto view = c(slice{0, 3}, slice{1, 2, 2}, slice{0, 3, 2});
+  std::vector<double> expect;
+  for (auto it = view.begin(); it != view.end(); it++) expect.push_back(*it);
+  ASSERT_EQ(view.size(), expect.size());
+  EXPECT_EQ(std::ptrdiff_t(view.size()), view.end() - view.begin());
+  for (std::size_t i = 0; i != expect.size(); ++i) {
+    EXPECT_EQ(expect[i], view.begin()[i]);
+    EXPECT_EQ(expect[i], *(view.end() - std::ptrdiff_t(expect.size() - i)));
+  }
+  auto it = view.begin() + 5;
+  EXPECT_EQ(it, view.begin() + 4 + 1);
+  EXPECT_EQ(expect[4], *--it);
+  EXPECT_EQ(expect[4], *it--);
+  EXPECT_EQ(expect[3], *it);
+  EXPECT_TRUE(view.begin() < it && it <= view.end() - 1);
+  EXPECT_TRUE((std::vector<double>(expect.rbegin(), expect.rend()) ==
+               std::vector<double>(std::reverse_iterator<decltype(it)>(
+                                       view.end()),
+                                   std::reverse_iterator<decltype(it)>(
+                                       view.begin()))));
+  MatrixRef<double, 3>::const_iterator cit = it;
+  EXPECT_EQ(expect[3], *cit);
+
+  // algorithms that need random access, on a column and a submatrix
+  mat m = {{5, 1, 9}, {3, 7, 2}, {8, 4, 6}, {0, 11, 10}};
+  auto col = m.col(1);
+  std::sort(col.begin(), col.end());
+  EXPECT_EQ(vec({1, 4, 7, 11}), vec(col));
+  mat n = m;
+  auto sub = n(slice{1, 3}, slice{0, 2, 2});
+  std::nth_element(sub.begin(), sub.begin() + 2, sub.end());
+  EXPECT_EQ(3, sub.begin()[2]);
+  EXPECT_EQ(5, n(0, 0));
+  EXPECT_EQ(7, n(2, 1));
+
+  // ranges of rows and columns
+  auto rows = row_views(m);
+  ASSERT_EQ(4, rows.size());
+  EXPECT_EQ(vec({3, 4, 2}), vec(rows[1]));
+  std::vector<double> sums(rows.size());
+  matrix_impl::parallel_for(
+      rows.size(), 2,
+      [&](std::size_t first, std::size_t last, std::size_t) {
+        for (auto r = rows.begin() + first; r != rows.begin() + last; ++r)
+          sums[r.position()] = sum(vec(*r));
+      });
+  EXPECT_EQ(std::vector<double>({15, 9, 21, 21}), sums);
+  static_assert(
+      std::is_same<std::iterator_traits<decltype(rows.begin())>::
+                       iterator_category,
+                   std::input_iterator_tag>::value,
+      "the views are made on the fly");
+  std::vector<double> firsts(rows.size());
+  std::transform(rows.begin(), rows.end(), firsts.begin(),
+                 [](MatrixRef<double, 1> r) { return r(0); });
+  EXPECT_EQ(std::vector<double>({5, 3, 8, 0}), firsts);
+  auto big = std::find_if(rows.begin(), rows.end(),
+                          [](MatrixRef<double, 1> r) { return r(2) == 6; });
+  EXPECT_EQ(2, big.position());
+  EXPECT_EQ(2, std::count_if(rows.begin(), rows.end(),
+                             [](MatrixRef<double, 1> r) {
+                               return sum(vec(r)) == 21;
+                             }));
+  std::for_each(rows.begin() + 1, rows.begin() + 3,
+                [](MatrixRef<double, 1> r) { r += 1; });
+  EXPECT_EQ(vec({4, 5, 3}), vec(rows[1]));
+  std::for_each(rows.begin() + 1, rows.begin() + 3,
+                [](MatrixRef<double, 1> r) { r -= 1; });
+  for (auto r : col_views(m)) r *= 2;
+  EXPECT_EQ(22, m(3, 1));
+  const mat &cm = m;
+  auto cols = col_views(cm);
+  EXPECT_EQ(3, cols.end() - cols.begin());
+  EXPECT_EQ(vec({18, 4, 12, 20}), vec(cols.begin()[2]));
+  EXPECT_EQ(3, row_views(m(slice{1, 3}, slice{0, 3})).size());
+}
+
 }  // namespace slab
 
 #endif  // MATRIX_TEST_MATRIX_SUBSCRIPT_H_